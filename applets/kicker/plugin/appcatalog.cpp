@@ -0,0 +1,104 @@
+/***************************************************************************
+ *   Copyright 2020 by the Plasma Workspace authors                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "appcatalog.h"
+
+#include <QFileInfo>
+
+#include <KSycoca>
+
+AppCatalog::AppCatalog() : QObject()
+{
+    connect(KSycoca::self(), static_cast<void (KSycoca::*)(const QStringList &)>(&KSycoca::databaseChanged),
+        this, &AppCatalog::clear);
+}
+
+AppCatalog::~AppCatalog()
+{
+}
+
+QSharedPointer<AppCatalog> AppCatalog::instance()
+{
+    static QWeakPointer<AppCatalog> s_instance;
+
+    QSharedPointer<AppCatalog> catalog = s_instance.toStrongRef();
+
+    if (!catalog) {
+        catalog.reset(new AppCatalog());
+        s_instance = catalog;
+    }
+
+    return catalog;
+}
+
+KService::Ptr AppCatalog::service(const QString &storageId)
+{
+    auto it = m_services.constFind(storageId);
+
+    if (it != m_services.constEnd()) {
+        return *it;
+    }
+
+    const KService::Ptr service = KService::serviceByStorageId(storageId);
+    m_services.insert(storageId, service);
+
+    return service;
+}
+
+QIcon AppCatalog::icon(const QString &iconName)
+{
+    auto it = m_icons.constFind(iconName);
+
+    if (it != m_icons.constEnd()) {
+        return *it;
+    }
+
+    QIcon icon;
+
+    if (QFileInfo::exists(iconName)) {
+        icon = QIcon(iconName);
+    } else {
+        icon = QIcon::fromTheme(iconName, QIcon::fromTheme(QStringLiteral("unknown")));
+    }
+
+    m_icons.insert(iconName, icon);
+
+    return icon;
+}
+
+QCollatorSortKey AppCatalog::sortKey(const QString &name)
+{
+    auto it = m_sortKeys.constFind(name);
+
+    if (it != m_sortKeys.constEnd()) {
+        return *it;
+    }
+
+    const QCollatorSortKey key = m_collator.sortKey(name);
+    m_sortKeys.insert(name, key);
+
+    return key;
+}
+
+void AppCatalog::clear()
+{
+    m_services.clear();
+    m_icons.clear();
+    m_sortKeys.clear();
+}
@@ -0,0 +1,74 @@
+/***************************************************************************
+ *   Copyright 2020 by the Plasma Workspace authors                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#ifndef APPCATALOG_H
+#define APPCATALOG_H
+
+#include <QCollator>
+#include <QHash>
+#include <QIcon>
+#include <QObject>
+#include <QSharedPointer>
+
+#include <KService>
+
+/**
+ * Application lookups shared by the Kicker models of all launchers in the
+ * process.
+ *
+ * Services by storage id (including the ones which don't exist), icons and
+ * collation sort keys of names are resolved once and kept until the sycoca
+ * database changes. The models and entries using it hold a reference, it
+ * goes away with the last one.
+ *
+ * Only to be used from the main thread.
+ */
+class AppCatalog : public QObject
+{
+    Q_OBJECT
+
+    public:
+        ~AppCatalog() override;
+
+        static QSharedPointer<AppCatalog> instance();
+
+        /**
+         * @return the service with @p storageId, or a null pointer if there is none
+         */
+        KService::Ptr service(const QString &storageId);
+
+        /**
+         * @return the icon for a name or path as found in desktop files
+         */
+        QIcon icon(const QString &iconName);
+
+        QCollatorSortKey sortKey(const QString &name);
+
+    private:
+        AppCatalog();
+
+        void clear();
+
+        QHash<QString, KService::Ptr> m_services;
+        QHash<QString, QIcon> m_icons;
+        QHash<QString, QCollatorSortKey> m_sortKeys;
+        QCollator m_collator;
+};
+
+#endif
@@ -28,7 +28,6 @@
 #include <QProcess>
 #include <QQmlPropertyMap>
 #include <QStandardPaths>
-#include <QFileInfo>
 #if HAVE_X11
 #include <QX11Info>
 #endif
@@ -50,6 +49,7 @@
 
 AppEntry::AppEntry(AbstractModel *owner, KService::Ptr service, NameFormat nameFormat)
 : AbstractEntry(owner)
+, m_catalog(AppCatalog::instance())
 , m_service(service)
 {
     if (m_service) {
@@ -58,6 +58,7 @@ AppEntry::AppEntry(AbstractModel *owner, KService::Ptr service, NameFormat nameF
 }
 
 AppEntry::AppEntry(AbstractModel *owner, const QString &id) : AbstractEntry(owner)
+, m_catalog(AppCatalog::instance())
 {
     const QUrl url(id);
 
@@ -65,7 +66,7 @@ AppEntry::AppEntry(AbstractModel *owner, const QString &id) : AbstractEntry(owne
         m_service = defaultAppByName(url.host());
         m_id = id;
     } else {
-        m_service = KService::serviceByStorageId(id);
+        m_service = m_catalog->service(id);
     }
 
     if (m_service) {
@@ -92,11 +93,7 @@ bool AppEntry::isValid() const
 QIcon AppEntry::icon() const
 {
     if (m_icon.isNull()) {
-        if (QFileInfo::exists(m_service->icon())) {
-            m_icon = QIcon(m_service->icon());
-        } else {
-            m_icon = QIcon::fromTheme(m_service->icon(), QIcon::fromTheme(QStringLiteral("unknown")));
-        }
+        m_icon = m_catalog->icon(m_service->icon());
     }
     return m_icon;
 }
@@ -130,6 +127,25 @@ QString AppEntry::menuId() const
     return m_service->menuId();
 }
 
+bool AppEntry::reload(KService::Ptr service, NameFormat nameFormat)
+{
+    const QString oldName = m_name;
+    const QString oldDescription = m_description;
+    const QString oldIconName = m_service ? m_service->icon() : QString();
+    const QString oldEntryPath = m_service ? m_service->entryPath() : QString();
+
+    m_service = service;
+    init(nameFormat);
+
+    const bool iconChanged = (m_service->icon() != oldIconName);
+    if (iconChanged) {
+        m_icon = QIcon();
+    }
+
+    return iconChanged || m_name != oldName || m_description != oldDescription
+        || m_service->entryPath() != oldEntryPath;
+}
+
 QUrl AppEntry::url() const
 {
     return QUrl::fromLocalFile(Kicker::resolvedServiceEntryPath(m_service));
@@ -277,6 +293,7 @@ KService::Ptr AppEntry::defaultAppByName(const QString& name)
 
 AppGroupEntry::AppGroupEntry(AppsModel *parentModel, KServiceGroup::Ptr group,
     bool paginate, int pageSize, bool flat, bool sorted, bool separators, int appNameFormat) : AbstractGroupEntry(parentModel),
+    m_catalog(AppCatalog::instance()),
     m_group(group)
 {
     AppsModel* model = new AppsModel(group->entryPath(), paginate, pageSize, flat,
@@ -295,10 +312,19 @@ AppGroupEntry::AppGroupEntry(AppsModel *parentModel, KServiceGroup::Ptr group,
     );
 }
 
+AppGroupEntry::~AppGroupEntry()
+{
+    if (m_childModel) {
+        // The connections above refer to this entry.
+        m_childModel->disconnect();
+        m_childModel->deleteLater();
+    }
+}
+
 QIcon AppGroupEntry::icon() const
 {
     if (m_icon.isNull()) {
-        m_icon = QIcon::fromTheme(m_group->icon(), QIcon::fromTheme(QStringLiteral("unknown")));
+        m_icon = m_catalog->icon(m_group->icon());
     }
     return m_icon;
 }
@@ -316,3 +342,21 @@ bool AppGroupEntry::hasChildren() const
 AbstractModel *AppGroupEntry::childModel() const {
     return m_childModel;
 }
+
+bool AppGroupEntry::reload(KServiceGroup::Ptr group)
+{
+    const bool iconChanged = (group->icon() != m_group->icon());
+    const bool changed = iconChanged || group->caption() != m_group->caption();
+
+    if (iconChanged) {
+        m_icon = QIcon();
+    }
+
+    m_group = group;
+
+    if (m_childModel) {
+        m_childModel->refresh();
+    }
+
+    return changed;
+}
@@ -21,6 +21,7 @@
 #define APPENTRY_H
 
 #include "abstractentry.h"
+#include "appcatalog.h"
 
 #include <KService>
 #include <KServiceGroup>
@@ -60,12 +61,19 @@ class AppEntry : public AbstractEntry
 
         QString menuId() const;
 
+        /**
+         * Updates the entry after the sycoca database changed.
+         * @return whether the name, description, icon or file changed
+         */
+        bool reload(KService::Ptr service, NameFormat nameFormat);
+
         static QString nameFromService(const KService::Ptr service, NameFormat nameFormat);
         static KService::Ptr defaultAppByName(const QString &name);
 
     private:
         void init(NameFormat nameFormat);
 
+        QSharedPointer<AppCatalog> m_catalog;
         QString m_id;
         QString m_name;
         QString m_description;
@@ -79,6 +87,7 @@ class AppGroupEntry : public AbstractGroupEntry
     public:
         AppGroupEntry(AppsModel *parentModel, KServiceGroup::Ptr group,
             bool paginate, int pageSize, bool flat, bool sorted, bool separators, int appNameFormat);
+        ~AppGroupEntry() override;
 
         QIcon icon() const override;
         QString name() const override;
@@ -86,7 +95,14 @@ class AppGroupEntry : public AbstractGroupEntry
         bool hasChildren() const override;
         AbstractModel *childModel() const override;
 
+        /**
+         * Updates the entry and its child model after the sycoca database changed.
+         * @return whether the name or icon changed
+         */
+        bool reload(KServiceGroup::Ptr group);
+
     private:
+        QSharedPointer<AppCatalog> m_catalog;
         KServiceGroup::Ptr m_group;
         mutable QIcon m_icon;
         QPointer<AbstractModel> m_childModel;
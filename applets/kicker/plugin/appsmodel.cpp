@@ -22,7 +22,6 @@
 #include "actionlist.h"
 #include "rootmodel.h"
 
-#include <QCollator>
 #include <QDebug>
 #include <QQmlPropertyMap>
 #include <QTimer>
@@ -30,9 +29,12 @@
 #include <KLocalizedString>
 #include <KSycoca>
 
+#include <vector>
+
 AppsModel::AppsModel(const QString &entryPath, bool paginate, int pageSize, bool flat,
     bool sorted, bool separators, QObject *parent)
 : AbstractModel(parent)
+, m_catalog(AppCatalog::instance())
 , m_complete(false)
 , m_paginate(paginate)
 , m_pageSize(pageSize)
@@ -57,6 +59,7 @@ AppsModel::AppsModel(const QString &entryPath, bool paginate, int pageSize, bool
 
 AppsModel::AppsModel(const QList<AbstractEntry *> entryList, bool deleteEntriesOnDestruction, QObject *parent)
 : AbstractModel(parent)
+, m_catalog(AppCatalog::instance())
 , m_complete(false)
 , m_paginate(false)
 , m_pageSize(24)
@@ -74,24 +77,24 @@ AppsModel::AppsModel(const QList<AbstractEntry *> entryList, bool deleteEntriesO
 , m_sorted(true)
 , m_appNameFormat(AppEntry::NameOnly)
 {
+    QSet<QString> storageIds;
+    storageIds.reserve(entryList.count());
+
     foreach(AbstractEntry *suggestedEntry, entryList) {
-        bool found = false;
-
-        foreach (const AbstractEntry *entry, m_entryList) {
-            if (entry->type() == AbstractEntry::RunnableType
-                && static_cast<const AppEntry *>(entry)->service()->storageId()
-                == static_cast<const AppEntry *>(suggestedEntry)->service()->storageId()) {
-                found = true;
-                break;
+        if (suggestedEntry->type() == AbstractEntry::RunnableType) {
+            const QString &storageId = static_cast<const AppEntry *>(suggestedEntry)->service()->storageId();
+
+            if (storageIds.contains(storageId)) {
+                continue;
             }
-        }
 
-        if (!found) {
-            m_entryList << suggestedEntry;
+            storageIds.insert(storageId);
         }
+
+        m_entryList << suggestedEntry;
     }
 
-    sortEntries();
+    sortEntries(m_entryList);
 }
 
 AppsModel::~AppsModel()
@@ -460,18 +463,49 @@ void AppsModel::refresh()
         return;
     }
 
-    beginResetModel();
+    const int oldCount = m_entryList.count();
+    const int oldSeparatorCount = m_separatorCount;
 
-    refreshInternal();
+    if ((m_paginate && !m_entryPath.isEmpty()) || (m_entryKeys.isEmpty() && !m_entryList.isEmpty())) {
+        // Pages don't map to the sycoca database, build them from scratch
+        beginResetModel();
+
+        refreshInternal();
+
+        endResetModel();
+    } else {
+        EntryCollector collector;
+
+        for (auto it = m_entryKeys.constBegin(); it != m_entryKeys.constEnd(); ++it) {
+            collector.reusableEntries.insert(it.value(), const_cast<AbstractEntry *>(it.key()));
+        }
 
-    endResetModel();
+        collectEntries(collector);
+
+        m_separatorCount = collector.separatorCount;
+        m_hiddenEntries = collector.hiddenEntries;
+
+        applyEntries(collector.entries, collector.changedEntries);
+
+        m_entryKeys = collector.keys;
+    }
 
     if (favoritesModel()) {
         favoritesModel()->refresh();
     }
 
-    emit countChanged();
-    emit separatorCountChanged();
+    if (m_entryList.count() != oldCount) {
+        emit countChanged();
+    }
+
+    if (m_separatorCount != oldSeparatorCount) {
+        emit separatorCountChanged();
+    }
+}
+
+void AppsModel::reloadApplications()
+{
+    refresh();
 }
 
 void AppsModel::refreshInternal()
@@ -483,12 +517,49 @@ void AppsModel::refreshInternal()
     if (m_entryList.count()) {
         qDeleteAll(m_entryList);
         m_entryList.clear();
+        m_entryKeys.clear();
         emit cleared();
     }
 
-    m_hiddenEntries.clear();
-    m_separatorCount = 0;
+    EntryCollector collector;
+    collectEntries(collector);
 
+    m_entryList = collector.entries;
+    m_entryKeys = collector.keys;
+    m_separatorCount = collector.separatorCount;
+    m_hiddenEntries = collector.hiddenEntries;
+
+    if (!m_entryPath.isEmpty() && m_paginate) {
+        QList<AbstractEntry *> groups;
+
+        int at = 0;
+        QList<AbstractEntry *> page;
+
+        foreach(AbstractEntry *app, m_entryList) {
+            page.append(app);
+
+            if (at == (m_pageSize - 1)) {
+                at = 0;
+                AppsModel *model = new AppsModel(page, true, this);
+                groups.append(new GroupEntry(this, QString(), QString(), model));
+                page.clear();
+            } else {
+                ++at;
+            }
+        }
+
+        if (page.count()) {
+            AppsModel *model = new AppsModel(page, true, this);
+            groups.append(new GroupEntry(this, QString(), QString(), model));
+        }
+
+        m_entryList = groups;
+        m_entryKeys.clear();
+    }
+}
+
+void AppsModel::collectEntries(EntryCollector &collector)
+{
     if (m_entryPath.isEmpty()) {
         KServiceGroup::Ptr group = KServiceGroup::root();
         if (!group) {
@@ -507,9 +578,7 @@ void AppsModel::refreshInternal()
                 KServiceGroup::Ptr subGroup(static_cast<KServiceGroup*>(p.data()));
 
                 if (!subGroup->noDisplay() && subGroup->childCount() > 0) {
-                    AppGroupEntry *groupEntry = new AppGroupEntry(this, subGroup, m_paginate, m_pageSize, m_flat,
-                        m_sorted, m_showSeparators, m_appNameFormat);
-                    m_entryList << groupEntry;
+                    addGroupEntry(collector, subGroup);
                 }
             } else if (p->isType(KST_KService) && m_showTopLevelItems) {
                 const KService::Ptr service(static_cast<KService*>(p.data()));
@@ -518,94 +587,39 @@ void AppsModel::refreshInternal()
                     continue;
                 }
 
-                bool found = false;
-
-                foreach (const AbstractEntry *entry, m_entryList) {
-                    if (entry->type() == AbstractEntry::RunnableType
-                        && static_cast<const AppEntry *>(entry)->service()->storageId() == service->storageId()) {
-                        found = true;
-                    }
-                }
-
-                if (!found) {
-                    m_entryList << new AppEntry(this, service, m_appNameFormat);
-                }
+                addAppEntry(collector, service);
              } else if (p->isType(KST_KServiceSeparator) && m_showSeparators && m_showTopLevelItems) {
-                if (!m_entryList.count()) {
-                    continue;
-                }
-
-                if (m_entryList.last()->type() == AbstractEntry::SeparatorType) {
-                    continue;
-                }
-
-                m_entryList << new SeparatorEntry(this);
-                ++m_separatorCount;
+                addSeparatorEntry(collector);
             }
         }
 
-        if (m_entryList.count()) {
-            while (m_entryList.last()->type() == AbstractEntry::SeparatorType) {
-                m_entryList.removeLast();
-                --m_separatorCount;
-            }
-        }
+        removeTrailingSeparators(collector);
 
         if (m_sorted) {
-            sortEntries();
+            sortEntries(collector.entries);
         }
 
-        m_changeTimer = new QTimer(this);
-        m_changeTimer->setSingleShot(true);
-        m_changeTimer->setInterval(100);
-        connect(m_changeTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+        if (!m_changeTimer) {
+            m_changeTimer = new QTimer(this);
+            m_changeTimer->setSingleShot(true);
+            m_changeTimer->setInterval(100);
+            connect(m_changeTimer, &QTimer::timeout, this, &AppsModel::reloadApplications);
 
-        connect(KSycoca::self(), SIGNAL(databaseChanged(QStringList)), SLOT(checkSycocaChanges(QStringList)));
+            connect(KSycoca::self(), SIGNAL(databaseChanged(QStringList)), SLOT(checkSycocaChanges(QStringList)));
+        }
     } else {
         KServiceGroup::Ptr group = KServiceGroup::group(m_entryPath);
-        processServiceGroup(group);
+        processServiceGroup(group, collector);
 
-        if (m_entryList.count()) {
-            while (m_entryList.last()->type() == AbstractEntry::SeparatorType) {
-                m_entryList.removeLast();
-                --m_separatorCount;
-            }
-        }
+        removeTrailingSeparators(collector);
 
         if (m_sorted) {
-            sortEntries();
-        }
-
-        if (m_paginate) {
-            QList<AbstractEntry *> groups;
-
-            int at = 0;
-            QList<AbstractEntry *> page;
-
-            foreach(AbstractEntry *app, m_entryList) {
-                page.append(app);
-
-                if (at == (m_pageSize - 1)) {
-                    at = 0;
-                    AppsModel *model = new AppsModel(page, true, this);
-                    groups.append(new GroupEntry(this, QString(), QString(), model));
-                    page.clear();
-                } else {
-                    ++at;
-                }
-            }
-
-            if (page.count()) {
-                AppsModel *model = new AppsModel(page, true, this);
-                groups.append(new GroupEntry(this, QString(), QString(), model));
-            }
-
-            m_entryList = groups;
+            sortEntries(collector.entries);
         }
     }
 }
 
-void AppsModel::processServiceGroup(KServiceGroup::Ptr group)
+void AppsModel::processServiceGroup(KServiceGroup::Ptr group, EntryCollector &collector)
 {
     if (!group || !group->isValid()) {
         return;
@@ -651,35 +665,14 @@ void AppsModel::processServiceGroup(KServiceGroup::Ptr group)
             }
 
             if (hiddenApps.contains(service->menuId())) {
-                m_hiddenEntries << service->menuId();
+                collector.hiddenEntries << service->menuId();
 
                 continue;
             }
 
-            bool found = false;
-
-            foreach (const AbstractEntry *entry, m_entryList) {
-                if (entry->type() == AbstractEntry::RunnableType
-                    && static_cast<const AppEntry *>(entry)->service()->storageId() == service->storageId()) {
-                    found = true;
-                    break;
-                }
-            }
-
-            if (!found) {
-                m_entryList << new AppEntry(this, service, m_appNameFormat);
-            }
+            addAppEntry(collector, service);
         } else if (p->isType(KST_KServiceSeparator) && m_showSeparators) {
-            if (!m_entryList.count()) {
-                continue;
-            }
-
-            if (m_entryList.last()->type() == AbstractEntry::SeparatorType) {
-                continue;
-            }
-
-            m_entryList << new SeparatorEntry(this);
-            ++m_separatorCount;
+            addSeparatorEntry(collector);
         } else if (p->isType(KST_KServiceGroup)) {
             const KServiceGroup::Ptr subGroup(static_cast<KServiceGroup*>(p.data()));
 
@@ -690,28 +683,229 @@ void AppsModel::processServiceGroup(KServiceGroup::Ptr group)
             if (m_flat) {
                 m_sorted = true;
                 const KServiceGroup::Ptr serviceGroup(static_cast<KServiceGroup*>(p.data()));
-                processServiceGroup(serviceGroup);
+                processServiceGroup(serviceGroup, collector);
             } else {
-                AppGroupEntry *groupEntry = new AppGroupEntry(this, subGroup, m_paginate, m_pageSize, m_flat,
-                    m_sorted, m_showSeparators, m_appNameFormat);
-                m_entryList << groupEntry;
+                addGroupEntry(collector, subGroup);
+            }
+        }
+    }
+}
+
+void AppsModel::addAppEntry(EntryCollector &collector, const KService::Ptr &service)
+{
+    const QString &storageId = service->storageId();
+
+    if (collector.storageIds.contains(storageId)) {
+        return;
+    }
+
+    collector.storageIds.insert(storageId);
+
+    const QString key = QLatin1String("app:") + storageId;
+    AppEntry *entry = static_cast<AppEntry *>(collector.reusableEntries.take(key));
+
+    if (entry) {
+        if (entry->reload(service, m_appNameFormat)) {
+            collector.changedEntries.insert(entry);
+        }
+    } else {
+        entry = new AppEntry(this, service, m_appNameFormat);
+    }
+
+    collector.entries << entry;
+    collector.keys.insert(entry, key);
+}
+
+void AppsModel::addGroupEntry(EntryCollector &collector, const KServiceGroup::Ptr &group)
+{
+    // The child model is set up with these, a group entry can only be reused if they didn't change
+    const QString key = QStringLiteral("group:%1:%2:%3:%4:%5:%6:%7").arg(group->entryPath(),
+        QString::number(m_paginate), QString::number(m_pageSize), QString::number(m_flat),
+        QString::number(m_sorted), QString::number(m_showSeparators), QString::number(m_appNameFormat));
+    AppGroupEntry *entry = static_cast<AppGroupEntry *>(collector.reusableEntries.take(key));
+
+    if (entry) {
+        if (entry->reload(group)) {
+            collector.changedEntries.insert(entry);
+        }
+    } else {
+        entry = new AppGroupEntry(this, group, m_paginate, m_pageSize, m_flat,
+            m_sorted, m_showSeparators, m_appNameFormat);
+    }
+
+    collector.entries << entry;
+    collector.keys.insert(entry, key);
+}
+
+void AppsModel::addSeparatorEntry(EntryCollector &collector)
+{
+    if (collector.entries.isEmpty()) {
+        return;
+    }
+
+    if (collector.entries.last()->type() == AbstractEntry::SeparatorType) {
+        return;
+    }
+
+    const QString key = QLatin1String("separator:") + collector.keys.value(collector.entries.last());
+    AbstractEntry *entry = collector.reusableEntries.take(key);
+
+    if (!entry) {
+        entry = new SeparatorEntry(this);
+    }
+
+    collector.entries << entry;
+    collector.keys.insert(entry, key);
+    ++collector.separatorCount;
+}
+
+void AppsModel::removeTrailingSeparators(EntryCollector &collector)
+{
+    while (!collector.entries.isEmpty() && collector.entries.last()->type() == AbstractEntry::SeparatorType) {
+        AbstractEntry *entry = collector.entries.takeLast();
+        const QString key = collector.keys.take(entry);
+        --collector.separatorCount;
+
+        if (m_entryKeys.contains(entry)) {
+            // Still in the current entry list, applyEntries() takes care of it
+            collector.reusableEntries.insert(key, entry);
+        } else {
+            delete entry;
+        }
+    }
+}
+
+void AppsModel::applyEntries(const QList<AbstractEntry *> &entries, const QSet<AbstractEntry *> &changedEntries)
+{
+    const QSet<AbstractEntry *> newEntries(entries.constBegin(), entries.constEnd());
+    QList<AbstractEntry *> removedEntries;
+
+    // Remove the entries which are gone, in contiguous ranges from the end
+    for (int last = m_entryList.count() - 1; last >= 0;) {
+        if (newEntries.contains(m_entryList.at(last))) {
+            --last;
+            continue;
+        }
+
+        int first = last;
+
+        while (first > 0 && !newEntries.contains(m_entryList.at(first - 1))) {
+            --first;
+        }
+
+        beginRemoveRows(QModelIndex(), first, last);
+
+        for (int i = last; i >= first; --i) {
+            removedEntries << m_entryList.takeAt(i);
+        }
+
+        endRemoveRows();
+
+        last = first - 1;
+    }
+
+    // The flattened All Applications model of the root model refers to the
+    // application entries of every category until it is built again
+    deleteEntriesLater(removedEntries);
+
+    const QSet<AbstractEntry *> keptEntries(m_entryList.constBegin(), m_entryList.constEnd());
+
+    // Move the kept entries into place and insert the new ones around them
+    for (int row = 0; row < entries.count(); ++row) {
+        AbstractEntry *entry = entries.at(row);
+
+        if (row < m_entryList.count() && m_entryList.at(row) == entry) {
+            continue;
+        }
+
+        if (keptEntries.contains(entry)) {
+            const int from = m_entryList.indexOf(entry, row + 1);
+
+            beginMoveRows(QModelIndex(), from, from, QModelIndex(), row);
+            m_entryList.move(from, row);
+            endMoveRows();
+        } else {
+            int last = row;
+
+            while (last + 1 < entries.count() && !keptEntries.contains(entries.at(last + 1))) {
+                ++last;
+            }
+
+            beginInsertRows(QModelIndex(), row, last);
+
+            for (int i = row; i <= last; ++i) {
+                m_entryList.insert(i, entries.at(i));
             }
+
+            endInsertRows();
+
+            row = last;
         }
     }
+
+    if (changedEntries.isEmpty()) {
+        return;
+    }
+
+    for (int row = 0; row < m_entryList.count(); ++row) {
+        if (!changedEntries.contains(m_entryList.at(row))) {
+            continue;
+        }
+
+        int last = row;
+
+        while (last + 1 < m_entryList.count() && changedEntries.contains(m_entryList.at(last + 1))) {
+            ++last;
+        }
+
+        emit dataChanged(index(row, 0), index(last, 0));
+
+        row = last;
+    }
+}
+
+void AppsModel::deleteEntriesLater(const QList<AbstractEntry *> &entries)
+{
+    if (entries.isEmpty()) {
+        return;
+    }
+
+    // Entries aren't QObjects, tie them to one which is deleted later
+    QObject *guard = new QObject();
+    QObject::connect(guard, &QObject::destroyed, [entries] {
+        qDeleteAll(entries);
+    });
+    guard->deleteLater();
 }
 
-void AppsModel::sortEntries()
+void AppsModel::sortEntries(QList<AbstractEntry *> &entries) const
 {
-    QCollator c;
+    struct SortItem {
+        AbstractEntry::EntryType type;
+        QCollatorSortKey key;
+        AbstractEntry *entry;
+    };
 
-    std::sort(m_entryList.begin(), m_entryList.end(),
-        [&c](AbstractEntry* a, AbstractEntry* b) {
-            if (a->type() != b->type()) {
-                return a->type() > b->type();
+    // Names are compared a lot more often than there are entries
+    std::vector<SortItem> items;
+    items.reserve(entries.count());
+
+    for (AbstractEntry *entry : qAsConst(entries)) {
+        items.push_back({entry->type(), m_catalog->sortKey(entry->name()), entry});
+    }
+
+    std::stable_sort(items.begin(), items.end(),
+        [](const SortItem &a, const SortItem &b) {
+            if (a.type != b.type) {
+                return a.type > b.type;
             } else {
-                return c.compare(a->name(), b->name()) < 0;
+                return a.key.compare(b.key) < 0;
             }
         });
+
+    for (int i = 0; i < entries.count(); ++i) {
+        entries[i] = items[i].entry;
+    }
 }
 
 void AppsModel::checkSycocaChanges(const QStringList &changes)
@@ -25,6 +25,7 @@
 #include "appentry.h"
 
 #include <QQmlParserStatus>
+#include <QSet>
 
 #include <KServiceGroup>
 
@@ -118,18 +119,62 @@ class AppsModel : public AbstractModel, public QQmlParserStatus
 
     protected Q_SLOTS:
         void refresh() override;
+        /**
+         * Called when the applications in the sycoca database changed.
+         */
+        virtual void reloadApplications();
 
     protected:
+        struct EntryCollector {
+            QList<AbstractEntry *> entries;
+            QHash<const AbstractEntry *, QString> keys;
+            // Entries of the previous refresh, by key
+            QHash<QString, AbstractEntry *> reusableEntries;
+            // Reused entries whose data changed
+            QSet<AbstractEntry *> changedEntries;
+            QSet<QString> storageIds;
+            QStringList hiddenEntries;
+            int separatorCount = 0;
+        };
+
         void refreshInternal();
 
+        /**
+         * Collects the entries for the current sycoca database, reusing
+         * the current entries with the same key.
+         */
+        void collectEntries(EntryCollector &collector);
+
+        /**
+         * Turns the current entry list into @p entries by removing, moving
+         * and inserting rows, and deletes the entries which are gone later.
+         */
+        void applyEntries(const QList<AbstractEntry *> &entries, const QSet<AbstractEntry *> &changedEntries);
+
+        /**
+         * Deletes @p entries once control returns to the event loop, along
+         * with the objects whose deletion was scheduled before.
+         */
+        static void deleteEntriesLater(const QList<AbstractEntry *> &entries);
+
+        /**
+         * Sorts groups before applications, each by name.
+         */
+        void sortEntries(QList<AbstractEntry *> &entries) const;
+
+        QSharedPointer<AppCatalog> m_catalog;
+
         bool m_complete;
 
         bool m_paginate;
         int m_pageSize;
 
         QList<AbstractEntry *> m_entryList;
+        // Keys of the entries which were collected from the sycoca database
+        QHash<const AbstractEntry *, QString> m_entryKeys;
         bool m_deleteEntriesOnDestruction;
         int m_separatorCount;
+        QStringList m_hiddenEntries;
         bool m_showSeparators;
         bool m_showTopLevelItems;
 
@@ -139,8 +184,11 @@ class AppsModel : public AbstractModel, public QQmlParserStatus
         void checkSycocaChanges(const QStringList &changes);
 
     private:
-        void processServiceGroup(KServiceGroup::Ptr group);
-        void sortEntries();
+        void processServiceGroup(KServiceGroup::Ptr group, EntryCollector &collector);
+        void addAppEntry(EntryCollector &collector, const KService::Ptr &service);
+        void addGroupEntry(EntryCollector &collector, const KServiceGroup::Ptr &group);
+        void addSeparatorEntry(EntryCollector &collector);
+        void removeTrailingSeparators(EntryCollector &collector);
 
         bool m_autoPopulate;
 
@@ -151,7 +199,6 @@ class AppsModel : public AbstractModel, public QQmlParserStatus
         bool m_flat;
         bool m_sorted;
         AppEntry::NameFormat m_appNameFormat;
-        QStringList m_hiddenEntries;
         static MenuEntryEditor *m_menuEntryEditor;
 };
 
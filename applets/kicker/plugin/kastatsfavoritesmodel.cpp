@@ -192,6 +192,7 @@ public:
               )
         , m_watcher(m_query)
         , m_clientId(clientId)
+        , m_catalog(AppCatalog::instance())
     {
         // Connecting the watcher
         connect(&m_watcher, &ResultWatcher::resultLinked,
@@ -446,6 +447,8 @@ public:
     Query m_query;
     ResultWatcher m_watcher;
     QString m_clientId;
+    // Keeps the lookups of the short-lived entries made to normalize ids
+    QSharedPointer<AppCatalog> m_catalog;
 
     QVector<NormalizedId> m_items;
     QHash<QString, QSharedPointer<AbstractEntry>> m_itemEntries;
@@ -68,6 +68,7 @@ GroupSortProxy::~GroupSortProxy()
 
 InvalidAppsFilterProxy::InvalidAppsFilterProxy(AbstractModel *parentModel, QAbstractItemModel *sourceModel) : QSortFilterProxyModel(parentModel)
 , m_parentModel(parentModel)
+, m_catalog(AppCatalog::instance())
 {
     connect(parentModel, &AbstractModel::favoritesModelChanged, this, &InvalidAppsFilterProxy::connectNewFavoritesModel);
     connectNewFavoritesModel();
@@ -97,7 +98,7 @@ bool InvalidAppsFilterProxy::filterAcceptsRow(int source_row, const QModelIndex
     const QString resource = sourceModel()->index(source_row, 0).data(ResultModel::ResourceRole).toString();
 
     if (resource.startsWith(QLatin1String("applications:"))) {
-        KService::Ptr service = KService::serviceByStorageId(resource.section(QLatin1Char(':'), 1));
+        KService::Ptr service = m_catalog->service(resource.section(QLatin1Char(':'), 1));
 
         KAStatsFavoritesModel* favoritesModel = m_parentModel ? static_cast<KAStatsFavoritesModel *>(m_parentModel->favoritesModel()) : nullptr;
 
@@ -130,6 +131,7 @@ bool GroupSortProxy::lessThan(const QModelIndex &left, const QModelIndex &right)
 
 RecentUsageModel::RecentUsageModel(QObject *parent, IncludeUsage usage, int ordering)
 : ForwardingModel(parent)
+, m_catalog(AppCatalog::instance())
 , m_usage(usage)
 , m_ordering((Ordering)ordering)
 , m_complete(false)
@@ -202,7 +204,7 @@ QVariant RecentUsageModel::data(const QModelIndex &index, int role) const
 QVariant RecentUsageModel::appData(const QString &resource, int role) const
 {
     const QString storageId = resource.section(QLatin1Char(':'), 1);
-    KService::Ptr service = KService::serviceByStorageId(storageId);
+    KService::Ptr service = m_catalog->service(storageId);
 
     QStringList allowedTypes({ QLatin1String("Service"), QLatin1String("Application") });
 
@@ -367,7 +369,7 @@ bool RecentUsageModel::trigger(int row, const QString &actionId, const QVariant
         }
 
         const QString storageId = resource.section(QLatin1Char(':'), 1);
-        KService::Ptr service = KService::serviceByStorageId(storageId);
+        KService::Ptr service = m_catalog->service(storageId);
 
         if (!service) {
             return false;
@@ -416,6 +418,7 @@ bool RecentUsageModel::trigger(int row, const QString &actionId, const QVariant
     } else if (actionId == QLatin1String("_kicker_jumpListAction")) {
         const QString storageId = sourceModel()->data(sourceModel()->index(row, 0), ResultModel::ResourceRole)
                                 .toString().section(QLatin1Char(':'), 1);
+        // Not shared through the catalog, as the command is changed
         KService::Ptr service = KService::serviceByStorageId(storageId);
         service->setExec(argument.toString());
         KIO::ApplicationLauncherJob *job = new KIO::ApplicationLauncherJob(service);
@@ -427,7 +430,7 @@ bool RecentUsageModel::trigger(int row, const QString &actionId, const QVariant
         if (resource.startsWith(QLatin1String("applications:"))) {
             const QString storageId = sourceModel()->data(sourceModel()->index(row, 0),
                 ResultModel::ResourceRole).toString().section(QLatin1Char(':'), 1);
-            KService::Ptr service = KService::serviceByStorageId(storageId);
+            KService::Ptr service = m_catalog->service(storageId);
 
             if (service) {
                 return Kicker::handleRecentDocumentAction(service, actionId, argument);
@@ -20,6 +20,7 @@
 #ifndef RECENTUSAGEMODEL_H
 #define RECENTUSAGEMODEL_H
 
+#include "appcatalog.h"
 #include "forwardingmodel.h"
 
 #include <QQmlParserStatus>
@@ -58,6 +59,7 @@ class InvalidAppsFilterProxy : public QSortFilterProxyModel
 
     private:
         QPointer<AbstractModel> m_parentModel;
+        QSharedPointer<AppCatalog> m_catalog;
 };
 
 class RecentUsageModel : public ForwardingModel, public QQmlParserStatus
@@ -119,6 +121,8 @@ class RecentUsageModel : public ForwardingModel, public QQmlParserStatus
 
         QModelIndex findPlaceForKFileItem(const KFileItem &fileItem) const;
 
+        QSharedPointer<AppCatalog> m_catalog;
+
         IncludeUsage m_usage;
         QPointer<QAbstractItemModel> m_activitiesModel;
 
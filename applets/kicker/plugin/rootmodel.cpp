@@ -26,8 +26,6 @@
 
 #include <KLocalizedString>
 
-#include <QCollator>
-
 GroupEntry::GroupEntry(AppsModel *parentModel, const QString &name,
     const QString &iconName, AbstractModel *childModel)
 : AbstractGroupEntry(parentModel)
@@ -75,6 +73,8 @@ RootModel::RootModel(QObject *parent) : AppsModel(QString(), parent)
 , m_recentAppsModel(nullptr)
 , m_recentDocsModel(nullptr)
 , m_recentContactsModel(nullptr)
+, m_allAppsEntry(nullptr)
+, m_appsBegin(0)
 {
 }
 
@@ -270,131 +270,135 @@ AbstractModel* RootModel::systemFavoritesModel()
     return nullptr;
 }
 
-void RootModel::refresh()
+AppsModel *RootModel::createAllAppsModel(const QList<AbstractEntry *> &appEntries, bool createFavorites)
 {
-    if (!m_complete) {
-        return;
+    if (!m_showAllApps) {
+        return nullptr;
     }
 
-    beginResetModel();
-
-    AppsModel::refreshInternal();
-
     AppsModel *allModel = nullptr;
-    m_recentAppsModel = nullptr;
-    m_recentDocsModel = nullptr;
-    m_recentContactsModel = nullptr;
-
-    if (m_showAllApps) {
-        QHash<QString, AbstractEntry *> appsHash;
-
-        std::function<void(AbstractEntry *)> processEntry = [&](AbstractEntry *entry) {
-            if (entry->type() == AbstractEntry::RunnableType) {
-                AppEntry *appEntry = static_cast<AppEntry*>(entry);
-                appsHash.insert(appEntry->service()->menuId(), appEntry);
-            } else if (entry->type() == AbstractEntry::GroupType) {
-                GroupEntry *groupEntry = static_cast<GroupEntry*>(entry);
-                AbstractModel *model = groupEntry->childModel();
-
-                if (!model) {
-                    return;
-                }
-
-                for (int i = 0; i < model->count(); ++i) {
-                    processEntry(static_cast<AbstractEntry*>(model->index(i, 0).internalPointer()));
-                }
+    QHash<QString, AbstractEntry *> appsHash;
+
+    std::function<void(AbstractEntry *)> processEntry = [&](AbstractEntry *entry) {
+        if (entry->type() == AbstractEntry::RunnableType) {
+            AppEntry *appEntry = static_cast<AppEntry*>(entry);
+            appsHash.insert(appEntry->service()->menuId(), appEntry);
+        } else if (entry->type() == AbstractEntry::GroupType) {
+            GroupEntry *groupEntry = static_cast<GroupEntry*>(entry);
+            AbstractModel *model = groupEntry->childModel();
+
+            if (!model) {
+                return;
             }
-        };
 
-        for (AbstractEntry *entry : m_entryList) {
-            processEntry(entry);
+            for (int i = 0; i < model->count(); ++i) {
+                processEntry(static_cast<AbstractEntry*>(model->index(i, 0).internalPointer()));
+            }
         }
+    };
 
-        QList<AbstractEntry *> apps(appsHash.values());
-        QCollator c;
+    for (AbstractEntry *entry : appEntries) {
+        processEntry(entry);
+    }
 
-        std::sort(apps.begin(), apps.end(),
-            [&c](AbstractEntry* a, AbstractEntry* b) {
-                if (a->type() != b->type()) {
-                    return a->type() > b->type();
-                } else {
-                    return c.compare(a->name(), b->name()) < 0;
-                }
-            });
+    QList<AbstractEntry *> apps(appsHash.values());
+    sortEntries(apps);
 
-        if (!m_showAllAppsCategorized && !m_paginate) { // The app list built above goes into a model.
-            allModel = new AppsModel(apps, false, this);
-        } else if (m_paginate) { // We turn the apps list into a subtree of pages.
+    if (!m_showAllAppsCategorized && !m_paginate) { // The app list built above goes into a model.
+        allModel = new AppsModel(apps, false, this);
+    } else if (m_paginate) { // We turn the apps list into a subtree of pages.
+        if (createFavorites) {
             m_favorites = new KAStatsFavoritesModel(this);
             emit favoritesModelChanged();
+        }
 
-            QList<AbstractEntry *> groups;
-
-            int at = 0;
-            QList<AbstractEntry *> page;
-            page.reserve(m_pageSize);
+        QList<AbstractEntry *> groups;
 
-            foreach(AbstractEntry *app, apps) {
-                page.append(app);
+        int at = 0;
+        QList<AbstractEntry *> page;
+        page.reserve(m_pageSize);
 
-                if (at == (m_pageSize - 1)) {
-                    at = 0;
-                    AppsModel *model = new AppsModel(page, false, this);
-                    groups.append(new GroupEntry(this, QString(), QString(), model));
-                    page.clear();
-                } else {
-                    ++at;
-                }
-            }
+        foreach(AbstractEntry *app, apps) {
+            page.append(app);
 
-            if (!page.isEmpty()) {
+            if (at == (m_pageSize - 1)) {
+                at = 0;
                 AppsModel *model = new AppsModel(page, false, this);
                 groups.append(new GroupEntry(this, QString(), QString(), model));
+                page.clear();
+            } else {
+                ++at;
             }
+        }
 
-            groups.prepend(new GroupEntry(this, QString(), QString(), m_favorites));
+        if (!page.isEmpty()) {
+            AppsModel *model = new AppsModel(page, false, this);
+            groups.append(new GroupEntry(this, QString(), QString(), model));
+        }
 
-            allModel = new AppsModel(groups, true, this);
-        } else { // We turn the apps list into a subtree of apps by starting letter.
-            QList<AbstractEntry *> groups;
-            QHash<QString, QList<AbstractEntry *>> m_categoryHash;
+        groups.prepend(new GroupEntry(this, QString(), QString(), m_favorites));
 
-            foreach (const AbstractEntry *groupEntry, m_entryList) {
-                AbstractModel *model = groupEntry->childModel();
+        allModel = new AppsModel(groups, true, this);
+    } else { // We turn the apps list into a subtree of apps by starting letter.
+        QList<AbstractEntry *> groups;
+        QHash<QString, QList<AbstractEntry *>> m_categoryHash;
 
-                if (!model) continue;
+        foreach (const AbstractEntry *groupEntry, appEntries) {
+            AbstractModel *model = groupEntry->childModel();
 
-                for (int i = 0; i < model->count(); ++i) {
-                    AbstractEntry *appEntry = static_cast<AbstractEntry *>(model->index(i, 0).internalPointer());
+            if (!model) continue;
 
-                    if (appEntry->name().isEmpty()) {
-                        continue;
-                    }
+            for (int i = 0; i < model->count(); ++i) {
+                AbstractEntry *appEntry = static_cast<AbstractEntry *>(model->index(i, 0).internalPointer());
 
-                    const QChar &first = appEntry->name().at(0).toUpper();
-                    m_categoryHash[first.isDigit() ? QStringLiteral("0-9") : first].append(appEntry);
+                if (appEntry->name().isEmpty()) {
+                    continue;
                 }
-            }
-
-            QHashIterator<QString, QList<AbstractEntry *>> i(m_categoryHash);
 
-            while (i.hasNext()) {
-                i.next();
-                AppsModel *model = new AppsModel(i.value(), false, this);
-                model->setDescription(i.key());
-                groups.append(new GroupEntry(this, i.key(), QString(), model));
+                const QChar &first = appEntry->name().at(0).toUpper();
+                m_categoryHash[first.isDigit() ? QStringLiteral("0-9") : first].append(appEntry);
             }
+        }
+
+        QHashIterator<QString, QList<AbstractEntry *>> i(m_categoryHash);
 
-            allModel = new AppsModel(groups, true, this);
+        while (i.hasNext()) {
+            i.next();
+            AppsModel *model = new AppsModel(i.value(), false, this);
+            model->setDescription(i.key());
+            groups.append(new GroupEntry(this, i.key(), QString(), model));
         }
 
-        allModel->setDescription(QStringLiteral("KICKER_ALL_MODEL")); // Intentionally no i18n.
+        allModel = new AppsModel(groups, true, this);
+    }
+
+    allModel->setDescription(QStringLiteral("KICKER_ALL_MODEL")); // Intentionally no i18n.
+
+    return allModel;
+}
+
+void RootModel::refresh()
+{
+    if (!m_complete) {
+        return;
     }
 
+    beginResetModel();
+
+    AppsModel::refreshInternal();
+
+    m_recentAppsModel = nullptr;
+    m_recentDocsModel = nullptr;
+    m_recentContactsModel = nullptr;
+    m_allAppsEntry = nullptr;
+
+    AppsModel *allModel = createAllAppsModel(m_entryList, true /* createFavorites */);
+
     int separatorPosition = 0;
 
     if (allModel) {
-        m_entryList.prepend(new GroupEntry(this, i18n("All Applications"), QString("applications-all"), allModel));
+        m_allAppsEntry = new GroupEntry(this, i18n("All Applications"), QString("applications-all"), allModel);
+        m_entryList.prepend(m_allAppsEntry);
         ++separatorPosition;
     }
 
@@ -430,9 +434,12 @@ void RootModel::refresh()
         ++separatorPosition;
     }
 
+    m_appsBegin = separatorPosition;
+
     if (m_showSeparators && separatorPosition > 0) {
         m_entryList.insert(separatorPosition, new SeparatorEntry(this));
         ++m_separatorCount;
+        ++m_appsBegin;
     }
 
     m_systemModel = new SystemModel(this);
@@ -451,3 +458,84 @@ void RootModel::refresh()
 
     emit refreshed();
 }
+
+void RootModel::reloadApplications()
+{
+    if (!m_complete) {
+        return;
+    }
+
+    const int oldCount = m_entryList.count();
+    const int oldSeparatorCount = m_separatorCount;
+
+    // The all applications model refers to the application entries and is built
+    // again. Its deletion is scheduled before refreshing the categories, which
+    // schedules the deletion of the entries that are gone, so it never refers
+    // to deleted entries.
+    QList<AbstractModel *> oldAllModels;
+
+    if (m_allAppsEntry && m_allAppsEntry->childModel()) {
+        AbstractModel *allModel = m_allAppsEntry->childModel();
+
+        for (int i = 0; i < allModel->count(); ++i) {
+            AbstractModel *model = allModel->modelForRow(i);
+
+            if (model && model != m_favorites) {
+                oldAllModels << model;
+            }
+        }
+
+        oldAllModels << allModel;
+    }
+
+    for (AbstractModel *model : qAsConst(oldAllModels)) {
+        model->deleteLater();
+    }
+
+    EntryCollector collector;
+
+    for (auto it = m_entryKeys.constBegin(); it != m_entryKeys.constEnd(); ++it) {
+        collector.reusableEntries.insert(it.value(), const_cast<AbstractEntry *>(it.key()));
+    }
+
+    collectEntries(collector);
+
+    // Keep the recent usage, contacts and power/session entries around the applications
+    const int appsEnd = m_entryList.count() - (m_showPowerSession ? 1 : 0);
+    QList<AbstractEntry *> entries = m_entryList.mid(0, m_appsBegin);
+    entries << collector.entries;
+    entries << m_entryList.mid(appsEnd);
+
+    if (m_allAppsEntry) {
+        AbstractEntry *allAppsEntry = new GroupEntry(this, i18n("All Applications"), QString("applications-all"),
+            createAllAppsModel(collector.entries, false /* createFavorites */));
+        entries.replace(entries.indexOf(m_allAppsEntry), allAppsEntry);
+        m_allAppsEntry = allAppsEntry;
+    }
+
+    m_separatorCount = collector.separatorCount;
+
+    for (int i = 0; i < m_appsBegin; ++i) {
+        if (entries.at(i)->type() == AbstractEntry::SeparatorType) {
+            ++m_separatorCount;
+        }
+    }
+
+    m_hiddenEntries = collector.hiddenEntries;
+
+    applyEntries(entries, collector.changedEntries);
+
+    m_entryKeys = collector.keys;
+
+    m_favorites->refresh();
+
+    if (m_entryList.count() != oldCount) {
+        emit countChanged();
+    }
+
+    if (m_separatorCount != oldSeparatorCount) {
+        emit separatorCountChanged();
+    }
+
+    emit refreshed();
+}
@@ -106,8 +106,11 @@ class RootModel : public AppsModel
 
     protected Q_SLOTS:
         void refresh() override;
+        void reloadApplications() override;
 
     private:
+        AppsModel *createAllAppsModel(const QList<AbstractEntry *> &appEntries, bool createFavorites);
+
         KAStatsFavoritesModel *m_favorites;
         SystemModel *m_systemModel;
 
@@ -122,6 +125,10 @@ class RootModel : public AppsModel
         RecentUsageModel *m_recentAppsModel;
         RecentUsageModel *m_recentDocsModel;
         RecentContactsModel *m_recentContactsModel;
+
+        AbstractEntry *m_allAppsEntry;
+        // Row of the first entry from the sycoca database
+        int m_appsBegin;
 };
 
 #endif
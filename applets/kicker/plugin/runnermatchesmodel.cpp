@@ -24,6 +24,7 @@
 
 #include <QAction>
 #include <QIcon>
+#include <QSet>
 
 #include <KLocalizedString>
 #include <KRunner/RunnerManager>
@@ -34,6 +35,7 @@
 RunnerMatchesModel::RunnerMatchesModel(const QString &runnerId, const QString &name,
     Plasma::RunnerManager *manager, QObject *parent)
 : AbstractModel(parent)
+, m_catalog(AppCatalog::instance())
 , m_runnerId(runnerId)
 , m_name(name)
 , m_runnerManager(manager)
@@ -73,7 +75,7 @@ QVariant RunnerMatchesModel::data(const QModelIndex &index, int role) const
             return QUrl(match.data().toString());
         } else if (runnerId == QLatin1String("recentdocuments")
                    || runnerId == QLatin1String("services")) {
-            KService::Ptr service = KService::serviceByStorageId(match.data().toString());
+            KService::Ptr service = m_catalog->service(match.data().toString());
             if (service) {
                 return QUrl::fromLocalFile(Kicker::resolvedServiceEntryPath(service));
             }
@@ -120,7 +122,7 @@ QVariant RunnerMatchesModel::data(const QModelIndex &index, int role) const
             return actionList;
         }
 
-        const KService::Ptr service = KService::serviceByStorageId(dataUrl.path());
+        const KService::Ptr service = m_catalog->service(dataUrl.path());
         if (service) {
             if (!actionList.isEmpty()) {
                 actionList << Kicker::createSeparatorActionItem();
@@ -185,7 +187,7 @@ bool RunnerMatchesModel::trigger(int row, const QString &actionId, const QVarian
 
     QObject *appletInterface = static_cast<RunnerModel *>(parent())->appletInterface();
 
-    const KService::Ptr service = KService::serviceByStorageId(match.data().toUrl().toString(QUrl::RemoveScheme));
+    const KService::Ptr service = m_catalog->service(match.data().toUrl().toString(QUrl::RemoveScheme));
 
     if (Kicker::handleAddLauncherAction(actionId, appletInterface, service)) {
         return true;
@@ -221,44 +223,140 @@ bool RunnerMatchesModel::trigger(int row, const QString &actionId, const QVarian
     return true;
 }
 
-void RunnerMatchesModel::setMatches(const QList< Plasma::QueryMatch > &matches)
+// Whether a view has to update the row of a match which kept its id
+static bool matchDataDiffers(const Plasma::QueryMatch &a, const Plasma::QueryMatch &b)
 {
-    int oldCount = m_matches.count();
-    int newCount = matches.count();
+    return a.text() != b.text()
+        || a.subtext() != b.subtext()
+        || a.iconName() != b.iconName()
+        || a.icon().cacheKey() != b.icon().cacheKey()
+        || a.data() != b.data()
+        || a.isEnabled() != b.isEnabled();
+}
 
-    bool emitCountChange = (oldCount != newCount);
+static QStringList matchKeys(const QList<Plasma::QueryMatch> &matches)
+{
+    QStringList keys;
+    keys.reserve(matches.count());
 
-    int ceiling = qMin(oldCount, newCount);
-    bool emitDataChange = false;
+    // Ids are not guaranteed to be unique, number the repeated ones
+    QHash<QString, int> occurrences;
 
-    for (int row = 0; row < ceiling; ++row) {
-        if (!(m_matches.at(row) == matches.at(row))) {
-            emitDataChange = true;
-            m_matches[row] = matches.at(row);
+    for (const Plasma::QueryMatch &match : matches) {
+        QString key = match.runner()->id() + QLatin1Char('\n') + match.id();
+        const int occurrence = occurrences[key]++;
+
+        if (occurrence > 0) {
+            key += QLatin1Char('\n') + QString::number(occurrence);
         }
-    }
 
-    if (emitDataChange) {
-        emit dataChanged(index(0, 0), index(ceiling - 1, 0));
+        keys << key;
     }
 
-    if (newCount > oldCount) {
-        beginInsertRows(QModelIndex(), oldCount, newCount - 1);
+    return keys;
+}
 
-        m_matches = matches;
+bool RunnerMatchesModel::setMatches(const QList< Plasma::QueryMatch > &matches)
+{
+    const int oldCount = m_matches.count();
+    const QStringList keys = matchKeys(matches);
+    const QSet<QString> newKeys(keys.constBegin(), keys.constEnd());
+    bool changed = false;
+
+    // Remove the matches which are gone, in contiguous ranges from the end
+    for (int last = m_matchKeys.count() - 1; last >= 0;) {
+        if (newKeys.contains(m_matchKeys.at(last))) {
+            --last;
+            continue;
+        }
 
-        endInsertRows();
-    } else if (newCount < oldCount) {
-        beginRemoveRows(QModelIndex(), newCount, oldCount - 1);
+        int first = last;
 
-        m_matches = matches;
+        while (first > 0 && !newKeys.contains(m_matchKeys.at(first - 1))) {
+            --first;
+        }
+
+        beginRemoveRows(QModelIndex(), first, last);
+
+        for (int i = last; i >= first; --i) {
+            m_matches.removeAt(i);
+            m_matchKeys.removeAt(i);
+        }
 
         endRemoveRows();
+
+        changed = true;
+        last = first - 1;
     }
 
-    if (emitCountChange) {
+    const QSet<QString> keptKeys(m_matchKeys.constBegin(), m_matchKeys.constEnd());
+
+    // Move the kept matches into place and insert the new ones around them
+    for (int row = 0; row < keys.count(); ++row) {
+        const QString &key = keys.at(row);
+
+        if (row < m_matchKeys.count() && m_matchKeys.at(row) == key) {
+            continue;
+        }
+
+        changed = true;
+
+        if (keptKeys.contains(key)) {
+            const int from = m_matchKeys.indexOf(key, row + 1);
+
+            beginMoveRows(QModelIndex(), from, from, QModelIndex(), row);
+            m_matches.move(from, row);
+            m_matchKeys.move(from, row);
+            endMoveRows();
+        } else {
+            int last = row;
+
+            while (last + 1 < keys.count() && !keptKeys.contains(keys.at(last + 1))) {
+                ++last;
+            }
+
+            beginInsertRows(QModelIndex(), row, last);
+
+            for (int i = row; i <= last; ++i) {
+                m_matches.insert(i, matches.at(i));
+                m_matchKeys.insert(i, keys.at(i));
+            }
+
+            endInsertRows();
+
+            row = last;
+        }
+    }
+
+    // The rows are in place now, update the kept matches in contiguous ranges
+    for (int row = 0; row < m_matches.count(); ++row) {
+        if (!matchDataDiffers(m_matches.at(row), matches.at(row))) {
+            // Still take the new match, it is the one the runner manager can run
+            m_matches[row] = matches.at(row);
+            continue;
+        }
+
+        int last = row;
+
+        while (last + 1 < m_matches.count() && matchDataDiffers(m_matches.at(last + 1), matches.at(last + 1))) {
+            ++last;
+        }
+
+        for (int i = row; i <= last; ++i) {
+            m_matches[i] = matches.at(i);
+        }
+
+        emit dataChanged(index(row, 0), index(last, 0));
+
+        changed = true;
+        row = last;
+    }
+
+    if (m_matches.count() != oldCount) {
         emit countChanged();
     }
+
+    return changed;
 }
 
 AbstractModel *RunnerMatchesModel::favoritesModel()
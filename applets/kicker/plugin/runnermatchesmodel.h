@@ -22,6 +22,7 @@
 #define RUNNERMATCHESMODEL_H
 
 #include "abstractmodel.h"
+#include "appcatalog.h"
 
 #include <KRunner/QueryMatch>
 
@@ -50,15 +51,24 @@ class RunnerMatchesModel : public AbstractModel
         QString runnerId() const { return m_runnerId; }
         QString name() const { return m_name; }
 
-        void setMatches(const QList<Plasma::QueryMatch> &matches);
+        /**
+         * Turns the current matches into @p matches by removing, moving,
+         * inserting and updating only the rows which differ, matches are
+         * told apart by their id.
+         * @return whether the model changed
+         */
+        bool setMatches(const QList<Plasma::QueryMatch> &matches);
 
         AbstractModel* favoritesModel() override;
 
     private:
+        QSharedPointer<AppCatalog> m_catalog;
         QString m_runnerId;
         QString m_name;
         Plasma::RunnerManager *m_runnerManager;
         QList<Plasma::QueryMatch> m_matches;
+        // Keys of m_matches, from their runner and id
+        QStringList m_matchKeys;
 };
 
 #endif
@@ -20,12 +20,14 @@
 
 #include "runnermodel.h"
 #include "runnermatchesmodel.h"
+#include "debug.h"
 
 #include <QSet>
 
 #include <KLocalizedString>
 #include <KRunner/AbstractRunner>
 #include <KRunner/RunnerManager>
+#include <krunner_version.h>
 
 RunnerModel::RunnerModel(QObject *parent) : QAbstractListModel(parent)
 , m_favoritesModel(nullptr)
@@ -33,6 +35,9 @@ RunnerModel::RunnerModel(QObject *parent) : QAbstractListModel(parent)
 , m_runnerManager(nullptr)
 , m_mergeResults(false)
 , m_deleteWhenEmpty(false)
+, m_batchCount(0)
+, m_firstResultsTime(-1)
+, m_stableResultsTime(-1)
 {
     m_queryTimer.setSingleShot(true);
     m_queryTimer.setInterval(10);
@@ -206,11 +211,44 @@ void RunnerModel::startQuery()
 
     createManager();
 
+    m_queryClock.start();
+    m_batchCount = 0;
+    m_firstResultsTime = -1;
+    m_stableResultsTime = -1;
+
     m_runnerManager->launchQuery(m_query);
 }
 
 void RunnerModel::matchesChanged(const QList<Plasma::QueryMatch> &matches)
 {
+    ++m_batchCount;
+
+    if (updateModels(matches) && m_queryClock.isValid()) {
+        m_stableResultsTime = m_queryClock.elapsed();
+
+        if (m_firstResultsTime < 0 && !matches.isEmpty()) {
+            m_firstResultsTime = m_stableResultsTime;
+        }
+    }
+}
+
+void RunnerModel::queryFinished()
+{
+    if (!m_queryClock.isValid()) {
+        return;
+    }
+
+    qCDebug(KICKER_DEBUG) << "Query" << m_query << "finished after" << m_queryClock.elapsed() << "ms:"
+        << m_batchCount << "batches, first results after" << m_firstResultsTime
+        << "ms, stable results after" << m_stableResultsTime << "ms";
+
+    m_queryClock.invalidate();
+}
+
+bool RunnerModel::updateModels(const QList<Plasma::QueryMatch> &matches)
+{
+    bool changed = false;
+
     // Group matches by runner.
     // We do not use a QMultiHash here because it keeps values in LIFO order, while we want FIFO.
     QHash<QString, QList<Plasma::QueryMatch> > matchesForRunner;
@@ -242,6 +280,8 @@ void RunnerModel::matchesChanged(const QList<Plasma::QueryMatch> &matches)
             m_models.append(matchesModel);
             endInsertRows();
             emit countChanged();
+
+            changed = true;
         } else {
             matchesModel = m_models.at(0);
         }
@@ -252,9 +292,7 @@ void RunnerModel::matchesChanged(const QList<Plasma::QueryMatch> &matches)
             matches.append(matchesForRunner.take(runnerId));
         }
 
-        matchesModel->setMatches(matches);
-
-        return;
+        return matchesModel->setMatches(matches) || changed;
     }
 
     // Assign matches to existing models. If there is no match for a model, delete it.
@@ -268,8 +306,10 @@ void RunnerModel::matchesChanged(const QList<Plasma::QueryMatch> &matches)
             delete matchesModel;
             endRemoveRows();
             emit countChanged();
-        } else {
-            matchesModel->setMatches(matches);
+
+            changed = true;
+        } else if (matchesModel->setMatches(matches)) {
+            changed = true;
         }
     }
 
@@ -303,7 +343,11 @@ void RunnerModel::matchesChanged(const QList<Plasma::QueryMatch> &matches)
             endInsertRows();
             emit countChanged();
         }
+
+        changed = true;
     }
+
+    return changed;
 }
 
 void RunnerModel::createManager()
@@ -313,6 +357,11 @@ void RunnerModel::createManager()
         m_runnerManager->setAllowedRunners(m_runners);
         connect(m_runnerManager, &Plasma::RunnerManager::matchesChanged,
                 this, &RunnerModel::matchesChanged);
+#if KRUNNER_VERSION >= QT_VERSION_CHECK(5, 75, 0)
+        // Older versions don't tell, the timing of the query just isn't logged then
+        connect(m_runnerManager, &Plasma::RunnerManager::queryFinished,
+                this, &RunnerModel::queryFinished);
+#endif
     }
 }
 
@@ -323,6 +372,8 @@ void RunnerModel::clear()
         m_runnerManager->matchSessionComplete();
     }
 
+    m_queryClock.invalidate();
+
     if (m_models.isEmpty()) {
         return;
     }
@@ -24,6 +24,7 @@
 #include "abstractmodel.h"
 
 #include <QAbstractListModel>
+#include <QElapsedTimer>
 #include <QTimer>
 
 #include <KRunner/QueryMatch>
@@ -89,8 +90,11 @@ class RunnerModel : public QAbstractListModel
     private Q_SLOTS:
         void startQuery();
         void matchesChanged(const QList<Plasma::QueryMatch> &matches);
+        void queryFinished();
 
     private:
+        // @return whether the visible results changed
+        bool updateModels(const QList<Plasma::QueryMatch> &matches);
         void createManager();
         void clear();
 
@@ -103,6 +107,12 @@ class RunnerModel : public QAbstractListModel
         QTimer m_queryTimer;
         bool m_mergeResults;
         bool m_deleteWhenEmpty;
+
+        // Time from launching the query to the batches of matches
+        QElapsedTimer m_queryClock;
+        int m_batchCount;
+        qint64 m_firstResultsTime;
+        qint64 m_stableResultsTime;
 };
 
 #endif
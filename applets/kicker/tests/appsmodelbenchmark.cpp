@@ -0,0 +1,331 @@
+/***************************************************************************
+ *   Copyright 2020 by the Plasma Workspace authors                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+// Builds a sycoca database with a synthetic application menu in the test
+// locations and measures how AppsModel follows changes to it, compared to
+// building the model from scratch.
+//
+// Example: appsmodelbenchmark --apps 2000 --categories 20 --iterations 30
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QThread>
+
+#include <KService>
+#include <KSycoca>
+
+#include "appsmodel.h"
+
+struct SignalCounter {
+    int insertedRows = 0;
+    int removedRows = 0;
+    int movedRows = 0;
+    int changedRows = 0;
+    int resets = 0;
+
+    void watch(QAbstractItemModel *model)
+    {
+        QObject::connect(model, &QAbstractItemModel::rowsInserted, [this](const QModelIndex &, int first, int last) {
+            insertedRows += last - first + 1;
+        });
+        QObject::connect(model, &QAbstractItemModel::rowsRemoved, [this](const QModelIndex &, int first, int last) {
+            removedRows += last - first + 1;
+        });
+        QObject::connect(model, &QAbstractItemModel::rowsMoved, [this](const QModelIndex &, int first, int last) {
+            movedRows += last - first + 1;
+        });
+        QObject::connect(model, &QAbstractItemModel::dataChanged, [this](const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+            changedRows += bottomRight.row() - topLeft.row() + 1;
+        });
+        QObject::connect(model, &QAbstractItemModel::modelReset, [this] {
+            ++resets;
+        });
+    }
+};
+
+struct Result {
+    int count = 0;
+    qint64 updateNs = 0;
+    qint64 rebuildNs = 0;
+    int keptChildModels = 0;
+    int childModels = 0;
+};
+
+class Benchmark
+{
+public:
+    Benchmark(int apps, int categories)
+        : m_apps(apps)
+        , m_categories(categories)
+        , m_applicationsDir(QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QLatin1String("/applications"))
+        , m_appDir(m_applicationsDir + QLatin1String("/kicker-benchmark"))
+    {
+    }
+
+    bool setUp()
+    {
+        QDir(m_appDir).removeRecursively();
+
+        if (!QDir().mkpath(m_appDir)) {
+            return false;
+        }
+
+        for (int i = 0; i < m_apps; ++i) {
+            writeApp(i, QStringLiteral("Application %1").arg(i, 5, 10, QLatin1Char('0')));
+        }
+
+        const QString menuDir = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + QLatin1String("/menus");
+        QDir().mkpath(menuDir);
+
+        QFile menu(menuDir + QLatin1String("/applications.menu"));
+        if (!menu.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+
+        QTextStream stream(&menu);
+        stream << "<!DOCTYPE Menu PUBLIC \"-//freedesktop//DTD Menu 1.0//EN\" "
+                  "\"http://www.freedesktop.org/standards/menu-spec/1.0/menu.dtd\">\n"
+               << "<Menu>\n  <Name>Applications</Name>\n  <AppDir>" << m_appDir << "</AppDir>\n";
+        for (int i = 0; i < m_categories; ++i) {
+            stream << "  <Menu><Name>" << category(i) << "</Name><Include><Category>"
+                   << category(i) << "</Category></Include></Menu>\n";
+        }
+        stream << "</Menu>\n";
+
+        return rebuildSycoca(QStringLiteral("app%1.desktop").arg(m_apps - 1), true);
+    }
+
+    void tearDown()
+    {
+        QDir(m_appDir).removeRecursively();
+    }
+
+    QString category(int i) const
+    {
+        return QStringLiteral("BenchmarkCategory%1").arg(i);
+    }
+
+    void writeApp(int i, const QString &name)
+    {
+        QFile file(m_appDir + QStringLiteral("/app%1.desktop").arg(i));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qFatal("Failed to write %s", qPrintable(file.fileName()));
+        }
+
+        QTextStream stream(&file);
+        stream << "[Desktop Entry]\nType=Application\nName=" << name << "\nGenericName=Benchmark application\n"
+               << "Exec=true\nIcon=applications-other\nCategories=" << category(i % m_categories) << ";\n";
+    }
+
+    void removeApp(int i)
+    {
+        QFile::remove(m_appDir + QStringLiteral("/app%1.desktop").arg(i));
+    }
+
+    // Waits until the database shows the change to the service with @p storageId
+    bool rebuildSycoca(const QString &storageId, bool exists)
+    {
+        for (int attempt = 0; attempt < 3; ++attempt) {
+            // Changing the subdirectory doesn't change the time stamp of the directory sycoca knows about
+            QFile stamp(m_applicationsDir + QLatin1String("/.kicker-benchmark-stamp"));
+            stamp.open(QIODevice::WriteOnly);
+            stamp.remove();
+
+            KSycoca::self()->ensureCacheValid();
+
+            if (static_cast<bool>(KService::serviceByStorageId(storageId)) == exists) {
+                return true;
+            }
+
+            // The time stamps might not have advanced yet
+            QThread::msleep(1000);
+        }
+
+        return false;
+    }
+
+private:
+    const int m_apps;
+    const int m_categories;
+    const QString m_applicationsDir;
+    const QString m_appDir;
+};
+
+static QList<AbstractModel *> childModels(AppsModel *model)
+{
+    QList<AbstractModel *> models;
+
+    for (int i = 0; i < model->count(); ++i) {
+        models << model->modelForRow(i);
+    }
+
+    return models;
+}
+
+static AppsModel *createModel(QObject *appletInterface)
+{
+    AppsModel *model = new AppsModel();
+    model->setAppletInterface(appletInterface);
+    model->componentComplete();
+    return model;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption appsOption(QStringLiteral("apps"), QStringLiteral("Number of applications"), QStringLiteral("count"), QStringLiteral("2000"));
+    QCommandLineOption categoriesOption(QStringLiteral("categories"), QStringLiteral("Number of menu categories"), QStringLiteral("count"), QStringLiteral("20"));
+    QCommandLineOption iterationsOption(QStringLiteral("iterations"), QStringLiteral("Number of changes to the database"), QStringLiteral("count"), QStringLiteral("30"));
+    parser.addOptions({appsOption, categoriesOption, iterationsOption});
+    parser.process(app);
+
+    const int apps = qMax(1, parser.value(appsOption).toInt());
+    const int categories = qBound(1, parser.value(categoriesOption).toInt(), apps);
+    const int iterations = qMax(1, parser.value(iterationsOption).toInt());
+
+    // Keep away from the user's menu and sycoca database
+    QStandardPaths::setTestModeEnabled(true);
+    qunsetenv("XDG_MENU_PREFIX");
+
+    QTextStream out(stdout);
+
+    Benchmark benchmark(apps, categories);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!benchmark.setUp()) {
+        qCritical() << "Failed to set up the sycoca database";
+        return 1;
+    }
+
+    out << "Built sycoca database with " << apps << " applications in " << categories
+        << " categories in " << timer.elapsed() << " ms\n";
+
+    // Only needs to exist, AppsModel doesn't populate without an applet
+    QObject appletInterface;
+
+    timer.restart();
+    AppsModel *model = createModel(&appletInterface);
+    out << "Initial model: " << model->count() << " categories in " << timer.elapsed() << " ms\n\n";
+
+    SignalCounter signalCounter;
+    signalCounter.watch(model);
+    for (AbstractModel *childModel : childModels(model)) {
+        signalCounter.watch(childModel);
+    }
+
+    const QStringList changes = {QStringLiteral("add"), QStringLiteral("rename"), QStringLiteral("remove")};
+    QHash<QString, Result> results;
+
+    int nextApp = apps;
+    QVector<int> addedApps;
+
+    for (int i = 0; i < iterations; ++i) {
+        QString change = changes.at(i % changes.count());
+        if (change == QLatin1String("remove") && addedApps.isEmpty()) {
+            change = QStringLiteral("add");
+        }
+
+        QString storageId;
+        bool exists = true;
+
+        if (change == QLatin1String("add")) {
+            const int id = nextApp++;
+            benchmark.writeApp(id, QStringLiteral("Application %1").arg(id, 5, 10, QLatin1Char('0')));
+            addedApps << id;
+            storageId = QStringLiteral("app%1.desktop").arg(id);
+        } else if (change == QLatin1String("rename")) {
+            const int id = (i * 7919) % apps;
+            benchmark.writeApp(id, QStringLiteral("Renamed Application %1.%2").arg(id).arg(i));
+            storageId = QStringLiteral("app%1.desktop").arg(id);
+        } else {
+            const int id = addedApps.takeFirst();
+            benchmark.removeApp(id);
+            storageId = QStringLiteral("app%1.desktop").arg(id);
+            exists = false;
+        }
+
+        if (!benchmark.rebuildSycoca(storageId, exists)) {
+            qWarning() << "Sycoca database didn't pick up" << change << storageId;
+            continue;
+        }
+
+        // Child models which are gone are only deleted later, so they can be compared
+        const QList<AbstractModel *> oldChildModels = childModels(model);
+
+        timer.restart();
+        static_cast<AbstractModel *>(model)->refresh();
+        const qint64 updateNs = timer.nsecsElapsed();
+
+        const QList<AbstractModel *> newChildModels = childModels(model);
+        const QSet<AbstractModel *> oldChildModelSet(oldChildModels.constBegin(), oldChildModels.constEnd());
+
+        timer.restart();
+        AppsModel *freshModel = createModel(&appletInterface);
+        const qint64 rebuildNs = timer.nsecsElapsed();
+        delete freshModel;
+
+        Result &result = results[change];
+        ++result.count;
+        result.updateNs += updateNs;
+        result.rebuildNs += rebuildNs;
+        result.childModels += newChildModels.count();
+        for (AbstractModel *childModel : newChildModels) {
+            if (oldChildModelSet.contains(childModel)) {
+                ++result.keptChildModels;
+            }
+        }
+
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    }
+
+    out << "change   count   update ms   rebuild ms   kept child models\n";
+    for (const QString &change : changes) {
+        const Result result = results.value(change);
+        if (!result.count) {
+            continue;
+        }
+
+        out << change.leftJustified(8)
+            << QString::number(result.count).rightJustified(5) << "   "
+            << QString::number(result.updateNs / result.count / 1e6, 'f', 2).rightJustified(9) << "   "
+            << QString::number(result.rebuildNs / result.count / 1e6, 'f', 2).rightJustified(10) << "   "
+            << result.keptChildModels << "/" << result.childModels << "\n";
+    }
+
+    out << "\nRows announced by the model and its categories: " << signalCounter.insertedRows << " inserted, "
+        << signalCounter.removedRows << " removed, " << signalCounter.movedRows << " moved, "
+        << signalCounter.changedRows << " changed, " << signalCounter.resets << " resets\n";
+
+    delete model;
+    benchmark.tearDown();
+
+    return 0;
+}
@@ -0,0 +1,41 @@
+/*****************************************************************************
+ * Copyright (C) 2020 by the Plasma Workspace authors                        *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+/**
+* Counts the heap allocations done in the test process, so benchmarks can
+* report how many allocations an update of an ion costs.
+*
+* The counting replaces the global operator new, so it covers the objects
+* created by the ions and the libraries they use. The shared data of the Qt
+* containers and strings is allocated with malloc and is not counted.
+*/
+namespace AllocationCounter
+{
+    /**
+     * @return the number of allocations done since the process started
+     */
+    quint64 count();
+}
+
+#endif
@@ -0,0 +1,130 @@
+/*****************************************************************************
+ * Copyright (C) 2020 by the Plasma Workspace authors                        *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include <QObject>
+#include <QStandardPaths>
+#include <QTest>
+
+#include "../bbcukmet/ion_bbcukmet.h"
+#include "allocationcounter.h"
+#include "replayfixtures.h"
+
+namespace {
+const QString s_weatherSource = QStringLiteral("bbcukmet|weather|London|2643743");
+}
+
+class UKMETReplayTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testReplay();
+    void benchmarkReplay();
+    void benchmarkReplayAllocations();
+};
+
+void UKMETReplayTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    ReplayFixtures::installTimeEngine();
+
+    const QByteArray observation = ReplayFixtures::read(QStringLiteral("bbcukmet_observation_2643743.xml"));
+    QVERIFY(!observation.isEmpty());
+    const QByteArray forecast = ReplayFixtures::read(QStringLiteral("bbcukmet_forecast_2643743.xml"));
+    QVERIFY(!forecast.isEmpty());
+
+    ReplayFixtures::setDocuments({
+        {QUrl(QStringLiteral("https://weather-broker-cdn.api.bbci.co.uk/en/observation/rss/2643743")), observation},
+        {QUrl(QStringLiteral("https://weather-broker-cdn.api.bbci.co.uk/en/forecast/rss/3day/2643743")), forecast},
+    });
+}
+
+void UKMETReplayTest::cleanupTestCase()
+{
+    ReplayFixtures::setDocuments({});
+}
+
+void UKMETReplayTest::testReplay()
+{
+    UKMETIon ion(nullptr, {});
+
+    // goes through the fetcher for the observation and then the forecast, like a real update
+    const Plasma::DataEngine::Data data = ReplayFixtures::replay(&ion, s_weatherSource);
+    QVERIFY(!data.isEmpty());
+
+    QCOMPARE(data.value(QStringLiteral("Place")).toString(), QStringLiteral("London, Greater London"));
+    QCOMPARE(data.value(QStringLiteral("Station")).toString(), QStringLiteral("London, Greater London"));
+    QCOMPARE(data.value(QStringLiteral("Observation Period")).toString(), QStringLiteral("Tuesday - 19:00 BST"));
+    QCOMPARE(data.value(QStringLiteral("Current Conditions")).toString(), QStringLiteral("Light Cloud"));
+    QCOMPARE(data.value(QStringLiteral("Latitude")).toDouble(), 51.5085);
+    QCOMPARE(data.value(QStringLiteral("Longitude")).toDouble(), -0.1257);
+
+    QCOMPARE(data.value(QStringLiteral("Temperature")).toFloat(), 22.0f);
+    QCOMPARE(data.value(QStringLiteral("Humidity")).toFloat(), 48.0f);
+    QCOMPARE(data.value(QStringLiteral("Pressure")).toFloat(), 1017.0f);
+    QCOMPARE(data.value(QStringLiteral("Pressure Tendency")).toString(), QStringLiteral("falling"));
+    QCOMPARE(data.value(QStringLiteral("Wind Speed")).toFloat(), 9.0f);
+    QCOMPARE(data.value(QStringLiteral("Wind Direction")).toString(), QStringLiteral("SW"));
+
+    QCOMPARE(data.value(QStringLiteral("Total Weather Days")).toInt(), 3);
+    // period|icon|summary|high|low|
+    const QStringList tonight = data.value(QStringLiteral("Short Forecast Day 0")).toString().split(QLatin1Char('|'));
+    QCOMPARE(tonight.count(), 6);
+    QCOMPARE(tonight.at(3), QString());
+    QCOMPARE(tonight.at(4), QStringLiteral("14"));
+    const QStringList thursday = data.value(QStringLiteral("Short Forecast Day 2")).toString().split(QLatin1Char('|'));
+    QCOMPARE(thursday.count(), 6);
+    QCOMPARE(thursday.at(3), QStringLiteral("24"));
+    QCOMPARE(thursday.at(4), QStringLiteral("12"));
+    QCOMPARE(data.value(QStringLiteral("Credit Url")).toString(), QStringLiteral("https://www.bbc.co.uk/weather/2643743"));
+
+    const WeatherFetcher::Statistics stats = WeatherFetcher::self()->statistics(QStringLiteral("weather-broker-cdn.api.bbci.co.uk"));
+    QCOMPARE(stats.failures, 0);
+    QCOMPARE(stats.parses, 2);
+}
+
+void UKMETReplayTest::benchmarkReplay()
+{
+    UKMETIon ion(nullptr, {});
+
+    QBENCHMARK {
+        QVERIFY(!ReplayFixtures::replay(&ion, s_weatherSource).isEmpty());
+    }
+}
+
+void UKMETReplayTest::benchmarkReplayAllocations()
+{
+    UKMETIon ion(nullptr, {});
+
+    // The first update also connects to the time engine
+    QVERIFY(!ReplayFixtures::replay(&ion, s_weatherSource).isEmpty());
+
+    const quint64 before = AllocationCounter::count();
+    QVERIFY(!ReplayFixtures::replay(&ion, s_weatherSource).isEmpty());
+    const quint64 allocations = AllocationCounter::count() - before;
+
+    QTest::setBenchmarkResult(allocations, QTest::Events);
+}
+
+QTEST_GUILESS_MAIN(UKMETReplayTest)
+
+#include "bbcukmetreplaytest.moc"
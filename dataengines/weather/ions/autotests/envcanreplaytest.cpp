@@ -0,0 +1,161 @@
+/*****************************************************************************
+ * Copyright (C) 2020 by the Plasma Workspace authors                        *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include <QFile>
+#include <QObject>
+#include <QStandardPaths>
+#include <QTest>
+
+#include "../envcan/ion_envcan.h"
+#include "allocationcounter.h"
+#include "replayfixtures.h"
+
+namespace {
+const QString s_source = QStringLiteral("envcan|weather|Toronto, ON");
+const QUrl s_url(QStringLiteral("http://dd.weatheroffice.ec.gc.ca/citypage_weather/xml/ON/s0000458_e.xml"));
+}
+
+class EnvCanadaReplayTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testReplay();
+    void benchmarkReplay();
+    void benchmarkReplayAllocations();
+};
+
+void EnvCanadaReplayTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    ReplayFixtures::installTimeEngine();
+
+    const QByteArray document = ReplayFixtures::read(QStringLiteral("envcan_s0000458_e.xml"));
+    QVERIFY(!document.isEmpty());
+
+    // A current station catalog keeps the ion from downloading the city list
+    StationCatalog catalog(QStringLiteral("envcan"));
+    catalog.setStations({
+        {QStringLiteral("Toronto, ON"), {QStringLiteral("s0000458"), QStringLiteral("ON"), QStringLiteral("Toronto")}},
+    });
+    QVERIFY(catalog.save());
+
+    ReplayFixtures::setDocuments({{s_url, document}});
+}
+
+void EnvCanadaReplayTest::cleanupTestCase()
+{
+    ReplayFixtures::setDocuments({});
+
+    StationCatalog catalog(QStringLiteral("envcan"));
+    QFile::remove(catalog.cacheFilePath());
+}
+
+void EnvCanadaReplayTest::testReplay()
+{
+    EnvCanadaIon ion(nullptr, {});
+
+    const Plasma::DataEngine::Data data = ReplayFixtures::replay(&ion, s_source);
+    QVERIFY(!data.isEmpty());
+
+    QCOMPARE(data.value(QStringLiteral("Place")).toString(), QStringLiteral("Toronto, ON"));
+    QCOMPARE(data.value(QStringLiteral("Country")).toString(), QStringLiteral("Canada"));
+    QCOMPARE(data.value(QStringLiteral("Region")).toString(), QStringLiteral("City of Toronto"));
+    QCOMPARE(data.value(QStringLiteral("Station")).toString(), QStringLiteral("YYZ"));
+    QCOMPARE(data.value(QStringLiteral("Latitude")).toDouble(), 43.68);
+    QCOMPARE(data.value(QStringLiteral("Longitude")).toDouble(), 79.63);
+    QCOMPARE(data.value(QStringLiteral("Observation Timestamp")).toDateTime(),
+             QDateTime(QDate(2020, 7, 7), QTime(18, 0), Qt::UTC));
+
+    QCOMPARE(data.value(QStringLiteral("Temperature")).toFloat(), 32.1f);
+    QCOMPARE(data.value(QStringLiteral("Dewpoint")).toFloat(), 19.5f);
+    QCOMPARE(data.value(QStringLiteral("Humidex")).toString(), QStringLiteral("39"));
+    QCOMPARE(data.value(QStringLiteral("Pressure")).toFloat(), 101.2f);
+    QCOMPARE(data.value(QStringLiteral("Pressure Tendency")).toString(), QStringLiteral("falling"));
+    QCOMPARE(data.value(QStringLiteral("Visibility")).toFloat(), 24.1f);
+    QCOMPARE(data.value(QStringLiteral("Humidity")).toFloat(), 47.0f);
+    QCOMPARE(data.value(QStringLiteral("Wind Speed")).toFloat(), 19.0f);
+    QCOMPARE(data.value(QStringLiteral("Wind Gust")).toFloat(), 31.0f);
+    QCOMPARE(data.value(QStringLiteral("Wind Direction")).toString(), QStringLiteral("SW"));
+    QCOMPARE(data.value(QStringLiteral("Normal High")).toFloat(), 27.0f);
+    QCOMPARE(data.value(QStringLiteral("Normal Low")).toFloat(), 17.0f);
+    QCOMPARE(data.value(QStringLiteral("UV Index")).toString(), QStringLiteral("8"));
+    QCOMPARE(data.value(QStringLiteral("UV Rating")).toString(), QStringLiteral("very high"));
+
+    QCOMPARE(data.value(QStringLiteral("Total Watches Issued")).toInt(), 0);
+    QCOMPARE(data.value(QStringLiteral("Total Warnings Issued")).toInt(), 1);
+    QCOMPARE(data.value(QStringLiteral("Warning Priority 0")).toString(), QStringLiteral("high"));
+    QCOMPARE(data.value(QStringLiteral("Warning Description 0")).toString(), QStringLiteral("HEAT WARNING  IN EFFECT"));
+    QCOMPARE(data.value(QStringLiteral("Warning Timestamp 0")).toString(), QStringLiteral("10:41 AM EDT Tuesday 07 July 2020"));
+
+    QCOMPARE(data.value(QStringLiteral("Total Weather Days")).toInt(), 3);
+    // period|icon|summary|high|low|probability of precipitation
+    const QStringList today = data.value(QStringLiteral("Short Forecast Day 0")).toString().split(QLatin1Char('|'));
+    QCOMPARE(today.count(), 6);
+    QCOMPARE(today.at(3), QStringLiteral("33"));
+    QCOMPARE(today.at(4), QString());
+    QCOMPARE(today.at(5), QStringLiteral("30"));
+    const QStringList tonight = data.value(QStringLiteral("Short Forecast Day 1")).toString().split(QLatin1Char('|'));
+    QCOMPARE(tonight.count(), 6);
+    QCOMPARE(tonight.at(3), QString());
+    QCOMPARE(tonight.at(4), QStringLiteral("22"));
+    QCOMPARE(tonight.at(5), QString());
+
+    QCOMPARE(data.value(QStringLiteral("Yesterday High")).toFloat(), 31.4f);
+    QCOMPARE(data.value(QStringLiteral("Yesterday Low")).toFloat(), 20.6f);
+    QCOMPARE(data.value(QStringLiteral("Yesterday Precip Total")).toString(), QStringLiteral("0.4"));
+    QCOMPARE(data.value(QStringLiteral("Record High Temperature")).toFloat(), 37.8f);
+    QCOMPARE(data.value(QStringLiteral("Record Low Temperature")).toFloat(), 8.9f);
+    QCOMPARE(data.value(QStringLiteral("Record Rainfall")).toFloat(), 58.7f);
+    QCOMPARE(data.value(QStringLiteral("Credit Url")).toString(), QStringLiteral("https://dd.weather.gc.ca/doc/LICENCE_GENERAL.txt"));
+
+    const WeatherFetcher::Statistics stats = WeatherFetcher::self()->statistics(s_url.host());
+    QCOMPARE(stats.failures, 0);
+    QVERIFY(stats.parses > 0);
+}
+
+void EnvCanadaReplayTest::benchmarkReplay()
+{
+    EnvCanadaIon ion(nullptr, {});
+
+    QBENCHMARK {
+        QVERIFY(!ReplayFixtures::replay(&ion, s_source).isEmpty());
+    }
+}
+
+void EnvCanadaReplayTest::benchmarkReplayAllocations()
+{
+    EnvCanadaIon ion(nullptr, {});
+
+    // The first update also connects to the time engine
+    QVERIFY(!ReplayFixtures::replay(&ion, s_source).isEmpty());
+
+    const quint64 before = AllocationCounter::count();
+    QVERIFY(!ReplayFixtures::replay(&ion, s_source).isEmpty());
+    const quint64 allocations = AllocationCounter::count() - before;
+
+    QTest::setBenchmarkResult(allocations, QTest::Events);
+}
+
+QTEST_GUILESS_MAIN(EnvCanadaReplayTest)
+
+#include "envcanreplaytest.moc"
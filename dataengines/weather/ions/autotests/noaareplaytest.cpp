@@ -0,0 +1,152 @@
+/*****************************************************************************
+ * Copyright (C) 2020 by the Plasma Workspace authors                        *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include <QFile>
+#include <QObject>
+#include <QStandardPaths>
+#include <QTest>
+
+#include "../noaa/ion_noaa.h"
+#include "allocationcounter.h"
+#include "replayfixtures.h"
+
+namespace {
+const QString s_source = QStringLiteral("noaa|weather|New York/La Guardia Airport, NY");
+const QUrl s_observationUrl(QStringLiteral("https://w1.weather.gov/xml/current_obs/KLGA.xml"));
+// requested for the coordinates of the station in the observation
+const QUrl s_forecastUrl(QStringLiteral("https://graphical.weather.gov/xml/sample_products/browser_interface/"
+                                        "ndfdBrowserClientByDay.php?lat=40.7794&lon=-73.8803&format=24+hourly&numDays=7"));
+}
+
+class NOAAReplayTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testReplay();
+    void benchmarkReplay();
+    void benchmarkReplayAllocations();
+};
+
+void NOAAReplayTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    ReplayFixtures::installTimeEngine();
+
+    const QByteArray observation = ReplayFixtures::read(QStringLiteral("noaa_KLGA.xml"));
+    QVERIFY(!observation.isEmpty());
+    const QByteArray forecast = ReplayFixtures::read(QStringLiteral("noaa_forecast_KLGA.xml"));
+    QVERIFY(!forecast.isEmpty());
+
+    // A current station catalog keeps the ion from downloading the station list
+    StationCatalog catalog(QStringLiteral("noaa"));
+    catalog.setStations({
+        {QStringLiteral("New York/La Guardia Airport, NY"),
+         {QStringLiteral("NY"), QStringLiteral("New York/La Guardia Airport"), QStringLiteral("KLGA"),
+          s_observationUrl.toString()}},
+    });
+    QVERIFY(catalog.save());
+
+    ReplayFixtures::setDocuments({
+        {s_observationUrl, observation},
+        {s_forecastUrl, forecast},
+    });
+}
+
+void NOAAReplayTest::cleanupTestCase()
+{
+    ReplayFixtures::setDocuments({});
+
+    StationCatalog catalog(QStringLiteral("noaa"));
+    QFile::remove(catalog.cacheFilePath());
+}
+
+void NOAAReplayTest::testReplay()
+{
+    NOAAIon ion(nullptr, {});
+
+    // goes through the fetcher for the observation and then the forecast, like a real update
+    const Plasma::DataEngine::Data data = ReplayFixtures::replay(&ion, s_source);
+    QVERIFY(!data.isEmpty());
+
+    QCOMPARE(data.value(QStringLiteral("Place")).toString(), QStringLiteral("New York, La Guardia Airport, NY"));
+    QCOMPARE(data.value(QStringLiteral("Station")).toString(), QStringLiteral("KLGA"));
+    QCOMPARE(data.value(QStringLiteral("Latitude")).toDouble(), 40.77944);
+    QCOMPARE(data.value(QStringLiteral("Longitude")).toDouble(), -73.88028);
+    QCOMPARE(data.value(QStringLiteral("Observation Timestamp")).toDateTime(),
+             QDateTime(QDate(2020, 7, 7), QTime(17, 51), Qt::UTC));
+    QCOMPARE(data.value(QStringLiteral("Observation Period")).toString(), QStringLiteral("1:51 pm"));
+
+    QCOMPARE(data.value(QStringLiteral("Temperature")).toFloat(), 88.0f);
+    QCOMPARE(data.value(QStringLiteral("Heat Index")).toFloat(), 92.0f);
+    QCOMPARE(data.value(QStringLiteral("Dewpoint")).toFloat(), 68.0f);
+    QCOMPARE(data.value(QStringLiteral("Pressure")).toFloat(), 29.89f);
+    QCOMPARE(data.value(QStringLiteral("Visibility")).toFloat(), 10.0f);
+    QCOMPARE(data.value(QStringLiteral("Humidity")).toFloat(), 52.0f);
+    QCOMPARE(data.value(QStringLiteral("Wind Speed")).toFloat(), 13.8f);
+    QCOMPARE(data.value(QStringLiteral("Wind Gust")).toFloat(), 0.0f);
+    QCOMPARE(data.value(QStringLiteral("Wind Direction")).toString(), QStringLiteral("SW"));
+    QVERIFY(!data.contains(QStringLiteral("Windchill")));
+
+    QCOMPARE(data.value(QStringLiteral("Total Weather Days")).toInt(), 7);
+    // day|icon|summary|high|low|
+    const QStringList firstDay = data.value(QStringLiteral("Short Forecast Day 0")).toString().split(QLatin1Char('|'));
+    QCOMPARE(firstDay.count(), 6);
+    QCOMPARE(firstDay.at(0), QLocale().toString(7));
+    QCOMPARE(firstDay.at(3), QStringLiteral("91"));
+    QCOMPARE(firstDay.at(4), QStringLiteral("75"));
+    const QStringList lastDay = data.value(QStringLiteral("Short Forecast Day 6")).toString().split(QLatin1Char('|'));
+    QCOMPARE(lastDay.count(), 6);
+    QCOMPARE(lastDay.at(0), QLocale().toString(13));
+    QCOMPARE(lastDay.at(3), QStringLiteral("87"));
+    QCOMPARE(lastDay.at(4), QStringLiteral("74"));
+
+    QCOMPARE(WeatherFetcher::self()->statistics(s_observationUrl.host()).failures, 0);
+    QCOMPARE(WeatherFetcher::self()->statistics(s_forecastUrl.host()).failures, 0);
+}
+
+void NOAAReplayTest::benchmarkReplay()
+{
+    NOAAIon ion(nullptr, {});
+
+    QBENCHMARK {
+        QVERIFY(!ReplayFixtures::replay(&ion, s_source).isEmpty());
+    }
+}
+
+void NOAAReplayTest::benchmarkReplayAllocations()
+{
+    NOAAIon ion(nullptr, {});
+
+    // The first update also connects to the time engine
+    QVERIFY(!ReplayFixtures::replay(&ion, s_source).isEmpty());
+
+    const quint64 before = AllocationCounter::count();
+    QVERIFY(!ReplayFixtures::replay(&ion, s_source).isEmpty());
+    const quint64 allocations = AllocationCounter::count() - before;
+
+    QTest::setBenchmarkResult(allocations, QTest::Events);
+}
+
+QTEST_GUILESS_MAIN(NOAAReplayTest)
+
+#include "noaareplaytest.moc"
@@ -0,0 +1,157 @@
+/*****************************************************************************
+ * Copyright (C) 2020 by the Plasma Workspace authors                        *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+// Implementation of the WeatherFetcher interface for the replay tests, which
+// serves the documents from ReplayFixtures::setDocuments() instead of downloading.
+
+#include "../weatherfetcher.h"
+#include "replayfixtures.h"
+
+#include <KIO/Global>
+
+#include <QPointer>
+#include <QTimer>
+
+namespace {
+QHash<QUrl, QByteArray> s_documents;
+}
+
+void ReplayFixtures::setDocuments(const QHash<QUrl, QByteArray> &documents)
+{
+    s_documents = documents;
+}
+
+class Q_DECL_HIDDEN WeatherFetchReply::Private
+{
+public:
+    QUrl url;
+    QByteArray data;
+    int error = 0;
+    QString errorString;
+};
+
+WeatherFetchReply::WeatherFetchReply(const QUrl &url, QObject *parent)
+    : QObject(parent)
+    , d(new Private)
+{
+    d->url = url;
+}
+
+WeatherFetchReply::~WeatherFetchReply()
+{
+    delete d;
+}
+
+QUrl WeatherFetchReply::url() const
+{
+    return d->url;
+}
+
+QByteArray WeatherFetchReply::data() const
+{
+    return d->data;
+}
+
+int WeatherFetchReply::error() const
+{
+    return d->error;
+}
+
+QString WeatherFetchReply::errorString() const
+{
+    return d->errorString;
+}
+
+bool WeatherFetchReply::isShared() const
+{
+    return false;
+}
+
+void WeatherFetchReply::setParseTime(qint64 msecs)
+{
+    WeatherFetcher::self()->recordParseTime(d->url, msecs);
+}
+
+class Q_DECL_HIDDEN WeatherFetcher::Private
+{
+public:
+    QHash<QString, WeatherFetcher::Statistics> statistics;
+};
+
+WeatherFetcher *WeatherFetcher::self()
+{
+    static WeatherFetcher s_self;
+    return &s_self;
+}
+
+WeatherFetcher::WeatherFetcher()
+    : QObject(nullptr)
+    , d(new Private)
+{
+}
+
+WeatherFetcher::~WeatherFetcher()
+{
+    delete d;
+}
+
+WeatherFetchReply *WeatherFetcher::get(const QUrl &url, QObject *parent, int maxAge)
+{
+    Q_UNUSED(maxAge)
+
+    WeatherFetchReply *reply = new WeatherFetchReply(url, parent);
+
+    Statistics &stats = d->statistics[url.host()];
+    ++stats.requests;
+
+    auto it = s_documents.constFind(url);
+    if (it != s_documents.constEnd()) {
+        reply->d->data = it.value();
+    } else {
+        ++stats.failures;
+        reply->d->error = KIO::ERR_DOES_NOT_EXIST;
+        reply->d->errorString = KIO::buildErrorString(KIO::ERR_DOES_NOT_EXIST, url.toDisplayString());
+    }
+
+    QPointer<WeatherFetchReply> guard(reply);
+    QTimer::singleShot(0, reply, [guard] {
+        if (guard) {
+            emit guard->finished(guard);
+        }
+    });
+    return reply;
+}
+
+QStringList WeatherFetcher::hosts() const
+{
+    return d->statistics.keys();
+}
+
+WeatherFetcher::Statistics WeatherFetcher::statistics(const QString &host) const
+{
+    return d->statistics.value(host);
+}
+
+void WeatherFetcher::recordParseTime(const QUrl &url, qint64 msecs)
+{
+    Statistics &stats = d->statistics[url.host()];
+    ++stats.parses;
+    stats.totalParseTime += msecs;
+    stats.maxParseTime = qMax(stats.maxParseTime, msecs);
+}
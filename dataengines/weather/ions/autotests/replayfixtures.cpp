@@ -0,0 +1,123 @@
+/*****************************************************************************
+ * Copyright (C) 2020 by the Plasma Workspace authors                        *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include "replayfixtures.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTest>
+
+#include <Plasma/PluginLoader>
+
+namespace {
+
+// Stands in for the time engine plugin, which is not available to the tests
+class ReplayTimeEngine : public Plasma::DataEngine
+{
+public:
+    ReplayTimeEngine()
+        : Plasma::DataEngine(nullptr)
+    {
+    }
+
+protected:
+    bool sourceRequestEvent(const QString &source) override
+    {
+        setData(source, QStringLiteral("Corrected Elevation"), 30.0);
+        return true;
+    }
+};
+
+class ReplayPluginLoader : public Plasma::PluginLoader
+{
+protected:
+    Plasma::DataEngine *internalLoadDataEngine(const QString &name) override
+    {
+        if (name == QLatin1String("time")) {
+            return new ReplayTimeEngine;
+        }
+        return nullptr;
+    }
+};
+
+// Collects the data published for a source
+class ReplayReceiver : public QObject
+{
+    Q_OBJECT
+
+public:
+    Plasma::DataEngine::Data data;
+
+public Q_SLOTS:
+    void dataUpdated(const QString &source, const Plasma::DataEngine::Data &data)
+    {
+        Q_UNUSED(source)
+
+        this->data = data;
+        emit updated();
+    }
+
+Q_SIGNALS:
+    void updated();
+};
+
+}
+
+QByteArray ReplayFixtures::read(const QString &fileName)
+{
+    QFile file(QFINDTESTDATA(QString(QLatin1String("fixtures/") + fileName)));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+void ReplayFixtures::installTimeEngine()
+{
+    Plasma::PluginLoader::setPluginLoader(new ReplayPluginLoader);
+}
+
+Plasma::DataEngine::Data ReplayFixtures::replay(Plasma::DataEngine *ion, const QString &source)
+{
+    ReplayReceiver receiver;
+    QSignalSpy updatedSpy(&receiver, &ReplayReceiver::updated);
+
+    ion->connectSource(source, &receiver);
+
+    // All ions publish the forecasts only once nothing is pending anymore
+    QElapsedTimer timer;
+    timer.start();
+    while (!receiver.data.contains(QStringLiteral("Total Weather Days")) && timer.elapsed() < 5000) {
+        updatedSpy.wait(5000 - timer.elapsed());
+    }
+
+    // The unused source is removed shortly after, so the next replay fetches again
+    ion->disconnectSource(source, &receiver);
+    QTest::qWaitFor([ion, &source] {
+        return !ion->sources().contains(source);
+    }, 5000);
+
+    if (!receiver.data.contains(QStringLiteral("Total Weather Days"))) {
+        return Plasma::DataEngine::Data();
+    }
+    return receiver.data;
+}
+
+#include "replayfixtures.moc"
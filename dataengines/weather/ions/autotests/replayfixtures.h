@@ -0,0 +1,63 @@
+/*****************************************************************************
+ * Copyright (C) 2020 by the Plasma Workspace authors                        *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#ifndef REPLAYFIXTURES_H
+#define REPLAYFIXTURES_H
+
+#include <QHash>
+#include <QUrl>
+
+#include <Plasma/DataEngine>
+
+/**
+* Runs an ion offline against recorded provider documents.
+*
+* The replay tests are built with their own implementation of the
+* WeatherFetcher interface instead of the weather_ion library, which serves
+* the documents set here, and with a stand-in for the time engine.
+*/
+class ReplayFixtures
+{
+public:
+    /**
+     * @return the content of @p fileName in the fixtures directory, empty if missing
+     */
+    static QByteArray read(const QString &fileName);
+
+    /**
+     * Serves all requests from @p documents, requests for other urls fail.
+     */
+    static void setDocuments(const QHash<QUrl, QByteArray> &documents);
+
+    /**
+     * Makes the ions get a time engine which reports daylight for every
+     * solar data source. Has to be called before any engine is loaded.
+     */
+    static void installTimeEngine();
+
+    /**
+     * Connects to @p source of @p ion and waits until the ion published
+     * the complete weather data for it.
+     *
+     * @return the published data, empty if it did not arrive in time
+     */
+    static Plasma::DataEngine::Data replay(Plasma::DataEngine *ion, const QString &source);
+};
+
+#endif
@@ -0,0 +1,144 @@
+/*****************************************************************************
+ * Copyright (C) 2020 by the Plasma Workspace authors                        *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include <QFile>
+#include <QObject>
+#include <QStandardPaths>
+#include <QTest>
+
+#include "../stationcatalog.h"
+
+class StationCatalogTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void testNormalize();
+    void testSearch_data();
+    void testSearch();
+    void testRoundTrip();
+    void testStale();
+    void testSourceUrl();
+
+private:
+    static QVector<StationCatalog::Station> testStations();
+};
+
+QVector<StationCatalog::Station> StationCatalogTest::testStations()
+{
+    return {
+        {QStringLiteral("Toronto, ON"), {QStringLiteral("s0000458"), QStringLiteral("ON"), QStringLiteral("Toronto")}},
+        {QStringLiteral("Montréal, QC"), {QStringLiteral("s0000635"), QStringLiteral("QC"), QStringLiteral("Montréal")}},
+        {QStringLiteral("Mont-Laurier, QC"), {QStringLiteral("s0000398"), QStringLiteral("QC"), QStringLiteral("Mont-Laurier")}},
+        {QStringLiteral("Ottawa (Kanata - Orléans), ON"), {QStringLiteral("s0000430"), QStringLiteral("ON"), QStringLiteral("Ottawa (Kanata - Orléans)")}},
+    };
+}
+
+void StationCatalogTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void StationCatalogTest::cleanup()
+{
+    StationCatalog catalog(QStringLiteral("test"));
+    QFile::remove(catalog.cacheFilePath());
+}
+
+void StationCatalogTest::testNormalize()
+{
+    QCOMPARE(StationCatalog::normalize(QStringLiteral("Montréal, QC")), QStringLiteral("montreal, qc"));
+    QCOMPARE(StationCatalog::normalize(QStringLiteral("ORLÉANS")), QStringLiteral("orleans"));
+    QCOMPARE(StationCatalog::normalize(QString()), QString());
+}
+
+void StationCatalogTest::testSearch_data()
+{
+    QTest::addColumn<QString>("term");
+    QTest::addColumn<QStringList>("expected");
+
+    QTest::newRow("prefix") << QStringLiteral("tor") << QStringList{QStringLiteral("Toronto, ON")};
+    QTest::newRow("substring") << QStringLiteral("ronto") << QStringList{QStringLiteral("Toronto, ON")};
+    QTest::newRow("case") << QStringLiteral("TORONTO") << QStringList{QStringLiteral("Toronto, ON")};
+    QTest::newRow("diacritics") << QStringLiteral("montreal") << QStringList{QStringLiteral("Montréal, QC")};
+    QTest::newRow("accented term") << QStringLiteral("orléans") << QStringList{QStringLiteral("Ottawa (Kanata - Orléans), ON")};
+    QTest::newRow("several") << QStringLiteral("mont") << QStringList{QStringLiteral("Montréal, QC"), QStringLiteral("Mont-Laurier, QC")};
+    QTest::newRow("short") << QStringLiteral("qc") << QStringList{QStringLiteral("Montréal, QC"), QStringLiteral("Mont-Laurier, QC")};
+    QTest::newRow("none") << QStringLiteral("vancouver") << QStringList();
+    QTest::newRow("empty") << QString() << QStringList();
+}
+
+void StationCatalogTest::testSearch()
+{
+    QFETCH(QString, term);
+    QFETCH(QStringList, expected);
+
+    StationCatalog catalog(QStringLiteral("test"));
+    catalog.setStations(testStations());
+
+    QCOMPARE(catalog.search(term), expected);
+}
+
+void StationCatalogTest::testRoundTrip()
+{
+    {
+        StationCatalog catalog(QStringLiteral("test"));
+        QVERIFY(!catalog.load());
+        catalog.setStations(testStations(), QStringLiteral("Tue, 07 Jul 2020 10:00:00 GMT"));
+        QVERIFY(catalog.save());
+    }
+
+    StationCatalog catalog(QStringLiteral("test"));
+    QVERIFY(catalog.load());
+    QCOMPARE(catalog.stations().count(), testStations().count());
+    QCOMPARE(catalog.stations().at(1).name, QStringLiteral("Montréal, QC"));
+    QCOMPARE(catalog.stations().at(1).fields, testStations().at(1).fields);
+    QCOMPARE(catalog.lastModified(), QStringLiteral("Tue, 07 Jul 2020 10:00:00 GMT"));
+    QCOMPARE(catalog.search(QStringLiteral("laurier")), QStringList{QStringLiteral("Mont-Laurier, QC")});
+}
+
+void StationCatalogTest::testStale()
+{
+    StationCatalog catalog(QStringLiteral("test"));
+    QVERIFY(catalog.isStale());
+
+    catalog.setStations(testStations());
+    QVERIFY(!catalog.isStale());
+
+    catalog.setStations({});
+    QVERIFY(catalog.isStale());
+}
+
+void StationCatalogTest::testSourceUrl()
+{
+    const QUrl defaultUrl(QStringLiteral("https://example.org/stations.xml"));
+    QCOMPARE(StationCatalog::sourceUrl(QStringLiteral("test"), defaultUrl), defaultUrl);
+
+    qputenv("PLASMA_WEATHER_CATALOG_URL_TEST", QFINDTESTDATA("stationcatalogtest.cpp").toLocal8Bit());
+    QCOMPARE(StationCatalog::sourceUrl(QStringLiteral("test"), defaultUrl),
+             QUrl::fromLocalFile(QFINDTESTDATA("stationcatalogtest.cpp")));
+    qunsetenv("PLASMA_WEATHER_CATALOG_URL_TEST");
+}
+
+QTEST_GUILESS_MAIN(StationCatalogTest)
+
+#include "stationcatalogtest.moc"
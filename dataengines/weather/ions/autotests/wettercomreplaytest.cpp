@@ -0,0 +1,119 @@
+/*****************************************************************************
+ * Copyright (C) 2020 by the Plasma Workspace authors                        *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include <QObject>
+#include <QTest>
+
+#include <KUnitConversion/Unit>
+
+#include "../wetter.com/ion_wettercom.h"
+#include "allocationcounter.h"
+#include "replayfixtures.h"
+
+namespace {
+const QString s_source = QStringLiteral("wettercom|weather|Heidelberg|DE0004329;Heidelberg");
+// the checksum is made from the project name, the api key and the city code
+const QUrl s_url(QStringLiteral("https://api.wetter.com/forecast/weather/city/DE0004329/project/weatherion/cs/89f1264869cce5c6fd5a2db80051f3d8"));
+}
+
+class WetterComReplayTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testReplay();
+    void benchmarkReplay();
+    void benchmarkReplayAllocations();
+};
+
+void WetterComReplayTest::initTestCase()
+{
+    // The ion sorts the forecasts into day and night by the local time
+    qputenv("TZ", "UTC");
+
+    const QByteArray document = ReplayFixtures::read(QStringLiteral("wettercom_DE0004329.xml"));
+    QVERIFY(!document.isEmpty());
+
+    ReplayFixtures::setDocuments({{s_url, document}});
+}
+
+void WetterComReplayTest::cleanupTestCase()
+{
+    ReplayFixtures::setDocuments({});
+}
+
+void WetterComReplayTest::testReplay()
+{
+    WetterComIon ion(nullptr, {});
+
+    const Plasma::DataEngine::Data data = ReplayFixtures::replay(&ion, s_source);
+    QVERIFY(!data.isEmpty());
+
+    QCOMPARE(data.value(QStringLiteral("Place")).toString(), QStringLiteral("Heidelberg"));
+    QCOMPARE(data.value(QStringLiteral("Station")).toString(), QStringLiteral("Heidelberg"));
+    QCOMPARE(data.value(QStringLiteral("Temperature Unit")).toInt(), int(KUnitConversion::Celsius));
+
+    QCOMPARE(data.value(QStringLiteral("Total Weather Days")).toInt(), 4);
+    // period|icon|summary|high|low|probability of precipitation
+    QCOMPARE(data.value(QStringLiteral("Short Forecast Day 0")).toString(),
+             QStringLiteral("Day|weather-few-clouds|few clouds|27|20|10"));
+    QCOMPARE(data.value(QStringLiteral("Short Forecast Day 1")).toString(),
+             QStringLiteral("Night nt|weather-clear-night|clear sky|16|13|0"));
+    QCOMPARE(data.value(QStringLiteral("Short Forecast Day 2")).toString(),
+             QLocale().toString(8) + QStringLiteral("|weather-overcast|overcast|22|14|30"));
+    QCOMPARE(data.value(QStringLiteral("Short Forecast Day 3")).toString(),
+             QLocale().toString(9) + QStringLiteral("|weather-showers-scattered|light rain|20|12|70"));
+
+    QCOMPARE(data.value(QStringLiteral("Credit")).toString(), QStringLiteral("Powered by wetter.com"));
+    QCOMPARE(data.value(QStringLiteral("Credit Url")).toString(),
+             QStringLiteral("https://www.wetter.com/deutschland/heidelberg/DE0004329.html"));
+
+    const WeatherFetcher::Statistics stats = WeatherFetcher::self()->statistics(s_url.host());
+    QCOMPARE(stats.failures, 0);
+    QCOMPARE(stats.parses, 1);
+}
+
+void WetterComReplayTest::benchmarkReplay()
+{
+    WetterComIon ion(nullptr, {});
+
+    QBENCHMARK {
+        QVERIFY(!ReplayFixtures::replay(&ion, s_source).isEmpty());
+    }
+}
+
+void WetterComReplayTest::benchmarkReplayAllocations()
+{
+    WetterComIon ion(nullptr, {});
+
+    QVERIFY(!ReplayFixtures::replay(&ion, s_source).isEmpty());
+
+    const quint64 before = AllocationCounter::count();
+    QVERIFY(!ReplayFixtures::replay(&ion, s_source).isEmpty());
+    const quint64 allocations = AllocationCounter::count() - before;
+
+    QTest::setBenchmarkResult(allocations, QTest::Events);
+}
+
+QTEST_GUILESS_MAIN(WetterComReplayTest)
+
+#include "wettercomreplaytest.moc"
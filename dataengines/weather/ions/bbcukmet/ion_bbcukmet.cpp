@@ -27,6 +27,7 @@
 #include <KUnitConversion/Converter>
 #include <KLocalizedString>
 
+#include <QElapsedTimer>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -309,14 +310,10 @@ void UKMETIon::getXMLData(const QString& source)
 
     const QUrl url(QStringLiteral("https://weather-broker-cdn.api.bbci.co.uk/en/observation/rss/") + m_place[source].stationId);
 
-    KIO::TransferJob* getJob = KIO::get(url, KIO::Reload, KIO::HideProgressInfo);
-    getJob->addMetaData(QStringLiteral("cookies"), QStringLiteral("none")); // Disable displaying cookies
-    m_obsJobXml.insert(getJob, new QXmlStreamReader);
-    m_obsJobList.insert(getJob, source);
+    WeatherFetchReply *reply = WeatherFetcher::self()->get(url, this);
+    m_obsJobList.insert(reply, source);
 
-    connect(getJob, &KIO::TransferJob::data,
-            this, &UKMETIon::observation_slotDataArrived);
-    connect(getJob, &KJob::result,
+    connect(reply, &WeatherFetchReply::finished,
             this, &UKMETIon::observation_slotJobFinished);
 }
 
@@ -350,14 +347,10 @@ void UKMETIon::getFiveDayForecast(const QString& source)
 
     const QUrl url(QStringLiteral("https://weather-broker-cdn.api.bbci.co.uk/en/forecast/rss/3day/") + place.stationId);
 
-    KIO::TransferJob* getJob = KIO::get(url, KIO::Reload, KIO::HideProgressInfo);
-    getJob->addMetaData(QStringLiteral("cookies"), QStringLiteral("none")); // Disable displaying cookies
-    m_forecastJobXml.insert(getJob, new QXmlStreamReader);
-    m_forecastJobList.insert(getJob, source);
+    WeatherFetchReply *reply = WeatherFetcher::self()->get(url, this);
+    m_forecastJobList.insert(reply, source);
 
-    connect(getJob, &KIO::TransferJob::data,
-            this, &UKMETIon::forecast_slotDataArrived);
-    connect(getJob, &KJob::result,
+    connect(reply, &WeatherFetchReply::finished,
             this, &UKMETIon::forecast_slotJobFinished);
 }
 
@@ -442,30 +435,18 @@ void UKMETIon::setup_slotJobFinished(KJob *job)
     m_jobHtml.remove(job);
 }
 
-void UKMETIon::observation_slotDataArrived(KIO::Job *job, const QByteArray &data)
-{
-    QByteArray local = data;
-    if (data.isEmpty() || !m_obsJobXml.contains(job)) {
-        return;
-    }
-
-    // Send to xml.
-    m_obsJobXml[job]->addData(local);
-}
-
-void UKMETIon::observation_slotJobFinished(KJob *job)
+void UKMETIon::observation_slotJobFinished(WeatherFetchReply *reply)
 {
-    const QString source = m_obsJobList.value(job);
+    const QString source = m_obsJobList.take(reply);
     setData(source, Data());
 
-    QXmlStreamReader *reader = m_obsJobXml.value(job);
-    if (reader) {
-        readObservationXMLData(m_obsJobList[job], *reader);
-    }
+    QElapsedTimer parseTimer;
+    parseTimer.start();
+    QXmlStreamReader reader(reply->data());
+    readObservationXMLData(source, reader);
+    reply->setParseTime(parseTimer.elapsed());
 
-    m_obsJobList.remove(job);
-    delete m_obsJobXml[job];
-    m_obsJobXml.remove(job);
+    reply->deleteLater();
 
     if (m_sourcesToReset.contains(source)) {
         m_sourcesToReset.removeAll(source);
@@ -473,28 +454,18 @@ void UKMETIon::observation_slotJobFinished(KJob *job)
     }
 }
 
-void UKMETIon::forecast_slotDataArrived(KIO::Job *job, const QByteArray &data)
+void UKMETIon::forecast_slotJobFinished(WeatherFetchReply *reply)
 {
-    QByteArray local = data;
-    if (data.isEmpty() || !m_forecastJobXml.contains(job)) {
-        return;
-    }
-
-    // Send to xml.
-    m_forecastJobXml[job]->addData(local);
-}
+    const QString source = m_forecastJobList.take(reply);
+    setData(source, Data());
 
-void UKMETIon::forecast_slotJobFinished(KJob *job)
-{
-    setData(m_forecastJobList[job], Data());
-    QXmlStreamReader *reader = m_forecastJobXml.value(job);
-    if (reader) {
-        readFiveDayForecastXMLData(m_forecastJobList[job], *reader);
-    }
+    QElapsedTimer parseTimer;
+    parseTimer.start();
+    QXmlStreamReader reader(reply->data());
+    readFiveDayForecastXMLData(source, reader);
+    reply->setParseTime(parseTimer.elapsed());
 
-    m_forecastJobList.remove(job);
-    delete m_forecastJobXml[job];
-    m_forecastJobXml.remove(job);
+    reply->deleteLater();
 }
 
 void UKMETIon::parsePlaceObservation(const QString &source, WeatherData& data, QXmlStreamReader& xml)
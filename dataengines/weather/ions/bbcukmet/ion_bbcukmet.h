@@ -23,6 +23,7 @@
 #define ION_BBCUKMET_H
 
 #include "../ion.h"
+#include "../weatherfetcher.h"
 
 #include <Plasma/DataEngineConsumer>
 
@@ -110,11 +111,9 @@ private Q_SLOTS:
     void setup_slotJobFinished(KJob *);
     //void setup_slotRedirected(KIO::Job *, const KUrl &url);
 
-    void observation_slotDataArrived(KIO::Job *, const QByteArray &);
-    void observation_slotJobFinished(KJob *);
+    void observation_slotJobFinished(WeatherFetchReply *reply);
 
-    void forecast_slotDataArrived(KIO::Job *, const QByteArray &);
-    void forecast_slotJobFinished(KJob *);
+    void forecast_slotJobFinished(WeatherFetchReply *reply);
 
 private:
     void updateWeather(const QString& source);
@@ -172,11 +171,9 @@ private:
     QHash<KJob *, QByteArray *> m_jobHtml;
     QHash<KJob *, QString> m_jobList;
 
-    QHash<KJob *, QXmlStreamReader*> m_obsJobXml;
-    QHash<KJob *, QString> m_obsJobList;
+    QHash<WeatherFetchReply *, QString> m_obsJobList;
 
-    QHash<KJob *, QXmlStreamReader *> m_forecastJobXml;
-    QHash<KJob *, QString> m_forecastJobList;
+    QHash<WeatherFetchReply *, QString> m_forecastJobList;
 
     QStringList m_sourcesToReset;
 };
@@ -27,6 +27,7 @@
 #include <KUnitConversion/Converter>
 #include <KLocalizedString>
 
+#include <QElapsedTimer>
 #include <QRegularExpression>
 #include <QTimeZone>
 
@@ -63,9 +64,17 @@ WeatherData::ForecastInfo::ForecastInfo()
 // ctor, dtor
 EnvCanadaIon::EnvCanadaIon(QObject *parent, const QVariantList &args)
         : IonInterface(parent, args)
+        , m_catalog(QStringLiteral("envcan"))
 {
+    // Use the cached city list right away, if we have one
+    if (loadStationCatalog()) {
+        setInitialized(true);
+    }
+
     // Get the real city XML URL so we can parse this
-    getXMLSetup();
+    if (m_catalog.isStale()) {
+        getXMLSetup();
+    }
 }
 
 void EnvCanadaIon::deleteForecasts()
@@ -90,7 +99,12 @@ void EnvCanadaIon::reset()
     deleteForecasts();
     emitWhenSetup = true;
     m_sourcesToReset = sources();
-    getXMLSetup();
+
+    if (m_catalog.isStale()) {
+        getXMLSetup();
+    } else {
+        setInitialized(true);
+    }
 }
 
 EnvCanadaIon::~EnvCanadaIon()
@@ -458,13 +472,10 @@ QStringList EnvCanadaIon::validate(const QString& source) const
 {
     QStringList placeList;
 
-    QString sourceNormalized = source.toUpper();
-    QHash<QString, EnvCanadaIon::XMLMapInfo>::const_iterator it = m_places.constBegin();
-    while (it != m_places.constEnd()) {
-        if (it.key().toUpper().contains(sourceNormalized)) {
-            placeList.append(QStringLiteral("place|") + it.key());
-        }
-        ++it;
+    const QStringList places = m_catalog.search(source);
+    placeList.reserve(places.count());
+    for (const QString &place : places) {
+        placeList.append(QStringLiteral("place|") + place);
     }
 
     placeList.sort();
@@ -515,10 +526,17 @@ void EnvCanadaIon::getXMLSetup()
 
     // If network is down, we need to spin and wait
 
-    const QUrl url(QStringLiteral("http://dd.weatheroffice.ec.gc.ca/citypage_weather/xml/siteList.xml"));
+    const QUrl url = StationCatalog::sourceUrl(QStringLiteral("envcan"),
+        QUrl(QStringLiteral("http://dd.weatheroffice.ec.gc.ca/citypage_weather/xml/siteList.xml")));
 
     KIO::TransferJob* getJob = KIO::get(url, KIO::NoReload, KIO::HideProgressInfo);
 
+    // Only download the list again if it changed since we cached it
+    if (!m_catalog.isEmpty() && !m_catalog.lastModified().isEmpty()) {
+        getJob->addMetaData(QStringLiteral("customHTTPHeader"),
+                            QStringLiteral("If-Modified-Since: ") + m_catalog.lastModified());
+    }
+
     m_xmlSetup.clear();
     connect(getJob, &KIO::TransferJob::data,
             this, &EnvCanadaIon::setup_slotDataArrived);
@@ -552,14 +570,10 @@ void EnvCanadaIon::getXMLData(const QString& source)
         return;
     }
 
-    KIO::TransferJob* getJob  = KIO::get(url, KIO::Reload, KIO::HideProgressInfo);
+    WeatherFetchReply *reply = WeatherFetcher::self()->get(url, this);
+    m_jobList.insert(reply, source);
 
-    m_jobXml.insert(getJob, new QXmlStreamReader);
-    m_jobList.insert(getJob, source);
-
-    connect(getJob, &KIO::TransferJob::data,
-            this, &EnvCanadaIon::slotDataArrived);
-    connect(getJob, &KJob::result,
+    connect(reply, &WeatherFetchReply::finished,
             this, &EnvCanadaIon::slotJobFinished);
 }
 
@@ -577,31 +591,20 @@ void EnvCanadaIon::setup_slotDataArrived(KIO::Job *job, const QByteArray &data)
     m_xmlSetup.addData(data);
 }
 
-void EnvCanadaIon::slotDataArrived(KIO::Job *job, const QByteArray &data)
-{
-
-    if (data.isEmpty() || !m_jobXml.contains(job)) {
-        return;
-    }
-
-    // Send to xml.
-    m_jobXml[job]->addData(data);
-}
-
-void EnvCanadaIon::slotJobFinished(KJob *job)
+void EnvCanadaIon::slotJobFinished(WeatherFetchReply *reply)
 {
     // Dual use method, if we're fetching location data to parse we need to do this first
-    const QString source = m_jobList.value(job);
+    const QString source = m_jobList.take(reply);
     //qCDebug(IONENGINE_ENVCAN) << source << m_sourcesToReset.contains(source);
     setData(source, Data());
-    QXmlStreamReader *reader = m_jobXml.value(job);
-    if (reader) {
-        readXMLData(m_jobList[job], *reader);
+    if (!reply->error()) {
+        QElapsedTimer parseTimer;
+        parseTimer.start();
+        QXmlStreamReader reader(reply->data());
+        readXMLData(source, reader);
+        reply->setParseTime(parseTimer.elapsed());
     }
-
-    m_jobList.remove(job);
-    delete m_jobXml[job];
-    m_jobXml.remove(job);
+    reply->deleteLater();
 
     if (m_sourcesToReset.contains(source)) {
         m_sourcesToReset.removeAll(source);
@@ -616,17 +619,75 @@ void EnvCanadaIon::slotJobFinished(KJob *job)
 
 void EnvCanadaIon::setup_slotJobFinished(KJob *job)
 {
-    Q_UNUSED(job)
-    const bool success = readXMLSetup();
+    KIO::TransferJob *transferJob = static_cast<KIO::TransferJob *>(job);
+
+    if (!job->error() && transferJob->queryMetaData(QStringLiteral("responsecode")) == QLatin1String("304")) {
+        // The cached city list is still current
+        m_xmlSetup.clear();
+        m_catalog.markUpToDate();
+        m_catalog.save();
+        setInitialized(!m_places.isEmpty());
+        return;
+    }
+
+    bool success = readXMLSetup();
     m_xmlSetup.clear();
+
+    if (success) {
+        updateStationCatalog(transferJob->queryMetaData(QStringLiteral("modified")));
+    } else {
+        // Keep going with what we had cached, if anything
+        success = !m_places.isEmpty();
+    }
+
     //qCDebug(IONENGINE_ENVCAN) << success << m_sourcesToReset;
     setInitialized(success);
 }
 
+bool EnvCanadaIon::loadStationCatalog()
+{
+    if (!m_catalog.load()) {
+        return false;
+    }
+
+    m_places.clear();
+    const auto stations = m_catalog.stations();
+    for (const StationCatalog::Station &station : stations) {
+        if (station.fields.size() != 3) {
+            continue;
+        }
+
+        XMLMapInfo info;
+        info.cityCode = station.fields.at(0);
+        info.territoryName = station.fields.at(1);
+        info.cityName = station.fields.at(2);
+        m_places.insert(station.name, info);
+    }
+
+    return !m_places.isEmpty();
+}
+
+void EnvCanadaIon::updateStationCatalog(const QString &lastModified)
+{
+    QVector<StationCatalog::Station> stations;
+    stations.reserve(m_places.count());
+
+    for (auto it = m_places.constBegin(); it != m_places.constEnd(); ++it) {
+        StationCatalog::Station station;
+        station.name = it.key();
+        station.fields = QStringList{it->cityCode, it->territoryName, it->cityName};
+        stations.append(station);
+    }
+
+    m_catalog.setStations(stations, lastModified);
+    m_catalog.save();
+}
+
 // Parse the city list and store into a QMap
 bool EnvCanadaIon::readXMLSetup()
 {
     bool success = false;
+    QHash<QString, EnvCanadaIon::XMLMapInfo> places;
     QString territory;
     QString code;
     QString cityName;
@@ -664,13 +725,18 @@ bool EnvCanadaIon::readXMLSetup()
             info.cityName = cityName;
 
             // Set the string list, we will use for the applet to display the available cities.
-            m_places[tmp] = info;
+            places[tmp] = info;
             success = true;
         }
 
     }
 
-    return (success && !m_xmlSetup.error());
+    success = success && !m_xmlSetup.error();
+    if (success) {
+        m_places = places;
+    }
+
+    return success;
 }
 
 void EnvCanadaIon::parseWeatherSite(WeatherData& data, QXmlStreamReader& xml)
@@ -23,6 +23,8 @@
 #define ION_ENVCAN_H
 
 #include "../ion.h"
+#include "../stationcatalog.h"
+#include "../weatherfetcher.h"
 
 #include <Plasma/DataEngineConsumer>
 
@@ -168,8 +170,7 @@ private Q_SLOTS:
     void setup_slotDataArrived(KIO::Job *, const QByteArray &);
     void setup_slotJobFinished(KJob *);
 
-    void slotDataArrived(KIO::Job *, const QByteArray &);
-    void slotJobFinished(KJob *);
+    void slotJobFinished(WeatherFetchReply *reply);
 
 private:
     void updateWeather(const QString& source);
@@ -186,6 +187,8 @@ private:
     // Load and Parse the place XML listing
     void getXMLSetup();
     bool readXMLSetup();
+    bool loadStationCatalog();
+    void updateStationCatalog(const QString &lastModified);
 
     // Load and parse the specific place(s)
     void getXMLData(const QString& source);
@@ -228,18 +231,17 @@ private:
 
     // Key dicts
     QHash<QString, EnvCanadaIon::XMLMapInfo> m_places;
+    StationCatalog m_catalog;
 
     // Weather information
     QHash<QString, WeatherData> m_weatherData;
 
     // Store KIO jobs
-    QHash<KJob *, QXmlStreamReader*> m_jobXml;
-    QHash<KJob *, QString> m_jobList;
+    QHash<WeatherFetchReply *, QString> m_jobList;
     QStringList m_sourcesToReset;
     QXmlStreamReader m_xmlSetup;
 
     bool emitWhenSetup;
-
 };
 
 #endif
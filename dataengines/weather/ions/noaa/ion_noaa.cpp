@@ -27,6 +27,7 @@
 #include <KUnitConversion/Converter>
 #include <KLocalizedString>
 
+#include <QElapsedTimer>
 #include <QLocale>
 #include <QTimeZone>
 
@@ -88,15 +89,32 @@ QMap<QString, IonInterface::WindDirections> const& NOAAIon::windIcons() const
 // ctor, dtor
 NOAAIon::NOAAIon(QObject *parent, const QVariantList &args)
         : IonInterface(parent, args)
+        , m_catalog(QStringLiteral("noaa"))
 {
+    // Use the cached station list right away, if we have one
+    if (loadStationCatalog()) {
+        setInitialized(true);
+    }
+
     // Get the real city XML URL so we can parse this
-    getXMLSetup();
+    if (m_catalog.isStale()) {
+        getXMLSetup();
+    }
 }
 
 void NOAAIon::reset()
 {
     m_sourcesToReset = sources();
-    getXMLSetup();
+
+    if (m_catalog.isStale()) {
+        getXMLSetup();
+        return;
+    }
+
+    setInitialized(true);
+    for (const QString& source : qAsConst(m_sourcesToReset)) {
+        updateSourceEvent(source);
+    }
 }
 
 NOAAIon::~NOAAIon()
@@ -109,24 +127,30 @@ QStringList NOAAIon::validate(const QString& source) const
 {
     QStringList placeList;
     QString station;
-    QString sourceNormalized = source.toUpper();
 
-    QHash<QString, NOAAIon::XMLMapInfo>::const_iterator it = m_places.constBegin();
-    // If the source name might look like a station ID, check these too and return the name
-    bool checkState = source.count() == 2;
+    // If the source name might look like a state, list all of its stations
+    const bool checkState = source.count() == 2;
 
-    while (it != m_places.constEnd()) {
-        if (checkState) {
+    if (checkState) {
+        QHash<QString, NOAAIon::XMLMapInfo>::const_iterator it = m_places.constBegin();
+        while (it != m_places.constEnd()) {
             if (it.value().stateName == source) {
                 placeList.append(QStringLiteral("place|").append(it.key()));
             }
-        } else if (it.key().toUpper().contains(sourceNormalized)) {
-            placeList.append(QStringLiteral("place|").append(it.key()));
-        } else if (it.value().stationID == sourceNormalized) {
-            station = QStringLiteral("place|").append(it.key());
+            ++it;
+        }
+    } else {
+        const QStringList places = m_catalog.search(source);
+        placeList.reserve(places.count());
+        for (const QString& place : places) {
+            placeList.append(QStringLiteral("place|").append(place));
         }
 
-        ++it;
+        // If the source name might look like a station ID, check these too and return the name
+        const QString stationPlace = m_stationIds.value(source.toUpper());
+        if (!stationPlace.isEmpty() && !places.contains(stationPlace)) {
+            station = QStringLiteral("place|").append(stationPlace);
+        }
     }
 
     placeList.sort();
@@ -177,12 +201,21 @@ bool NOAAIon::updateIonSource(const QString& source)
 }
 
 // Parses city list and gets the correct city based on ID number
-void NOAAIon::getXMLSetup() const
+void NOAAIon::getXMLSetup()
 {
-    const QUrl url(QStringLiteral("https://www.weather.gov/data/current_obs/index.xml"));
+    const QUrl url = StationCatalog::sourceUrl(QStringLiteral("noaa"),
+        QUrl(QStringLiteral("https://www.weather.gov/data/current_obs/index.xml")));
 
     KIO::TransferJob* getJob = KIO::get(url, KIO::NoReload, KIO::HideProgressInfo);
 
+    // Only download the list again if it changed since we cached it
+    if (!m_catalog.isEmpty() && !m_catalog.lastModified().isEmpty()) {
+        getJob->addMetaData(QStringLiteral("customHTTPHeader"),
+                            QStringLiteral("If-Modified-Since: ") + m_catalog.lastModified());
+    }
+
+    m_xmlSetup.clear();
+
     connect(getJob, &KIO::TransferJob::data,
             this, &NOAAIon::setup_slotDataArrived);
     connect(getJob, &KJob::result,
@@ -209,13 +242,10 @@ void NOAAIon::getXMLData(const QString& source)
         return;
     }
 
-    KIO::TransferJob* getJob = KIO::get(url, KIO::Reload, KIO::HideProgressInfo);
-    m_jobXml.insert(getJob, new QXmlStreamReader);
-    m_jobList.insert(getJob, source);
+    WeatherFetchReply *reply = WeatherFetcher::self()->get(url, this);
+    m_jobList.insert(reply, source);
 
-    connect(getJob, &KIO::TransferJob::data,
-            this, &NOAAIon::slotDataArrived);
-    connect(getJob, &KJob::result,
+    connect(reply, &WeatherFetchReply::finished,
             this, &NOAAIon::slotJobFinished);
 }
 
@@ -231,38 +261,43 @@ void NOAAIon::setup_slotDataArrived(KIO::Job *job, const QByteArray &data)
     m_xmlSetup.addData(data);
 }
 
-void NOAAIon::slotDataArrived(KIO::Job *job, const QByteArray &data)
-{
-    if (data.isEmpty() || !m_jobXml.contains(job)) {
-        return;
-    }
-
-    // Send to xml.
-    m_jobXml[job]->addData(data);
-}
-
-void NOAAIon::slotJobFinished(KJob *job)
+void NOAAIon::slotJobFinished(WeatherFetchReply *reply)
 {
     // Dual use method, if we're fetching location data to parse we need to do this first
-    const QString source(m_jobList.value(job));
+    const QString source = m_jobList.take(reply);
     removeAllData(source);
-    QXmlStreamReader *reader = m_jobXml.value(job);
-    if (reader) {
-        readXMLData(m_jobList[job], *reader);
+    if (!reply->error()) {
+        QElapsedTimer parseTimer;
+        parseTimer.start();
+        QXmlStreamReader reader(reply->data());
+        readXMLData(source, reader);
+        reply->setParseTime(parseTimer.elapsed());
     }
+    reply->deleteLater();
 
     // Now that we have the longitude and latitude, fetch the seven day forecast.
-    getForecast(m_jobList[job]);
-
-    m_jobList.remove(job);
-    m_jobXml.remove(job);
-    delete reader;
+    getForecast(source);
 }
 
 void NOAAIon::setup_slotJobFinished(KJob *job)
 {
-    Q_UNUSED(job)
-    const bool success = readXMLSetup();
+    KIO::TransferJob *transferJob = static_cast<KIO::TransferJob *>(job);
+
+    bool success = false;
+    if (!job->error() && transferJob->queryMetaData(QStringLiteral("responsecode")) == QLatin1String("304")) {
+        // The cached station list is still current
+        m_catalog.markUpToDate();
+        m_catalog.save();
+        success = !m_places.isEmpty();
+    } else if (readXMLSetup()) {
+        updateStationCatalog(transferJob->queryMetaData(QStringLiteral("modified")));
+        success = true;
+    } else {
+        // Keep going with what we had cached, if anything
+        success = !m_places.isEmpty();
+    }
+    m_xmlSetup.clear();
+
     setInitialized(success);
 
     for (const QString& source : qAsConst(m_sourcesToReset)) {
@@ -358,9 +393,63 @@ void NOAAIon::parseStationList()
     }
 }
 
+bool NOAAIon::loadStationCatalog()
+{
+    if (!m_catalog.load()) {
+        return false;
+    }
+
+    m_places.clear();
+    const auto stations = m_catalog.stations();
+    for (const StationCatalog::Station& station : stations) {
+        if (station.fields.size() != 4) {
+            continue;
+        }
+
+        NOAAIon::XMLMapInfo info;
+        info.stateName = station.fields.at(0);
+        info.stationName = station.fields.at(1);
+        info.stationID = station.fields.at(2);
+        info.XMLurl = station.fields.at(3);
+        m_places.insert(station.name, info);
+    }
+    updateStationIds();
+
+    return !m_places.isEmpty();
+}
+
+void NOAAIon::updateStationCatalog(const QString& lastModified)
+{
+    QVector<StationCatalog::Station> stations;
+    stations.reserve(m_places.count());
+
+    for (auto it = m_places.constBegin(); it != m_places.constEnd(); ++it) {
+        StationCatalog::Station station;
+        station.name = it.key();
+        station.fields = QStringList{it->stateName, it->stationName, it->stationID, it->XMLurl};
+        stations.append(station);
+    }
+
+    m_catalog.setStations(stations, lastModified);
+    m_catalog.save();
+}
+
+void NOAAIon::updateStationIds()
+{
+    m_stationIds.clear();
+    m_stationIds.reserve(m_places.count());
+    for (auto it = m_places.constBegin(); it != m_places.constEnd(); ++it) {
+        m_stationIds.insert(it->stationID.toUpper(), it.key());
+    }
+}
+
 // Parse the city list and store into a QMap
 bool NOAAIon::readXMLSetup()
 {
+    // Keep the current list in case the new one turns out to be broken
+    const QHash<QString, NOAAIon::XMLMapInfo> previousPlaces = m_places;
+    m_places.clear();
+
     bool success = false;
     while (!m_xmlSetup.atEnd()) {
         m_xmlSetup.readNext();
@@ -372,7 +461,15 @@ bool NOAAIon::readXMLSetup()
             }
         }
     }
-    return (!m_xmlSetup.error() && success);
+
+    success = success && !m_xmlSetup.error();
+    if (success) {
+        updateStationIds();
+    } else {
+        m_places = previousPlaces;
+    }
+
+    return success;
 }
 
 void NOAAIon::parseWeatherSite(WeatherData& data, QXmlStreamReader& xml)
@@ -815,39 +912,26 @@ void NOAAIon::getForecast(const QString& source)
                                  QLatin1String("&lon=") + QString::number(lon) +
                                  QLatin1String("&format=24+hourly&numDays=7"));
 
-    KIO::TransferJob* getJob = KIO::get(url, KIO::Reload, KIO::HideProgressInfo);
-    m_jobXml.insert(getJob, new QXmlStreamReader);
-    m_jobList.insert(getJob, source);
+    WeatherFetchReply *reply = WeatherFetcher::self()->get(url, this);
+    m_jobList.insert(reply, source);
 
-    connect(getJob, &KIO::TransferJob::data,
-            this, &NOAAIon::forecast_slotDataArrived);
-    connect(getJob, &KJob::result,
+    connect(reply, &WeatherFetchReply::finished,
             this, &NOAAIon::forecast_slotJobFinished);
 }
 
-void NOAAIon::forecast_slotDataArrived(KIO::Job *job, const QByteArray &data)
-{
-    if (data.isEmpty() || !m_jobXml.contains(job)) {
-        return;
-    }
-
-    // Send to xml.
-    m_jobXml[job]->addData(data);
-}
-
-void NOAAIon::forecast_slotJobFinished(KJob *job)
+void NOAAIon::forecast_slotJobFinished(WeatherFetchReply *reply)
 {
-    QXmlStreamReader *reader = m_jobXml.value(job);
-    const QString source = m_jobList.value(job);
-
-    if (reader) {
-        readForecast(source, *reader);
-        updateWeather(source);
+    const QString source = m_jobList.take(reply);
+
+    if (!reply->error()) {
+        QElapsedTimer parseTimer;
+        parseTimer.start();
+        QXmlStreamReader reader(reply->data());
+        readForecast(source, reader);
+        reply->setParseTime(parseTimer.elapsed());
     }
-
-    m_jobList.remove(job);
-    delete m_jobXml[job];
-    m_jobXml.remove(job);
+    updateWeather(source);
+    reply->deleteLater();
 
     if (m_sourcesToReset.contains(source)) {
         m_sourcesToReset.removeAll(source);
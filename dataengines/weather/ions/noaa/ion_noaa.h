@@ -23,6 +23,8 @@
 #define ION_NOAA_H
 
 #include "../ion.h"
+#include "../stationcatalog.h"
+#include "../weatherfetcher.h"
 
 #include <Plasma/DataEngineConsumer>
 
@@ -111,11 +113,9 @@ private Q_SLOTS:
     void setup_slotDataArrived(KIO::Job *, const QByteArray &);
     void setup_slotJobFinished(KJob *);
 
-    void slotDataArrived(KIO::Job *, const QByteArray &);
-    void slotJobFinished(KJob *);
+    void slotJobFinished(WeatherFetchReply *reply);
 
-    void forecast_slotDataArrived(KIO::Job *, const QByteArray &);
-    void forecast_slotJobFinished(KJob *);
+    void forecast_slotJobFinished(WeatherFetchReply *reply);
 
 private:
     void updateWeather(const QString& source);
@@ -131,8 +131,11 @@ private:
     IonInterface::ConditionIcons getConditionIcon(const QString& weather, bool isDayTime) const;
 
     // Load and Parse the place XML listing
-    void getXMLSetup() const;
+    void getXMLSetup();
     bool readXMLSetup();
+    bool loadStationCatalog();
+    void updateStationCatalog(const QString &lastModified);
+    void updateStationIds();
 
     // Load and parse the specific place(s)
     void getXMLData(const QString& source);
@@ -167,13 +170,15 @@ private:
 
     // Key dicts
     QHash<QString, NOAAIon::XMLMapInfo> m_places;
+    // station id -> key in m_places
+    QHash<QString, QString> m_stationIds;
+    StationCatalog m_catalog;
 
     // Weather information
     QHash<QString, WeatherData> m_weatherData;
 
     // Store KIO jobs
-    QHash<KJob *, QXmlStreamReader*> m_jobXml;
-    QHash<KJob *, QString> m_jobList;
+    QHash<WeatherFetchReply *, QString> m_jobList;
     QXmlStreamReader m_xmlSetup;
 
     // bool emitWhenSetup;
@@ -0,0 +1,262 @@
+/*****************************************************************************
+ * Copyright (C) 2020 by the Plasma Workspace authors                        *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include "stationcatalog.h"
+
+#include "iondebug.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+const quint32 s_cacheMagic = 0x57535443; // "WSTC"
+const qint32 s_cacheVersion = 1;
+// Station lists change only when the providers add or remove stations
+const qint64 s_maxAgeSecs = 7 * 24 * 60 * 60;
+const int s_ngramSize = 3;
+}
+
+class Q_DECL_HIDDEN StationCatalog::Private
+{
+public:
+    void rebuildIndex();
+
+    QString ionName;
+    QVector<Station> stations;
+    QDateTime lastUpdated;
+    QString lastModified;
+
+    // normalized station names, same order as stations
+    QVector<QString> normalizedNames;
+    // trigram of a normalized name -> rows of the stations containing it
+    QHash<QString, QVector<int>> ngrams;
+};
+
+void StationCatalog::Private::rebuildIndex()
+{
+    normalizedNames.clear();
+    ngrams.clear();
+
+    normalizedNames.reserve(stations.count());
+    for (int row = 0; row < stations.count(); ++row) {
+        const QString normalized = StationCatalog::normalize(stations.at(row).name);
+        normalizedNames.append(normalized);
+
+        for (int i = 0; i + s_ngramSize <= normalized.size(); ++i) {
+            QVector<int> &rows = ngrams[normalized.mid(i, s_ngramSize)];
+            // the same trigram can appear several times in one name
+            if (rows.isEmpty() || rows.last() != row) {
+                rows.append(row);
+            }
+        }
+    }
+}
+
+StationCatalog::StationCatalog(const QString &ionName)
+    : d(new Private)
+{
+    d->ionName = ionName;
+}
+
+StationCatalog::~StationCatalog()
+{
+    delete d;
+}
+
+QString StationCatalog::cacheFilePath() const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+        + QLatin1String("/plasma_engine_weather/") + d->ionName + QLatin1String("_stations.cache");
+}
+
+bool StationCatalog::load()
+{
+    QFile file(cacheFilePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_14);
+
+    quint32 magic = 0;
+    qint32 version = 0;
+    stream >> magic >> version;
+    if (magic != s_cacheMagic || version != s_cacheVersion) {
+        qCDebug(IONENGINE) << "Ignoring station cache with unknown format" << file.fileName();
+        return false;
+    }
+
+    QDateTime lastUpdated;
+    QString lastModified;
+    qint32 count = 0;
+    stream >> lastUpdated >> lastModified >> count;
+
+    QVector<Station> stations;
+    stations.reserve(qMax(0, count));
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        Station station;
+        stream >> station.name >> station.fields;
+        stations.append(station);
+    }
+
+    if (stream.status() != QDataStream::Ok || stations.isEmpty()) {
+        qCDebug(IONENGINE) << "Failed to read station cache" << file.fileName();
+        return false;
+    }
+
+    d->stations = stations;
+    d->lastUpdated = lastUpdated;
+    d->lastModified = lastModified;
+    d->rebuildIndex();
+
+    return true;
+}
+
+bool StationCatalog::save() const
+{
+    const QString path = cacheFilePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(IONENGINE) << "Failed to write station cache" << path << file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_14);
+
+    stream << s_cacheMagic << s_cacheVersion
+           << d->lastUpdated << d->lastModified << qint32(d->stations.count());
+    for (const Station &station : qAsConst(d->stations)) {
+        stream << station.name << station.fields;
+    }
+
+    return file.commit();
+}
+
+void StationCatalog::setStations(const QVector<Station> &stations, const QString &lastModified)
+{
+    d->stations = stations;
+    d->lastModified = lastModified;
+    d->lastUpdated = QDateTime::currentDateTimeUtc();
+    d->rebuildIndex();
+}
+
+void StationCatalog::markUpToDate()
+{
+    d->lastUpdated = QDateTime::currentDateTimeUtc();
+}
+
+QVector<StationCatalog::Station> StationCatalog::stations() const
+{
+    return d->stations;
+}
+
+bool StationCatalog::isEmpty() const
+{
+    return d->stations.isEmpty();
+}
+
+bool StationCatalog::isStale() const
+{
+    return d->stations.isEmpty() || !d->lastUpdated.isValid()
+        || d->lastUpdated.secsTo(QDateTime::currentDateTimeUtc()) > s_maxAgeSecs;
+}
+
+QDateTime StationCatalog::lastUpdated() const
+{
+    return d->lastUpdated;
+}
+
+QString StationCatalog::lastModified() const
+{
+    return d->lastModified;
+}
+
+QStringList StationCatalog::search(const QString &term) const
+{
+    QStringList result;
+
+    const QString normalizedTerm = normalize(term);
+    if (normalizedTerm.isEmpty()) {
+        return result;
+    }
+
+    if (normalizedTerm.size() < s_ngramSize) {
+        for (int row = 0; row < d->normalizedNames.count(); ++row) {
+            if (d->normalizedNames.at(row).contains(normalizedTerm)) {
+                result.append(d->stations.at(row).name);
+            }
+        }
+        return result;
+    }
+
+    // Every match contains all trigrams of the term, so only the
+    // stations of its rarest trigram need to be checked
+    const QVector<int> *candidates = nullptr;
+    for (int i = 0; i + s_ngramSize <= normalizedTerm.size(); ++i) {
+        auto it = d->ngrams.constFind(normalizedTerm.mid(i, s_ngramSize));
+        if (it == d->ngrams.constEnd()) {
+            return result;
+        }
+        if (!candidates || it->count() < candidates->count()) {
+            candidates = &it.value();
+        }
+    }
+
+    for (int row : *candidates) {
+        if (d->normalizedNames.at(row).contains(normalizedTerm)) {
+            result.append(d->stations.at(row).name);
+        }
+    }
+
+    return result;
+}
+
+QUrl StationCatalog::sourceUrl(const QString &ionName, const QUrl &defaultUrl)
+{
+    const QString variable = QLatin1String("PLASMA_WEATHER_CATALOG_URL_") + ionName.toUpper();
+    const QString override = qEnvironmentVariable(variable.toLatin1().constData());
+    if (!override.isEmpty()) {
+        return QUrl::fromUserInput(override);
+    }
+    return defaultUrl;
+}
+
+QString StationCatalog::normalize(const QString &text)
+{
+    const QString decomposed = text.normalized(QString::NormalizationForm_KD);
+
+    QString result;
+    result.reserve(decomposed.size());
+    for (const QChar c : decomposed) {
+        if (c.category() != QChar::Mark_NonSpacing) {
+            result.append(c);
+        }
+    }
+
+    return result.toCaseFolded();
+}
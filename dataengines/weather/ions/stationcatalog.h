@@ -0,0 +1,120 @@
+/*****************************************************************************
+ * Copyright (C) 2020 by the Plasma Workspace authors                        *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#ifndef STATIONCATALOG_H
+#define STATIONCATALOG_H
+
+#include <QDateTime>
+#include <QStringList>
+#include <QUrl>
+#include <QVector>
+
+#include "ion_export.h"
+
+/**
+* A persistent list of the weather stations (places) offered by a provider.
+*
+* Ions which need to download a full station list before they can validate
+* places store it in a StationCatalog. The catalog is kept on disk, so the
+* ion can answer validate requests right after startup and only has to
+* refresh the list once it is stale. Searching goes through an index over
+* normalized (case and diacritics folded) place names, so it doesn't need
+* to scan and convert every place name for each request.
+*/
+class ION_EXPORT StationCatalog
+{
+public:
+    struct Station {
+        /// Display name of the place, used as key by the ion, e.g. "Toronto, ON"
+        QString name;
+        /// Ion specific data needed to fetch the weather for this place
+        QStringList fields;
+    };
+
+    /**
+     * @param ionName name of the ion, used for the cache file name
+     */
+    explicit StationCatalog(const QString &ionName);
+    ~StationCatalog();
+
+    /**
+     * Loads the catalog from the on-disk cache.
+     * @return true if a non-empty catalog could be read
+     */
+    bool load();
+
+    /**
+     * Writes the catalog to the on-disk cache.
+     */
+    bool save() const;
+
+    /**
+     * Replaces all stations and rebuilds the search index.
+     * @param lastModified value of the Last-Modified header of the station list, if any
+     */
+    void setStations(const QVector<Station> &stations, const QString &lastModified = QString());
+
+    /**
+     * Marks the catalog as up to date, e.g. when the provider reported the
+     * station list as not modified.
+     */
+    void markUpToDate();
+
+    QVector<Station> stations() const;
+    bool isEmpty() const;
+
+    /**
+     * @return whether the catalog should be refreshed from the provider
+     */
+    bool isStale() const;
+
+    QDateTime lastUpdated() const;
+    QString lastModified() const;
+
+    /**
+     * @return the names of all stations containing @p term, ignoring case and diacritics,
+     * in the order they were added
+     */
+    QStringList search(const QString &term) const;
+
+    QString cacheFilePath() const;
+
+    /**
+     * Returns the url the station list should be downloaded from.
+     *
+     * The environment variable PLASMA_WEATHER_CATALOG_URL_<IONNAME> overrides
+     * @p defaultUrl, so tests can point the ion to a local file instead of the provider.
+     */
+    static QUrl sourceUrl(const QString &ionName, const QUrl &defaultUrl);
+
+    /**
+     * @return @p text case folded and without diacritics
+     */
+    static QString normalize(const QString &text);
+
+private:
+    class Private;
+    Private* const d;
+
+    Q_DISABLE_COPY(StationCatalog)
+};
+
+Q_DECLARE_TYPEINFO(StationCatalog::Station, Q_MOVABLE_TYPE);
+
+#endif
@@ -0,0 +1,266 @@
+/*****************************************************************************
+ * Copyright (C) 2020 by the Plasma Workspace authors                        *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#include "weatherfetcher.h"
+
+#include "iondebug.h"
+
+#include <KIO/Job>
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+
+namespace {
+// Downloaded documents are kept at most this long for reuse
+const qint64 s_maxCacheAgeSecs = 15 * 60;
+// Downloads taking longer than this are logged even without debug output
+const qint64 s_slowFetchMsecs = 5000;
+}
+
+class Q_DECL_HIDDEN WeatherFetchReply::Private
+{
+public:
+    QUrl url;
+    QByteArray data;
+    int error = 0;
+    QString errorString;
+    bool shared = false;
+};
+
+WeatherFetchReply::WeatherFetchReply(const QUrl &url, QObject *parent)
+    : QObject(parent)
+    , d(new Private)
+{
+    d->url = url;
+}
+
+WeatherFetchReply::~WeatherFetchReply()
+{
+    delete d;
+}
+
+QUrl WeatherFetchReply::url() const
+{
+    return d->url;
+}
+
+QByteArray WeatherFetchReply::data() const
+{
+    return d->data;
+}
+
+int WeatherFetchReply::error() const
+{
+    return d->error;
+}
+
+QString WeatherFetchReply::errorString() const
+{
+    return d->errorString;
+}
+
+bool WeatherFetchReply::isShared() const
+{
+    return d->shared;
+}
+
+void WeatherFetchReply::setParseTime(qint64 msecs)
+{
+    WeatherFetcher::self()->recordParseTime(d->url, msecs);
+}
+
+class Q_DECL_HIDDEN WeatherFetcher::Private
+{
+public:
+    struct Download {
+        QByteArray data;
+        QElapsedTimer timer;
+        QVector<QPointer<WeatherFetchReply>> replies;
+    };
+
+    struct CachedDocument {
+        QByteArray data;
+        QDateTime fetched;
+    };
+
+    void finishDownload(const QUrl &url, KJob *job);
+    void pruneCache();
+
+    QHash<QUrl, Download> downloads;
+    QHash<QUrl, CachedDocument> cache;
+    QHash<QString, WeatherFetcher::Statistics> statistics;
+};
+
+void WeatherFetcher::Private::finishDownload(const QUrl &url, KJob *job)
+{
+    auto it = downloads.find(url);
+    if (it == downloads.end()) {
+        return;
+    }
+
+    const Download download = it.value();
+    downloads.erase(it);
+
+    const qint64 elapsed = download.timer.elapsed();
+
+    WeatherFetcher::Statistics &stats = statistics[url.host()];
+    stats.totalFetchTime += elapsed;
+    stats.maxFetchTime = qMax(stats.maxFetchTime, elapsed);
+
+    if (job->error()) {
+        ++stats.failures;
+        qCDebug(IONENGINE) << "Failed to fetch" << url << job->errorString();
+    } else {
+        CachedDocument &document = cache[url];
+        document.data = download.data;
+        document.fetched = QDateTime::currentDateTimeUtc();
+        pruneCache();
+    }
+
+    if (elapsed > s_slowFetchMsecs) {
+        qCInfo(IONENGINE) << "Fetching" << url << "took" << elapsed << "ms";
+    } else {
+        qCDebug(IONENGINE) << "Fetched" << url << "in" << elapsed << "ms for" << download.replies.count() << "requests";
+    }
+
+    for (const QPointer<WeatherFetchReply> &reply : download.replies) {
+        if (!reply) {
+            continue;
+        }
+
+        if (job->error()) {
+            reply->d->error = job->error();
+            reply->d->errorString = job->errorString();
+        } else {
+            reply->d->data = download.data;
+        }
+
+        emit reply->finished(reply);
+    }
+}
+
+void WeatherFetcher::Private::pruneCache()
+{
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+
+    for (auto it = cache.begin(); it != cache.end();) {
+        if (it->fetched.secsTo(now) > s_maxCacheAgeSecs) {
+            it = cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+WeatherFetcher *WeatherFetcher::self()
+{
+    static WeatherFetcher s_self;
+    return &s_self;
+}
+
+WeatherFetcher::WeatherFetcher()
+    : QObject(nullptr)
+    , d(new Private)
+{
+}
+
+WeatherFetcher::~WeatherFetcher()
+{
+    delete d;
+}
+
+WeatherFetchReply *WeatherFetcher::get(const QUrl &url, QObject *parent, int maxAge)
+{
+    WeatherFetchReply *reply = new WeatherFetchReply(url, parent);
+
+    Statistics &stats = d->statistics[url.host()];
+    ++stats.requests;
+
+    auto cacheIt = d->cache.constFind(url);
+    if (cacheIt != d->cache.constEnd() && cacheIt->fetched.secsTo(QDateTime::currentDateTimeUtc()) <= maxAge) {
+        ++stats.sharedReplies;
+
+        reply->d->data = cacheIt->data;
+        reply->d->shared = true;
+
+        QPointer<WeatherFetchReply> guard(reply);
+        QTimer::singleShot(0, reply, [guard] {
+            if (guard) {
+                emit guard->finished(guard);
+            }
+        });
+        return reply;
+    }
+
+    auto downloadIt = d->downloads.find(url);
+    if (downloadIt != d->downloads.end()) {
+        ++stats.sharedReplies;
+
+        reply->d->shared = true;
+        downloadIt->replies.append(reply);
+        return reply;
+    }
+
+    ++stats.downloads;
+
+    Private::Download &download = d->downloads[url];
+    download.timer.start();
+    download.replies.append(reply);
+
+    KIO::TransferJob *getJob = KIO::get(url, KIO::NoReload, KIO::HideProgressInfo);
+    // Let the http cache revalidate stale documents using the provider's expiry and ETag
+    getJob->addMetaData(QStringLiteral("cache"), QStringLiteral("verify"));
+    getJob->addMetaData(QStringLiteral("cookies"), QStringLiteral("none")); // Disable displaying cookies
+
+    connect(getJob, &KIO::TransferJob::data, this, [this, url](KIO::Job *, const QByteArray &data) {
+        auto it = d->downloads.find(url);
+        if (it != d->downloads.end() && !data.isEmpty()) {
+            it->data.append(data);
+        }
+    });
+    connect(getJob, &KJob::result, this, [this, url](KJob *job) {
+        d->finishDownload(url, job);
+    });
+
+    return reply;
+}
+
+QStringList WeatherFetcher::hosts() const
+{
+    return d->statistics.keys();
+}
+
+WeatherFetcher::Statistics WeatherFetcher::statistics(const QString &host) const
+{
+    return d->statistics.value(host);
+}
+
+void WeatherFetcher::recordParseTime(const QUrl &url, qint64 msecs)
+{
+    Statistics &stats = d->statistics[url.host()];
+    ++stats.parses;
+    stats.totalParseTime += msecs;
+    stats.maxParseTime = qMax(stats.maxParseTime, msecs);
+
+    qCDebug(IONENGINE) << "Parsed" << url << "in" << msecs << "ms";
+}
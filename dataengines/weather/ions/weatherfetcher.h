@@ -0,0 +1,143 @@
+/*****************************************************************************
+ * Copyright (C) 2020 by the Plasma Workspace authors                        *
+ *                                                                           *
+ * This library is free software; you can redistribute it and/or             *
+ * modify it under the terms of the GNU Library General Public               *
+ * License as published by the Free Software Foundation; either              *
+ * version 2 of the License, or (at your option) any later version.          *
+ *                                                                           *
+ * This library is distributed in the hope that it will be useful,           *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU         *
+ * Library General Public License for more details.                          *
+ *                                                                           *
+ * You should have received a copy of the GNU Library General Public License *
+ * along with this library; see the file COPYING.LIB.  If not, write to      *
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,      *
+ * Boston, MA 02110-1301, USA.                                               *
+ *****************************************************************************/
+
+#ifndef WEATHERFETCHER_H
+#define WEATHERFETCHER_H
+
+#include <QHash>
+#include <QObject>
+#include <QUrl>
+
+#include "ion_export.h"
+
+class WeatherFetcher;
+
+/**
+* The result of a WeatherFetcher::get() request.
+*
+* The reply is owned by the object passed to WeatherFetcher::get() and
+* should be deleted by it once finished() has been handled.
+*/
+class ION_EXPORT WeatherFetchReply : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~WeatherFetchReply() override;
+
+    QUrl url() const;
+
+    /**
+     * @return the complete document, empty on error
+     */
+    QByteArray data() const;
+
+    /**
+     * @return the KIO error code, 0 on success
+     */
+    int error() const;
+    QString errorString() const;
+
+    /**
+     * @return true if the data came from a download started for another request
+     */
+    bool isShared() const;
+
+    /**
+     * Records how long the ion took to parse the data, so it shows up
+     * in the statistics of the provider.
+     */
+    void setParseTime(qint64 msecs);
+
+Q_SIGNALS:
+    /**
+     * Emitted once the data is available or the download failed.
+     * This is always emitted asynchronously, even for data already cached.
+     */
+    void finished(WeatherFetchReply *reply);
+
+private:
+    WeatherFetchReply(const QUrl &url, QObject *parent);
+
+    class Private;
+    Private* const d;
+
+    friend class WeatherFetcher;
+};
+
+/**
+* Shared download layer for the weather data of all ions in a process.
+*
+* Requests for an url which is already being downloaded are attached to
+* the running download instead of starting another one, and documents
+* downloaded very recently are handed out again without any network access.
+* Downloads go through the KIO http cache in verify mode, so expiry
+* times and ETags sent by the providers are honoured across processes.
+*
+* The time taken for downloading and parsing is recorded per host, so slow
+* providers can be identified in the kde.dataengine.ion debug output.
+*/
+class ION_EXPORT WeatherFetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Statistics {
+        int requests = 0;
+        int downloads = 0;
+        int sharedReplies = 0;
+        int failures = 0;
+        qint64 totalFetchTime = 0;
+        qint64 maxFetchTime = 0;
+        int parses = 0;
+        qint64 totalParseTime = 0;
+        qint64 maxParseTime = 0;
+    };
+
+    static WeatherFetcher *self();
+
+    ~WeatherFetcher() override;
+
+    /**
+     * Requests the document at @p url.
+     *
+     * @param url the url to download
+     * @param parent owner of the returned reply
+     * @param maxAge maximum age in seconds of an already downloaded copy that may be used instead
+     */
+    WeatherFetchReply *get(const QUrl &url, QObject *parent, int maxAge = 60);
+
+    /**
+     * @return the hosts statistics were recorded for
+     */
+    QStringList hosts() const;
+    Statistics statistics(const QString &host) const;
+
+private:
+    WeatherFetcher();
+
+    void recordParseTime(const QUrl &url, qint64 msecs);
+
+    class Private;
+    Private* const d;
+
+    friend class WeatherFetchReply;
+};
+
+#endif
@@ -35,6 +35,7 @@
 #include <KLocalizedString>
 
 #include <QCryptographicHash>
+#include <QElapsedTimer>
 #include <QXmlStreamReader>
 #include <QLocale>
 
@@ -473,42 +474,25 @@ void WetterComIon::fetchForecast(const QString& source)
 
     const QUrl url(QStringLiteral(FORECAST_URL).arg(m_place[source].placeCode, encodedKey));
 
-    KIO::TransferJob* getJob = KIO::get(url, KIO::Reload, KIO::HideProgressInfo);
-    getJob->addMetaData(QStringLiteral("cookies"), QStringLiteral("none"));
-    m_forecastJobXml.insert(getJob, new QXmlStreamReader);
-    m_forecastJobList.insert(getJob, source);
+    WeatherFetchReply *reply = WeatherFetcher::self()->get(url, this);
+    m_forecastJobList.insert(reply, source);
 
-    connect(getJob, &KIO::TransferJob::data,
-            this, &WetterComIon::forecast_slotDataArrived);
-    connect(getJob, &KJob::result,
+    connect(reply, &WeatherFetchReply::finished,
             this, &WetterComIon::forecast_slotJobFinished);
 }
 
-void WetterComIon::forecast_slotDataArrived(KIO::Job *job, const QByteArray &data)
-{
-    QByteArray local = data;
-
-    if (data.isEmpty() || !m_forecastJobXml.contains(job)) {
-        return;
-    }
-
-    m_forecastJobXml[job]->addData(local);
-}
-
-void WetterComIon::forecast_slotJobFinished(KJob *job)
+void WetterComIon::forecast_slotJobFinished(WeatherFetchReply *reply)
 {
-    const QString source(m_forecastJobList.value(job));
+    const QString source(m_forecastJobList.take(reply));
     setData(source, Data());
-    QXmlStreamReader *reader = m_forecastJobXml.value(job);
-
-    if (reader) {
-        parseWeatherForecast(source, *reader);
-    }
 
-    m_forecastJobList.remove(job);
+    QElapsedTimer parseTimer;
+    parseTimer.start();
+    QXmlStreamReader reader(reply->data());
+    parseWeatherForecast(source, reader);
+    reply->setParseTime(parseTimer.elapsed());
 
-    delete m_forecastJobXml[job];
-    m_forecastJobXml.remove(job);
+    reply->deleteLater();
 
     if (m_sourcesToReset.contains(source)) {
         m_sourcesToReset.removeAll(source);
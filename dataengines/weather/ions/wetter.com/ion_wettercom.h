@@ -26,6 +26,7 @@
 #define ION_WETTERCOM_H
 
 #include "../ion.h"
+#include "../weatherfetcher.h"
 
 #include <QVector>
 
@@ -117,8 +118,7 @@ private Q_SLOTS:
     void setup_slotDataArrived(KIO::Job *, const QByteArray &);
     void setup_slotJobFinished(KJob *);
 
-    void forecast_slotDataArrived(KIO::Job *, const QByteArray &);
-    void forecast_slotJobFinished(KJob *);
+    void forecast_slotJobFinished(WeatherFetchReply *reply);
 
 private:
     void cleanup();
@@ -168,8 +168,7 @@ private:
     QHash<KJob *, QString> m_searchJobList;
 
     // Store KIO jobs - Forecast retrieval
-    QHash<KJob *, QXmlStreamReader *> m_forecastJobXml;
-    QHash<KJob *, QString> m_forecastJobList;
+    QHash<WeatherFetchReply *, QString> m_forecastJobList;
 
     QStringList m_sourcesToReset;
 };
@@ -27,7 +27,9 @@
 
 #include <QStandardPaths>
 #include <QFile>
+#include <QFileInfo>
 #include <QDir>
+#include <QTimer>
 
 K_PLUGIN_CLASS_WITH_JSON(DesktopNotifier, "desktopnotifier.json")
 
@@ -43,6 +45,13 @@ DesktopNotifier::DesktopNotifier(QObject *parent, const QList<QVariant> &)
 
     connect(dirWatch, &KDirWatch::created, this, &DesktopNotifier::created);
     connect(dirWatch, &KDirWatch::dirty, this, &DesktopNotifier::dirty);
+
+    m_compressTimer = new QTimer(this);
+    m_compressTimer->setSingleShot(true);
+    m_compressTimer->setInterval(100);
+    connect(m_compressTimer, &QTimer::timeout, this, &DesktopNotifier::processPendingChanges);
+
+    resetSnapshots();
 }
 
 void DesktopNotifier::watchDir(const QString &path)
@@ -59,33 +68,194 @@ void DesktopNotifier::created(const QString &path)
 
 void DesktopNotifier::dirty(const QString &path)
 {
-    Q_UNUSED(path)
-
     if (path.startsWith(QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + '/' + "Trash/files")) {
-        QList<QUrl> trashUrls;
+        m_trashDirty = true;
+    } else if (path == QStandardPaths::writableLocation(QStandardPaths::ConfigLocation) + QStringLiteral("/user-dirs.dirs")){
+        checkDesktopLocation();
+        return;
+    } else {
+        const QString cleanPath = QDir::cleanPath(path);
+        if (m_snapshots.contains(cleanPath) || QFileInfo(cleanPath).isDir()) {
+            m_pendingDirs.insert(cleanPath);
+        } else {
+            m_pendingDirs.insert(QFileInfo(cleanPath).absolutePath());
+        }
+    }
 
-        // Check for any .desktop file linking to trash:/ to update its icon
-        const auto desktopFiles = QDir(QStandardPaths::writableLocation(QStandardPaths::DesktopLocation)).entryInfoList({QStringLiteral("*.desktop")});
-        for (const auto &fi : desktopFiles) {
-            KDesktopFile df(fi.absoluteFilePath());
-            if (df.hasLinkType() && df.readUrl() == QLatin1String("trash:/")) {
-                trashUrls << QUrl(QStringLiteral("desktop:/") + fi.fileName());
-            }
+    // Don't restart an active timer, a continuous stream of changes
+    // must not delay the notifications indefinitely
+    if (!m_compressTimer->isActive()) {
+        m_compressTimer->start();
+    }
+}
+
+void DesktopNotifier::processPendingChanges()
+{
+    const QSet<QString> dirs = m_pendingDirs;
+    m_pendingDirs.clear();
+
+    for (const QString &dir : dirs) {
+        updateDir(dir);
+    }
+
+    if (m_trashDirty) {
+        m_trashDirty = false;
+
+        // Update the icon of any .desktop file linking to trash:/
+        QList<QUrl> trashUrls;
+        trashUrls.reserve(m_trashLinks.count());
+        for (const QString &fileName : qAsConst(m_trashLinks)) {
+            trashUrls << QUrl(QStringLiteral("desktop:/") + fileName);
         }
 
         if (!trashUrls.isEmpty()) {
             org::kde::KDirNotify::emitFilesChanged(trashUrls);
         }
-    } else if (path == QStandardPaths::writableLocation(QStandardPaths::ConfigLocation) + QStringLiteral("/user-dirs.dirs")){
-        checkDesktopLocation();
+    }
+}
+
+DesktopNotifier::Snapshot DesktopNotifier::scanDir(const QString &path) const
+{
+    Snapshot snapshot;
+
+    const auto entries = QDir(path).entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System);
+    snapshot.reserve(entries.count());
+    for (const QFileInfo &fi : entries) {
+        Entry entry;
+        entry.size = fi.size();
+        entry.lastModified = fi.lastModified();
+        entry.isDir = fi.isDir();
+        snapshot.insert(fi.fileName(), entry);
+    }
+
+    return snapshot;
+}
+
+void DesktopNotifier::updateDir(const QString &path)
+{
+    const QString desktopPath = QDir::cleanPath(QStandardPaths::writableLocation(QStandardPaths::DesktopLocation));
+    const bool isDesktop = (path == desktopPath);
+
+    if (!isDesktop && !QFileInfo(path).isDir()) {
+        // The directory itself is gone, its parent reports the removal
+        m_snapshots.remove(path);
+        return;
+    }
+
+    const QUrl dirUrl = desktopUrl(path);
+    const Snapshot current = scanDir(path);
+
+    auto it = m_snapshots.find(path);
+    if (it == m_snapshots.end()) {
+        // Nothing to compare against, emitting FilesAdded forces a re-read of the dir
+        m_snapshots.insert(path, current);
+        if (isDesktop) {
+            m_trashLinks.clear();
+            for (auto entryIt = current.constBegin(); entryIt != current.constEnd(); ++entryIt) {
+                updateTrashLink(path, entryIt.key());
+            }
+        }
+        org::kde::KDirNotify::emitFilesAdded(dirUrl);
+        return;
+    }
+
+    const Snapshot previous = it.value();
+    *it = current;
+
+    bool added = false;
+    QList<QUrl> removedUrls;
+    QList<QUrl> changedUrls;
+
+    for (auto entryIt = current.constBegin(); entryIt != current.constEnd(); ++entryIt) {
+        const QString &fileName = entryIt.key();
+        const Entry &entry = entryIt.value();
+
+        auto oldIt = previous.constFind(fileName);
+        if (oldIt == previous.constEnd()) {
+            added = true;
+        } else if (oldIt->size != entry.size || oldIt->lastModified != entry.lastModified || oldIt->isDir != entry.isDir) {
+            changedUrls << desktopUrl(path + QLatin1Char('/') + fileName);
+        } else {
+            continue;
+        }
+
+        if (isDesktop) {
+            updateTrashLink(path, fileName);
+        }
+    }
+
+    for (auto oldIt = previous.constBegin(); oldIt != previous.constEnd(); ++oldIt) {
+        const QString &fileName = oldIt.key();
+        if (current.contains(fileName)) {
+            continue;
+        }
+
+        const QString filePath = path + QLatin1Char('/') + fileName;
+        removedUrls << desktopUrl(filePath);
+
+        if (oldIt->isDir) {
+            m_snapshots.remove(filePath);
+        }
+        if (isDesktop) {
+            m_trashLinks.remove(fileName);
+        }
+    }
+
+    if (added) {
+        // KDirNotify has no per-item "added" notification, listers pick up
+        // the new items by updating the directory
+        org::kde::KDirNotify::emitFilesAdded(dirUrl);
+    }
+    if (!removedUrls.isEmpty()) {
+        org::kde::KDirNotify::emitFilesRemoved(removedUrls);
+    }
+    if (!changedUrls.isEmpty()) {
+        org::kde::KDirNotify::emitFilesChanged(changedUrls);
+    }
+}
+
+void DesktopNotifier::updateTrashLink(const QString &path, const QString &fileName)
+{
+    if (!fileName.endsWith(QLatin1String(".desktop"))) {
+        return;
+    }
+
+    const QString filePath = path + QLatin1Char('/') + fileName;
+    if (!QFile::exists(filePath)) {
+        m_trashLinks.remove(fileName);
+        return;
+    }
+
+    KDesktopFile df(filePath);
+    if (df.hasLinkType() && df.readUrl() == QLatin1String("trash:/")) {
+        m_trashLinks.insert(fileName);
     } else {
-        // Emitting FilesAdded forces a re-read of the dir
-        QUrl url;
-        url.setScheme(QStringLiteral("desktop"));
-        const auto relativePath = QDir(QStandardPaths::writableLocation(QStandardPaths::DesktopLocation)).relativeFilePath(path);
-        url.setPath(QStringLiteral("%1/%2").arg(url.path(), relativePath));
-        url.setPath(QDir::cleanPath(url.path()));
-        org::kde::KDirNotify::emitFilesAdded(url);
+        m_trashLinks.remove(fileName);
+    }
+}
+
+QUrl DesktopNotifier::desktopUrl(const QString &path) const
+{
+    QUrl url;
+    url.setScheme(QStringLiteral("desktop"));
+    const auto relativePath = QDir(QStandardPaths::writableLocation(QStandardPaths::DesktopLocation)).relativeFilePath(path);
+    url.setPath(QStringLiteral("%1/%2").arg(url.path(), relativePath));
+    url.setPath(QDir::cleanPath(url.path()));
+    return url;
+}
+
+void DesktopNotifier::resetSnapshots()
+{
+    m_snapshots.clear();
+    m_trashLinks.clear();
+    m_pendingDirs.clear();
+
+    const QString desktopPath = QDir::cleanPath(QStandardPaths::writableLocation(QStandardPaths::DesktopLocation));
+    const Snapshot snapshot = scanDir(desktopPath);
+    m_snapshots.insert(desktopPath, snapshot);
+
+    for (auto it = snapshot.constBegin(); it != snapshot.constEnd(); ++it) {
+        updateTrashLink(desktopPath, it.key());
     }
 }
 
@@ -95,6 +265,7 @@ void DesktopNotifier::checkDesktopLocation()
 
     if (m_desktopLocation != currentLocation) {
         m_desktopLocation = currentLocation;
+        resetSnapshots();
         org::kde::KDirNotify::emitFilesChanged(QList<QUrl>() << QUrl(QStringLiteral("desktop:/")));
     }
 }
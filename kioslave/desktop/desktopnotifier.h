@@ -21,9 +21,13 @@
 
 #include <kdedmodule.h>
 #include <QDBusAbstractAdaptor>
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
 #include <QUrl>
 
 class KDirWatch;
+class QTimer;
 
 class DesktopNotifier : public KDEDModule
 {
@@ -39,12 +43,37 @@ public slots:
 private slots:
     void created(const QString &path);
     void dirty(const QString &path);
+    void processPendingChanges();
 
 private:
+    struct Entry {
+        qint64 size = 0;
+        QDateTime lastModified;
+        bool isDir = false;
+    };
+    using Snapshot = QHash<QString, Entry>;
+
     void checkDesktopLocation();
+    void resetSnapshots();
+    Snapshot scanDir(const QString &path) const;
+    void updateDir(const QString &path);
+    void updateTrashLink(const QString &path, const QString &fileName);
+    QUrl desktopUrl(const QString &path) const;
 
     KDirWatch *dirWatch;
     QUrl m_desktopLocation;
+
+    // Events are collected for a short while so that bulk operations
+    // (e.g. copying many files to the desktop) result in a single batch
+    // of notifications instead of one full re-listing per file.
+    QTimer *m_compressTimer;
+    QSet<QString> m_pendingDirs;
+    bool m_trashDirty = false;
+
+    // Last known contents of each watched directory, keyed by local path.
+    QHash<QString, Snapshot> m_snapshots;
+    // File names of .desktop files on the desktop linking to trash:/
+    QSet<QString> m_trashLinks;
 };
 
 #endif
@@ -24,11 +24,14 @@
 
 // Qt
 #include <QCoreApplication>
+#include <QDBusArgument>
 #include <QDBusConnection>
 #include <QDBusInterface>
 #include <QDBusReply>
 #include <QDBusVariant>
 #include <QFont>
+#include <QHash>
+#include <QKeySequence>
 #include <QMenu>
 #include <QPointer>
 #include <QTime>
@@ -59,6 +62,37 @@ static QTime sChrono;
 static const char *DBUSMENU_PROPERTY_ID = "_dbusmenu_id";
 static const char *DBUSMENU_PROPERTY_ICON_NAME = "_dbusmenu_icon_name";
 static const char *DBUSMENU_PROPERTY_ICON_DATA_HASH = "_dbusmenu_icon_data_hash";
+static const char *DBUSMENU_PROPERTY_PROPERTIES = "_dbusmenu_properties";
+
+/**
+ * Values which aren't basic D-Bus types, like shortcuts and sometimes
+ * icon-data, arrive as D-Bus arguments. These can only be read once and
+ * don't compare by value, so turn them into Qt types the properties can
+ * be compared with and applied from.
+ */
+static QVariantMap normalizedProperties(const QVariantMap &properties)
+{
+    QVariantMap map = properties;
+    for (QVariantMap::Iterator it = map.begin(), end = map.end(); it != end; ++it) {
+        if (it->userType() != qMetaTypeId<QDBusArgument>()) {
+            continue;
+        }
+
+        const QDBusArgument arg = it->value<QDBusArgument>();
+        if (it.key() == QLatin1String("shortcut")) {
+            DBusMenuShortcut dmShortcut;
+            arg >> dmShortcut;
+            *it = QVariant::fromValue(dmShortcut.toKeySequence());
+        } else if (arg.currentSignature() == QLatin1String("ay")) {
+            *it = qdbus_cast<QByteArray>(arg);
+        } else if (arg.currentSignature() == QLatin1String("as")) {
+            *it = qdbus_cast<QStringList>(arg);
+        } else if (arg.currentSignature() == QLatin1String("a{sv}")) {
+            *it = qdbus_cast<QVariantMap>(arg);
+        }
+    }
+    return map;
+}
 
 static QAction *createKdeTitle(QAction *action, QWidget *parent)
 {
@@ -89,12 +123,21 @@ public:
 
     QSet<int> m_idsRefreshedByAboutToShow;
     QSet<int> m_pendingLayoutUpdates;
+    // Property updates received since the last pass, by item id. Removed
+    // properties are invalid values.
+    QHash<int, QVariantMap> m_pendingPropertyUpdates;
+    // Latest GetLayout call for the menu of an item, replies to earlier
+    // calls are outdated
+    QHash<int, QDBusPendingCallWatcher *> m_layoutCallForId;
+    // Icons looked up during the current pass
+    QHash<QString, QIcon> m_iconForName;
 
     QDBusPendingCallWatcher *refresh(int id)
     {
         auto call = m_interface->GetLayout(id, 1, QStringList());
         QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, q);
         watcher->setProperty(DBUSMENU_PROPERTY_ID, id);
+        m_layoutCallForId.insert(id, watcher);
         QObject::connect(watcher, &QDBusPendingCallWatcher::finished,
             q, &DBusMenuImporter::slotGetLayoutFinished);
 
@@ -145,11 +188,164 @@ public:
 
         if (isKdeTitle) {
             action = createKdeTitle(action, parent);
+            action->setProperty(DBUSMENU_PROPERTY_ID, id);
+        }
+
+        return action;
+    }
+
+    /**
+     * Creates the action for a new item and connects it to the importer.
+     * It still has to be inserted into @p menu.
+     */
+    QAction *createConnectedAction(int id, const QVariantMap &properties, QMenu *menu)
+    {
+        QAction *action = createAction(id, properties, menu);
+        action->setProperty(DBUSMENU_PROPERTY_PROPERTIES, properties);
+        m_actionForId.insert(id, action);
+
+        QObject::connect(action, &QObject::destroyed, q, [this, id, action]() {
+            // The id might already be used by a new action
+            if (m_actionForId.value(id) == action) {
+                m_actionForId.remove(id);
+            }
+        });
+
+        QObject::connect(action, &QAction::triggered, q, [id, this]() {
+            q->sendClickedEvent(id);
+        });
+
+        if (QMenu *menuAction = action->menu()) {
+            QObject::connect(menuAction, &QMenu::aboutToShow, q, &DBusMenuImporter::slotMenuAboutToShow, Qt::UniqueConnection);
         }
+        QObject::connect(menu, &QMenu::aboutToHide, q, &DBusMenuImporter::slotMenuAboutToHide, Qt::UniqueConnection);
 
         return action;
     }
 
+    /**
+     * Updates the mutable properties of an existing action, unless they
+     * are the same as when they were last applied
+     */
+    void updateChangedProperties(QAction *action, const QVariantMap &properties)
+    {
+        const QVariant previous = action->property(DBUSMENU_PROPERTY_PROPERTIES);
+        if (previous.isValid() && previous.toMap() == properties) {
+            return;
+        }
+        action->setProperty(DBUSMENU_PROPERTY_PROPERTIES, properties);
+
+        QStringList filteredKeys = properties.keys();
+        filteredKeys.removeOne(QStringLiteral("type"));
+        filteredKeys.removeOne(QStringLiteral("toggle-type"));
+        filteredKeys.removeOne(QStringLiteral("children-display"));
+        updateAction(action, properties, filteredKeys);
+    }
+
+    /**
+     * Turns the actions of @p menu into the ones of @p items: outdated
+     * actions are removed, new ones inserted where they belong and only
+     * the actions which aren't in place yet are moved.
+     */
+    void applyLayout(QMenu *menu, const QList<DBusMenuLayoutItem> &items)
+    {
+        QSet<int> newIds;
+        newIds.reserve(items.count());
+        for (const DBusMenuLayoutItem &item : items) {
+            newIds << item.id;
+        }
+
+        // The actions currently in the menu, in order, which are kept
+        QList<QAction *> current;
+        current.reserve(items.count());
+        for (QAction *action : menu->actions()) {
+            const int id = action->property(DBUSMENU_PROPERTY_ID).toInt();
+            if (m_actionForId.value(id) != action) {
+                // Removed by an earlier update, waiting to be deleted
+                continue;
+            }
+            if (!newIds.contains(id)) {
+                // Not calling removeAction() as QMenu will immediately close when it becomes empty,
+                // which can happen when an application completely reloads this menu.
+                // When the action is deleted deferred, it is removed from the menu.
+                action->deleteLater();
+                m_actionForId.remove(id);
+                continue;
+            }
+            current << action;
+        }
+
+        int position = 0;
+        for (const DBusMenuLayoutItem &item : items) {
+            // Skip items listed twice
+            if (!newIds.remove(item.id)) {
+                continue;
+            }
+
+            // The layout is at least as recent as the updates received before it
+            m_pendingPropertyUpdates.remove(item.id);
+
+            const QVariantMap properties = normalizedProperties(item.properties);
+            QAction *action = m_actionForId.value(item.id);
+            if (!action) {
+                action = createConnectedAction(item.id, properties, menu);
+            } else {
+                updateChangedProperties(action, properties);
+            }
+
+            if (current.value(position) == action) {
+                ++position;
+                continue;
+            }
+
+            // Inserting an action which is already in the menu moves it
+            QAction *before = current.value(position);
+            const int previousPosition = current.indexOf(action, position);
+            if (previousPosition >= 0) {
+                current.removeAt(previousPosition);
+            }
+            menu->insertAction(before, action);
+            current.insert(position++, action);
+        }
+
+        m_iconForName.clear();
+    }
+
+    /**
+     * Applies the property updates received since the last pass
+     */
+    void applyPendingPropertyUpdates()
+    {
+        for (QHash<int, QVariantMap>::ConstIterator it = m_pendingPropertyUpdates.constBegin(), end = m_pendingPropertyUpdates.constEnd(); it != end; ++it) {
+            QAction *action = m_actionForId.value(it.key());
+            if (!action) {
+                continue;
+            }
+
+            // The next layout has to apply all properties again
+            action->setProperty(DBUSMENU_PROPERTY_PROPERTIES, QVariant());
+
+            for (QVariantMap::ConstIterator property = it->constBegin(), propertiesEnd = it->constEnd(); property != propertiesEnd; ++property) {
+                updateActionProperty(action, property.key(), property.value());
+            }
+        }
+
+        m_pendingPropertyUpdates.clear();
+        m_iconForName.clear();
+    }
+
+    QIcon iconForName(const QString &name)
+    {
+        QHash<QString, QIcon>::ConstIterator it = m_iconForName.constFind(name);
+        if (it != m_iconForName.constEnd()) {
+            return *it;
+        }
+
+        const QIcon icon = q->iconForName(name);
+        m_iconForName.insert(name, icon);
+        return icon;
+    }
+
     /**
      * Update mutable properties of an action. A property may be listed in
      * requestedProperties but not in map, this means we should use the default value
@@ -217,7 +413,7 @@ public:
             action->setIcon(QIcon());
             return;
         }
-        action->setIcon(q->iconForName(iconName));
+        action->setIcon(iconForName(iconName));
     }
 
     void updateActionIconByData(QAction *action, const QVariant &value)
@@ -245,6 +441,12 @@ public:
 
     void updateActionShortcut(QAction *action, const QVariant &value)
     {
+        if (value.userType() != qMetaTypeId<QDBusArgument>()) {
+            // Already normalized, or removed
+            action->setShortcut(value.value<QKeySequence>());
+            return;
+        }
+
         QDBusArgument arg = value.value<QDBusArgument>();
         DBusMenuShortcut dmShortcut;
         arg >> dmShortcut;
@@ -318,6 +520,8 @@ void DBusMenuImporter::slotLayoutUpdated(uint revision, int parentId)
 
 void DBusMenuImporter::processPendingLayoutUpdates()
 {
+    d->applyPendingPropertyUpdates();
+
     QSet<int> ids = d->m_pendingLayoutUpdates;
     d->m_pendingLayoutUpdates.clear();
     Q_FOREACH(int id, ids) {
@@ -335,32 +539,39 @@ QMenu *DBusMenuImporter::menu() const
 
 void DBusMenuImporterPrivate::slotItemsPropertiesUpdated(const DBusMenuItemList &updatedList, const DBusMenuItemKeysList &removedList)
 {
+    // Applications tend to send many updates in a row, they are applied
+    // together with the pending layout updates
     Q_FOREACH(const DBusMenuItem &item, updatedList) {
-        QAction *action = m_actionForId.value(item.id);
-        if (!action) {
+        if (!m_actionForId.contains(item.id)) {
             // We don't know this action. It probably is in a menu we haven't fetched yet.
             continue;
         }
 
+        QVariantMap &pending = m_pendingPropertyUpdates[item.id];
+        const QVariantMap properties = normalizedProperties(item.properties);
         QVariantMap::ConstIterator
-            it = item.properties.constBegin(),
-            end = item.properties.constEnd();
+            it = properties.constBegin(),
+            end = properties.constEnd();
         for(; it != end; ++it) {
-            updateActionProperty(action, it.key(), it.value());
+            pending.insert(it.key(), it.value());
         }
     }
 
     Q_FOREACH(const DBusMenuItemKeys &item, removedList) {
-        QAction *action = m_actionForId.value(item.id);
-        if (!action) {
+        if (!m_actionForId.contains(item.id)) {
             // We don't know this action. It probably is in a menu we haven't fetched yet.
             continue;
         }
 
+        QVariantMap &pending = m_pendingPropertyUpdates[item.id];
         Q_FOREACH(const QString &key, item.properties) {
-            updateActionProperty(action, key, QVariant());
+            pending.insert(key, QVariant());
         }
     }
+
+    if (!m_pendingPropertyUpdates.isEmpty() && !m_pendingLayoutUpdateTimer->isActive()) {
+        m_pendingLayoutUpdateTimer->start();
+    }
 }
 
 QAction *DBusMenuImporter::actionForId(int id) const
@@ -380,6 +591,13 @@ void DBusMenuImporter::slotGetLayoutFinished(QDBusPendingCallWatcher *watcher)
     int parentId = watcher->property(DBUSMENU_PROPERTY_ID).toInt();
     watcher->deleteLater();
 
+    // Replies to earlier calls can arrive after the ones to newer calls
+    if (d->m_layoutCallForId.value(parentId) != watcher) {
+        qDebug(DBUSMENUQT) << "Ignoring outdated layout of menu" << parentId;
+        return;
+    }
+    d->m_layoutCallForId.remove(parentId);
+
     QMenu *menu = d->menuForId(parentId);
 
     QDBusPendingReply<uint, DBusMenuLayoutItem> reply = *watcher;
@@ -401,58 +619,7 @@ void DBusMenuImporter::slotGetLayoutFinished(QDBusPendingCallWatcher *watcher)
         return;
     }
 
-    //remove outdated actions
-    QSet<int> newDBusMenuItemIds;
-    newDBusMenuItemIds.reserve(rootItem.children.count());
-    for (const DBusMenuLayoutItem &item: rootItem.children) {
-        newDBusMenuItemIds << item.id;
-    }
-    for (QAction *action: menu->actions()) {
-        int id = action->property(DBUSMENU_PROPERTY_ID).toInt();
-        if (! newDBusMenuItemIds.contains(id)) {
-            // Not calling removeAction() as QMenu will immediately close when it becomes empty,
-            // which can happen when an application completely reloads this menu.
-            // When the action is deleted deferred, it is removed from the menu.
-            action->deleteLater();
-            d->m_actionForId.remove(id);
-        }
-    }
-
-    //insert or update new actions into our menu
-    for (const DBusMenuLayoutItem &dbusMenuItem: rootItem.children) {
-        DBusMenuImporterPrivate::ActionForId::Iterator it = d->m_actionForId.find(dbusMenuItem.id);
-        QAction *action = nullptr;
-        if (it == d->m_actionForId.end()) {
-            int id = dbusMenuItem.id;
-            action = d->createAction(id, dbusMenuItem.properties, menu);
-            d->m_actionForId.insert(id, action);
-
-            connect(action, &QObject::destroyed, this, [this, id]() {
-                d->m_actionForId.remove(id);
-            });
-
-            connect(action, &QAction::triggered, this, [ id, this]() {
-                sendClickedEvent(id);
-            });
-
-            if (QMenu *menuAction = action->menu()) {
-                connect(menuAction, &QMenu::aboutToShow, this, &DBusMenuImporter::slotMenuAboutToShow, Qt::UniqueConnection);
-            }
-            connect(menu, &QMenu::aboutToHide, this, &DBusMenuImporter::slotMenuAboutToHide, Qt::UniqueConnection);
-
-            menu->addAction(action);
-        } else {
-            action = *it;
-            QStringList filteredKeys = dbusMenuItem.properties.keys();
-            filteredKeys.removeOne("type");
-            filteredKeys.removeOne("toggle-type");
-            filteredKeys.removeOne("children-display");
-            d->updateAction(*it, dbusMenuItem.properties, filteredKeys);
-            // Move the action to the tail so we can keep the order same as the dbus request.
-            menu->removeAction(action);
-            menu->addAction(action);
-        }
-    }
+    d->applyLayout(menu, rootItem.children);
 
     emit menuUpdated(menu);
 }
@@ -0,0 +1,369 @@
+/*
+ *   Copyright 2020 by the Plasma Workspace authors
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// Serves a sequence of recorded GetLayout replies from a fake DBusMenu
+// server in the same process and measures how long DBusMenuImporter takes
+// to follow each layout update, and what it does to the QMenu.
+//
+// Without a recording, a bookmark menu with random changes is generated.
+// --save writes it in the recording format, which is a JSON array of steps:
+//   [{"revision": 2,
+//     "items": [{"id": 1, "label": "Bookmark", "icon-name": "bookmarks"}, ...],
+//     "updated": [{"id": 1, "label": "Renamed bookmark"}]}, ...]
+// "updated" is sent with ItemsPropertiesUpdated right before LayoutUpdated.
+//
+// Example: dbusmenubenchmark --items 2000 --steps 200
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDBusConnection>
+#include <QDBusVariant>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QIcon>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMenu>
+#include <QRandomGenerator>
+#include <QSignalSpy>
+#include <QTextStream>
+
+#include "../dbusmenuimporter.h"
+#include "../dbusmenutypes_p.h"
+
+static const QString s_path = QStringLiteral("/MenuBar");
+
+struct Step {
+    uint revision = 0;
+    QList<DBusMenuLayoutItem> items;
+    DBusMenuItemList updated;
+};
+
+class FakeMenuServer : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "com.canonical.dbusmenu")
+
+public:
+    void setStep(const Step &step)
+    {
+        if (!step.updated.isEmpty()) {
+            emit ItemsPropertiesUpdated(step.updated, DBusMenuItemKeysList());
+        }
+
+        m_revision = step.revision;
+        m_root.children = step.items;
+        emit LayoutUpdated(m_revision, 0);
+    }
+
+public Q_SLOTS:
+    uint GetLayout(int parentId, int recursionDepth, const QStringList &propertyNames, DBusMenuLayoutItem &item)
+    {
+        Q_UNUSED(recursionDepth)
+        Q_UNUSED(propertyNames)
+
+        item.id = parentId;
+        item.children = parentId == 0 ? m_root.children : QList<DBusMenuLayoutItem>();
+        return m_revision;
+    }
+
+    bool AboutToShow(int id)
+    {
+        Q_UNUSED(id)
+        return false;
+    }
+
+    void Event(int id, const QString &eventId, const QDBusVariant &data, uint timestamp)
+    {
+        Q_UNUSED(id)
+        Q_UNUSED(eventId)
+        Q_UNUSED(data)
+        Q_UNUSED(timestamp)
+    }
+
+Q_SIGNALS:
+    void LayoutUpdated(uint revision, int parent);
+    void ItemsPropertiesUpdated(const DBusMenuItemList &updatedProps, const DBusMenuItemKeysList &removedProps);
+
+private:
+    uint m_revision = 0;
+    DBusMenuLayoutItem m_root = {0, QVariantMap(), {}};
+};
+
+class BenchmarkImporter : public DBusMenuImporter
+{
+public:
+    using DBusMenuImporter::DBusMenuImporter;
+
+    int iconLookups = 0;
+
+protected:
+    QIcon iconForName(const QString &name) override
+    {
+        ++iconLookups;
+        return QIcon::fromTheme(name);
+    }
+};
+
+// Counts what happens to the actions of a menu
+class ActionEventCounter : public QObject
+{
+public:
+    int added = 0;
+    int removed = 0;
+    int changed = 0;
+
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        switch (event->type()) {
+        case QEvent::ActionAdded:
+            ++added;
+            break;
+        case QEvent::ActionRemoved:
+            ++removed;
+            break;
+        case QEvent::ActionChanged:
+            ++changed;
+            break;
+        default:
+            break;
+        }
+        return QObject::eventFilter(watched, event);
+    }
+};
+
+static DBusMenuLayoutItem bookmark(int id, int version)
+{
+    DBusMenuLayoutItem item;
+    item.id = id;
+    item.properties.insert(QStringLiteral("label"), QStringLiteral("Bookmark %1 (%2)").arg(id).arg(version));
+    item.properties.insert(QStringLiteral("icon-name"), QStringLiteral("bookmarks"));
+    item.properties.insert(QStringLiteral("enabled"), true);
+    return item;
+}
+
+static QVector<Step> generateSteps(int itemCount, int stepCount)
+{
+    QVector<Step> steps;
+    QRandomGenerator random(itemCount);
+
+    Step step;
+    step.revision = 1;
+    for (int id = 1; id <= itemCount; ++id) {
+        step.items << bookmark(id, 0);
+    }
+    steps << step;
+
+    int nextId = itemCount + 1;
+    for (int i = 1; i < stepCount; ++i) {
+        step.updated.clear();
+        ++step.revision;
+
+        const int position = random.bounded(qMax(1, step.items.count()));
+        switch (i % 5) {
+        case 0: // browsers update the layout without changes
+            break;
+        case 1: {
+            DBusMenuLayoutItem &item = step.items[position];
+            item = bookmark(item.id, i);
+            step.updated << DBusMenuItem{item.id, item.properties};
+            break;
+        }
+        case 2:
+            step.items.insert(position, bookmark(nextId++, i));
+            break;
+        case 3:
+            if (step.items.count() > 1) {
+                step.items.removeAt(position);
+            }
+            break;
+        case 4:
+            step.items.move(position, random.bounded(step.items.count()));
+            break;
+        }
+
+        steps << step;
+    }
+
+    return steps;
+}
+
+static QVariantMap propertiesFromJson(const QJsonObject &object)
+{
+    QVariantMap properties = object.toVariantMap();
+    properties.remove(QStringLiteral("id"));
+    return properties;
+}
+
+static QJsonObject propertiesToJson(int id, const QVariantMap &properties)
+{
+    QJsonObject object = QJsonObject::fromVariantMap(properties);
+    object.insert(QStringLiteral("id"), id);
+    return object;
+}
+
+static QVector<Step> loadSteps(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCritical() << "Cannot read" << fileName;
+        return {};
+    }
+
+    QVector<Step> steps;
+    const QJsonArray array = QJsonDocument::fromJson(file.readAll()).array();
+    for (const QJsonValue &value : array) {
+        const QJsonObject object = value.toObject();
+
+        Step step;
+        step.revision = object.value(QStringLiteral("revision")).toInt();
+        for (const QJsonValue &item : object.value(QStringLiteral("items")).toArray()) {
+            const QJsonObject itemObject = item.toObject();
+            step.items << DBusMenuLayoutItem{itemObject.value(QStringLiteral("id")).toInt(), propertiesFromJson(itemObject), {}};
+        }
+        for (const QJsonValue &item : object.value(QStringLiteral("updated")).toArray()) {
+            const QJsonObject itemObject = item.toObject();
+            step.updated << DBusMenuItem{itemObject.value(QStringLiteral("id")).toInt(), propertiesFromJson(itemObject)};
+        }
+        steps << step;
+    }
+
+    return steps;
+}
+
+static bool saveSteps(const QVector<Step> &steps, const QString &fileName)
+{
+    QJsonArray array;
+    for (const Step &step : steps) {
+        QJsonArray items;
+        for (const DBusMenuLayoutItem &item : step.items) {
+            items << propertiesToJson(item.id, item.properties);
+        }
+        QJsonArray updated;
+        for (const DBusMenuItem &item : step.updated) {
+            updated << propertiesToJson(item.id, item.properties);
+        }
+
+        QJsonObject object;
+        object.insert(QStringLiteral("revision"), static_cast<int>(step.revision));
+        object.insert(QStringLiteral("items"), items);
+        if (!updated.isEmpty()) {
+            object.insert(QStringLiteral("updated"), updated);
+        }
+        array << object;
+    }
+
+    QFile file(fileName);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+        && file.write(QJsonDocument(array).toJson(QJsonDocument::Compact)) >= 0;
+}
+
+int main(int argc, char **argv)
+{
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption itemsOption(QStringLiteral("items"), QStringLiteral("Number of generated menu items"), QStringLiteral("count"), QStringLiteral("1000"));
+    QCommandLineOption stepsOption(QStringLiteral("steps"), QStringLiteral("Number of generated layout updates"), QStringLiteral("count"), QStringLiteral("100"));
+    QCommandLineOption recordingOption(QStringLiteral("recording"), QStringLiteral("Replay the layouts of a recording instead"), QStringLiteral("file"));
+    QCommandLineOption saveOption(QStringLiteral("save"), QStringLiteral("Save the generated layouts as a recording"), QStringLiteral("file"));
+    parser.addOptions({itemsOption, stepsOption, recordingOption, saveOption});
+    parser.process(app);
+
+    DBusMenuTypes_register();
+
+    const QVector<Step> steps = parser.isSet(recordingOption)
+        ? loadSteps(parser.value(recordingOption))
+        : generateSteps(qMax(1, parser.value(itemsOption).toInt()), qMax(2, parser.value(stepsOption).toInt()));
+    if (steps.isEmpty()) {
+        return 1;
+    }
+
+    if (parser.isSet(saveOption) && !saveSteps(steps, parser.value(saveOption))) {
+        qCritical() << "Cannot write" << parser.value(saveOption);
+        return 1;
+    }
+
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    if (!bus.isConnected()) {
+        qCritical() << "The benchmark needs a session bus";
+        return 1;
+    }
+
+    FakeMenuServer server;
+    server.setStep(steps.first());
+    bus.registerObject(s_path, &server, QDBusConnection::ExportAllSlots | QDBusConnection::ExportAllSignals);
+
+    QTextStream out(stdout);
+
+    BenchmarkImporter importer(bus.baseService(), s_path);
+    QSignalSpy menuUpdated(&importer, &DBusMenuImporter::menuUpdated);
+    if (!menuUpdated.wait(5000)) {
+        qCritical() << "The importer didn't load the menu";
+        return 1;
+    }
+
+    QMenu *menu = importer.menu();
+    out << "Initial menu: " << menu->actions().count() << " items, " << importer.iconLookups << " icon lookups\n";
+
+    ActionEventCounter counter;
+    menu->installEventFilter(&counter);
+    importer.iconLookups = 0;
+
+    QElapsedTimer timer;
+    qint64 totalNs = 0;
+    qint64 maxNs = 0;
+
+    for (int i = 1; i < steps.count(); ++i) {
+        menuUpdated.clear();
+
+        timer.start();
+        server.setStep(steps.at(i));
+        if (!menuUpdated.wait(5000)) {
+            qWarning() << "No menu update for step" << i;
+            continue;
+        }
+        const qint64 elapsed = timer.nsecsElapsed();
+
+        totalNs += elapsed;
+        maxNs = qMax(maxNs, elapsed);
+
+        // Removed actions are deleted later
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    }
+
+    const int updates = steps.count() - 1;
+    out << updates << " layout updates of " << steps.last().items.count() << " items\n"
+        << "average: " << QString::number(totalNs / updates / 1e6, 'f', 3) << " ms, "
+        << "maximum: " << QString::number(maxNs / 1e6, 'f', 3) << " ms\n"
+        << "menu actions: " << counter.added << " added, " << counter.removed << " removed, "
+        << counter.changed << " changed\n"
+        << "icon lookups: " << importer.iconLookups << "\n";
+
+    if (menu->actions().count() != steps.last().items.count()) {
+        qWarning() << "The menu has" << menu->actions().count() << "items instead of" << steps.last().items.count();
+        return 1;
+    }
+
+    return 0;
+}
+
+#include "dbusmenubenchmark.moc"
@@ -39,7 +39,11 @@
 #include <algorithm>
 #include <functional>
 
-static const int s_notificationsLimit = 1000;
+// Images are kept on disk, so this is mostly bounded by the notifications' text
+static const int s_notificationsLimit = 5000;
+// The timer is delayed by this much so that timeouts due shortly after each other
+// are handled with a single wake-up. Timeouts are only ever handled late, never early.
+static const qint64 s_timeoutSlack = 1000;
 
 using namespace NotificationManager;
 
@@ -47,34 +51,39 @@ AbstractNotificationsModel::Private::Private(AbstractNotificationsModel *q)
     : q(q)
     , lastRead(QDateTime::currentDateTimeUtc())
 {
+    clock.start();
 
+    timeoutTimer.setSingleShot(true);
+    timeoutTimer.setTimerType(Qt::CoarseTimer);
+    QObject::connect(&timeoutTimer, &QTimer::timeout, q, [this] {
+        processTimeouts();
+    });
 }
 
-AbstractNotificationsModel::Private::~Private()
-{
-    qDeleteAll(notificationTimeouts);
-    notificationTimeouts.clear();
-}
+AbstractNotificationsModel::Private::~Private() = default;
 
 void AbstractNotificationsModel::Private::onNotificationAdded(const Notification &notification)
 {
     // Once we reach a certain insane number of notifications discard some old ones
-    // as we keep pixmaps around etc
     if (notifications.count() >= s_notificationsLimit) {
         const int cleanupCount = s_notificationsLimit / 2;
         qCDebug(NOTIFICATIONMANAGER) << "Reached the notification limit of" << s_notificationsLimit << ", discarding the oldest" << cleanupCount << "notifications";
         q->beginRemoveRows(QModelIndex(), 0, cleanupCount - 1);
         for (int i = 0 ; i < cleanupCount; ++i) {
-            notifications.removeAt(0);
+            stopNotificationTimeout(notifications.at(i).id());
             // TODO close gracefully?
         }
+        notifications.remove(0, cleanupCount);
+        rebuildRowIndex();
         q->endRemoveRows();
     }
 
     setupNotificationTimeout(notification);
 
-    q->beginInsertRows(QModelIndex(), notifications.count(), notifications.count());
+    const int row = notifications.count();
+    q->beginInsertRows(QModelIndex(), row, row);
     notifications.append(std::move(notification));
+    rowOfNotification.insert(notifications.at(row).id(), row);
     q->endInsertRows();
 }
 
@@ -91,6 +100,10 @@ void AbstractNotificationsModel::Private::onNotificationReplaced(uint replacedId
     setupNotificationTimeout(notification);
 
     notifications[row] = notification;
+    if (notification.id() != replacedId) {
+        rowOfNotification.remove(replacedId);
+        rowOfNotification.insert(notification.id(), row);
+    }
     const QModelIndex idx = q->index(row, 0);
     emit q->dataChanged(idx, idx);
 }
@@ -132,6 +145,8 @@ void AbstractNotificationsModel::Private::onNotificationRemoved(uint removedId,
 
     q->beginRemoveRows(QModelIndex(), row, row);
     notifications.removeAt(row);
+    rowOfNotification.remove(removedId);
+    updateRowIndex(row);
     q->endRemoveRows();
 }
 
@@ -143,35 +158,96 @@ void AbstractNotificationsModel::Private::setupNotificationTimeout(const Notific
         return;
     }
 
-    QTimer *timer = notificationTimeouts.value(notification.id());
-    if (!timer) {
-        timer = new QTimer();
-        timer->setSingleShot(true);
+    const qint64 deadline = clock.elapsed()
+        + timeoutGracePeriod + (notification.timeout() == -1 ? 120000 /*2min, max configurable default timeout*/ : notification.timeout());
 
-        connect(timer, &QTimer::timeout, q, [this, timer] {
-            const uint id = timer->property("notificationId").toUInt();
-            q->expire(id);
-        });
-        notificationTimeouts.insert(notification.id(), timer);
+    notificationTimeouts.insert(notification.id(), deadline);
+    timeoutQueue.push({deadline, notification.id()});
+
+    // Restarting timeouts leaves stale entries behind, don't let them pile up
+    if (timeoutQueue.size() > 2 * static_cast<size_t>(notificationTimeouts.count()) + 64) {
+        std::vector<Timeout> timeouts;
+        timeouts.reserve(notificationTimeouts.count());
+        for (auto it = notificationTimeouts.constBegin(), end = notificationTimeouts.constEnd(); it != end; ++it) {
+            timeouts.push_back({it.value(), it.key()});
+        }
+        timeoutQueue = decltype(timeoutQueue)(std::greater<Timeout>(), std::move(timeouts));
     }
 
-    timer->stop();
-    timer->setProperty("notificationId", notification.id());
-    timer->setInterval(60000 /*1min*/ + (notification.timeout() == -1 ? 120000 /*2min, max configurable default timeout*/ : notification.timeout()));
-    timer->start();
+    if (!timeoutTimer.isActive() || deadline < scheduledDeadline) {
+        scheduleNextTimeout();
+    }
 }
 
-int AbstractNotificationsModel::rowOfNotification(uint id) const
+void AbstractNotificationsModel::Private::stopNotificationTimeout(uint notificationId)
 {
-    auto it = std::find_if(d->notifications.constBegin(), d->notifications.constEnd(), [id](const Notification &item) {
-        return item.id() == id;
-    });
+    // The queue entry is dropped once it comes up
+    notificationTimeouts.remove(notificationId);
+}
+
+void AbstractNotificationsModel::Private::scheduleNextTimeout()
+{
+    while (!timeoutQueue.empty()) {
+        const Timeout &next = timeoutQueue.top();
+        auto it = notificationTimeouts.constFind(next.notificationId);
+        if (it != notificationTimeouts.constEnd() && it.value() == next.deadline) {
+            break;
+        }
+        timeoutQueue.pop();
+    }
+
+    if (timeoutQueue.empty()) {
+        timeoutTimer.stop();
+        scheduledDeadline = -1;
+        return;
+    }
+
+    scheduledDeadline = timeoutQueue.top().deadline;
+    // Waking up too early is harmless, processTimeouts() just schedules the timer again
+    timeoutTimer.start(static_cast<int>(qMax<qint64>(0, scheduledDeadline + s_timeoutSlack - clock.elapsed())));
+}
+
+void AbstractNotificationsModel::Private::processTimeouts()
+{
+    const qint64 now = clock.elapsed();
+
+    QVector<uint> expiredIds;
+    while (!timeoutQueue.empty() && timeoutQueue.top().deadline <= now) {
+        const Timeout timeout = timeoutQueue.top();
+        timeoutQueue.pop();
+
+        auto it = notificationTimeouts.find(timeout.notificationId);
+        if (it != notificationTimeouts.end() && it.value() == timeout.deadline) {
+            notificationTimeouts.erase(it);
+            expiredIds.append(timeout.notificationId);
+        }
+    }
+
+    scheduleNextTimeout();
 
-    if (it == d->notifications.constEnd()) {
-        return -1;
+    // Expiring may change the notifications and their timeouts, so only do it now
+    for (uint id : qAsConst(expiredIds)) {
+        q->expire(id);
     }
+}
 
-    return std::distance(d->notifications.constBegin(), it);
+void AbstractNotificationsModel::Private::rebuildRowIndex()
+{
+    rowOfNotification.clear();
+    rowOfNotification.reserve(notifications.count());
+    updateRowIndex(0);
+}
+
+void AbstractNotificationsModel::Private::updateRowIndex(int firstRow)
+{
+    for (int row = firstRow; row < notifications.count(); ++row) {
+        rowOfNotification.insert(notifications.at(row).id(), row);
+    }
+}
+
+int AbstractNotificationsModel::rowOfNotification(uint id) const
+{
+    return d->rowOfNotification.value(id, -1);
 }
 
 AbstractNotificationsModel::AbstractNotificationsModel()
@@ -220,12 +296,13 @@ QVariant AbstractNotificationsModel::data(const QModelIndex &index, int role) co
     case Notifications::SummaryRole: return notification.summary();
     case Notifications::BodyRole: return notification.body();
     case Notifications::IconNameRole:
-        if (notification.image().isNull()) {
+        if (!notification.d->hasImage()) {
             return notification.icon();
         }
         break;
     case Notifications::ImageRole:
-        if (!notification.image().isNull()) {
+        // Decoded from the image cache only once a delegate asks for it
+        if (notification.d->hasImage()) {
             return notification.image();
         }
         break;
@@ -317,7 +394,7 @@ void AbstractNotificationsModel::startTimeout(uint notificationId)
 
 void AbstractNotificationsModel::stopTimeout(uint notificationId)
 {
-    delete d->notificationTimeouts.take(notificationId);
+    d->stopNotificationTimeout(notificationId);
 }
 
 void AbstractNotificationsModel::clear(Notifications::ClearFlags flags)
@@ -360,11 +437,15 @@ void AbstractNotificationsModel::clear(Notifications::ClearFlags flags)
 
     for (const auto &range : clearQueue) {
         beginRemoveRows(QModelIndex(), range.first, range.second);
-        for (int i = range.second; i >= range.first; --i) {
-            d->notifications.removeAt(i);
+        for (int i = range.first; i <= range.second; ++i) {
+            d->rowOfNotification.remove(d->notifications.at(i).id());
         }
+        d->notifications.remove(range.first, range.second - range.first + 1);
         endRemoveRows();
     }
+
+    // The rows after each removed range have moved, update them all at once
+    d->rebuildRowIndex();
 }
 
 void AbstractNotificationsModel::onNotificationAdded(const Notification &notification)
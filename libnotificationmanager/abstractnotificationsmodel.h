@@ -76,9 +76,9 @@ protected:
     const QVector<Notification>& notifications();
     int rowOfNotification(uint id) const;
 
+    class Private;
 
 private:
-    class Private;
     QScopedPointer<Private> d;
 
     Q_DISABLE_COPY(AbstractNotificationsModel)
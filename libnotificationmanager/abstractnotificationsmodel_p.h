@@ -25,6 +25,13 @@
 #include "server.h"
 
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QTimer>
+
+#include <functional>
+#include <queue>
+#include <vector>
 
 namespace NotificationManager
 {
@@ -35,19 +42,50 @@ public:
     explicit Private(AbstractNotificationsModel *q);
     ~Private();
 
+    // For subclasses which need to reach into the model, like the autotests
+    static Private *get(AbstractNotificationsModel *q)
+    {
+        return q->d.data();
+    }
+
     void onNotificationAdded(const Notification &notification);
     void onNotificationReplaced(uint replacedId, const Notification &notification);
     void onNotificationRemoved(uint notificationId, Server::CloseReason reason);
 
     void setupNotificationTimeout(const Notification &notification);
+    void stopNotificationTimeout(uint notificationId);
+    void scheduleNextTimeout();
+    void processTimeouts();
+
+    void rebuildRowIndex();
+    void updateRowIndex(int firstRow);
 
     AbstractNotificationsModel *q;
 
     QVector<Notification> notifications;
+    // Row of each notification in notifications, kept up to date on every change
+    QHash<uint /*notificationId*/, int /*row*/> rowOfNotification;
+
     // Fallback timeout to ensure all notifications expire eventually
     // otherwise when it isn't shown to the user and doesn't expire
     // an app might wait indefinitely for the notification to do so
-    QHash<uint /*notificationId*/, QTimer*> notificationTimeouts;
+    qint64 timeoutGracePeriod = 60000; // 1min on top of the notification's own timeout
+    struct Timeout {
+        qint64 deadline;
+        uint notificationId;
+
+        bool operator>(const Timeout &other) const {
+            return deadline > other.deadline;
+        }
+    };
+    // All timeouts are driven by a single timer for the earliest deadline.
+    // Entries whose deadline no longer matches notificationTimeouts are stale
+    // (stopped or restarted) and skipped once they come up.
+    std::priority_queue<Timeout, std::vector<Timeout>, std::greater<Timeout>> timeoutQueue;
+    QHash<uint /*notificationId*/, qint64 /*deadline*/> notificationTimeouts;
+    QTimer timeoutTimer;
+    qint64 scheduledDeadline = -1;
+    QElapsedTimer clock;
 
     QDateTime lastRead;
 
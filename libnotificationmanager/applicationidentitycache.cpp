@@ -0,0 +1,198 @@
+/*
+ * Copyright 2020 by the Plasma Workspace authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "applicationidentitycache_p.h"
+
+#include "debug.h"
+
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QStandardPaths>
+
+#include <KConfig>
+#include <KConfigGroup>
+#include <KDirWatch>
+#include <KServiceTypeTrader>
+#include <KSycoca>
+
+using namespace NotificationManager;
+
+ApplicationIdentityCache::ApplicationIdentityCache()
+    : QObject(nullptr)
+    , m_notifyRcWatch(new KDirWatch(this))
+{
+    connect(KSycoca::self(), QOverload<const QStringList &>::of(&KSycoca::databaseChanged), this, [this] {
+        m_services.clear();
+        m_flatpakRenames.clear();
+        m_flatpakRenamesValid = false;
+    });
+
+    connect(m_notifyRcWatch, &KDirWatch::created, this, &ApplicationIdentityCache::onNotifyRcChanged);
+    connect(m_notifyRcWatch, &KDirWatch::dirty, this, &ApplicationIdentityCache::onNotifyRcChanged);
+    connect(m_notifyRcWatch, &KDirWatch::deleted, this, &ApplicationIdentityCache::onNotifyRcChanged);
+}
+
+ApplicationIdentityCache::~ApplicationIdentityCache() = default;
+
+namespace NotificationManager
+{
+class ApplicationIdentityCacheSingleton
+{
+public:
+    ApplicationIdentityCache self;
+};
+}
+
+Q_GLOBAL_STATIC(ApplicationIdentityCacheSingleton, s_self)
+
+ApplicationIdentityCache &ApplicationIdentityCache::self()
+{
+    return s_self()->self;
+}
+
+ApplicationIdentityCache::Service ApplicationIdentityCache::service(const QString &desktopEntry)
+{
+    if (desktopEntry.isEmpty()) {
+        return Service();
+    }
+
+    auto it = m_services.constFind(desktopEntry);
+    if (it != m_services.constEnd()) {
+        return it.value();
+    }
+
+    Service info;
+    info.service = findService(desktopEntry);
+    if (info.service) {
+        info.desktopEntryName = info.service->desktopEntryName();
+        info.name = info.service->name();
+        info.iconName = info.service->icon();
+        info.configurable = !info.service->noDisplay();
+    }
+
+    m_services.insert(desktopEntry, info);
+    return info;
+}
+
+KService::Ptr ApplicationIdentityCache::findService(const QString &desktopEntry)
+{
+    KService::Ptr service;
+
+    if (desktopEntry.startsWith(QLatin1Char('/'))) {
+        service = KService::serviceByDesktopPath(desktopEntry);
+    } else {
+        service = KService::serviceByDesktopName(desktopEntry);
+    }
+
+    if (!service) {
+        const QString lowerDesktopEntry = desktopEntry.toLower();
+        service = KService::serviceByDesktopName(lowerDesktopEntry);
+    }
+
+    // Try if it's a renamed flatpak
+    if (!service) {
+        if (!m_flatpakRenamesValid) {
+            // HACK Querying for XDG lists in KServiceTypeTrader does not work, do it manually
+            const auto services = KServiceTypeTrader::self()->query(QStringLiteral("Application"),
+                                                                    QStringLiteral("exist Exec and exist [X-Flatpak-RenamedFrom]"));
+            for (const KService::Ptr &renamedService : services) {
+                const QVariant renamedFrom = renamedService->property(QStringLiteral("X-Flatpak-RenamedFrom"), QVariant::String);
+                const auto names = renamedFrom.toString().split(QChar(';'));
+                for (const QString &name : names) {
+                    if (!name.isEmpty() && !m_flatpakRenames.contains(name)) {
+                        m_flatpakRenames.insert(name, renamedService);
+                    }
+                }
+            }
+            m_flatpakRenamesValid = true;
+        }
+
+        service = m_flatpakRenames.value(desktopEntry + QLatin1String(".desktop"));
+    }
+
+    return service;
+}
+
+ApplicationIdentityCache::NotifyRc ApplicationIdentityCache::notifyRc(const QString &notifyRcName)
+{
+    if (notifyRcName.isEmpty()) {
+        return NotifyRc();
+    }
+
+    auto it = m_notifyRcs.constFind(notifyRcName);
+    if (it != m_notifyRcs.constEnd()) {
+        return it.value();
+    }
+
+    const NotifyRc info = readNotifyRc(notifyRcName);
+    m_notifyRcs.insert(notifyRcName, info);
+    watchNotifyRc(notifyRcName);
+    return info;
+}
+
+void ApplicationIdentityCache::watchNotifyRc(const QString &notifyRcName)
+{
+    // Applications being installed or updated can add or change their notifyrc,
+    // and the user's settings live next to the other config files
+    const QString fileName = notifyRcName + QStringLiteral(".notifyrc");
+
+    QStringList paths{QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + QLatin1Char('/') + fileName};
+    const QStringList dataDirs = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
+    for (const QString &dataDir : dataDirs) {
+        paths << dataDir + QStringLiteral("/knotifications5/") + fileName;
+    }
+
+    // Also reports the files being created
+    for (const QString &path : qAsConst(paths)) {
+        if (!m_notifyRcWatch->contains(path)) {
+            m_notifyRcWatch->addFile(path);
+        }
+    }
+}
+
+ApplicationIdentityCache::NotifyRc ApplicationIdentityCache::readNotifyRc(const QString &notifyRcName)
+{
+    NotifyRc info;
+
+    // Check whether the application actually has notifications we can configure
+    KConfig config(notifyRcName + QStringLiteral(".notifyrc"), KConfig::NoGlobals);
+    config.addConfigSources(QStandardPaths::locateAll(QStandardPaths::GenericDataLocation,
+                            QStringLiteral("knotifications5/") + notifyRcName + QStringLiteral(".notifyrc")));
+
+    KConfigGroup globalGroup(&config, "Global");
+    info.iconName = globalGroup.readEntry("IconName");
+
+    const QRegularExpression regexp(QStringLiteral("^Event/([^/]*)$"));
+    info.configurable = !config.groupList().filter(regexp).isEmpty();
+
+    return info;
+}
+
+void ApplicationIdentityCache::onNotifyRcChanged(const QString &path)
+{
+    if (!path.endsWith(QLatin1String(".notifyrc"))) {
+        return;
+    }
+
+    const QString notifyRcName = QFileInfo(path).completeBaseName();
+    if (m_notifyRcs.remove(notifyRcName)) {
+        qCDebug(NOTIFICATIONMANAGER) << "Notification configuration of" << notifyRcName << "changed";
+    }
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2020 by the Plasma Workspace authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+
+#include <KService>
+
+class KDirWatch;
+
+namespace NotificationManager
+{
+
+/**
+ * @short Resolves and caches who sent a notification
+ *
+ * Looking up the service of a desktop entry can involve a full
+ * KServiceTypeTrader scan and reading the notifyrc of an application
+ * touches several files on disk. Chatty applications would do that for
+ * every single notification, so the results are kept until the sycoca
+ * database or the notifyrc files change.
+ *
+ * This must only be used from the main thread.
+ **/
+class Q_DECL_HIDDEN ApplicationIdentityCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Service {
+        KService::Ptr service;
+        QString desktopEntryName;
+        QString name;
+        QString iconName;
+        // has a visible entry the user can configure notifications for
+        bool configurable = false;
+    };
+
+    struct NotifyRc {
+        // IconName of the Global group
+        QString iconName;
+        // has any events the user can configure
+        bool configurable = false;
+    };
+
+    ~ApplicationIdentityCache() override;
+
+    static ApplicationIdentityCache &self();
+
+    /**
+     * @return the service for @p desktopEntry, which can be a desktop file name,
+     * path, or the name a flatpak was renamed from; an empty Service if none was found
+     */
+    Service service(const QString &desktopEntry);
+
+    NotifyRc notifyRc(const QString &notifyRcName);
+
+private:
+    friend class ApplicationIdentityCacheSingleton;
+    ApplicationIdentityCache();
+    Q_DISABLE_COPY(ApplicationIdentityCache)
+
+    KService::Ptr findService(const QString &desktopEntry);
+    NotifyRc readNotifyRc(const QString &notifyRcName);
+    void watchNotifyRc(const QString &notifyRcName);
+
+    void onNotifyRcChanged(const QString &path);
+
+    // including negative results
+    QHash<QString /*desktopEntry*/, Service> m_services;
+    // X-Flatpak-RenamedFrom desktop id -> service, built on first use
+    QHash<QString, KService::Ptr> m_flatpakRenames;
+    bool m_flatpakRenamesValid = false;
+
+    QHash<QString /*notifyRcName*/, NotifyRc> m_notifyRcs;
+    KDirWatch *m_notifyRcWatch;
+
+};
+
+} // namespace NotificationManager
@@ -0,0 +1,322 @@
+/*
+ * Copyright 2020 by the Plasma Workspace authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QObject>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+#include "abstractnotificationsmodel.h"
+#include "abstractnotificationsmodel_p.h"
+#include "notification.h"
+
+using namespace NotificationManager;
+
+// Feeds notifications into the model like the server would
+class TestNotificationsModel : public AbstractNotificationsModel
+{
+public:
+    void add(uint id, int timeout = -1)
+    {
+        Notification notification(id);
+        notification.setSummary(QStringLiteral("Notification %1").arg(id));
+        notification.setTimeout(timeout);
+        onNotificationAdded(notification);
+    }
+
+    void add(const Notification &notification)
+    {
+        onNotificationAdded(notification);
+    }
+
+    void replace(uint id)
+    {
+        Notification notification(id);
+        notification.setSummary(QStringLiteral("Replaced %1").arg(id));
+        onNotificationReplaced(id, notification);
+    }
+
+    int row(uint id) const
+    {
+        return rowOfNotification(id);
+    }
+
+    // Expire notifications without waiting for the grace period
+    void setTimeoutGracePeriod(qint64 msec)
+    {
+        Private::get(this)->timeoutGracePeriod = msec;
+    }
+
+    void expire(uint notificationId) override
+    {
+        expired.insert(notificationId, clock.isValid() ? clock.elapsed() : -1);
+        onNotificationRemoved(notificationId, Server::CloseReason::Expired);
+    }
+
+    void close(uint notificationId) override
+    {
+        onNotificationRemoved(notificationId, Server::CloseReason::DismissedByUser);
+    }
+
+    void invokeDefaultAction(uint) override {}
+    void invokeAction(uint, const QString &) override {}
+    void reply(uint, const QString &) override {}
+
+    // When each notification was expired, relative to the clock
+    QHash<uint, qint64> expired;
+    QElapsedTimer clock;
+};
+
+class AbstractNotificationsModelTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+
+    void testRowIndex();
+    void testLimit();
+    void testClearExpired();
+    void testTimeouts();
+    void testImages();
+
+    void benchmarkFlood_data();
+    void benchmarkFlood();
+};
+
+static void verifyRows(const TestNotificationsModel &model)
+{
+    for (int row = 0; row < model.rowCount(); ++row) {
+        const uint id = model.index(row, 0).data(Notifications::IdRole).toUInt();
+        QCOMPARE(model.row(id), row);
+    }
+}
+
+void AbstractNotificationsModelTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QDir(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/plasma_notifications")).removeRecursively();
+}
+
+void AbstractNotificationsModelTest::testRowIndex()
+{
+    TestNotificationsModel model;
+    for (uint id = 1; id <= 10; ++id) {
+        model.add(id);
+    }
+    verifyRows(model);
+
+    model.close(3);
+    model.close(7);
+    QCOMPARE(model.rowCount(), 8);
+    QCOMPARE(model.row(3), -1);
+    QCOMPARE(model.row(7), -1);
+    verifyRows(model);
+
+    model.replace(5);
+    QCOMPARE(model.index(model.row(5), 0).data(Notifications::SummaryRole).toString(), QStringLiteral("Replaced 5"));
+    QCOMPARE(model.rowCount(), 8);
+
+    // Replacing a notification which doesn't exist adds it
+    model.replace(42);
+    QCOMPARE(model.row(42), 8);
+    verifyRows(model);
+
+    // Expired notifications stay in the history
+    model.expire(1);
+    QCOMPARE(model.row(1), 0);
+    QVERIFY(model.index(0, 0).data(Notifications::ExpiredRole).toBool());
+}
+
+void AbstractNotificationsModelTest::testLimit()
+{
+    TestNotificationsModel model;
+    for (uint id = 1; id <= 5001; ++id) {
+        model.add(id);
+    }
+
+    // Reaching the limit of 5000 discards the oldest half
+    QCOMPARE(model.rowCount(), 2501);
+    QCOMPARE(model.row(1), -1);
+    QCOMPARE(model.row(2501), 0);
+    QCOMPARE(model.row(5001), 2500);
+    verifyRows(model);
+}
+
+void AbstractNotificationsModelTest::testClearExpired()
+{
+    TestNotificationsModel model;
+    for (uint id = 1; id <= 10; ++id) {
+        model.add(id);
+    }
+    for (uint id : {2, 3, 4, 8, 10}) {
+        model.expire(id);
+    }
+
+    model.clear(Notifications::ClearExpired);
+    QCOMPARE(model.rowCount(), 5);
+    for (uint id : {2, 3, 4, 8, 10}) {
+        QCOMPARE(model.row(id), -1);
+    }
+    verifyRows(model);
+}
+
+void AbstractNotificationsModelTest::testTimeouts()
+{
+    TestNotificationsModel model;
+    model.setTimeoutGracePeriod(0);
+
+    model.clock.start();
+    model.add(1, 300);
+    model.add(2, 100);
+    model.add(3, 200);
+    model.add(4, 100);
+    model.add(5, 0); // never expires
+    model.stopTimeout(4);
+    // Restarting leaves a stale entry for the old deadline behind
+    model.add(6, 100);
+    model.startTimeout(6);
+
+    QTRY_COMPARE_WITH_TIMEOUT(model.expired.count(), 4, 5000);
+    QVERIFY(!model.expired.contains(4));
+    QVERIFY(!model.expired.contains(5));
+
+    // Late is fine, early is not
+    QVERIFY(model.expired.value(1) >= 300);
+    QVERIFY(model.expired.value(2) >= 100);
+    QVERIFY(model.expired.value(3) >= 200);
+    QVERIFY(model.expired.value(6) >= 100);
+
+    for (uint id : {1, 2, 3, 6}) {
+        QVERIFY(model.index(model.row(id), 0).data(Notifications::ExpiredRole).toBool());
+    }
+
+    // Nothing else comes up later
+    QTest::qWait(1500);
+    QCOMPARE(model.expired.count(), 4);
+}
+
+void AbstractNotificationsModelTest::testImages()
+{
+    QImage avatar(32, 32, QImage::Format_ARGB32);
+    avatar.fill(Qt::red);
+
+    QImage other(32, 32, QImage::Format_ARGB32);
+    other.fill(Qt::blue);
+
+    TestNotificationsModel model;
+    for (uint id = 1; id <= 10; ++id) {
+        Notification notification(id);
+        notification.setImage(id == 10 ? other : avatar);
+        model.add(notification);
+    }
+
+    // The images are shown from memory until they are written
+    QCOMPARE(model.index(model.row(1), 0).data(Notifications::ImageRole).value<QImage>(), avatar);
+
+    // The same image sent with several notifications is only stored once
+    const QDir imagesDir(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/plasma_notifications/images"));
+    QTRY_COMPARE(imagesDir.entryList({QStringLiteral("*.png")}, QDir::Files).count(), 2);
+
+    const QModelIndex first = model.index(model.row(1), 0);
+    QCOMPARE(first.data(Notifications::ImageRole).value<QImage>(), avatar);
+    QVERIFY(!first.data(Notifications::IconNameRole).isValid());
+    QCOMPARE(model.index(model.row(10), 0).data(Notifications::ImageRole).value<QImage>(), other);
+
+    // Notifications without an image fall back to their icon
+    Notification withoutImage(11);
+    withoutImage.setIcon(QStringLiteral("dialog-information"));
+    model.add(withoutImage);
+    const QModelIndex last = model.index(model.row(11), 0);
+    QVERIFY(!last.data(Notifications::ImageRole).isValid());
+    QCOMPARE(last.data(Notifications::IconNameRole).toString(), QStringLiteral("dialog-information"));
+
+    // Image files are read right away, applications remove their temporary files
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    QImage green(32, 32, QImage::Format_ARGB32);
+    green.fill(Qt::green);
+    const QString greenPath = tempDir.filePath(QStringLiteral("green.png"));
+    QVERIFY(green.save(greenPath));
+
+    Notification withImagePath(12);
+    withImagePath.setIcon(greenPath);
+    QVERIFY(QFile::remove(greenPath));
+    model.add(withImagePath);
+    QCOMPARE(model.index(model.row(12), 0).data(Notifications::ImageRole).value<QImage>(), green);
+    QVERIFY(!model.index(model.row(12), 0).data(Notifications::IconNameRole).isValid());
+    QTRY_COMPARE(imagesDir.entryList({QStringLiteral("*.png")}, QDir::Files).count(), 3);
+
+    // An image that can't be decoded leaves the icon to fall back to
+    const QString brokenPath = tempDir.filePath(QStringLiteral("broken.png"));
+    QFile broken(brokenPath);
+    QVERIFY(broken.open(QIODevice::WriteOnly));
+    broken.write("not an image");
+    broken.close();
+
+    Notification withBrokenImage(13);
+    withBrokenImage.setIcon(brokenPath);
+    QVERIFY(withBrokenImage.image().isNull());
+    withBrokenImage.setIcon(QStringLiteral("dialog-information"));
+    model.add(withBrokenImage);
+    const QModelIndex brokenIndex = model.index(model.row(13), 0);
+    QVERIFY(!brokenIndex.data(Notifications::ImageRole).isValid());
+    QCOMPARE(brokenIndex.data(Notifications::IconNameRole).toString(), QStringLiteral("dialog-information"));
+}
+
+void AbstractNotificationsModelTest::benchmarkFlood_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("100") << 100;
+    QTest::newRow("900") << 900;
+}
+
+void AbstractNotificationsModelTest::benchmarkFlood()
+{
+    QFETCH(int, count);
+
+    // A burst of notifications, each replaced and finally either expired or
+    // closed, like a chat or CI bot flooding the server
+    QBENCHMARK {
+        TestNotificationsModel model;
+        for (int i = 1; i <= count; ++i) {
+            model.add(i, 5000);
+        }
+        for (int i = 1; i <= count; ++i) {
+            model.replace(i);
+            model.startTimeout(i);
+        }
+        for (int i = 1; i <= count; ++i) {
+            if (i % 2) {
+                model.expire(i);
+            } else {
+                model.close(i);
+            }
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(AbstractNotificationsModelTest)
+
+#include "abstractnotificationsmodeltest.moc"
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2020 by the Plasma Workspace authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusObjectPath>
+#include <QObject>
+
+#include <algorithm>
+
+#include "jobsmodel.h"
+#include "notifications.h"
+
+using namespace NotificationManager;
+
+static const QString s_desktopEntry = QStringLiteral("org.kde.jobsmodeltest");
+
+class JobsModelTest : public QObject
+{
+    Q_OBJECT
+public Q_SLOTS:
+    // Unity LauncherEntry API
+    void launcherEntryUpdate(const QString &uri, const QVariantMap &properties);
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testBurstCoalesced();
+
+private:
+    static QString requestView();
+    static void call(const QString &path, const QString &method, const QVariantList &arguments);
+    int percentageChanges(int row) const;
+
+    JobsModel::Ptr m_model;
+    QList<QPair<QModelIndex, QVector<int>>> m_changes;
+    QList<QVariantMap> m_launcherEntryUpdates;
+};
+
+void JobsModelTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+
+    if (!QDBusConnection::sessionBus().isConnected()) {
+        QSKIP("The test needs a session bus");
+    }
+
+    m_model = JobsModel::createJobsModel();
+    if (!m_model->init()) {
+        QSKIP("Another job view server is running");
+    }
+
+    connect(m_model.data(), &QAbstractItemModel::dataChanged, this,
+            [this](const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles) {
+        Q_UNUSED(bottomRight)
+        m_changes.append(qMakePair(QModelIndex(topLeft), roles));
+    });
+
+    QVERIFY(QDBusConnection::sessionBus().connect(QString(),
+                                                  QStringLiteral("/org/kde/notificationmanager/jobs"),
+                                                  QStringLiteral("com.canonical.Unity.LauncherEntry"),
+                                                  QStringLiteral("Update"),
+                                                  this,
+                                                  SLOT(launcherEntryUpdate(QString,QVariantMap))));
+}
+
+void JobsModelTest::launcherEntryUpdate(const QString &uri, const QVariantMap &properties)
+{
+    if (uri == QLatin1String("application://") + s_desktopEntry) {
+        m_launcherEntryUpdates.append(properties);
+    }
+}
+
+QString JobsModelTest::requestView()
+{
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    QDBusMessage message = QDBusMessage::createMethodCall(bus.baseService(),
+                                                          QStringLiteral("/JobViewServer"),
+                                                          QStringLiteral("org.kde.JobViewServerV2"),
+                                                          QStringLiteral("requestView"));
+    message.setArguments({s_desktopEntry, 0, QVariantMap{{QStringLiteral("immediate"), true}}});
+
+    const QDBusMessage reply = bus.call(message);
+    if (reply.type() != QDBusMessage::ReplyMessage || reply.arguments().isEmpty()) {
+        return QString();
+    }
+    return reply.arguments().first().value<QDBusObjectPath>().path();
+}
+
+void JobsModelTest::call(const QString &path, const QString &method, const QVariantList &arguments)
+{
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    QDBusMessage message = QDBusMessage::createMethodCall(bus.baseService(),
+                                                          path,
+                                                          QStringLiteral("org.kde.JobViewV2"),
+                                                          method);
+    message.setArguments(arguments);
+    bus.call(message);
+}
+
+int JobsModelTest::percentageChanges(int row) const
+{
+    return std::count_if(m_changes.constBegin(), m_changes.constEnd(), [row](const QPair<QModelIndex, QVector<int>> &change) {
+        return change.first.row() == row && change.second.contains(Notifications::PercentageRole);
+    });
+}
+
+void JobsModelTest::testBurstCoalesced()
+{
+    const QString first = requestView();
+    const QString second = requestView();
+    QVERIFY(!first.isEmpty());
+    QVERIFY(!second.isEmpty());
+    QCOMPARE(m_model->rowCount(), 2);
+
+    QTRY_VERIFY(!m_launcherEntryUpdates.isEmpty() && m_launcherEntryUpdates.last().value(QStringLiteral("count")).toInt() == 2);
+    m_changes.clear();
+    m_launcherEntryUpdates.clear();
+
+    // A copy job reporting every single percent
+    for (uint percent = 1; percent <= 100; ++percent) {
+        call(first, QStringLiteral("setPercent"), {percent});
+        call(second, QStringLiteral("setPercent"), {percent / 2});
+    }
+
+    QTRY_COMPARE(m_model->index(0, 0).data(Notifications::PercentageRole).toInt(), 100);
+    QTRY_COMPARE(m_model->index(1, 0).data(Notifications::PercentageRole).toInt(), 50);
+    QTRY_VERIFY(!m_launcherEntryUpdates.isEmpty()
+                && m_launcherEntryUpdates.last().value(QStringLiteral("progress")).toDouble() == 0.75);
+
+    // The views and the task manager only see a few of the 200 changes
+    QVERIFY(percentageChanges(0) <= 2);
+    QVERIFY(percentageChanges(1) <= 2);
+    QVERIFY(m_launcherEntryUpdates.count() <= 2);
+    QCOMPARE(m_launcherEntryUpdates.last().value(QStringLiteral("count")).toInt(), 2);
+
+    // A finished job no longer counts towards the application's progress
+    call(first, QStringLiteral("terminate"), {QString()});
+    QTRY_COMPARE(m_launcherEntryUpdates.last().value(QStringLiteral("count")).toInt(), 1);
+    QCOMPARE(m_launcherEntryUpdates.last().value(QStringLiteral("progress")).toDouble(), 0.5);
+
+    call(second, QStringLiteral("terminate"), {QString()});
+    QTRY_COMPARE(m_launcherEntryUpdates.last().value(QStringLiteral("count")).toInt(), 0);
+    QCOMPARE(m_launcherEntryUpdates.last().value(QStringLiteral("progress-visible")).toBool(), false);
+}
+
+QTEST_GUILESS_MAIN(JobsModelTest)
+
+#include "jobsmodeltest.moc"
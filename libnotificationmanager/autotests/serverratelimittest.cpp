@@ -0,0 +1,154 @@
+/*
+ * Copyright 2020 by the Plasma Workspace authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QObject>
+
+#include "ratelimit_p.h"
+
+using namespace NotificationManager;
+
+// The server defaults
+static const int s_burst = 20;
+static const int s_perMinute = 60;
+
+class ServerRateLimitTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testFlood();
+    void testTrickle();
+    void testFullBucketEndsBurst();
+    void testQuietMinuteEndsBurst();
+    void testSummaryClosed();
+    void testCriticalExempt();
+
+private:
+    static int flood(RateLimit &rateLimit, qint64 now, int count);
+};
+
+// @return how many of the @p count notifications were accepted
+int ServerRateLimitTest::flood(RateLimit &rateLimit, qint64 now, int count)
+{
+    int accepted = 0;
+    for (int i = 0; i < count; ++i) {
+        if (rateLimit.take(now, s_burst, s_perMinute)) {
+            ++accepted;
+        }
+    }
+    return accepted;
+}
+
+void ServerRateLimitTest::testFlood()
+{
+    RateLimit rateLimit;
+
+    QCOMPARE(flood(rateLimit, 1000, 30), 20);
+
+    QCOMPARE(rateLimit.accepted, 20u);
+    QCOMPARE(rateLimit.suppressed, 10u);
+    QCOMPARE(rateLimit.suppressedInBurst, 10u);
+    QCOMPARE(rateLimit.bursts, 1u);
+}
+
+void ServerRateLimitTest::testTrickle()
+{
+    RateLimit rateLimit;
+    QCOMPARE(flood(rateLimit, 1000, 30), 20);
+    rateLimit.summaryId = 42;
+
+    // A single token coming back doesn't end the burst, the same summary keeps counting
+    QVERIFY(rateLimit.take(2000, s_burst, s_perMinute));
+    QVERIFY(!rateLimit.take(2000, s_burst, s_perMinute));
+
+    QCOMPARE(rateLimit.summaryId, 42u);
+    QCOMPARE(rateLimit.suppressedInBurst, 11u);
+    QCOMPARE(rateLimit.suppressed, 11u);
+    QCOMPARE(rateLimit.bursts, 1u);
+
+    // Neither does half a token
+    QVERIFY(!rateLimit.take(2500, s_burst, s_perMinute));
+    QCOMPARE(rateLimit.suppressedInBurst, 12u);
+}
+
+void ServerRateLimitTest::testFullBucketEndsBurst()
+{
+    RateLimit rateLimit;
+    QCOMPARE(flood(rateLimit, 1000, 30), 20);
+    rateLimit.summaryId = 42;
+
+    // 20 seconds later the bucket is full again
+    QCOMPARE(flood(rateLimit, 21000, 21), 20);
+
+    QCOMPARE(rateLimit.summaryId, 0u);
+    QCOMPARE(rateLimit.suppressedInBurst, 1u);
+    QCOMPARE(rateLimit.suppressed, 11u);
+    QCOMPARE(rateLimit.bursts, 2u);
+}
+
+void ServerRateLimitTest::testQuietMinuteEndsBurst()
+{
+    // Slow enough that the bucket isn't full again after a minute
+    const int perMinute = 2;
+
+    RateLimit rateLimit;
+    for (int i = 0; i < s_burst; ++i) {
+        QVERIFY(rateLimit.take(0, s_burst, perMinute));
+    }
+    QVERIFY(!rateLimit.take(0, s_burst, perMinute));
+    rateLimit.summaryId = 42;
+
+    QVERIFY(rateLimit.take(59999, s_burst, perMinute));
+    QVERIFY(!rateLimit.take(59999, s_burst, perMinute));
+    QCOMPARE(rateLimit.summaryId, 42u);
+    QCOMPARE(rateLimit.suppressedInBurst, 2u);
+
+    QVERIFY(rateLimit.take(119999, s_burst, perMinute));
+    QCOMPARE(rateLimit.summaryId, 0u);
+    QCOMPARE(rateLimit.suppressedInBurst, 0u);
+    QCOMPARE(rateLimit.bursts, 1u);
+}
+
+void ServerRateLimitTest::testSummaryClosed()
+{
+    RateLimit rateLimit;
+    QCOMPARE(flood(rateLimit, 1000, 30), 20);
+    rateLimit.summaryId = 42;
+
+    rateLimit.endBurst();
+
+    // The next suppressed notification needs a new summary
+    QVERIFY(!rateLimit.take(1000, s_burst, s_perMinute));
+    QCOMPARE(rateLimit.summaryId, 0u);
+    QCOMPARE(rateLimit.suppressedInBurst, 1u);
+    QCOMPARE(rateLimit.bursts, 2u);
+}
+
+void ServerRateLimitTest::testCriticalExempt()
+{
+    QVERIFY(RateLimit::isExempt({{QStringLiteral("urgency"), QVariant::fromValue<uchar>(2)}}));
+    QVERIFY(!RateLimit::isExempt({{QStringLiteral("urgency"), QVariant::fromValue<uchar>(1)}}));
+    QVERIFY(!RateLimit::isExempt({{QStringLiteral("urgency"), QVariant::fromValue<uchar>(0)}}));
+    QVERIFY(!RateLimit::isExempt({}));
+}
+
+QTEST_GUILESS_MAIN(ServerRateLimitTest)
+
+#include "serverratelimittest.moc"
@@ -46,6 +46,20 @@
 
 using namespace NotificationManager;
 
+namespace {
+// Bounds for how often changes of a single running job are announced, the
+// more jobs are running the less often each of them is updated
+const int s_minJobUpdateInterval = 100;
+const int s_maxJobUpdateInterval = 1000;
+const int s_jobUpdateIntervalPerJob = 10;
+
+// Roles which change all the time while a job is running
+bool isProgressRole(int role)
+{
+    return role == Notifications::PercentageRole || role == Notifications::BodyRole;
+}
+}
+
 JobsModelPrivate::JobsModelPrivate(QObject *parent)
     : QObject(parent)
     , m_serviceWatcher(new QDBusServiceWatcher(this))
@@ -56,27 +70,10 @@ JobsModelPrivate::JobsModelPrivate(QObject *parent)
     m_serviceWatcher->setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
     connect(m_serviceWatcher, &QDBusServiceWatcher::serviceUnregistered, this, &JobsModelPrivate::onServiceUnregistered);
 
-    m_compressUpdatesTimer->setInterval(0);
-    m_compressUpdatesTimer->setSingleShot(true);
-    connect(m_compressUpdatesTimer, &QTimer::timeout, this, [this] {
-        for (auto it = m_pendingDirtyRoles.constBegin(), end = m_pendingDirtyRoles.constEnd(); it != end; ++it) {
-            Job *job = it.key();
-            const QVector<int> roles = it.value();
-            const int row = m_jobViews.indexOf(job);
-            if (row == -1) {
-                continue;
-            }
-
-            emit jobViewChanged(row, job, roles);
+    m_clock.start();
 
-            // This is updated here and not the percentageChanged signal so we also get some batching out of it
-            if (roles.contains(Notifications::PercentageRole)) {
-                updateApplicationPercentage(job->desktopEntry());
-            }
-        }
-
-        m_pendingDirtyRoles.clear();
-    });
+    m_compressUpdatesTimer->setSingleShot(true);
+    connect(m_compressUpdatesTimer, &QTimer::timeout, this, &JobsModelPrivate::flushPendingUpdates);
 
     m_pendingJobViewsTimer->setInterval(500);
     m_pendingJobViewsTimer->setSingleShot(true);
@@ -90,11 +87,7 @@ JobsModelPrivate::JobsModelPrivate(QObject *parent)
                 continue;
             }
 
-            const int newRow = m_jobViews.count();
-            emit jobViewAboutToBeAdded(newRow, job);
-            m_jobViews.append(job);
-            emit jobViewAdded(newRow, job);
-            updateApplicationPercentage(job->desktopEntry());
+            appendJobView(job);
         }
 
         m_pendingJobViews.clear();
@@ -108,23 +101,23 @@ JobsModelPrivate::~JobsModelPrivate()
     sessionBus.unregisterService(QStringLiteral("org.kde.kuiserver"));
     sessionBus.unregisterObject(QStringLiteral("/JobViewServer"));
 
-    // Remember which services we had running and clear their progress
-    QStringList desktopEntries;
-    for (Job *job : qAsConst(m_jobViews)) {
-        if (!desktopEntries.contains(job->desktopEntry())) {
-            desktopEntries.append(job->desktopEntry());
-        }
-    }
-
     qDeleteAll(m_jobViews);
     m_jobViews.clear();
+    m_jobRows.clear();
     qDeleteAll(m_pendingJobViews);
     m_pendingJobViews.clear();
 
     m_pendingDirtyRoles.clear();
+    m_lastJobUpdates.clear();
+    m_jobProgress.clear();
 
+    // Clear the progress of all applications we had announced any
+    const QStringList desktopEntries = m_applicationProgress.keys();
     for (const QString &desktopEntry : desktopEntries) {
-        updateApplicationPercentage(desktopEntry);
+        ApplicationProgress &progress = m_applicationProgress[desktopEntry];
+        progress.percentageSum = 0;
+        progress.count = 0;
+        sendApplicationProgress(desktopEntry);
     }
 }
 
@@ -335,12 +328,13 @@ QDBusObjectPath JobsModelPrivate::requestView(const QString &desktopEntry,
 
         if (job->state() == Notifications::JobStateStopped) {
             unwatchJob(job);
-            updateApplicationPercentage(job->desktopEntry());
             emitJobUrlsChanged();
         }
+        updateJobProgress(job);
     });
     connect(job, &Job::percentageChanged, this, [this, job] {
         scheduleUpdate(job, Notifications::PercentageRole);
+        updateJobProgress(job);
     });
     connect(job, &Job::errorChanged, this, [this, job] {
         scheduleUpdate(job, Notifications::JobErrorRole);
@@ -360,18 +354,16 @@ QDBusObjectPath JobsModelPrivate::requestView(const QString &desktopEntry,
 
     // Delay showing a job view by 500ms to avoid showing really short stat jobs and other useless stuff
     if (hints.value(QStringLiteral("immediate")).toBool()) {
-        const int newRow = m_jobViews.count();
-        emit jobViewAboutToBeAdded(newRow, job);
-        m_jobViews.append(job);
-        emit jobViewAdded(newRow, job);
-        updateApplicationPercentage(job->desktopEntry());
+        appendJobView(job);
     } else {
         m_pendingJobViews.append(job);
         m_pendingJobViewsTimer->start();
     }
 
     m_jobServices.insert(job, serviceName);
-    m_serviceWatcher->addWatchedService(serviceName);
+    if (++m_serviceJobCounts[serviceName] == 1) {
+        m_serviceWatcher->addWatchedService(serviceName);
+    }
 
     if (!connection().interface()->isServiceRegistered(serviceName)) {
         qCWarning(NOTIFICATIONMANAGER) << "Service that requested the view wasn't registered anymore by the time the request was being processed";
@@ -383,24 +375,41 @@ QDBusObjectPath JobsModelPrivate::requestView(const QString &desktopEntry,
     return job->d->objectPath();
 }
 
+void JobsModelPrivate::appendJobView(Job *job)
+{
+    const int newRow = m_jobViews.count();
+    emit jobViewAboutToBeAdded(newRow, job);
+    m_jobViews.append(job);
+    m_jobRows.insert(job, newRow);
+    emit jobViewAdded(newRow, job);
+
+    updateJobProgress(job);
+}
+
 void JobsModelPrivate::remove(Job *job)
 {
-    const int activeRow = m_jobViews.indexOf(job);
-    const int pendingRow = m_pendingJobViews.indexOf(job);
+    const int activeRow = m_jobRows.value(job, -1);
+    const int pendingRow = activeRow == -1 ? m_pendingJobViews.indexOf(job) : -1;
 
     Job *jobToBeRemoved = nullptr;
 
     if (activeRow > -1) {
         emit jobViewAboutToBeRemoved(activeRow);
         jobToBeRemoved = m_jobViews.takeAt(activeRow);
+        m_jobRows.remove(jobToBeRemoved);
+        for (int row = activeRow; row < m_jobViews.count(); ++row) {
+            m_jobRows[m_jobViews.at(row)] = row;
+        }
     } else if (pendingRow > -1) {
         jobToBeRemoved = m_pendingJobViews.takeAt(pendingRow);
     }
     Q_ASSERT(jobToBeRemoved);
 
     m_pendingDirtyRoles.remove(jobToBeRemoved);
+    m_lastJobUpdates.remove(jobToBeRemoved);
 
-    const QString desktopEntry = jobToBeRemoved->desktopEntry();
+    // No longer in m_jobRows, so this drops it from its application's progress
+    updateJobProgress(jobToBeRemoved);
 
     unwatchJob(jobToBeRemoved);
 
@@ -408,8 +417,6 @@ void JobsModelPrivate::remove(Job *job)
     if (activeRow > -1) {
         emit jobViewRemoved(activeRow);
     }
-
-    updateApplicationPercentage(desktopEntry);
 }
 
 void JobsModelPrivate::removeAt(int row)
@@ -418,31 +425,71 @@ void JobsModelPrivate::removeAt(int row)
     remove(m_jobViews.at(row));
 }
 
+// Keeps the running sums of the application progress up to date, this is called
+// whenever the percentage or state of a job changes or it is added or removed.
+void JobsModelPrivate::updateJobProgress(Job *job)
+{
+    const bool running = m_jobRows.contains(job) && job->state() != Notifications::JobStateStopped;
+
+    QString desktopEntry;
+
+    auto it = m_jobProgress.find(job);
+    if (it != m_jobProgress.end()) {
+        if (running && it->percentage == job->percentage()) {
+            return;
+        }
+
+        desktopEntry = it->desktopEntry;
+        ApplicationProgress &progress = m_applicationProgress[desktopEntry];
+        progress.percentageSum -= it->percentage;
+
+        if (running) {
+            it->percentage = job->percentage();
+            progress.percentageSum += it->percentage;
+        } else {
+            --progress.count;
+            m_jobProgress.erase(it);
+        }
+    } else if (running) {
+        desktopEntry = job->desktopEntry();
+        ApplicationProgress &progress = m_applicationProgress[desktopEntry];
+        progress.percentageSum += job->percentage();
+        ++progress.count;
+        JobProgress &jobProgress = m_jobProgress[job];
+        jobProgress.desktopEntry = desktopEntry;
+        jobProgress.percentage = job->percentage();
+    } else {
+        return;
+    }
+
+    if (!desktopEntry.isEmpty()) {
+        m_dirtyApplications.insert(desktopEntry);
+        scheduleFlush(!running);
+    }
+}
+
 // This will forward overall application process via Unity API.
 // This way users of that like Task Manager and Latte Dock still get basic job information.
-void JobsModelPrivate::updateApplicationPercentage(const QString &desktopEntry)
+void JobsModelPrivate::sendApplicationProgress(const QString &desktopEntry)
 {
-    if (desktopEntry.isEmpty()) {
+    auto it = m_applicationProgress.find(desktopEntry);
+    if (it == m_applicationProgress.end()) {
         return;
     }
 
-    int jobsPercentages = 0;
-    int jobsCount = 0;
+    const int jobsCount = it->count;
+    const int percentage = jobsCount > 0 ? it->percentageSum / jobsCount : 0;
 
-    for (int i = 0; i < m_jobViews.count(); ++i) {
-        Job *job = m_jobViews.at(i);
-        if (job->state() == Notifications::JobStateStopped
-                || job->desktopEntry() != desktopEntry) {
-            continue;
-        }
+    const bool changed = jobsCount != it->sentCount || percentage != it->sentPercentage;
+    it->sentCount = jobsCount;
+    it->sentPercentage = percentage;
 
-        jobsPercentages += job->percentage();
-        ++jobsCount;
+    if (jobsCount == 0) {
+        m_applicationProgress.erase(it);
     }
 
-    int percentage = 0;
-    if (jobsCount > 0) {
-        percentage = jobsPercentages / jobsCount;
+    if (desktopEntry.isEmpty() || !changed) {
+        return;
     }
 
     const QVariantMap properties = {
@@ -463,12 +510,17 @@ void JobsModelPrivate::updateApplicationPercentage(const QString &desktopEntry)
 
 void JobsModelPrivate::unwatchJob(Job *job)
 {
-    const QString serviceName = m_jobServices.take(job);
+    auto it = m_jobServices.find(job);
+    if (it == m_jobServices.end()) {
+        return;
+    }
+
+    const QString serviceName = it.value();
+    m_jobServices.erase(it);
+
     // Check if there's any jobs left for this service, otherwise stop watching it
-    auto it = std::find_if(m_jobServices.constBegin(), m_jobServices.constEnd(), [&serviceName](const QString &item) {
-        return item == serviceName;
-    });
-    if (it == m_jobServices.constEnd()) {
+    if (--m_serviceJobCounts[serviceName] == 0) {
+        m_serviceJobCounts.remove(serviceName);
         m_serviceWatcher->removeWatchedService(serviceName);
     }
 }
@@ -499,6 +551,76 @@ void JobsModelPrivate::onServiceUnregistered(const QString &serviceName)
 
 void JobsModelPrivate::scheduleUpdate(Job *job, Notifications::Roles role)
 {
-    m_pendingDirtyRoles[job].append(role);
-    m_compressUpdatesTimer->start();
+    QVector<int> &roles = m_pendingDirtyRoles[job];
+    if (!roles.contains(role)) {
+        roles.append(role);
+    }
+    scheduleFlush(!isProgressRole(role));
+}
+
+void JobsModelPrivate::scheduleFlush(bool immediately)
+{
+    // A running timer is waiting for throttled progress updates, which
+    // will then be flushed together with this one
+    if (immediately || !m_compressUpdatesTimer->isActive()) {
+        m_compressUpdatesTimer->start(0);
+    }
+}
+
+int JobsModelPrivate::jobUpdateInterval() const
+{
+    return qBound(s_minJobUpdateInterval, m_jobProgress.count() * s_jobUpdateIntervalPerJob, s_maxJobUpdateInterval);
+}
+
+void JobsModelPrivate::flushPendingUpdates()
+{
+    const qint64 now = m_clock.elapsed();
+    const int interval = jobUpdateInterval();
+    qint64 nextFlush = -1;
+
+    // Changes can be scheduled again while the views handle the signal
+    const QHash<Job *, QVector<int>> pendingDirtyRoles = m_pendingDirtyRoles;
+    m_pendingDirtyRoles.clear();
+
+    for (auto it = pendingDirtyRoles.constBegin(), end = pendingDirtyRoles.constEnd(); it != end; ++it) {
+        Job *job = it.key();
+        const QVector<int> &roles = it.value();
+        // The job might have been removed, also while handling the signal for another one
+        if (!m_jobRows.contains(job)) {
+            continue;
+        }
+
+        // Only progress changes of running jobs are throttled, anything else,
+        // including the final state of a job, is announced right away
+        if (job->state() != Notifications::JobStateStopped
+                && std::all_of(roles.constBegin(), roles.constEnd(), isProgressRole)) {
+            auto lastUpdateIt = m_lastJobUpdates.constFind(job);
+            if (lastUpdateIt != m_lastJobUpdates.constEnd() && now - lastUpdateIt.value() < interval) {
+                const qint64 due = lastUpdateIt.value() + interval;
+                nextFlush = nextFlush == -1 ? due : qMin(nextFlush, due);
+
+                QVector<int> &pendingRoles = m_pendingDirtyRoles[job];
+                for (int role : roles) {
+                    if (!pendingRoles.contains(role)) {
+                        pendingRoles.append(role);
+                    }
+                }
+                continue;
+            }
+        }
+
+        m_lastJobUpdates.insert(job, now);
+        emit jobViewChanged(m_jobRows.value(job), job, roles);
+    }
+
+    const QSet<QString> dirtyApplications = m_dirtyApplications;
+    m_dirtyApplications.clear();
+    for (const QString &desktopEntry : dirtyApplications) {
+        sendApplicationProgress(desktopEntry);
+    }
+
+    // Unless something else was scheduled meanwhile, wake up again for the throttled updates
+    if (nextFlush != -1 && !m_compressUpdatesTimer->isActive()) {
+        m_compressUpdatesTimer->start(int(qMax<qint64>(0, nextFlush - now)));
+    }
 }
@@ -23,6 +23,8 @@
 #include <QObject>
 #include <QDBusContext>
 #include <QDBusObjectPath>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QSet>
 #include <QVector>
 
@@ -82,21 +84,52 @@ public: // stuff used by public class
     QVector<Job *> m_jobViews;
 
 private:
+    struct JobProgress {
+        QString desktopEntry;
+        int percentage = 0;
+    };
+
+    struct ApplicationProgress {
+        int percentageSum = 0;
+        int count = 0;
+        // what was last announced via the Unity LauncherEntry API
+        int sentPercentage = -1;
+        int sentCount = -1;
+    };
+
+    void appendJobView(Job *job);
+
     void unwatchJob(Job *job);
     void onServiceUnregistered(const QString &serviceName);
 
-    void updateApplicationPercentage(const QString &desktopEntry);
+    void updateJobProgress(Job *job);
+    void sendApplicationProgress(const QString &desktopEntry);
 
     QStringList jobUrls() const;
     void scheduleUpdate(Job *job, Notifications::Roles role);
+    void scheduleFlush(bool immediately);
+    void flushPendingUpdates();
+    int jobUpdateInterval() const;
 
     QDBusServiceWatcher *m_serviceWatcher = nullptr;
     // Job -> serviceName
     QHash<Job *, QString> m_jobServices;
+    QHash<QString, int> m_serviceJobCounts;
     int m_highestJobId = 1;
 
+    // Job -> row in m_jobViews
+    QHash<Job *, int> m_jobRows;
+
+    // Running jobs in m_jobViews and what they contribute to their application's progress
+    QHash<Job *, JobProgress> m_jobProgress;
+    QHash<QString /*desktopEntry*/, ApplicationProgress> m_applicationProgress;
+    QSet<QString> m_dirtyApplications;
+
     QTimer *m_compressUpdatesTimer = nullptr;
     QHash<Job *, QVector<int>> m_pendingDirtyRoles;
+    QElapsedTimer m_clock;
+    // Job -> m_clock time its last change was announced
+    QHash<Job *, qint64> m_lastJobUpdates;
 
     QTimer *m_pendingJobViewsTimer = nullptr;
     QVector<Job *> m_pendingJobViews;
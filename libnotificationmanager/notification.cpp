@@ -25,6 +25,9 @@
 
 #include "notifications.h"
 
+#include "applicationidentitycache_p.h"
+#include "notificationimagecache_p.h"
+
 #include <QDBusArgument>
 #include <QDateTime>
 #include <QDebug>
@@ -33,10 +36,7 @@
 #include <QRegularExpression>
 #include <QXmlStreamReader>
 
-#include <KConfig>
-#include <KConfigGroup>
 #include <KService>
-#include <KServiceTypeTrader>
 
 #include "debug.h"
 
@@ -223,6 +223,7 @@ void Notification::Private::loadImagePath(const QString &path)
     // We're lenient and also allow local paths.
 
     image = QImage(); // clear
+    storedImage.reset();
     icon.clear();
 
     QUrl imageUrl;
@@ -243,16 +244,38 @@ void Notification::Private::loadImagePath(const QString &path)
         return;
     }
 
+    // Applications often pass temporary files which are gone by the time the
+    // notification is shown, so decode it now and store it like image-data
     QImageReader reader(imageUrl.toLocalFile());
     reader.setAutoTransform(true);
 
     const QSize imageSize = reader.size();
-    if (imageSize.isValid() && (imageSize.width() > maximumImageSize().width() || imageSize.height() > maximumImageSize().height())) {
-        const QSize thumbnailSize = imageSize.scaled(maximumImageSize(), Qt::KeepAspectRatio);
-        reader.setScaledSize(thumbnailSize);
+    const QSize max = maximumImageSize();
+    if (imageSize.isValid() && (imageSize.width() > max.width() || imageSize.height() > max.height())) {
+        reader.setScaledSize(imageSize.scaled(max, Qt::KeepAspectRatio));
     }
 
     image = reader.read();
+    if (image.isNull()) {
+        qCDebug(NOTIFICATIONMANAGER) << "Failed to load notification image" << path << reader.errorString();
+    }
+}
+
+void Notification::Private::storeImage()
+{
+    if (image.isNull()) {
+        return;
+    }
+
+    storedImage = NotificationImageCache::self().insert(image);
+    if (storedImage) {
+        image = QImage();
+    }
+}
+
+bool Notification::Private::hasImage() const
+{
+    return !image.isNull() || !storedImage.isNull();
 }
 
 QString Notification::Private::defaultComponentName()
@@ -268,38 +291,7 @@ QSize Notification::Private::maximumImageSize()
 
 KService::Ptr Notification::Private::serviceForDesktopEntry(const QString &desktopEntry)
 {
-    KService::Ptr service;
-
-    if (desktopEntry.startsWith(QLatin1Char('/'))) {
-        service = KService::serviceByDesktopPath(desktopEntry);
-    } else {
-        service = KService::serviceByDesktopName(desktopEntry);
-    }
-
-    if (!service) {
-        const QString lowerDesktopEntry = desktopEntry.toLower();
-        service = KService::serviceByDesktopName(lowerDesktopEntry);
-    }
-
-    // Try if it's a renamed flatpak
-    if (!service) {
-        const QString desktopId = desktopEntry + QLatin1String(".desktop");
-        // HACK Querying for XDG lists in KServiceTypeTrader does not work, do it manually
-        const auto services = KServiceTypeTrader::self()->query(QStringLiteral("Application"),
-                                                                QStringLiteral("exist Exec and exist [X-Flatpak-RenamedFrom]"));
-        for (auto it = services.constBegin(); it != services.constEnd() && !service; ++it) {
-            const QVariant renamedFrom = (*it)->property(QStringLiteral("X-Flatpak-RenamedFrom"), QVariant::String);
-            const auto names = renamedFrom.toString().split(QChar(';'));
-            for (const QString &name : names) {
-                if (name == desktopId) {
-                    service = *it;
-                    break;
-                }
-            }
-        }
-    }
-
-    return service;
+    return ApplicationIdentityCache::self().service(desktopEntry).service;
 }
 
 void Notification::Private::setDesktopEntry(const QString &desktopEntry)
@@ -308,33 +300,25 @@ void Notification::Private::setDesktopEntry(const QString &desktopEntry)
 
     configurableService = false;
 
-    KService::Ptr service = serviceForDesktopEntry(desktopEntry);
-    if (service) {
-        this->desktopEntry = service->desktopEntryName();
-        serviceName = service->name();
-        applicationIconName = service->icon();
-        configurableService = !service->noDisplay();
+    const ApplicationIdentityCache::Service service = ApplicationIdentityCache::self().service(desktopEntry);
+    if (service.service) {
+        this->desktopEntry = service.desktopEntryName;
+        serviceName = service.name;
+        applicationIconName = service.iconName;
+        configurableService = service.configurable;
     }
 
     const bool isDefaultEvent = (notifyRcName == defaultComponentName());
     configurableNotifyRc = false;
     if (!notifyRcName.isEmpty()) {
-        // Check whether the application actually has notifications we can configure
-        KConfig config(notifyRcName + QStringLiteral(".notifyrc"), KConfig::NoGlobals);
-        config.addConfigSources(QStandardPaths::locateAll(QStandardPaths::GenericDataLocation,
-                                QStringLiteral("knotifications5/") + notifyRcName + QStringLiteral(".notifyrc")));
-
-        KConfigGroup globalGroup(&config, "Global");
-
-        const QString iconName = globalGroup.readEntry("IconName");
+        const ApplicationIdentityCache::NotifyRc notifyRc = ApplicationIdentityCache::self().notifyRc(notifyRcName);
 
         // also only overwrite application icon name for non-default events (or if we don't have a service icon)
-        if (!iconName.isEmpty() && (!isDefaultEvent || applicationIconName.isEmpty())) {
-            applicationIconName = iconName;
+        if (!notifyRc.iconName.isEmpty() && (!isDefaultEvent || applicationIconName.isEmpty())) {
+            applicationIconName = notifyRc.iconName;
         }
 
-        const QRegularExpression regexp(QStringLiteral("^Event/([^/]*)$"));
-        configurableNotifyRc = !config.groupList().filter(regexp).isEmpty();
+        configurableNotifyRc = notifyRc.configurable;
     }
 
     // For default events we try to show the application name from the desktop entry if possible
@@ -409,9 +393,10 @@ void Notification::Private::processHints(const QVariantMap &hints)
 
     if (it != end) {
         image = decodeNotificationSpecImageHint(it->value<QDBusArgument>());
+        storedImage.reset();
     }
 
-    if (image.isNull()) {
+    if (!hasImage()) {
         it = hints.find(QStringLiteral("image-path"));
         if (it == end) {
             it = hints.find(QStringLiteral("image_path"));
@@ -423,6 +408,7 @@ void Notification::Private::processHints(const QVariantMap &hints)
     }
 
     sanitizeImage(image);
+    storeImage();
 }
 
 void Notification::Private::setUrgency(Notifications::Urgency urgency)
@@ -550,16 +536,22 @@ void Notification::setIcon(const QString &icon)
 {
     d->loadImagePath(icon);
     Private::sanitizeImage(d->image);
+    d->storeImage();
 }
 
 QImage Notification::image() const
 {
+    if (d->storedImage) {
+        return NotificationImageCache::self().image(d->storedImage);
+    }
     return d->image;
 }
 
 void Notification::setImage(const QImage &image)
 {
     d->image = image;
+    d->storedImage.reset();
+    d->storeImage();
 }
 
 QString Notification::desktopEntry() const
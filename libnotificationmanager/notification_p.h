@@ -31,6 +31,7 @@
 #include <KService>
 
 #include "notifications.h"
+#include "notificationimagecache_p.h"
 
 namespace NotificationManager
 {
@@ -46,6 +47,9 @@ public:
     static void sanitizeImage(QImage &image);
 
     void loadImagePath(const QString &path);
+    // Moves the image into the NotificationImageCache
+    void storeImage();
+    bool hasImage() const;
 
     static QString defaultComponentName();
     static QSize maximumImageSize();
@@ -70,7 +74,10 @@ public:
     QString rawBody;
     // Can be theme icon name or path
     QString icon;
+    // Only set until the image is stored, or if it couldn't be stored
     QImage image;
+    // Image in the NotificationImageCache
+    NotificationImageCache::Handle storedImage;
 
     QString applicationName;
     QString desktopEntry;
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2020 by the Plasma Workspace authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "notificationimagecache_p.h"
+
+#include "debug.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrentRun>
+
+using namespace NotificationManager;
+
+namespace {
+// Decoded images kept in memory, in KiB
+const int s_memoryCacheSize = 16 * 1024;
+// Images which haven't been stored again for this long are removed on startup
+const qint64 s_maxAgeSecs = 30 * 24 * 60 * 60;
+// Storing an image again only refreshes its file time when it is older than this
+const qint64 s_touchIntervalSecs = 24 * 60 * 60;
+
+int imageCost(const QImage &image)
+{
+    return qMax(1, int(image.sizeInBytes() / 1024));
+}
+
+// Runs in a worker thread, returns the path of the file or an empty string
+QString writeImage(const QImage &image, const QString &directory)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    const qint32 header[] = {image.width(), image.height(), static_cast<qint32>(image.format())};
+    hash.addData(reinterpret_cast<const char *>(header), sizeof(header));
+
+    // Scan lines can be padded with uninitialized bytes, only hash the actual pixels
+    const int lineLength = (image.width() * image.depth() + 7) / 8;
+    for (int y = 0; y < image.height(); ++y) {
+        hash.addData(reinterpret_cast<const char *>(image.constScanLine(y)), lineLength);
+    }
+
+    const QString path = directory + QLatin1Char('/') + QString::fromLatin1(hash.result().toHex()) + QLatin1String(".png");
+
+    const QFileInfo info(path);
+    if (info.exists()) {
+        // Keep it from being considered stale
+        if (info.lastModified().secsTo(QDateTime::currentDateTime()) > s_touchIntervalSecs) {
+            QFile file(path);
+            if (file.open(QIODevice::ReadWrite)) {
+                file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+            }
+        }
+        return path;
+    }
+
+    // Identical images stored at the same time end up as the same file, QSaveFile makes that safe
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || !image.save(&file, "PNG") || !file.commit()) {
+        qCWarning(NOTIFICATIONMANAGER) << "Failed to store notification image" << path << file.errorString();
+        return QString();
+    }
+
+    return path;
+}
+}
+
+namespace NotificationManager
+{
+class NotificationImageCacheSingleton
+{
+public:
+    NotificationImageCache self;
+};
+}
+
+Q_GLOBAL_STATIC(NotificationImageCacheSingleton, s_self)
+
+NotificationImageCache::NotificationImageCache()
+    : QObject(nullptr)
+    , m_directory(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/plasma_notifications/images"))
+{
+    m_images.setMaxCost(s_memoryCacheSize);
+
+    if (!QDir().mkpath(m_directory)) {
+        qCWarning(NOTIFICATIONMANAGER) << "Failed to create notification image cache" << m_directory;
+    }
+
+    removeStaleFiles();
+}
+
+NotificationImageCache::~NotificationImageCache() = default;
+
+NotificationImageCache &NotificationImageCache::self()
+{
+    return s_self()->self;
+}
+
+QString NotificationImageCache::directory() const
+{
+    return m_directory;
+}
+
+NotificationImageCache::Handle NotificationImageCache::insert(const QImage &image)
+{
+    if (image.isNull()) {
+        return Handle();
+    }
+
+    // Until it is written, the image is shown from memory
+    Handle handle(new Entry);
+    handle->image = image;
+
+    auto *watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher, handle] {
+        const QString path = watcher->result();
+        watcher->deleteLater();
+
+        if (path.isEmpty()) {
+            return;
+        }
+
+        // It is most likely about to be shown in a popup
+        m_images.insert(path, new QImage(handle->image), imageCost(handle->image));
+
+        handle->filePath = path;
+        handle->image = QImage();
+    });
+    watcher->setFuture(QtConcurrent::run(writeImage, image, m_directory));
+
+    return handle;
+}
+
+QImage NotificationImageCache::image(const Handle &handle)
+{
+    if (!handle) {
+        return QImage();
+    }
+
+    if (handle->filePath.isEmpty()) {
+        return handle->image;
+    }
+
+    if (const QImage *cached = m_images.object(handle->filePath)) {
+        return *cached;
+    }
+
+    QImageReader reader(handle->filePath);
+    const QImage image = reader.read();
+    if (image.isNull()) {
+        qCDebug(NOTIFICATIONMANAGER) << "Failed to load notification image" << handle->filePath << reader.errorString();
+        return image;
+    }
+
+    m_images.insert(handle->filePath, new QImage(image), imageCost(image));
+
+    return image;
+}
+
+void NotificationImageCache::removeStaleFiles()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+
+    const QFileInfoList files = QDir(m_directory).entryInfoList({QStringLiteral("*.png")}, QDir::Files);
+    for (const QFileInfo &info : files) {
+        if (info.lastModified().secsTo(now) > s_maxAgeSecs) {
+            QFile::remove(info.absoluteFilePath());
+        }
+    }
+}
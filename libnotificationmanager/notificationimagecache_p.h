@@ -0,0 +1,87 @@
+/*
+ * Copyright 2020 by the Plasma Workspace authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QCache>
+#include <QImage>
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+
+namespace NotificationManager
+{
+
+/**
+ * @short Keeps notification images on disk rather than in memory
+ *
+ * Images are stored as PNG files named after a hash of their contents, so
+ * the same avatar sent with many messages is only written and kept once.
+ * Hashing, encoding and writing happen in a worker thread.
+ *
+ * Notifications only hold a handle and decode the image when it is actually
+ * shown; a small number of recently used images is kept decoded in memory.
+ *
+ * This must only be used from the main thread.
+ **/
+class Q_DECL_HIDDEN NotificationImageCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Entry {
+        // File the image is loaded from, empty while it is still being written
+        QString filePath;
+        // Kept until the image is written, or if it couldn't be
+        QImage image;
+    };
+    // Shared by all notifications showing the same image
+    using Handle = QSharedPointer<Entry>;
+
+    ~NotificationImageCache() override;
+
+    static NotificationImageCache &self();
+
+    /**
+     * Stores @p image in the background.
+     * @return the handle to look up the image with, null if @p image is null
+     */
+    Handle insert(const QImage &image);
+
+    /**
+     * @return the image of @p handle, a null image if it can't be loaded
+     */
+    QImage image(const Handle &handle);
+
+    QString directory() const;
+
+private:
+    friend class NotificationImageCacheSingleton;
+    NotificationImageCache();
+    Q_DISABLE_COPY(NotificationImageCache)
+
+    void removeStaleFiles();
+
+    QString m_directory;
+    // Decoded images by file path, cost in KiB
+    QCache<QString, QImage> m_images;
+};
+
+} // namespace NotificationManager
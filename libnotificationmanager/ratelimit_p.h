@@ -0,0 +1,111 @@
+/*
+ * Copyright 2020 by the Plasma Workspace authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QVariantMap>
+
+namespace NotificationManager
+{
+
+/**
+ * Rate limit of the notifications of a single application
+ *
+ * Every application gets a bucket of burst notifications which refills
+ * by perMinute. Notifications beyond that are not shown individually
+ * but counted in a single summary notification for the application.
+ */
+class RateLimit
+{
+public:
+    /**
+     * Critical notifications, e.g. about a low battery, are always shown
+     */
+    static bool isExempt(const QVariantMap &hints)
+    {
+        // DBus type is actually "byte", 2 is critical
+        return hints.value(QStringLiteral("urgency")).toInt() == 2;
+    }
+
+    /**
+     * Takes a token for a notification sent at @p now, in msecs of a monotonic clock
+     *
+     * @return whether the notification can be shown, otherwise it was counted
+     * in the current burst
+     */
+    bool take(qint64 now, int burst, int perMinute)
+    {
+        if (lastRefill < 0) {
+            tokens = burst;
+        } else {
+            tokens = qMin<double>(burst, tokens + (now - lastRefill) * perMinute / 60000.0);
+        }
+        lastRefill = now;
+
+        // A few tokens trickling back in don't end the burst, the application has to
+        // calm down until the bucket is full again or it was quiet for a whole minute
+        if (suppressedInBurst && (tokens >= burst || now - lastSuppressed >= 60000)) {
+            endBurst();
+        }
+
+        if (tokens >= 1) {
+            tokens -= 1;
+            ++accepted;
+            return true;
+        }
+
+        lastSuppressed = now;
+        ++suppressed;
+        if (!suppressedInBurst) {
+            ++bursts;
+        }
+        ++suppressedInBurst;
+        return false;
+    }
+
+    /**
+     * Starts counting anew, e.g. because the summary notification was closed
+     */
+    void endBurst()
+    {
+        summaryId = 0;
+        suppressedInBurst = 0;
+    }
+
+    QString applicationName;
+    QString desktopEntry;
+    QString iconName;
+
+    double tokens = 0;
+    qint64 lastRefill = -1;
+
+    // summary notification of the current burst
+    uint summaryId = 0;
+    uint suppressedInBurst = 0;
+    qint64 lastSuppressed = -1;
+
+    // statistics
+    uint accepted = 0;
+    uint suppressed = 0;
+    uint bursts = 0;
+};
+
+} // namespace NotificationManager
@@ -34,9 +34,11 @@
 #include "utils_p.h"
 
 #include <QDBusConnection>
+#include <QDBusMessage>
 #include <QDBusServiceWatcher>
 
 #include <KConfigGroup>
+#include <KLocalizedString>
 #include <KService>
 #include <KSharedConfig>
 #include <KUser>
@@ -57,6 +59,16 @@ ServerPrivate::ServerPrivate(QObject *parent)
     connect(m_notificationWatchers, &QDBusServiceWatcher::serviceUnregistered, [=](const QString &service) {
         m_notificationWatchers->removeWatchedService(service);
     });
+
+    m_rateLimitClock.start();
+    // Once the summary of a burst is closed, the next burst needs a new one
+    connect(static_cast<Server*>(parent), &Server::notificationRemoved, this, [this](uint id) {
+        for (RateLimit &rateLimit : m_rateLimits) {
+            if (rateLimit.summaryId == id) {
+                rateLimit.endBurst();
+            }
+        }
+    });
 }
 
 ServerPrivate::~ServerPrivate() = default;
@@ -137,6 +149,10 @@ bool ServerPrivate::init()
                                              QStringLiteral("Notify"), this, SLOT(onBroadcastNotification(QMap<QString,QVariant>)));
     }
 
+    // A burst of 0 turns off flood control
+    m_rateLimitBurst = config.readEntry("RateLimitBurst", m_rateLimitBurst);
+    m_rateLimitPerMinute = qMax(1, config.readEntry("RateLimitPerMinute", m_rateLimitPerMinute));
+
     m_valid = true;
     emit validChanged();
 
@@ -148,6 +164,19 @@ uint ServerPrivate::Notify(const QString &app_name, uint replaces_id, const QStr
                            const QVariantMap &hints, int timeout)
 {
     const bool wasReplaced = replaces_id > 0;
+
+    // Updates of existing notifications don't add anything, only limit new ones.
+    // This is checked before processing the hints, which might contain large images.
+    if (!wasReplaced && !checkRateLimit(app_name, app_icon, hints)) {
+        // Broadcasts arrive as a signal, there is nobody to reply to
+        if (!calledFromDBus() || message().type() != QDBusMessage::MethodCallMessage) {
+            return 0;
+        }
+        sendErrorReply(QStringLiteral("org.freedesktop.Notifications.Error.ExcessNotificationGeneration"),
+                       QStringLiteral("Created too many notifications in quick succession"));
+        return 0;
+    }
+
     uint notificationId = 0;
     if (wasReplaced) {
         notificationId = replaces_id;
@@ -174,7 +203,7 @@ uint ServerPrivate::Notify(const QString &app_name, uint replaces_id, const QStr
     notification.d->processHints(hints);
 
     // If we didn't get a pixmap, load the app_icon instead
-    if (notification.d->image.isNull()) {
+    if (!notification.d->hasImage()) {
         notification.setIcon(app_icon);
     }
 
@@ -218,6 +247,9 @@ uint ServerPrivate::Notify(const QString &app_name, uint replaces_id, const QStr
             && m_lastNotification.created().msecsTo(notification.created()) < 1000) {
         qCDebug(NOTIFICATIONMANAGER) << "Discarding excess notification creation request";
 
+        if (!calledFromDBus() || message().type() != QDBusMessage::MethodCallMessage) {
+            return 0;
+        }
         sendErrorReply(QStringLiteral("org.freedesktop.Notifications.Error.ExcessNotificationGeneration"),
                        QStringLiteral("Created too many similar notifications in quick succession"));
         return 0;
@@ -345,12 +377,75 @@ void ServerPrivate::onBroadcastNotification(const QMap<QString, QVariant> &prope
     );
 }
 
+bool ServerPrivate::checkRateLimit(const QString &appName, const QString &appIcon, const QVariantMap &hints)
+{
+    if (m_rateLimitBurst <= 0 || RateLimit::isExempt(hints)) {
+        return true;
+    }
+
+    const QString desktopEntry = hints.value(QStringLiteral("desktop-entry")).toString();
+    QString key = !desktopEntry.isEmpty() ? desktopEntry : appName;
+    if (key.isEmpty()) {
+        // Not nice but at least limits the single connection
+        key = message().service();
+    }
+
+    RateLimit &rateLimit = m_rateLimits[key];
+    if (rateLimit.take(m_rateLimitClock.elapsed(), m_rateLimitBurst, m_rateLimitPerMinute)) {
+        rateLimit.applicationName = appName;
+        rateLimit.desktopEntry = desktopEntry;
+        rateLimit.iconName = appIcon;
+        return true;
+    }
+
+    if (rateLimit.suppressedInBurst == 1) {
+        qCInfo(NOTIFICATIONMANAGER) << "Application" << key << "exceeded the notification rate limit, coalescing further notifications";
+    }
+
+    const QString displayName = !rateLimit.applicationName.isEmpty() ? rateLimit.applicationName : key;
+
+    Notification summary(rateLimit.summaryId);
+    summary.setApplicationName(rateLimit.applicationName);
+    summary.setDesktopEntry(rateLimit.desktopEntry);
+    summary.setIcon(rateLimit.iconName);
+    summary.setSummary(i18ncp("@title Notification summarizing notifications not shown individually",
+                              "%1 more notification", "%1 more notifications", rateLimit.suppressedInBurst));
+    summary.setBody(i18nc("@info %1 is an application name",
+                          "%1 sent too many notifications in quick succession.", displayName));
+
+    rateLimit.summaryId = add(summary);
+
+    return false;
+}
+
+QVariantMap ServerPrivate::GetRateLimitStatistics() const
+{
+    QVariantMap statistics;
+
+    for (auto it = m_rateLimits.constBegin(), end = m_rateLimits.constEnd(); it != end; ++it) {
+        const RateLimit &rateLimit = it.value();
+        statistics.insert(it.key(), QVariantMap{
+            {QStringLiteral("applicationName"), rateLimit.applicationName},
+            {QStringLiteral("desktopEntry"), rateLimit.desktopEntry},
+            {QStringLiteral("accepted"), rateLimit.accepted},
+            {QStringLiteral("suppressed"), rateLimit.suppressed},
+            {QStringLiteral("bursts"), rateLimit.bursts},
+        });
+    }
+
+    return statistics;
+}
+
 uint ServerPrivate::add(const Notification &notification)
 {
     // TODO check if notification with ID already exists and signal update instead
     if (notification.id() == 0) {
-        ++m_highestNotificationId;
+        // Allocate ids the same way as Notify() so the two never hand out the same one
+        if (!m_highestNotificationId) {
+            ++m_highestNotificationId;
+        }
         notification.d->id = m_highestNotificationId;
+        ++m_highestNotificationId;
 
         emit static_cast<Server*>(parent())->notificationAdded(notification);
     } else {
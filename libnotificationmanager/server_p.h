@@ -22,9 +22,12 @@
 
 #include <QObject>
 #include <QDBusContext>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QStringList>
 
 #include "notification.h"
+#include "ratelimit_p.h"
 
 class QDBusServiceWatcher;
 
@@ -75,6 +78,9 @@ public:
     
     void InvokeAction(uint id, const QString &actionKey);
 
+    // Flood control
+    QVariantMap GetRateLimitStatistics() const;
+
 Q_SIGNALS:
     // DBus
     void NotificationClosed(uint id, uint reason);
@@ -123,6 +129,8 @@ private:
     void onInhibitionServiceUnregistered(const QString &serviceName);
     void onInhibitedChanged(); // emit DBus change signal
 
+    bool checkRateLimit(const QString &appName, const QString &appIcon, const QVariantMap &hints);
+
     bool m_dbusObjectValid = false;
 
     mutable QScopedPointer<ServerInfo> m_currentOwner;
@@ -137,6 +145,12 @@ private:
 
     Notification m_lastNotification;
 
+    // Notifications of every application beyond the burst are summarized, see RateLimit
+    QHash<QString /*desktop entry or app name*/, RateLimit> m_rateLimits;
+    QElapsedTimer m_rateLimitClock;
+    int m_rateLimitBurst = 20;
+    int m_rateLimitPerMinute = 60;
+
 };
 
 } // namespace NotificationManager
@@ -23,9 +23,9 @@
 #include <QDebug>
 
 #include <KConfigWatcher>
-#include <KService>
 
 #include "server.h"
+#include "applicationidentitycache_p.h"
 #include "mirroredscreenstracker_p.h"
 #include "debug.h"
 
@@ -218,13 +218,13 @@ void Settings::setServiceBehavior(const QString &notifyRcName, NotificationBehav
 
 void Settings::registerKnownApplication(const QString &desktopEntry)
 {
-    KService::Ptr service = KService::serviceByDesktopName(desktopEntry);
-    if (!service) {
+    const ApplicationIdentityCache::Service service = ApplicationIdentityCache::self().service(desktopEntry);
+    if (!service.service) {
         qCDebug(NOTIFICATIONMANAGER) << "Application" << desktopEntry << "cannot be registered as seen application since there is no service for it";
         return;
     }
 
-    if (service->noDisplay()) {
+    if (!service.configurable) {
         qCDebug(NOTIFICATIONMANAGER) << "Application" << desktopEntry << "will not be registered as seen application since it's marked as NoDisplay";
         return;
     }
@@ -0,0 +1,503 @@
+/*
+ * Copyright 2020 by the Plasma Workspace authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Floods the notification server running in this process on a private session bus
+// and reports how long it takes for the notifications to show up in a Notifications
+// model set up like the notification history.
+//
+// Example: notificationserverbenchmark --count 20000 --mix plain=60,image=20,replace=15,job=5
+
+#include <QColor>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusError>
+#include <QDBusMessage>
+#include <QDBusMetaType>
+#include <QDBusObjectPath>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QImage>
+#include <QProcess>
+#include <QRandomGenerator>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QTimer>
+#include <QVector>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <sys/resource.h>
+
+#include <algorithm>
+
+#include "notifications.h"
+
+using namespace NotificationManager;
+
+struct ImageData {
+    int width = 0;
+    int height = 0;
+    int rowStride = 0;
+    bool hasAlpha = true;
+    int bitsPerSample = 8;
+    int channels = 4;
+    QByteArray data;
+};
+Q_DECLARE_METATYPE(ImageData)
+
+QDBusArgument &operator<<(QDBusArgument &argument, const ImageData &image)
+{
+    argument.beginStructure();
+    argument << image.width << image.height << image.rowStride << image.hasAlpha
+             << image.bitsPerSample << image.channels << image.data;
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, ImageData &image)
+{
+    argument.beginStructure();
+    argument >> image.width >> image.height >> image.rowStride >> image.hasAlpha
+             >> image.bitsPerSample >> image.channels >> image.data;
+    argument.endStructure();
+    return argument;
+}
+
+class NotificationServerBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Kind {
+        Plain = 0,
+        Image,
+        Replace,
+        Job,
+        KindCount
+    };
+
+    NotificationServerBenchmark(const QDBusConnection &client, QObject *parent = nullptr);
+
+    bool setMix(const QString &mix);
+
+    int count = 5000;
+    int window = 64;
+    int applications = 10;
+    int avatars = 4;
+    int jobSteps = 10;
+    quint32 seed = 1;
+
+    void start();
+
+private:
+    void sendNext();
+    void sendNotify(Kind kind);
+    void sendJob();
+    void finishOperation();
+
+    void observeRows(const QModelIndex &parent, int first, int last);
+
+    void finish();
+    void report();
+
+    QDBusConnection m_client;
+    Notifications m_model;
+
+    int m_weights[KindCount] = {70, 10, 15, 5};
+    int m_sent[KindCount] = {};
+    QVector<QVariant> m_avatars;
+
+    QRandomGenerator m_random;
+    int m_started = 0;
+    int m_inFlight = 0;
+    int m_errors = 0;
+    int m_rateLimited = 0;
+
+    // Ids returned by the server which can be replaced
+    QVector<uint> m_ids;
+
+    QElapsedTimer m_clock;
+    qint64 m_duration = 0;
+    // Sequence number in the summary -> time it was sent
+    QHash<int, qint64> m_sentAt;
+    // in nanoseconds
+    QVector<qint64> m_latencies;
+};
+
+NotificationServerBenchmark::NotificationServerBenchmark(const QDBusConnection &client, QObject *parent)
+    : QObject(parent)
+    , m_client(client)
+{
+    // Configured like the notification history
+    m_model.setShowExpired(true);
+    m_model.setShowDismissed(true);
+    m_model.setShowJobs(true);
+    m_model.setSortMode(Notifications::SortByTypeAndUrgency);
+    m_model.setGroupMode(Notifications::GroupApplicationsFlat);
+
+    connect(&m_model, &QAbstractItemModel::rowsInserted, this, &NotificationServerBenchmark::observeRows);
+    connect(&m_model, &QAbstractItemModel::dataChanged, this, [this](const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles) {
+        if (roles.isEmpty() || roles.contains(Notifications::SummaryRole)) {
+            observeRows(topLeft.parent(), topLeft.row(), bottomRight.row());
+        }
+    });
+}
+
+bool NotificationServerBenchmark::setMix(const QString &mix)
+{
+    static const QStringList s_names{
+        QStringLiteral("plain"), QStringLiteral("image"), QStringLiteral("replace"), QStringLiteral("job")
+    };
+
+    std::fill(std::begin(m_weights), std::end(m_weights), 0);
+
+    const QStringList parts = mix.split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (const QString &part : parts) {
+        const QStringList keyValue = part.split(QLatin1Char('='));
+        const int kind = s_names.indexOf(keyValue.first().trimmed());
+        bool ok = false;
+        const int weight = keyValue.value(1).toInt(&ok);
+        if (kind == -1 || !ok || weight < 0) {
+            return false;
+        }
+        m_weights[kind] = weight;
+    }
+
+    return std::any_of(std::begin(m_weights), std::end(m_weights), [](int weight) {
+        return weight > 0;
+    });
+}
+
+void NotificationServerBenchmark::start()
+{
+    m_random.seed(seed);
+
+    // The same few avatars over and over, like a busy chat
+    for (int i = 0; i < avatars; ++i) {
+        QImage avatar(64, 64, QImage::Format_RGBA8888);
+        avatar.fill(QColor::fromHsv((i * 360) / qMax(1, avatars), 200, 200));
+
+        ImageData image;
+        image.width = avatar.width();
+        image.height = avatar.height();
+        image.rowStride = avatar.bytesPerLine();
+        image.data = QByteArray(reinterpret_cast<const char *>(avatar.constBits()), avatar.sizeInBytes());
+        m_avatars.append(QVariant::fromValue(image));
+    }
+
+    m_clock.start();
+    sendNext();
+}
+
+void NotificationServerBenchmark::sendNext()
+{
+    int totalWeight = 0;
+    for (int weight : m_weights) {
+        totalWeight += weight;
+    }
+
+    while (m_inFlight < window && m_started < count) {
+        int pick = m_random.bounded(totalWeight);
+        int kind = 0;
+        while (pick >= m_weights[kind]) {
+            pick -= m_weights[kind];
+            ++kind;
+        }
+
+        ++m_started;
+        ++m_inFlight;
+
+        if (kind == Job) {
+            sendJob();
+        } else {
+            sendNotify(static_cast<Kind>(kind));
+        }
+    }
+}
+
+void NotificationServerBenchmark::sendNotify(Kind kind)
+{
+    uint replacesId = 0;
+    if (kind == Replace) {
+        if (m_ids.isEmpty()) {
+            kind = Plain;
+        } else {
+            replacesId = m_ids.at(m_random.bounded(m_ids.count()));
+        }
+    }
+    ++m_sent[kind];
+
+    const int sequence = m_started;
+
+    QVariantMap hints;
+    if (kind == Image && !m_avatars.isEmpty()) {
+        hints.insert(QStringLiteral("image-data"), m_avatars.at(m_random.bounded(m_avatars.count())));
+    }
+
+    QDBusMessage message = QDBusMessage::createMethodCall(QStringLiteral("org.freedesktop.Notifications"),
+                                                          QStringLiteral("/org/freedesktop/Notifications"),
+                                                          QStringLiteral("org.freedesktop.Notifications"),
+                                                          QStringLiteral("Notify"));
+    message.setArguments({
+        QStringLiteral("Benchmark App %1").arg(sequence % qMax(1, applications)),
+        replacesId,
+        QStringLiteral("dialog-information"),
+        QStringLiteral("Benchmark %1").arg(sequence),
+        QStringLiteral("Body of notification <b>%1</b> with some <i>markup</i>").arg(sequence),
+        QStringList(),
+        hints,
+        -1
+    });
+
+    m_sentAt.insert(sequence, m_clock.nsecsElapsed());
+
+    auto *watcher = new QDBusPendingCallWatcher(m_client.asyncCall(message), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, sequence](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+
+        QDBusPendingReply<uint> reply = *watcher;
+        if (reply.isError()) {
+            m_sentAt.remove(sequence);
+            if (reply.error().name() == QLatin1String("org.freedesktop.Notifications.Error.ExcessNotificationGeneration")) {
+                ++m_rateLimited;
+            } else {
+                ++m_errors;
+            }
+        } else {
+            m_ids.append(reply.value());
+        }
+
+        finishOperation();
+    });
+}
+
+void NotificationServerBenchmark::sendJob()
+{
+    ++m_sent[Job];
+
+    QDBusMessage message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.JobViewServer"),
+                                                          QStringLiteral("/JobViewServer"),
+                                                          QStringLiteral("org.kde.JobViewServerV2"),
+                                                          QStringLiteral("requestView"));
+    message.setArguments({
+        QStringLiteral("org.kde.dolphin"),
+        0,
+        QVariantMap{{QStringLiteral("immediate"), true}}
+    });
+
+    auto *watcher = new QDBusPendingCallWatcher(m_client.asyncCall(message), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+
+        QDBusPendingReply<QDBusObjectPath> reply = *watcher;
+        if (reply.isError()) {
+            ++m_errors;
+            finishOperation();
+            return;
+        }
+
+        const QString path = reply.value().path();
+        auto jobCall = [this, &path](const QString &method, const QVariantList &arguments) {
+            QDBusMessage message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.JobViewServer"),
+                                                                  path,
+                                                                  QStringLiteral("org.kde.JobViewV2"),
+                                                                  method);
+            message.setArguments(arguments);
+            m_client.send(message);
+        };
+
+        for (int step = 1; step <= jobSteps; ++step) {
+            jobCall(QStringLiteral("setInfoMessage"), {QStringLiteral("Copying file %1").arg(step)});
+            jobCall(QStringLiteral("setPercent"), {uint(step * 100 / jobSteps)});
+        }
+        jobCall(QStringLiteral("terminate"), {QString()});
+
+        finishOperation();
+    });
+}
+
+void NotificationServerBenchmark::finishOperation()
+{
+    --m_inFlight;
+
+    if (m_started < count) {
+        sendNext();
+    } else if (m_inFlight == 0) {
+        finish();
+    }
+}
+
+void NotificationServerBenchmark::observeRows(const QModelIndex &parent, int first, int last)
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    const QString prefix = QStringLiteral("Benchmark ");
+
+    for (int row = first; row <= last; ++row) {
+        const QString summary = m_model.index(row, 0, parent).data(Notifications::SummaryRole).toString();
+        if (!summary.startsWith(prefix)) {
+            continue;
+        }
+
+        bool ok = false;
+        const int sequence = summary.midRef(prefix.length()).toInt(&ok);
+        if (!ok) {
+            continue;
+        }
+
+        auto it = m_sentAt.find(sequence);
+        if (it != m_sentAt.end()) {
+            m_latencies.append(now - it.value());
+            m_sentAt.erase(it);
+        }
+    }
+}
+
+void NotificationServerBenchmark::finish()
+{
+    m_duration = m_clock.nsecsElapsed();
+
+    // Give the job updates sent without waiting for a reply a chance to be processed
+    QTimer::singleShot(500, this, [this] {
+        report();
+        qApp->quit();
+    });
+}
+
+void NotificationServerBenchmark::report()
+{
+    QTextStream out(stdout);
+
+    const double seconds = m_duration / 1e9;
+
+    out << "Sent " << m_started << " requests in " << QString::number(seconds, 'f', 2) << " s, "
+        << QString::number(m_started / qMax(seconds, 1e-9), 'f', 0) << " requests/s" << '\n';
+    out << "  plain: " << m_sent[Plain] << ", image: " << m_sent[Image]
+        << ", replace: " << m_sent[Replace] << ", job: " << m_sent[Job] << '\n';
+    out << "  rate limited: " << m_rateLimited << ", errors: " << m_errors
+        << ", never seen in the model: " << m_sentAt.count() << '\n';
+
+    if (!m_latencies.isEmpty()) {
+        std::sort(m_latencies.begin(), m_latencies.end());
+        auto percentile = [this](double fraction) {
+            const int index = qMin(m_latencies.count() - 1, int(fraction * m_latencies.count()));
+            return QString::number(m_latencies.at(index) / 1e6, 'f', 3);
+        };
+
+        out << "Notify -> model latency (ms): p50 " << percentile(0.5)
+            << ", p90 " << percentile(0.9)
+            << ", p99 " << percentile(0.99)
+            << ", max " << percentile(1.0) << '\n';
+    }
+
+    out << "Rows in the model: " << m_model.rowCount() << '\n';
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        // Includes the client side, which is small compared to the server and models
+        out << "Peak memory: " << QString::number(usage.ru_maxrss / 1024.0, 'f', 1) << " MiB" << '\n';
+    }
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(QStringLiteral("notificationserverbenchmark"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Measures the throughput and latency of the notification server and models"));
+    parser.addHelpOption();
+
+    QCommandLineOption countOption(QStringLiteral("count"), QStringLiteral("Number of requests to send."), QStringLiteral("n"), QStringLiteral("5000"));
+    QCommandLineOption mixOption(QStringLiteral("mix"),
+                                 QStringLiteral("Relative weights of the kinds of requests: plain, image, replace and job."),
+                                 QStringLiteral("mix"), QStringLiteral("plain=70,image=10,replace=15,job=5"));
+    QCommandLineOption windowOption(QStringLiteral("window"), QStringLiteral("Maximum number of requests waiting for a reply."), QStringLiteral("n"), QStringLiteral("64"));
+    QCommandLineOption applicationsOption(QStringLiteral("applications"), QStringLiteral("Number of different applications sending notifications."), QStringLiteral("n"), QStringLiteral("10"));
+    QCommandLineOption avatarsOption(QStringLiteral("avatars"), QStringLiteral("Number of different images sent with notifications."), QStringLiteral("n"), QStringLiteral("4"));
+    QCommandLineOption jobStepsOption(QStringLiteral("job-steps"), QStringLiteral("Number of progress updates per job."), QStringLiteral("n"), QStringLiteral("10"));
+    QCommandLineOption seedOption(QStringLiteral("seed"), QStringLiteral("Seed for picking the kind of each request."), QStringLiteral("n"), QStringLiteral("1"));
+    QCommandLineOption rateLimitOption(QStringLiteral("rate-limit"), QStringLiteral("Keep the flood control of the server enabled."));
+    parser.addOptions({countOption, mixOption, windowOption, applicationsOption, avatarsOption, jobStepsOption, seedOption, rateLimitOption});
+    parser.process(app);
+
+    // Don't touch the configuration, notification history or image cache of the user
+    QStandardPaths::setTestModeEnabled(true);
+
+    KConfigGroup config(KSharedConfig::openConfig(), QStringLiteral("Notifications"));
+    if (parser.isSet(rateLimitOption)) {
+        config.deleteEntry("RateLimitBurst");
+    } else {
+        config.writeEntry("RateLimitBurst", 0);
+    }
+
+    // A private bus, so we neither compete with nor disturb the notification server of the session
+    QProcess dbusDaemon;
+    dbusDaemon.start(QStringLiteral("dbus-daemon"), {QStringLiteral("--session"), QStringLiteral("--nofork"), QStringLiteral("--print-address")});
+    if (!dbusDaemon.waitForStarted() || !dbusDaemon.waitForReadyRead(5000)) {
+        qCritical() << "Failed to start dbus-daemon" << dbusDaemon.errorString();
+        return 1;
+    }
+
+    const QByteArray address = dbusDaemon.readLine().trimmed();
+    qputenv("DBUS_SESSION_BUS_ADDRESS", address);
+
+    // Take over the notification and job services on the private bus, like plasmashell
+    app.setProperty("_plasma_dbus_master", true);
+
+    qDBusRegisterMetaType<ImageData>();
+
+    // Requests come from another connection, so they are actually sent through the bus
+    QDBusConnection client = QDBusConnection::connectToBus(QString::fromLatin1(address), QStringLiteral("notificationserverbenchmark-client"));
+    if (!client.isConnected()) {
+        qCritical() << "Failed to connect to the private bus" << client.lastError().message();
+        return 1;
+    }
+
+    NotificationServerBenchmark benchmark(client);
+    benchmark.count = qMax(1, parser.value(countOption).toInt());
+    benchmark.window = qMax(1, parser.value(windowOption).toInt());
+    benchmark.applications = qMax(1, parser.value(applicationsOption).toInt());
+    benchmark.avatars = qMax(1, parser.value(avatarsOption).toInt());
+    benchmark.jobSteps = qMax(1, parser.value(jobStepsOption).toInt());
+    benchmark.seed = parser.value(seedOption).toUInt();
+
+    if (!benchmark.setMix(parser.value(mixOption))) {
+        qCritical() << "Invalid mix" << parser.value(mixOption);
+        return 1;
+    }
+
+    QTimer::singleShot(0, &benchmark, &NotificationServerBenchmark::start);
+
+    const int result = app.exec();
+
+    QDBusConnection::disconnectFromBus(QStringLiteral("notificationserverbenchmark-client"));
+    dbusDaemon.terminate();
+    dbusDaemon.waitForFinished();
+
+    return result;
+}
+
+#include "notificationserverbenchmark.moc"
@@ -21,6 +21,7 @@
 #include "firefox.h"
 #include "bookmarks_debug.h"
 #include <QFile>
+#include <QFileInfo>
 #include <QDir>
 #include <QRegularExpression>
 #include <KConfigGroup>
@@ -33,7 +34,6 @@
 Firefox::Firefox(QObject *parent) :
     QObject(parent),
     m_favicon(new FallbackFavicon(this)),
-    m_fetchsqlite(nullptr),
     m_fetchsqlite_fav(nullptr)
 {
     reloadConfiguration();
@@ -61,8 +61,11 @@ void Firefox::prepare()
             + QStringLiteral("/bookmarkrunnerfirefoxfavdbfile.sqlite");
     }
     if (!m_dbFile.isEmpty()) {
-        m_fetchsqlite = new FetchSqlite(m_dbFile, m_dbCacheFile);
-        m_fetchsqlite->prepare();
+        const QDateTime lastModified = databaseLastModified();
+        if (!lastModified.isValid() || lastModified != m_bookmarksLastModified) {
+            loadBookmarks();
+            m_bookmarksLastModified = lastModified;
+        }
     }
     if (!m_dbFile_fav.isEmpty()) {
         m_fetchsqlite_fav = new FetchSqlite(m_dbFile_fav, m_dbCacheFile_fav);
@@ -75,37 +78,35 @@ void Firefox::prepare()
     }
 }
 
-QList< BookmarkMatch > Firefox::match(const QString& term, bool addEverything)
+QDateTime Firefox::databaseLastModified() const
 {
-    QList< BookmarkMatch > matches;
-    if (!m_fetchsqlite) {
-        return matches;
+    // Firefox writes changes to the write-ahead log first
+    const QDateTime dbLastModified = QFileInfo(m_dbFile).lastModified();
+    const QDateTime walLastModified = QFileInfo(m_dbFile + QStringLiteral("-wal")).lastModified();
+    if (walLastModified.isValid() && walLastModified > dbLastModified) {
+        return walLastModified;
     }
+    return dbLastModified;
+}
+
+void Firefox::loadBookmarks()
+{
+    FetchSqlite fetchSqlite(m_dbFile, m_dbCacheFile);
+    fetchSqlite.prepare();
+
+    const QString query = QStringLiteral("SELECT moz_bookmarks.title, moz_places.url " \
+                                         "FROM moz_bookmarks, moz_places WHERE " \
+                                         "moz_bookmarks.type = 1 AND moz_bookmarks.fk = moz_places.id");
 
-    QString query;
-    if (addEverything) {
-        query = QStringLiteral("SELECT moz_bookmarks.fk, moz_bookmarks.title, moz_places.url " \
-                    "FROM moz_bookmarks, moz_places WHERE " \
-                    "moz_bookmarks.type = 1 AND moz_bookmarks.fk = moz_places.id");
-    } else {
-        query = QStringLiteral("SELECT moz_bookmarks.fk, moz_bookmarks.title, moz_places.url " \
-                        "FROM moz_bookmarks, moz_places WHERE " \
-                        "moz_bookmarks.type = 1 AND moz_bookmarks.fk = moz_places.id AND " \
-                        "(moz_bookmarks.title LIKE :term OR moz_places.url LIKE :term)");
-    }
-    const QMap<QString, QVariant> bindVariables {
-        {QStringLiteral(":term"), QStringLiteral("%%%1%%").arg(term)},
-    };
-    const QList<QVariantMap> results = m_fetchsqlite->query(query, bindVariables);
     QMultiMap<QString, QString> uniqueResults;
-    for (const QVariantMap &result : results) {
-        const QString title = result.value(QStringLiteral("title")).toString();
-        const QUrl url = result.value(QStringLiteral("url")).toUrl();
+    fetchSqlite.query(query, {}, [&uniqueResults](const QSqlQuery &row) {
+        const QString title = row.value(0).toString();
+        const QUrl url(row.value(1).toString());
         if (url.isEmpty() || url.scheme() == QLatin1String("place")) {
             // Don't use bookmarks with empty url or Firefox's "place:" scheme,
             // e.g. used for "Most Visited" or "Recent Tags"
             //qDebug() << "element " << url << " was not added";
-            continue;
+            return;
         }
 
         auto urlString = url.toString();
@@ -132,11 +133,49 @@ QList< BookmarkMatch > Firefox::match(const QString& term, bool addEverything)
             // first or unique entry
             uniqueResults.insert(urlString, title);
         }
-    }
+    });
+
+    fetchSqlite.teardown();
 
+    QVector<Bookmark> bookmarks;
+    bookmarks.reserve(uniqueResults.size());
     for (auto result = uniqueResults.constKeyValueBegin(); result != uniqueResults.constKeyValueEnd(); ++result) {
-        const QString url = (*result).first;
-        BookmarkMatch bookmarkMatch(m_favicon->iconFor(url), term, (*result).second, url);
+        Bookmark bookmark;
+        bookmark.url = (*result).first;
+        bookmark.title = (*result).second;
+        bookmark.foldedUrl = bookmark.url.toCaseFolded();
+        bookmark.foldedTitle = bookmark.title.toCaseFolded();
+        bookmarks.append(bookmark);
+    }
+
+    qCDebug(RUNNER_BOOKMARKS) << "Loaded" << bookmarks.count() << "Firefox bookmarks";
+
+    QWriteLocker locker(&m_bookmarksLock);
+    m_bookmarks.swap(bookmarks);
+}
+
+QList< BookmarkMatch > Firefox::match(const QString& term, bool addEverything)
+{
+    QList< BookmarkMatch > matches;
+
+    // a shallow copy, a reload in the meantime swaps in another list
+    QVector<Bookmark> bookmarks;
+    {
+        QReadLocker locker(&m_bookmarksLock);
+        bookmarks = m_bookmarks;
+    }
+    if (bookmarks.isEmpty()) {
+        return matches;
+    }
+
+    const QString foldedTerm = term.toCaseFolded();
+
+    for (const Bookmark &bookmark : qAsConst(bookmarks)) {
+        if (!addEverything && !bookmark.foldedTitle.contains(foldedTerm) && !bookmark.foldedUrl.contains(foldedTerm)) {
+            continue;
+        }
+
+        BookmarkMatch bookmarkMatch(m_favicon->iconFor(bookmark.url), term, bookmark.title, bookmark.url);
         bookmarkMatch.addTo(matches, addEverything);
     }
 
@@ -145,11 +184,6 @@ QList< BookmarkMatch > Firefox::match(const QString& term, bool addEverything)
 
 void Firefox::teardown()
 {
-    if (m_fetchsqlite) {
-        m_fetchsqlite->teardown();
-        delete m_fetchsqlite;
-        m_fetchsqlite = nullptr;
-    }
     if (m_fetchsqlite_fav) {
         m_fetchsqlite_fav->teardown();
         delete m_fetchsqlite_fav;
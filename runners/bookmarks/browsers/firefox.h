@@ -21,7 +21,10 @@
 #ifndef FIREFOX_H
 #define FIREFOX_H
 
+#include <QDateTime>
+#include <QReadWriteLock>
 #include <QSqlDatabase>
+#include <QVector>
 #include "browser.h"
 
 class Favicon;
@@ -37,13 +40,28 @@ public Q_SLOTS:
     void teardown() override;
     void prepare() override;
 private:
+    struct Bookmark {
+        QString title;
+        QString url;
+        // case folded title and url for matching
+        QString foldedTitle;
+        QString foldedUrl;
+    };
+
     virtual void reloadConfiguration();
+    QDateTime databaseLastModified() const;
+    void loadBookmarks();
+
+    // all bookmarks of the places database, loaded once per change of the database.
+    // prepare() swaps in a new list while match() may run in other threads.
+    QVector<Bookmark> m_bookmarks;
+    QReadWriteLock m_bookmarksLock;
+    QDateTime m_bookmarksLastModified;
     QString m_dbFile;
     QString m_dbFile_fav;
     QString m_dbCacheFile;
     QString m_dbCacheFile_fav;
     Favicon * m_favicon;
-    FetchSqlite *m_fetchsqlite;
     FetchSqlite *m_fetchsqlite_fav;
 };
 
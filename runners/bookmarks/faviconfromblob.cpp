@@ -91,6 +91,9 @@ void FaviconFromBlob::prepare()
 void FaviconFromBlob::teardown()
 {
     m_fetchsqlite->teardown();
+
+    QMutexLocker locker(&m_iconsMutex);
+    m_icons.clear();
 }
 
 void FaviconFromBlob::cleanCacheDirectory()
@@ -99,6 +102,23 @@ void FaviconFromBlob::cleanCacheDirectory()
 }
 
 QIcon FaviconFromBlob::iconFor(const QString &url)
+{
+    {
+        QMutexLocker locker(&m_iconsMutex);
+        auto it = m_icons.constFind(url);
+        if (it != m_icons.constEnd()) {
+            return it.value();
+        }
+    }
+
+    const QIcon icon = lookupIcon(url);
+
+    QMutexLocker locker(&m_iconsMutex);
+    m_icons.insert(url, icon);
+    return icon;
+}
+
+QIcon FaviconFromBlob::lookupIcon(const QString &url)
 {
     //qDebug() << "got url: " << url;
     QString fileChecksum = QString::number(qChecksum(url.toLatin1(), url.toLatin1().size()));
@@ -106,12 +126,15 @@ QIcon FaviconFromBlob::iconFor(const QString &url)
     if(iconFile.size() == 0)
         iconFile.remove();
     if(!iconFile.exists()) {
-        QMap<QString,QVariant> bindVariables;
-        bindVariables.insert(QStringLiteral(":url"), url);
-        QList<QVariantMap> faviconFound = m_fetchsqlite->query(m_query, bindVariables);
-        if(faviconFound.isEmpty()) return defaultIcon();
-
-        QByteArray iconData = faviconFound.first().value(m_blobcolumn).toByteArray();
+        const QMap<QString, QVariant> bindVariables {
+            {QStringLiteral(":url"), url},
+        };
+        QByteArray iconData;
+        m_fetchsqlite->query(m_query, bindVariables, [this, &iconData](const QSqlQuery &row) {
+            if (iconData.isEmpty()) {
+                iconData = row.value(m_blobcolumn).toByteArray();
+            }
+        });
         //qDebug() << "Favicon found: " << iconData.size() << " bytes";
         if(iconData.size() <=0)
             return defaultIcon();
@@ -21,7 +21,9 @@
 #ifndef FAVICONFROMBLOB_H
 #define FAVICONFROMBLOB_H
 
+#include <QHash>
 #include <QIcon>
+#include <QMutex>
 #include "favicon.h"
 #include "fetchsqlite.h"
 
@@ -44,7 +46,11 @@ private:
     QString m_query;
     QString const m_blobcolumn;
     FetchSqlite *m_fetchsqlite;
+    // icons already looked up in this session, by url
+    QHash<QString, QIcon> m_icons;
+    QMutex m_iconsMutex;
     void cleanCacheDirectory();
+    QIcon lookupIcon(const QString &url);
 };
 
 #endif // FAVICONFROMBLOB_H
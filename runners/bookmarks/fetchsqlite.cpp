@@ -53,6 +53,11 @@ void FetchSqlite::prepare()
 
 void FetchSqlite::teardown()
 {
+    QMutexLocker lock(&m_mutex);
+
+    // the statements have to be gone before their connections can be removed
+    m_preparedQueries.clear();
+
     QString connectionPrefix = m_databaseFile + "-";
 
     const auto connections = QSqlDatabase::connectionNames();
@@ -88,36 +93,65 @@ static QSqlDatabase openDbConnection(const QString& databaseFile) {
     return db;
 }
 
-QList<QVariantMap> FetchSqlite::query(const QString &sql, QMap<QString, QVariant> bindObjects)
+QSqlQuery *FetchSqlite::preparedQuery(const QString &sql)
 {
-    QMutexLocker lock(&m_mutex);
-
     auto db = openDbConnection(m_databaseFile);
 
-    //qDebug() << "query: " << sql;
+    const QString key = db.connectionName() + QLatin1Char('\n') + sql;
+    auto it = m_preparedQueries.find(key);
+    if (it != m_preparedQueries.end()) {
+        return &it.value();
+    }
+
     QSqlQuery query(db);
-    query.prepare(sql);
+    query.setForwardOnly(true);
+    if (!query.prepare(sql)) {
+        qCDebug(RUNNER_BOOKMARKS) << "Failed to prepare" << sql << query.lastError().text();
+        return nullptr;
+    }
+
+    return &m_preparedQueries.insert(key, query).value();
+}
+
+bool FetchSqlite::query(const QString &sql, const QMap<QString, QVariant> &bindObjects,
+                        const std::function<void(const QSqlQuery &row)> &readRow)
+{
+    QMutexLocker lock(&m_mutex);
+
+    QSqlQuery *query = preparedQuery(sql);
+    if (!query) {
+        return false;
+    }
+
     for (auto entry = bindObjects.constKeyValueBegin(); entry != bindObjects.constKeyValueEnd(); ++entry) {
-        query.bindValue((*entry).first, (*entry).second);
-        //qDebug() << "* Bound " << variableName << " to " << query.boundValue(variableName);
+        query->bindValue((*entry).first, (*entry).second);
+    }
+
+    if (!query->exec()) {
+        qCDebug(RUNNER_BOOKMARKS) << "Query failed" << sql << query->lastError().text();
+        return false;
     }
 
-    if(!query.exec()) {
-        QSqlError error = db.lastError();
-        //qDebug() << "query failed: " << error.text() << " (" << error.type() << ", " << error.number() << ")";
-        //qDebug() << query.lastQuery();
+    while (query->next()) {
+        readRow(*query);
     }
+    // keep the statement, but release the result set and the database lock
+    query->finish();
+
+    return true;
+}
 
+QList<QVariantMap> FetchSqlite::query(const QString &sql, QMap<QString, QVariant> bindObjects)
+{
     QList<QVariantMap> result;
-    while(query.next()) {
+    query(sql, bindObjects, [&result](const QSqlQuery &row) {
         QVariantMap recordValues;
-        QSqlRecord record = query.record();
-        for(int field=0; field<record.count(); field++) {
-            QVariant value = record.value(field);
-            recordValues.insert(record.fieldName(field), value  );
+        const QSqlRecord record = row.record();
+        for (int field = 0; field < record.count(); field++) {
+            recordValues.insert(record.fieldName(field), record.value(field));
         }
         result << recordValues;
-    }
+    });
 
     return result;
 }
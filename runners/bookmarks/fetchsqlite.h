@@ -21,6 +21,8 @@
 #ifndef FETCHSQLITE_H
 #define FETCHSQLITE_H
 #include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QHash>
 #include <QList>
 #include <QVariantMap>
 
@@ -30,6 +32,7 @@
 #include <QObject>
 #include <QMutex>
 
+#include <functional>
 
 class FetchSqlite : public QObject
 {
@@ -41,11 +44,25 @@ public:
     void teardown();
     QList<QVariantMap> query(const QString &sql, QMap<QString,QVariant> bindObjects);
     QList<QVariantMap> query(const QString &sql);
+
+    /**
+     * Runs @p sql and calls @p readRow for each resulting row, which can read the
+     * columns by index with their actual types, e.g. row.value(0).toString().
+     * The statement is prepared only once per thread and reused until teardown().
+     * @return false if the query failed
+     */
+    bool query(const QString &sql, const QMap<QString, QVariant> &bindObjects,
+               const std::function<void(const QSqlQuery &row)> &readRow);
+
     QStringList tables(QSql::TableType type = QSql::Tables);
 
 private:
+    QSqlQuery *preparedQuery(const QString &sql);
+
     QString const m_databaseFile;
     QMutex m_mutex;
+    // connection name + sql -> prepared statement
+    QHash<QString, QSqlQuery> m_preparedQueries;
 };
 
 #endif // FETCHSQLITE_H
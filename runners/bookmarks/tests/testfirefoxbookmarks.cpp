@@ -0,0 +1,127 @@
+/*
+ *   Copyright 2020 by the Plasma Workspace authors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "testfirefoxbookmarks.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QTest>
+#include <KConfigGroup>
+#include <KSharedConfig>
+#include "browsers/firefox.h"
+
+static const QString s_connection = QStringLiteral("testfirefoxbookmarks");
+
+void TestFirefoxBookmarks::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_profileDir.isValid());
+    m_dbFile = m_profileDir.filePath(QStringLiteral("places.sqlite"));
+
+    QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), s_connection);
+    db.setDatabaseName(m_dbFile);
+    QVERIFY(db.open());
+    QSqlQuery query(db);
+    QVERIFY(query.exec(QStringLiteral("CREATE TABLE moz_places (id INTEGER PRIMARY KEY, url TEXT)")));
+    QVERIFY(query.exec(QStringLiteral("CREATE TABLE moz_bookmarks (id INTEGER PRIMARY KEY, type INTEGER, fk INTEGER, title TEXT)")));
+    addBookmark(1, QStringLiteral("KDE"), QStringLiteral("https://kde.org/"));
+    addBookmark(2, QStringLiteral("Plasma"), QStringLiteral("https://plasma-desktop.org/"));
+
+    // Firefox reads the profile database to use from kdeglobals
+    KConfigGroup grp(KSharedConfig::openConfig(QStringLiteral("kdeglobals")), QStringLiteral("General"));
+    grp.writeEntry("dbfile", m_dbFile);
+    QVERIFY(grp.sync());
+}
+
+void TestFirefoxBookmarks::cleanupTestCase()
+{
+    QSqlDatabase::database(s_connection).close();
+    QSqlDatabase::removeDatabase(s_connection);
+
+    KConfigGroup grp(KSharedConfig::openConfig(QStringLiteral("kdeglobals")), QStringLiteral("General"));
+    grp.deleteEntry("dbfile");
+    grp.sync();
+}
+
+void TestFirefoxBookmarks::addBookmark(int id, const QString &title, const QString &url)
+{
+    QSqlQuery query(QSqlDatabase::database(s_connection));
+    query.prepare(QStringLiteral("INSERT INTO moz_places (id, url) VALUES (:id, :url)"));
+    query.bindValue(QStringLiteral(":id"), id);
+    query.bindValue(QStringLiteral(":url"), url);
+    QVERIFY(query.exec());
+    query.prepare(QStringLiteral("INSERT INTO moz_bookmarks (id, type, fk, title) VALUES (:id, 1, :id, :title)"));
+    query.bindValue(QStringLiteral(":id"), id);
+    query.bindValue(QStringLiteral(":title"), title);
+    QVERIFY(query.exec());
+}
+
+void TestFirefoxBookmarks::setDatabaseLastModified(const QDateTime &lastModified)
+{
+    QFile file(m_dbFile);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.setFileTime(lastModified, QFileDevice::FileModificationTime));
+}
+
+void TestFirefoxBookmarks::itShouldFindAllBookmarks()
+{
+    Firefox firefox;
+    firefox.prepare();
+    QCOMPARE(firefox.match(QStringLiteral("any"), true).size(), 2);
+    QCOMPARE(firefox.match(QStringLiteral("plasma"), false).size(), 1);
+    firefox.teardown();
+}
+
+void TestFirefoxBookmarks::itShouldKeepBookmarksWhileDatabaseIsUnchanged()
+{
+    Firefox firefox;
+    firefox.prepare();
+    QCOMPARE(firefox.match(QStringLiteral("any"), true).size(), 2);
+    firefox.teardown();
+
+    // The bookmarks are only read again if the database looks modified
+    const QDateTime lastModified = QFileInfo(m_dbFile).lastModified();
+    addBookmark(3, QStringLiteral("Krunner"), QStringLiteral("https://userbase.kde.org/Plasma/Krunner"));
+    setDatabaseLastModified(lastModified);
+
+    firefox.prepare();
+    QCOMPARE(firefox.match(QStringLiteral("any"), true).size(), 2);
+    QCOMPARE(firefox.match(QStringLiteral("krunner"), false).size(), 0);
+    firefox.teardown();
+}
+
+void TestFirefoxBookmarks::itShouldReloadBookmarksWhenDatabaseChanged()
+{
+    Firefox firefox;
+    firefox.prepare();
+    const int bookmarkCount = firefox.match(QStringLiteral("any"), true).size();
+    firefox.teardown();
+
+    addBookmark(4, QStringLiteral("Bugs"), QStringLiteral("https://bugs.kde.org/"));
+    setDatabaseLastModified(QFileInfo(m_dbFile).lastModified().addSecs(10));
+
+    firefox.prepare();
+    QCOMPARE(firefox.match(QStringLiteral("any"), true).size(), bookmarkCount + 1);
+    QCOMPARE(firefox.match(QStringLiteral("bugs"), false).size(), 1);
+    firefox.teardown();
+}
+
+QTEST_MAIN(TestFirefoxBookmarks);
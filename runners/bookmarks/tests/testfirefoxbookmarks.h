@@ -0,0 +1,46 @@
+/*
+ *   Copyright 2020 by the Plasma Workspace authors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef TESTFIREFOXBOOKMARKS_H
+#define TESTFIREFOXBOOKMARKS_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+class TestFirefoxBookmarks : public QObject
+{
+Q_OBJECT
+public:
+    explicit TestFirefoxBookmarks(QObject* parent = nullptr) : QObject(parent) {}
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void itShouldFindAllBookmarks();
+    void itShouldKeepBookmarksWhileDatabaseIsUnchanged();
+    void itShouldReloadBookmarksWhenDatabaseChanged();
+
+private:
+    void addBookmark(int id, const QString &title, const QString &url);
+    void setDatabaseLastModified(const QDateTime &lastModified);
+
+    QTemporaryDir m_profileDir;
+    QString m_dbFile;
+};
+
+#endif // TESTFIREFOXBOOKMARKS_H
@@ -0,0 +1,127 @@
+/*
+ *   Copyright (C) 2020 by the Plasma Workspace authors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License version 2 as
+ *   published by the Free Software Foundation
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <QLocale>
+#include <QObject>
+#include <QTest>
+
+#include <KRunner/RunnerContext>
+
+#include "../calculatorrunner.h"
+
+class CalculatorRunnerTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+
+    void testCalculate_data();
+    void testCalculate();
+    void testRepeatedQuery();
+
+    void benchmarkTyping();
+    void benchmarkRepeatedQuery();
+
+private:
+    QString result(CalculatorRunner &runner, const QString &query);
+};
+
+void CalculatorRunnerTest::initTestCase()
+{
+    QLocale::setDefault(QLocale::c());
+}
+
+QString CalculatorRunnerTest::result(CalculatorRunner &runner, const QString &query)
+{
+    Plasma::RunnerContext context;
+    context.setQuery(query);
+    runner.match(context);
+
+    const QList<Plasma::QueryMatch> matches = context.matches();
+    return matches.isEmpty() ? QString() : matches.first().text();
+}
+
+void CalculatorRunnerTest::testCalculate_data()
+{
+    QTest::addColumn<QString>("query");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("sum") << QStringLiteral("2+2") << QStringLiteral("4");
+    QTest::newRow("spaces") << QStringLiteral("12 * 3") << QStringLiteral("36");
+    QTest::newRow("power") << QStringLiteral("=2^10") << QStringLiteral("1024");
+    QTest::newRow("rounding") << QStringLiteral("0.1+0.2") << QStringLiteral("0.3");
+    QTest::newRow("division") << QStringLiteral("3/2=") << QStringLiteral("1.5");
+    QTest::newRow("hex") << QStringLiteral("hex=250+5") << QStringLiteral("0xFF");
+#ifndef ENABLE_QALCULATE
+    QTest::newRow("incomplete") << QStringLiteral("12*(") << QString();
+#endif
+    QTest::newRow("too short") << QStringLiteral("1+") << QString();
+}
+
+void CalculatorRunnerTest::testCalculate()
+{
+    QFETCH(QString, query);
+    QFETCH(QString, expected);
+
+    CalculatorRunner runner(this, QVariantList());
+    QCOMPARE(result(runner, query), expected);
+}
+
+void CalculatorRunnerTest::testRepeatedQuery()
+{
+    CalculatorRunner runner(this, QVariantList());
+
+    // the second query is answered from the cache and has to match the first one
+    QCOMPARE(result(runner, QStringLiteral("7*6")), QStringLiteral("42"));
+    QCOMPARE(result(runner, QStringLiteral("7*6")), QStringLiteral("42"));
+    // the cache is keyed by the normalized expression
+    QCOMPARE(result(runner, QStringLiteral("7 * 6")), QStringLiteral("42"));
+    QCOMPARE(result(runner, QStringLiteral("=7*6")), QStringLiteral("42"));
+    QCOMPARE(result(runner, QStringLiteral("hex=7*6")), QStringLiteral("0x2A"));
+}
+
+void CalculatorRunnerTest::benchmarkTyping()
+{
+    CalculatorRunner runner(this, QVariantList());
+    int round = 0;
+
+    // One iteration queries every prefix of an expression, like krunner does
+    // while the expression is typed. Each round uses another expression,
+    // so the keystrokes are not answered from the cache.
+    QBENCHMARK {
+        const QString expression = QStringLiteral("%1*(3+4)/7-0.5").arg(++round);
+        for (int i = 1; i <= expression.size(); ++i) {
+            result(runner, expression.left(i));
+        }
+    }
+}
+
+void CalculatorRunnerTest::benchmarkRepeatedQuery()
+{
+    CalculatorRunner runner(this, QVariantList());
+    const QString expression = QStringLiteral("12*(3+4)/7-0.5");
+    QCOMPARE(result(runner, expression), QStringLiteral("11.5"));
+
+    QBENCHMARK {
+        result(runner, expression);
+    }
+}
+
+QTEST_MAIN(CalculatorRunnerTest)
+
+#include "calculatorrunnertest.moc"
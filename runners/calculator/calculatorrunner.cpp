@@ -25,11 +25,12 @@
 #include "qalculate_engine.h"
 #else
 #include <QJSEngine>
-#include <QGuiApplication>
-#include <QClipboard>
 #include <QRegularExpression>
+#include <QThreadStorage>
 #endif
 
+#include <QClipboard>
+#include <QGuiApplication>
 #include <QIcon>
 #include <QDebug>
 
@@ -37,17 +38,75 @@
 #include <krunner/querymatch.h>
 
 static const QString s_copyToClipboardId = QStringLiteral("copyToClipboard");
+static const int s_maxCachedResults = 200;
+
+#ifndef ENABLE_QALCULATE
+namespace {
+/**
+ * A JavaScript engine set up for evaluating expressions.
+ *
+ * Setting up an engine is a lot more expensive than evaluating a simple
+ * expression, so every thread matches are run in keeps its own one.
+ */
+class JSCalculator
+{
+public:
+    JSCalculator()
+    {
+        // expressions can assign to Math members, don't let that leak into later queries
+        m_engine.evaluate(QStringLiteral("Object.freeze(Math);"));
+
+        //ECMAScript has issues with the last digit in simple rational computations
+        //This function rounds off the last digit; see bug 167986
+        m_round = m_engine.evaluate(QStringLiteral("(function(result) {\
+                                                    var exponent = 14-(1+Math.floor(Math.log(Math.abs(result))/Math.log(10)));\
+                                                    var order=Math.pow(10,exponent);\
+                                                    return (order > 0? Math.round(result*order)/order : 0);\
+                                                    })"));
+    }
+
+    QJSValue evaluate(const QString &term)
+    {
+        return m_engine.evaluate(QStringLiteral("var result = %1; result").arg(term));
+    }
+
+    QJSValue round(const QJSValue &result)
+    {
+        return m_round.call({result});
+    }
+
+    static JSCalculator *forCurrentThread()
+    {
+        static QThreadStorage<JSCalculator *> s_calculators;
+        if (!s_calculators.hasLocalData()) {
+            s_calculators.setLocalData(new JSCalculator);
+        }
+        return s_calculators.localData();
+    }
 
-K_EXPORT_PLASMA_RUNNER(calculatorrunner, CalculatorRunner)
+private:
+    QJSEngine m_engine;
+    QJSValue m_round;
+};
+}
+#endif
 
 CalculatorRunner::CalculatorRunner( QObject* parent, const QVariantList &args )
     : Plasma::AbstractRunner(parent, args)
+    , m_cache(s_maxCachedResults)
 {
     Q_UNUSED(args)
 
     #ifdef ENABLE_QALCULATE
     m_engine = new QalculateEngine;
     setSpeed(SlowSpeed);
+    // get the expensive first calculation out of the way before the user types
+    connect(this, &Plasma::AbstractRunner::prepare, m_engine, &QalculateEngine::warmUp);
+    connect(m_engine, &QalculateEngine::exchangeRatesUpdated, this, [this] {
+        QMutexLocker locker(&m_cacheMutex);
+        m_cache.clear();
+        ++m_cacheGeneration;
+    });
     #endif
 
     setObjectName( QStringLiteral("Calculator" ));
@@ -284,6 +343,34 @@ void CalculatorRunner::match(Plasma::RunnerContext &context)
 }
 
 QString CalculatorRunner::calculate(const QString& term, bool *isApproximate)
+{
+    int generation;
+    {
+        QMutexLocker locker(&m_cacheMutex);
+        if (const CalculationResult *cached = m_cache.object(term)) {
+            *isApproximate = cached->isApproximate;
+            return cached->result;
+        }
+        generation = m_cacheGeneration;
+    }
+
+    CalculationResult *calculation = new CalculationResult;
+    calculation->result = evaluate(term, &calculation->isApproximate);
+    *isApproximate = calculation->isApproximate;
+    const QString result = calculation->result;
+
+    QMutexLocker locker(&m_cacheMutex);
+    if (generation == m_cacheGeneration) {
+        m_cache.insert(term, calculation);
+    } else {
+        // calculated with the exchange rates from before
+        delete calculation;
+    }
+
+    return result;
+}
+
+QString CalculatorRunner::evaluate(const QString& term, bool *isApproximate)
 {
     #ifdef ENABLE_QALCULATE
     QString result;
@@ -298,8 +385,8 @@ QString CalculatorRunner::calculate(const QString& term, bool *isApproximate)
     #else
     Q_UNUSED(isApproximate);
     //qDebug() << "calculating" << term;
-    QJSEngine eng;
-    QJSValue result = eng.evaluate(QStringLiteral("var result = %1; result").arg(term));
+    JSCalculator *calculator = JSCalculator::forCurrentThread();
+    QJSValue result = calculator->evaluate(term);
 
     if (result.isError()) {
         return QString();
@@ -314,11 +401,7 @@ QString CalculatorRunner::calculate(const QString& term, bool *isApproximate)
         return resultString;
     }
 
-    //ECMAScript has issues with the last digit in simple rational computations
-    //This script rounds off the last digit; see bug 167986
-    QString roundedResultString = eng.evaluate(QStringLiteral("var exponent = 14-(1+Math.floor(Math.log(Math.abs(result))/Math.log(10)));\
-                                                var order=Math.pow(10,exponent);\
-                                                (order > 0? Math.round(result*order)/order : 0)")).toString();
+    QString roundedResultString = calculator->round(result).toString();
 
     roundedResultString.replace(QLatin1Char('.'), QLocale().decimalPoint(), Qt::CaseInsensitive);
 
@@ -330,11 +413,8 @@ void CalculatorRunner::run(const Plasma::RunnerContext &context, const Plasma::Q
 {
     Q_UNUSED(context);
     if (match.selectedAction() == action(s_copyToClipboardId)) {
-#ifdef ENABLE_QALCULATE
-        m_engine->copyToClipboard();
-#else
+        // the match may come from the cache, so the engine's last result might belong to another query
         QGuiApplication::clipboard()->setText(match.text());
-#endif
     }
 }
 
@@ -352,5 +432,3 @@ QMimeData * CalculatorRunner::mimeDataForMatch(const Plasma::QueryMatch &match)
     result->setText(match.text());
     return result;
 }
-
-#include "calculatorrunner.moc"
@@ -20,7 +20,9 @@
 #ifndef CALCULATORRUNNER_H
 #define CALCULATORRUNNER_H
 
+#include <QCache>
 #include <QMimeData>
+#include <QMutex>
 
 #ifdef ENABLE_QALCULATE
 class QalculateEngine;
@@ -47,11 +49,24 @@ class CalculatorRunner : public Plasma::AbstractRunner
         QMimeData * mimeDataForMatch(const Plasma::QueryMatch &match) override;
 
     private:
+        struct CalculationResult {
+            QString result;
+            bool isApproximate = false;
+        };
+
         QString calculate(const QString& term, bool *isApproximate);
+        QString evaluate(const QString& term, bool *isApproximate);
         void userFriendlySubstitutions(QString& cmd);
         void powSubstitutions(QString& cmd);
         void hexSubstitutions(QString& cmd);
 
+        // krunner queries again for every keystroke, so remember recent results
+        // by the substituted expression
+        QMutex m_cacheMutex;
+        QCache<QString, CalculationResult> m_cache;
+        // Incremented whenever the cache is cleared
+        int m_cacheGeneration = 0;
+
         #ifdef ENABLE_QALCULATE
         QalculateEngine* m_engine;
         #endif
@@ -30,6 +30,8 @@
 #include <QApplication>
 #include <QClipboard>
 #include <QDebug>
+#include <QMutex>
+#include <QtConcurrentRun>
 
 #include <KLocalizedString>
 #include <KProtocolManager>
@@ -37,11 +39,60 @@
 
 QAtomicInt QalculateEngine::s_counter;
 
+namespace {
+// CALCULATOR is shared by all engines and not thread-safe,
+// while krunner runs matches in several threads
+QMutex s_calculatorMutex;
+bool s_warmedUp = false;
+
+// The options are the same for every query, so they are only set up once
+const EvaluationOptions &evaluationOptions()
+{
+    static const EvaluationOptions eo = [] {
+        EvaluationOptions options;
+
+        options.auto_post_conversion = POST_CONVERSION_BEST;
+        options.keep_zero_units = false;
+
+        options.parse_options.angle_unit = ANGLE_UNIT_RADIANS;
+        options.structuring = STRUCTURING_SIMPLIFY;
+
+        // suggested in https://github.com/Qalculate/libqalculate/issues/16
+        // to avoid memory overflow for seemingly innocent calculations (Bug 277011)
+        options.approximation = APPROXIMATION_APPROXIMATE;
+
+        return options;
+    }();
+    return eo;
+}
+
+const PrintOptions &printOptions()
+{
+    static const PrintOptions po = [] {
+        PrintOptions options;
+        options.number_fraction_format = FRACTION_DECIMAL;
+        options.indicate_infinite_series = false;
+        options.use_all_prefixes = false;
+        options.use_denominator_prefix = true;
+        options.negative_exponents = false;
+        options.lower_case_e = true;
+        options.base_display = BASE_DISPLAY_NORMAL;
+        #if defined(QALCULATE_MAJOR_VERSION) && defined(QALCULATE_MINOR_VERSION) && (QALCULATE_MAJOR_VERSION > 2 || (QALCULATE_MAJOR_VERSION == 2 && QALCULATE_MINOR_VERSION >= 2))
+        options.interval_display = INTERVAL_DISPLAY_SIGNIFICANT_DIGITS;
+        #endif
+        return options;
+    }();
+    return po;
+}
+}
+
 QalculateEngine::QalculateEngine(QObject* parent):
     QObject(parent)
 {
     m_lastResult = "";
     s_counter.ref();
+
+    QMutexLocker locker(&s_calculatorMutex);
     if (!CALCULATOR) {
         new Calculator();
         CALCULATOR->terminateThreads();
@@ -49,12 +100,17 @@ QalculateEngine::QalculateEngine(QObject* parent):
         CALCULATOR->loadLocalDefinitions();
         CALCULATOR->loadGlobalCurrencies();
         CALCULATOR->loadExchangeRates();
+        CALCULATOR->setPrecision(16);
+        s_warmedUp = false;
     }
 }
 
 QalculateEngine::~QalculateEngine()
 {
-    if (s_counter.deref()) {
+    m_warmUp.waitForFinished();
+
+    QMutexLocker locker(&s_calculatorMutex);
+    if (!s_counter.deref()) {
         delete CALCULATOR;
         CALCULATOR = nullptr;
     }
@@ -75,7 +131,11 @@ void QalculateEngine::updateResult(KJob* job)
         qDebug() << i18n("The exchange rates could not be updated. The following error has been reported: %1",job->errorString());
     } else {
         // the exchange rates have been successfully updated, now load them
-        CALCULATOR->loadExchangeRates();
+        {
+            QMutexLocker locker(&s_calculatorMutex);
+            CALCULATOR->loadExchangeRates();
+        }
+        emit exchangeRatesUpdated();
     }
 }
 
@@ -89,34 +149,12 @@ QString QalculateEngine::evaluate(const QString& expression, bool *isApproximate
     QByteArray ba = input.replace(QChar(0xA3), "GBP").replace(QChar(0xA5), "JPY").replace('$', "USD").replace(QChar(0x20AC), "EUR").toLatin1();
     const char *ctext = ba.data();
 
+    QMutexLocker locker(&s_calculatorMutex);
     CALCULATOR->terminateThreads();
-    EvaluationOptions eo;
-
-    eo.auto_post_conversion = POST_CONVERSION_BEST;
-    eo.keep_zero_units = false;
-
-    eo.parse_options.angle_unit = ANGLE_UNIT_RADIANS;
-    eo.structuring = STRUCTURING_SIMPLIFY;
-
-    // suggested in https://github.com/Qalculate/libqalculate/issues/16
-    // to avoid memory overflow for seemingly innocent calculations (Bug 277011)
-    eo.approximation = APPROXIMATION_APPROXIMATE;
-
-    CALCULATOR->setPrecision(16);
-    MathStructure result = CALCULATOR->calculate(ctext, eo);
-
-    PrintOptions po;
-    po.number_fraction_format = FRACTION_DECIMAL;
-    po.indicate_infinite_series = false;
-    po.use_all_prefixes = false;
-    po.use_denominator_prefix = true;
-    po.negative_exponents = false;
-    po.lower_case_e = true;
-    po.base_display = BASE_DISPLAY_NORMAL;
-    #if defined(QALCULATE_MAJOR_VERSION) && defined(QALCULATE_MINOR_VERSION) && (QALCULATE_MAJOR_VERSION > 2 || (QALCULATE_MAJOR_VERSION == 2 && QALCULATE_MINOR_VERSION >= 2))
-    po.interval_display = INTERVAL_DISPLAY_SIGNIFICANT_DIGITS;
-    #endif
+    MathStructure result = CALCULATOR->calculate(ctext, evaluationOptions());
+    s_warmedUp = true;
 
+    const PrintOptions &po = printOptions();
     result.format(po);
 
     m_lastResult = result.print(po).c_str();
@@ -128,6 +166,22 @@ QString QalculateEngine::evaluate(const QString& expression, bool *isApproximate
     return m_lastResult;
 }
 
+void QalculateEngine::warmUp()
+{
+    if (m_warmUp.isRunning()) {
+        return;
+    }
+
+    m_warmUp = QtConcurrent::run([] {
+        QMutexLocker locker(&s_calculatorMutex);
+        if (s_warmedUp || !CALCULATOR) {
+            return;
+        }
+        CALCULATOR->calculate("1+1", evaluationOptions());
+        s_warmedUp = true;
+    });
+}
+
 void QalculateEngine::copyToClipboard(bool flag)
 {
     Q_UNUSED(flag);
@@ -21,6 +21,7 @@
 #define QALCULATEENGINE_H
 
 #include <QAtomicInt>
+#include <QFuture>
 #include <QObject>
 
 class KJob;
@@ -38,6 +39,12 @@ public Q_SLOTS:
     QString evaluate(const QString& expression, bool *isApproximate = nullptr);
 	void updateExchangeRates();
 
+	/**
+	 * Runs a first calculation in the background, libqalculate sets up
+	 * a lot of its state lazily and the first query would pay for it otherwise.
+	 */
+	void warmUp();
+
 	void copyToClipboard(bool flag = true);
 
 protected Q_SLOTS:
@@ -46,9 +53,15 @@ protected Q_SLOTS:
 Q_SIGNALS:
 	void resultReady(const QString&);
 	void formattedResultReady(const QString&);
+	/**
+	 * Emitted once new exchange rates were loaded, results of currency
+	 * conversions calculated before are outdated then.
+	 */
+	void exchangeRatesUpdated();
 
 private:
 	QString m_lastResult;
+	QFuture<void> m_warmUp;
 	static QAtomicInt s_counter;
 };
 
@@ -0,0 +1,135 @@
+/*
+ *   Copyright (C) 2020 by the Plasma Workspace authors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License version 2 as
+ *   published by the Free Software Foundation
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <QObject>
+#include <QTest>
+
+#include "../processindex.h"
+
+class ProcessIndexTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testParseStat_data();
+    void testParseStat();
+    void testParseStatKeepsName();
+    void testCpuUsage_data();
+    void testCpuUsage();
+};
+
+void ProcessIndexTest::testParseStat_data()
+{
+    QTest::addColumn<QByteArray>("stat");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<QString>("name");
+    QTest::addColumn<quint64>("cpuTicks");
+
+    QTest::newRow("plain")
+        << QByteArray("1234 (bash) S 1 1234 1234 34816 1234 4194304 1000 0 0 0 150 25 0 0 20 0 1 0 100 9000000 500\n")
+        << true << QStringLiteral("bash") << quint64(175);
+    QTest::newRow("spaces")
+        << QByteArray("4321 (Web Content) R 1200 1200 1200 0 -1 4194560 5000 0 3 0 98765 4321 0 0 20 0 30 0 2000\n")
+        << true << QStringLiteral("Web Content") << quint64(103086);
+    QTest::newRow("parentheses")
+        << QByteArray("42 (a) b (c)) S 1 42 42 0 -1 4194560 1 0 0 0 7 3 0 0 20 0 1 0 1\n")
+        << true << QStringLiteral("a) b (c)") << quint64(10);
+    QTest::newRow("fake fields in the name")
+        << QByteArray("43 (x) S 1 2 3 4 5 6 7 8 9 10 11 12) S 1 43 43 0 -1 0 0 0 0 0 1 2 0 0 20 0 1 0 1\n")
+        << true << QStringLiteral("x) S 1 2 3 4 5 6 7 8 9 10 11 12") << quint64(3);
+    QTest::newRow("utf-8")
+        << QByteArray("44 (b\xc3\xa4r) S 1 44 44 0 -1 0 0 0 0 0 20 22 0 0 20 0 1 0 1\n")
+        << true << QStringLiteral("bär") << quint64(42);
+    QTest::newRow("empty name")
+        << QByteArray("45 () Z 1 45 45 0 -1 0 0 0 0 0 0 0 0 0 20 0 1 0 1\n")
+        << true << QString() << quint64(0);
+    QTest::newRow("truncated")
+        << QByteArray("46 (short) S 1 46")
+        << true << QStringLiteral("short") << quint64(0);
+    QTest::newRow("no name")
+        << QByteArray("47 S 1 47 47 0 -1 0 0 0 0 0 1 1\n")
+        << false << QString() << quint64(0);
+    QTest::newRow("reversed parentheses")
+        << QByteArray("48 )x( S\n")
+        << false << QString() << quint64(0);
+}
+
+void ProcessIndexTest::testParseStat()
+{
+    QFETCH(QByteArray, stat);
+    QFETCH(bool, valid);
+    QFETCH(QString, name);
+    QFETCH(quint64, cpuTicks);
+
+    QString parsedName;
+    quint64 parsedTicks = 0;
+    QCOMPARE(ProcessIndex::parseStat(stat.constData(), parsedName, parsedTicks), valid);
+    if (valid) {
+        QCOMPARE(parsedName, name);
+        QCOMPARE(parsedTicks, cpuTicks);
+    }
+}
+
+void ProcessIndexTest::testParseStatKeepsName()
+{
+    QString name = QStringLiteral("Web Content");
+    const QChar *data = name.constData();
+    quint64 cpuTicks = 0;
+
+    // An unchanged name is not assigned again
+    QVERIFY(ProcessIndex::parseStat("1 (Web Content) S 1 1 1 0 -1 0 0 0 0 0 2 2 0", name, cpuTicks));
+    QCOMPARE(name.constData(), data);
+    QCOMPARE(cpuTicks, quint64(4));
+
+    QVERIFY(ProcessIndex::parseStat("1 (Isolated Web Co) S 1 1 1 0 -1 0 0 0 0 0 2 2 0", name, cpuTicks));
+    QCOMPARE(name, QStringLiteral("Isolated Web Co"));
+}
+
+void ProcessIndexTest::testCpuUsage_data()
+{
+    QTest::addColumn<quint64>("previousTicks");
+    QTest::addColumn<quint64>("ticks");
+    QTest::addColumn<qint64>("elapsed");
+    QTest::addColumn<int>("cpuCount");
+    QTest::addColumn<qreal>("usage");
+
+    // At 100 ticks per second
+    QTest::newRow("idle") << quint64(500) << quint64(500) << qint64(1000) << 1 << qreal(0);
+    QTest::newRow("half") << quint64(500) << quint64(550) << qint64(1000) << 1 << qreal(50);
+    QTest::newRow("half of two seconds") << quint64(0) << quint64(100) << qint64(2000) << 1 << qreal(50);
+    QTest::newRow("one of four cpus") << quint64(0) << quint64(100) << qint64(1000) << 4 << qreal(25);
+    QTest::newRow("all of four cpus") << quint64(0) << quint64(400) << qint64(1000) << 4 << qreal(100);
+    QTest::newRow("more than possible") << quint64(0) << quint64(1000) << qint64(1000) << 2 << qreal(100);
+    QTest::newRow("reused pid") << quint64(1000) << quint64(10) << qint64(1000) << 1 << qreal(0);
+    QTest::newRow("no time elapsed") << quint64(0) << quint64(10) << qint64(0) << 1 << qreal(0);
+    QTest::newRow("unknown cpu count") << quint64(0) << quint64(50) << qint64(1000) << -1 << qreal(50);
+}
+
+void ProcessIndexTest::testCpuUsage()
+{
+    QFETCH(quint64, previousTicks);
+    QFETCH(quint64, ticks);
+    QFETCH(qint64, elapsed);
+    QFETCH(int, cpuCount);
+    QFETCH(qreal, usage);
+
+    QCOMPARE(ProcessIndex::cpuUsage(previousTicks, ticks, elapsed, 100, cpuCount), usage);
+}
+
+QTEST_GUILESS_MAIN(ProcessIndexTest)
+
+#include "processindextest.moc"
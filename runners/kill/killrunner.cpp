@@ -23,18 +23,16 @@
 #include <QAction>
 #include <QDebug>
 #include <QIcon>
+#include <QtConcurrentRun>
 
 #include <KProcess>
 #include <KAuth>
 #include <KLocalizedString>
 
-#include <processcore/processes.h>
-#include <processcore/process.h>
-
 K_EXPORT_PLASMA_RUNNER(kill, KillRunner)
 
 KillRunner::KillRunner(QObject *parent, const QVariantList &args)
-        : Plasma::AbstractRunner(parent, args), m_processes(nullptr)
+        : Plasma::AbstractRunner(parent, args)
 {
     setObjectName(QStringLiteral("Kill Runner"));
 
@@ -48,9 +46,16 @@ KillRunner::KillRunner(QObject *parent, const QVariantList &args)
     m_delayedCleanupTimer.setInterval(50);
     m_delayedCleanupTimer.setSingleShot(true);
     connect(&m_delayedCleanupTimer, &QTimer::timeout, this, &KillRunner::cleanup);
+
+    // Keeps up with processes that come and go while typing, and provides the CPU usage deltas
+    m_refreshTimer.setInterval(1000);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &KillRunner::startRefresh);
 }
 
-KillRunner::~KillRunner() = default;
+KillRunner::~KillRunner()
+{
+    m_refreshFuture.waitForFinished();
+}
 
 
 void KillRunner::reloadConfiguration()
@@ -72,21 +77,27 @@ void KillRunner::reloadConfiguration()
 void KillRunner::prep()
 {
     m_delayedCleanupTimer.stop();
+
+    // Only the first refresh blocks matching, in case the query arrives before it is done
+    startRefresh();
+    m_refreshTimer.start();
 }
 
-void KillRunner::cleanup()
+void KillRunner::startRefresh()
 {
-    if (!m_processes) {
+    if (!m_refreshFuture.isFinished()) {
         return;
     }
 
-    if (m_prepLock.tryLockForWrite()) {
-        delete m_processes;
-        m_processes = nullptr;
+    m_refreshFuture = QtConcurrent::run(&m_processes, &ProcessIndex::refresh);
+}
 
-        m_prepLock.unlock();
-    } else {
-        m_delayedCleanupTimer.stop();
+void KillRunner::cleanup()
+{
+    m_refreshTimer.stop();
+
+    if (!m_processes.tryClear()) {
+        m_delayedCleanupTimer.start();
     }
 }
 
@@ -97,37 +108,22 @@ void KillRunner::match(Plasma::RunnerContext &context)
         return;
     }
 
-    m_prepLock.lockForRead();
-    if (!m_processes) {
-        m_prepLock.unlock();
-        m_prepLock.lockForWrite();
-        if (!m_processes) {
-            suspendMatching(true);
-            m_processes = new KSysGuard::Processes();
-            m_processes->updateAllProcesses();
-            suspendMatching(false);
-        }
-    }
-    m_prepLock.unlock();
-
     term = term.right(term.length() - m_triggerWord.length());
 
     if (term.length() < 2)  {
         return;
     }
 
-    QList<Plasma::QueryMatch> matches;
-    const QList<KSysGuard::Process *> processlist = m_processes->getAllProcesses();
-    for (const KSysGuard::Process *process : processlist) {
-        if (!context.isValid()) {
-            return;
-        }
-        const QString name = process->name();
-        if (!name.contains(term, Qt::CaseInsensitive)) {
-            continue;
-        }
+    m_processes.ensureRefreshed();
+    if (!context.isValid()) {
+        return;
+    }
 
-        const quint64 pid = process->pid();
+    QList<Plasma::QueryMatch> matches;
+    const QVector<ProcessIndex::Process> processes = m_processes.find(term);
+    for (const ProcessIndex::Process &process : processes) {
+        const QString &name = process.name;
+        const quint64 pid = process.pid;
         Plasma::QueryMatch match(this);
         match.setText(i18n("Terminate %1", name));
         match.setSubtext(i18n("Process ID: %1", QString::number(pid)));
@@ -138,10 +134,10 @@ void KillRunner::match(Plasma::RunnerContext &context)
         // Set the relevance
         switch (m_sorting) {
         case Sort::CPU:
-            match.setRelevance((process->userUsage() + process->sysUsage()) / 100);
+            match.setRelevance(process.cpuUsage / 100);
             break;
         case Sort::CPUI:
-            match.setRelevance(1 - (process->userUsage() + process->sysUsage()) / 100);
+            match.setRelevance(1 - process.cpuUsage / 100);
             break;
         case Sort::NONE:
             match.setRelevance(name.compare(term, Qt::CaseInsensitive) == 0 ? 1 : 9);
@@ -21,20 +21,15 @@
 #ifndef KILLRUNNER_H
 #define KILLRUNNER_H
 
-#include <QReadWriteLock>
+#include <QFuture>
 #include <QTimer>
 
 #include <KRunner/AbstractRunner>
 
 #include "config_keys.h"
+#include "processindex.h"
 class QAction;
 
-namespace KSysGuard
-{
-    class Processes;
-    class Process;
-}
-
 class KillRunner : public Plasma::AbstractRunner
 {
     Q_OBJECT
@@ -51,6 +46,7 @@ public:
 private Q_SLOTS:
     void prep();
     void cleanup();
+    void startRefresh();
 
 private:
     /** The trigger word */
@@ -59,11 +55,14 @@ private:
     /** How to sort */
     Sort m_sorting;
 
-    /** process lister */
-    KSysGuard::Processes *m_processes;
+    /** process table, refreshed in the background while a match session is running */
+    ProcessIndex m_processes;
+
+    /** timer for refreshing m_processes */
+    QTimer m_refreshTimer;
 
-    /** lock for initializing m_processes */
-    QReadWriteLock m_prepLock;
+    /** the running background refresh */
+    QFuture<void> m_refreshFuture;
 
     /** timer for retrying the cleanup due to lock contention */
     QTimer m_delayedCleanupTimer;
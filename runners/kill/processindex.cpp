@@ -0,0 +1,309 @@
+/* Copyright 2020 by the Plasma Workspace authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "processindex.h"
+
+#include <QMutexLocker>
+#include <QReadLocker>
+#include <QWriteLocker>
+
+#include <processcore/processes.h>
+#include <processcore/process.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+ProcessIndex::ProcessIndex() = default;
+
+ProcessIndex::~ProcessIndex()
+{
+    delete m_processes;
+}
+
+void ProcessIndex::refresh()
+{
+    QMutexLocker locker(&m_refreshMutex);
+
+    QHash<qint64, Entry> entries;
+    {
+        QReadLocker readLocker(&m_lock);
+        entries = m_entries;
+    }
+
+    const bool namesChanged = scan(entries);
+    const QVector<Name> names = namesChanged ? buildNames(entries) : QVector<Name>();
+
+    QWriteLocker writeLocker(&m_lock);
+    m_entries = entries;
+    if (namesChanged) {
+        m_names = names;
+    }
+    m_refreshed = true;
+}
+
+void ProcessIndex::ensureRefreshed()
+{
+    {
+        QMutexLocker locker(&m_refreshMutex);
+        if (m_refreshed) {
+            return;
+        }
+    }
+
+    // Another thread might have refreshed in the meantime, which doesn't hurt
+    refresh();
+}
+
+bool ProcessIndex::tryClear()
+{
+    if (!m_refreshMutex.tryLock()) {
+        return false;
+    }
+
+    {
+        QWriteLocker writeLocker(&m_lock);
+        m_entries.clear();
+        m_names.clear();
+    }
+
+    m_refreshed = false;
+    m_sinceLastRefresh.invalidate();
+    delete m_processes;
+    m_processes = nullptr;
+
+    m_refreshMutex.unlock();
+    return true;
+}
+
+bool ProcessIndex::isEmpty() const
+{
+    QReadLocker locker(&m_lock);
+    return m_entries.isEmpty();
+}
+
+bool ProcessIndex::parseStat(const char *buffer, QString &name, quint64 &cpuTicks)
+{
+    // The name is in parentheses and can contain anything, including spaces and parentheses
+    const char *nameStart = strchr(buffer, '(');
+    const char *nameEnd = strrchr(buffer, ')');
+    if (!nameStart || !nameEnd || nameEnd < nameStart) {
+        return false;
+    }
+
+    const QByteArray rawName = QByteArray::fromRawData(nameStart + 1, nameEnd - nameStart - 1);
+    if (name.isEmpty() || name.toUtf8() != rawName) {
+        name = QString::fromUtf8(rawName);
+    }
+
+    // Fields after the name: state is the third field of the file, utime and stime the 14th and 15th
+    const char *field = nameEnd + 1;
+    quint64 utime = 0;
+    quint64 stime = 0;
+    for (int number = 3; number <= 15 && *field; ++number) {
+        while (*field == ' ') {
+            ++field;
+        }
+        if (number == 14) {
+            utime = strtoull(field, nullptr, 10);
+        } else if (number == 15) {
+            stime = strtoull(field, nullptr, 10);
+        }
+        while (*field && *field != ' ') {
+            ++field;
+        }
+    }
+
+    cpuTicks = utime + stime;
+    return true;
+}
+
+qreal ProcessIndex::cpuUsage(quint64 previousTicks, quint64 ticks, qint64 elapsed, long ticksPerSecond, long cpuCount)
+{
+    // A reused pid can have used less time than the process before it
+    if (elapsed <= 0 || ticks < previousTicks || ticksPerSecond <= 0) {
+        return 0;
+    }
+
+    const qreal seconds = (ticks - previousTicks) / qreal(ticksPerSecond);
+    return qBound<qreal>(0, seconds * 1000 / elapsed * 100 / qMax(1L, cpuCount), 100);
+}
+
+#ifdef Q_OS_LINUX
+// Reads the name and used CPU time from /proc/<pid>/stat
+static bool readStat(const char *pid, QString &name, quint64 &cpuTicks)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%s/stat", pid);
+
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+
+    char buffer[1024];
+    const ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (length <= 0) {
+        return false;
+    }
+    buffer[length] = '\0';
+
+    return ProcessIndex::parseStat(buffer, name, cpuTicks);
+}
+#endif
+
+bool ProcessIndex::scan(QHash<qint64, Entry> &entries)
+{
+    bool namesChanged = false;
+
+    const qint64 elapsed = m_sinceLastRefresh.isValid() ? m_sinceLastRefresh.restart() : 0;
+    if (!m_sinceLastRefresh.isValid()) {
+        m_sinceLastRefresh.start();
+    }
+
+    QHash<qint64, Entry> newEntries;
+    newEntries.reserve(entries.count());
+
+#ifdef Q_OS_LINUX
+    static const long s_ticksPerSecond = sysconf(_SC_CLK_TCK);
+    static const long s_cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+
+    DIR *proc = opendir("/proc");
+    if (!proc) {
+        entries.clear();
+        return true;
+    }
+
+    while (dirent *dirEntry = readdir(proc)) {
+        const char *pidString = dirEntry->d_name;
+        if (*pidString < '0' || *pidString > '9') {
+            continue;
+        }
+        const qint64 pid = strtoll(pidString, nullptr, 10);
+
+        Entry entry;
+        const auto it = entries.constFind(pid);
+        const bool known = it != entries.constEnd();
+        if (known) {
+            entry = it.value();
+        }
+
+        const QString previousName = entry.process.name;
+        quint64 cpuTicks = 0;
+        if (!readStat(pidString, entry.process.name, cpuTicks)) {
+            // Exited in the meantime
+            continue;
+        }
+
+        if (!known || entry.process.name != previousName) {
+            namesChanged = true;
+        }
+
+        entry.process.pid = pid;
+        entry.process.cpuUsage = known ? cpuUsage(entry.cpuTicks, cpuTicks, elapsed, s_ticksPerSecond, s_cpuCount) : 0;
+        entry.cpuTicks = cpuTicks;
+
+        newEntries.insert(pid, entry);
+    }
+
+    closedir(proc);
+#else
+    Q_UNUSED(elapsed)
+
+    // KSysGuard needs the same instance to calculate the CPU usage
+    if (!m_processes) {
+        m_processes = new KSysGuard::Processes();
+    }
+    m_processes->updateAllProcesses();
+
+    const QList<KSysGuard::Process *> processes = m_processes->getAllProcesses();
+    for (const KSysGuard::Process *process : processes) {
+        Entry entry;
+        entry.process.pid = process->pid();
+        entry.process.name = process->name();
+        entry.process.cpuUsage = process->userUsage() + process->sysUsage();
+
+        const auto it = entries.constFind(entry.process.pid);
+        if (it == entries.constEnd() || it->process.name != entry.process.name) {
+            namesChanged = true;
+        }
+
+        newEntries.insert(entry.process.pid, entry);
+    }
+#endif
+
+    if (newEntries.count() != entries.count()) {
+        namesChanged = true;
+    }
+
+    entries = newEntries;
+    return namesChanged;
+}
+
+QVector<ProcessIndex::Name> ProcessIndex::buildNames(const QHash<qint64, Entry> &entries)
+{
+    QHash<QString, QVector<qint64>> pidsByName;
+    for (auto it = entries.constBegin(), end = entries.constEnd(); it != end; ++it) {
+        pidsByName[it->process.name].append(it.key());
+    }
+
+    QVector<Name> names;
+    names.reserve(pidsByName.count());
+    for (auto it = pidsByName.constBegin(), end = pidsByName.constEnd(); it != end; ++it) {
+        Name name;
+        name.foldedName = it.key().toCaseFolded();
+        name.pids = it.value();
+        names.append(name);
+    }
+
+    return names;
+}
+
+void ProcessIndex::appendProcesses(const Name &name, QVector<Process> &processes) const
+{
+    for (qint64 pid : name.pids) {
+        const auto it = m_entries.constFind(pid);
+        if (it != m_entries.constEnd()) {
+            processes.append(it->process);
+        }
+    }
+}
+
+QVector<ProcessIndex::Process> ProcessIndex::find(const QString &term) const
+{
+    const QString foldedTerm = term.toCaseFolded();
+
+    QVector<Process> processes;
+
+    QReadLocker locker(&m_lock);
+    for (const Name &name : m_names) {
+        if (name.foldedName.contains(foldedTerm)) {
+            appendProcesses(name, processes);
+        }
+    }
+
+    return processes;
+}
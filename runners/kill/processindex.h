@@ -0,0 +1,126 @@
+/* Copyright 2020 by the Plasma Workspace authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROCESSINDEX_H
+#define PROCESSINDEX_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QString>
+#include <QVector>
+
+namespace KSysGuard
+{
+    class Processes;
+}
+
+/**
+ * A table of the running processes, indexed by name.
+ *
+ * On Linux it is read directly from /proc: refreshing only parses the
+ * stat file of each process, reuses what is known about processes seen
+ * before and groups the processes by name, so lookups only look at
+ * each distinct name once instead of at every process.
+ * Elsewhere the processes are listed through KSysGuard.
+ *
+ * refresh() can be called from any thread, lookups can run concurrently.
+ */
+class ProcessIndex
+{
+public:
+    struct Process {
+        qint64 pid = 0;
+        QString name;
+        // Percentage of the total CPU time used since the previous refresh
+        qreal cpuUsage = 0;
+    };
+
+    ProcessIndex();
+    ~ProcessIndex();
+    Q_DISABLE_COPY(ProcessIndex)
+
+    /**
+     * Updates the table, the CPU usage is only known from the second refresh on.
+     */
+    void refresh();
+
+    /**
+     * Refreshes unless this was already done before.
+     */
+    void ensureRefreshed();
+
+    /**
+     * Drops the table, the next refresh starts from scratch.
+     * @return false if a refresh is running, the table is kept then
+     */
+    bool tryClear();
+
+    bool isEmpty() const;
+
+    /**
+     * @return the processes whose name contains @p term, ignoring case
+     */
+    QVector<Process> find(const QString &term) const;
+
+    /**
+     * Reads the name and the used CPU time in clock ticks from the contents
+     * of a /proc/<pid>/stat file in @p buffer.
+     * @p name is only assigned if it changed, to keep sharing the string.
+     */
+    static bool parseStat(const char *buffer, QString &name, quint64 &cpuTicks);
+
+    /**
+     * @return the percentage of the total CPU time on @p cpuCount CPUs used by
+     * a process whose CPU time went from @p previousTicks to @p ticks in @p elapsed ms
+     */
+    static qreal cpuUsage(quint64 previousTicks, quint64 ticks, qint64 elapsed, long ticksPerSecond, long cpuCount);
+
+private:
+    struct Entry {
+        Process process;
+        // utime + stime in clock ticks at the last refresh
+        quint64 cpuTicks = 0;
+    };
+
+    struct Name {
+        QString foldedName;
+        QVector<qint64> pids;
+    };
+
+    // @return whether processes were added, removed or renamed
+    bool scan(QHash<qint64, Entry> &entries);
+    static QVector<Name> buildNames(const QHash<qint64, Entry> &entries);
+    void appendProcesses(const Name &name, QVector<Process> &processes) const;
+
+    // Serializes refresh() and tryClear()
+    QMutex m_refreshMutex;
+    bool m_refreshed = false;
+    QElapsedTimer m_sinceLastRefresh;
+    // Only used where there is no /proc to read
+    KSysGuard::Processes *m_processes = nullptr;
+
+    // Protects everything below
+    mutable QReadWriteLock m_lock;
+    QHash<qint64, Entry> m_entries;
+    QVector<Name> m_names;
+};
+
+#endif
@@ -21,7 +21,10 @@
 
 #include <QAction>
 #include <QDir>
+#include <QFileInfo>
 #include <QMimeData>
+#include <QSet>
+#include <QTimer>
 
 #include <KDesktopFile>
 #include <KConfigGroup>
@@ -37,16 +40,23 @@ static const QString s_openParentDirId = QStringLiteral("openParentDir");
 
 RecentDocuments::RecentDocuments(QObject *parent, const QVariantList& args)
     : Plasma::AbstractRunner(parent, args)
+    , m_reloadTimer(new QTimer(this))
 {
     Q_UNUSED(args);
     setObjectName( QStringLiteral("Recent Documents" ));
     loadRecentDocuments();
+
+    // opening a document touches several files at once, reload only once for all of them
+    m_reloadTimer->setSingleShot(true);
+    m_reloadTimer->setInterval(100);
+    connect(m_reloadTimer, &QTimer::timeout, this, &RecentDocuments::loadRecentDocuments);
+
     // listen for changes to the list of recent documents
     KDirWatch *recentDocWatch = new KDirWatch(this);
     recentDocWatch->addDir(KRecentDocument::recentDocumentDirectory(), KDirWatch::WatchFiles);
-    connect(recentDocWatch, &KDirWatch::created, this, &RecentDocuments::loadRecentDocuments);
-    connect(recentDocWatch, &KDirWatch::deleted, this, &RecentDocuments::loadRecentDocuments);
-    connect(recentDocWatch, &KDirWatch::dirty, this, &RecentDocuments::loadRecentDocuments);
+    connect(recentDocWatch, &KDirWatch::created, m_reloadTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(recentDocWatch, &KDirWatch::deleted, m_reloadTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(recentDocWatch, &KDirWatch::dirty, m_reloadTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
     addSyntax(Plasma::RunnerSyntax(QStringLiteral(":q:"), i18n("Looks for documents recently used with names matching :q:.")));
 
     addAction(s_openParentDirId, QIcon::fromTheme(QStringLiteral("document-open-folder")), i18n("Open Containing Folder"));
@@ -58,61 +68,140 @@ RecentDocuments::~RecentDocuments()
 
 void RecentDocuments::loadRecentDocuments()
 {
-    m_recentdocuments = KRecentDocument::recentDocuments();
+    // Only desktop files which were added or changed since the last time are parsed,
+    // KRecentDocument::recentDocuments() would read all of them again
+    const QDir dir(KRecentDocument::recentDocumentDirectory(), QStringLiteral("*.desktop"),
+                   QDir::Time, QDir::Files | QDir::Readable | QDir::Hidden);
+    const QFileInfoList files = dir.entryInfoList();
+
+    QHash<QString, RecentDocument> parsedDocuments;
+    parsedDocuments.reserve(files.count());
+    QVector<RecentDocument> documents;
+    documents.reserve(files.count());
+
+    // avoid duplicates
+    QSet<QUrl> knownUrls;
+
+    for (const QFileInfo &file : files) {
+        const QString path = file.absoluteFilePath();
+        const QDateTime lastModified = file.lastModified();
+
+        auto it = m_parsedDocuments.constFind(path);
+        const RecentDocument document = (it != m_parsedDocuments.constEnd() && it->lastModified == lastModified)
+            ? it.value() : readDocument(path, lastModified);
+
+        parsedDocuments.insert(path, document);
+
+        if (!document.url.isValid() || knownUrls.contains(document.url)) {
+            continue;
+        }
+
+        // The file may be gone by now, KRecentDocument only cleans those up when listing
+        if (document.url.isLocalFile() && !QFileInfo::exists(document.url.toLocalFile())) {
+            continue;
+        }
+
+        knownUrls.insert(document.url);
+        documents.append(document);
+    }
+
+    m_parsedDocuments = parsedDocuments;
+
+    QMutexLocker locker(&m_documentsMutex);
+    m_documents = documents;
 }
 
+RecentDocuments::RecentDocument RecentDocuments::readDocument(const QString &desktopFilePath, const QDateTime &lastModified) const
+{
+    RecentDocument document;
+    document.desktopFilePath = desktopFilePath;
+    document.lastModified = lastModified;
+
+    KDesktopFile config(desktopFilePath);
+    document.url = QUrl(config.readUrl());
+    document.name = config.readName();
+    if (document.name.isEmpty()) {
+        document.name = document.url.fileName();
+    }
+    document.iconName = config.readIcon();
+
+    const QUrl folderUrl = document.url.adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash);
+    if (folderUrl.isLocalFile()) {
+        const QString homePath = QDir::homePath();
+        QString folderPath = folderUrl.toLocalFile();
+        if (folderPath.startsWith(homePath)) {
+            folderPath.replace(0, homePath.length(), QStringLiteral("~"));
+        }
+        document.subtext = folderPath;
+    } else {
+        document.subtext = folderUrl.toDisplayString();
+    }
 
-void RecentDocuments::match(Plasma::RunnerContext &context)
+    document.foldedName = document.name.toCaseFolded();
+    for (int i = 0; i < document.foldedName.size(); ++i) {
+        if (document.foldedName.at(i).isLetterOrNumber()
+            && (i == 0 || !document.foldedName.at(i - 1).isLetterOrNumber())) {
+            document.wordStarts.append(i);
+        }
+    }
+
+    return document;
+}
+
+qreal RecentDocuments::matchRelevance(const RecentDocument &document, const QString &foldedTerm)
 {
-    if (m_recentdocuments.isEmpty()) {
-        return;
+    if (document.foldedName.startsWith(foldedTerm)) {
+        return 1.0;
     }
 
+    // "report" should find "2020-annual-report.odt", but not "unreported.txt"
+    for (int start : document.wordStarts) {
+        if (document.foldedName.midRef(start).startsWith(foldedTerm)) {
+            return 0.9;
+        }
+    }
+
+    return 0;
+}
+
+void RecentDocuments::match(Plasma::RunnerContext &context)
+{
     const QString term = context.query();
     if (term.length() < 3) {
         return;
     }
 
-    const QString homePath = QDir::homePath();
+    QVector<RecentDocument> documents;
+    {
+        QMutexLocker locker(&m_documentsMutex);
+        documents = m_documents;
+    }
 
-    // avoid duplicates
-    QSet<QUrl> knownUrls;
+    if (documents.isEmpty()) {
+        return;
+    }
+
+    const QString foldedTerm = term.toCaseFolded();
 
-    for (const QString &document : qAsConst(m_recentdocuments)) {
+    for (const RecentDocument &document : qAsConst(documents)) {
         if (!context.isValid()) {
             return;
         }
 
-        if (document.contains(term, Qt::CaseInsensitive)) {
-            KDesktopFile config(document);
-
-            const QUrl url = QUrl(config.readUrl());
-            if (knownUrls.contains(url)) {
-                continue;
-            }
-
-            knownUrls.insert(url);
-
-            Plasma::QueryMatch match(this);
-            match.setType(Plasma::QueryMatch::PossibleMatch);
-            match.setRelevance(1.0);
-            match.setIconName(config.readIcon());
-            match.setData(url);
-            match.setText(config.readName());
-
-            QUrl folderUrl = url.adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash);
-            if (folderUrl.isLocalFile()) {
-                QString folderPath = folderUrl.toLocalFile();
-                if (folderPath.startsWith(homePath)) {
-                    folderPath.replace(0, homePath.length(), QStringLiteral("~"));
-                }
-                match.setSubtext(folderPath);
-            } else {
-                match.setSubtext(folderUrl.toDisplayString());
-            }
-
-            context.addMatch(match);
+        const qreal relevance = matchRelevance(document, foldedTerm);
+        if (relevance <= 0) {
+            continue;
         }
+
+        Plasma::QueryMatch match(this);
+        match.setType(Plasma::QueryMatch::PossibleMatch);
+        match.setRelevance(relevance);
+        match.setIconName(document.iconName);
+        match.setData(document.url);
+        match.setText(document.name);
+        match.setSubtext(document.subtext);
+
+        context.addMatch(match);
     }
 }
 
@@ -22,7 +22,14 @@
 
 #include <krunner/abstractrunner.h>
 
+#include <QDateTime>
+#include <QHash>
 #include <QIcon>
+#include <QMutex>
+#include <QUrl>
+#include <QVector>
+
+class QTimer;
 
 class RecentDocuments : public Plasma::AbstractRunner {
     Q_OBJECT
@@ -42,7 +49,28 @@ class RecentDocuments : public Plasma::AbstractRunner {
         void loadRecentDocuments();
 
     private:
-        QStringList m_recentdocuments;
+        struct RecentDocument {
+            QString desktopFilePath;
+            QDateTime lastModified;
+            QUrl url;
+            QString name;
+            QString iconName;
+            QString subtext;
+            // case folded name and the positions of the words in it, for matching
+            QString foldedName;
+            QVector<int> wordStarts;
+        };
+
+        RecentDocument readDocument(const QString &desktopFilePath, const QDateTime &lastModified) const;
+        static qreal matchRelevance(const RecentDocument &document, const QString &foldedTerm);
+
+        // all parsed desktop files by path, only used from the main thread
+        QHash<QString, RecentDocument> m_parsedDocuments;
+        // the documents to match against, most recent first; guarded by m_documentsMutex
+        // as match() runs in other threads
+        QVector<RecentDocument> m_documents;
+        QMutex m_documentsMutex;
+        QTimer *m_reloadTimer;
 };
 
 
@@ -41,6 +41,9 @@ private Q_SLOTS:
     void testChromeAppsRelevance();
     void testKonsoleVsYakuakeComment();
     void testSystemSettings();
+    void testAbbreviation();
+
+    void benchmarkTyping();
 };
 
 void ServiceRunnerTest::initTestCase()
@@ -159,6 +162,45 @@ void ServiceRunnerTest::testSystemSettings()
     QVERIFY(!foreignSystemSettingsFound);
 }
 
+void ServiceRunnerTest::testAbbreviation()
+{
+    // Characters of the name typed in order, starting at a word, match as well
+    // but rate below matching substrings.
+    ServiceRunner runner(this, QVariantList());
+    Plasma::RunnerContext context;
+    context.setQuery(QStringLiteral("sysset"));
+
+    runner.match(context);
+
+    bool systemSettingsFound = false;
+    for (auto match : context.matches()) {
+        qDebug() << "matched" << match.text();
+        if (match.text() == QLatin1String("System Settings ServiceRunnerTest")) {
+            QCOMPARE(match.relevance(), 0.42);
+            systemSettingsFound = true;
+        }
+        QVERIFY(match.text() != QLatin1String("KDE System Settings ServiceRunnerTest"));
+    }
+    QVERIFY(systemSettingsFound);
+}
+
+void ServiceRunnerTest::benchmarkTyping()
+{
+    ServiceRunner runner(this, QVariantList());
+    // The services are indexed once per session, not per keystroke
+    emit runner.prepare();
+
+    const QString query = QStringLiteral("system settings");
+
+    QBENCHMARK {
+        for (int i = 1; i <= query.size(); ++i) {
+            Plasma::RunnerContext context;
+            context.setQuery(query.left(i));
+            runner.match(context);
+        }
+    }
+}
+
 QTEST_MAIN(ServiceRunnerTest)
 
 #include "servicerunnertest.moc"
@@ -37,6 +37,7 @@
 #include <KServiceAction>
 #include <KServiceTypeTrader>
 #include <KStringHandler>
+#include <KSycoca>
 
 #include <KIO/ApplicationLauncherJob>
 
@@ -48,16 +49,156 @@ int weightedLength(const QString &query) {
     return KStringHandler::logicalLength(query);
 }
 
+bool containsAll(const QString &foldedText, const QVector<QStringRef> &foldedWords)
+{
+    for (const QStringRef &word : foldedWords) {
+        if (!foldedText.contains(word)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool anyContains(const QStringList &foldedList, const QStringRef &foldedWord)
+{
+    for (const QString &item : foldedList) {
+        if (item.contains(foldedWord)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QStringList caseFolded(const QStringList &list)
+{
+    QStringList folded;
+    folded.reserve(list.size());
+    for (const QString &item : list) {
+        folded << item.toCaseFolded();
+    }
+    return folded;
+}
+
 }  // namespace
 
+/**
+ * @brief The services the runner matches against, prepared for matching
+ *
+ * Going through KServiceTypeTrader for every keystroke parses a constraint
+ * string and scans the whole database several times, so the services are
+ * collected once per sycoca change with their case folded fields instead.
+ */
+class ServiceIndex
+{
+public:
+    struct Service {
+        KService::Ptr service;
+        QString name;
+        QString genericName;
+        QString exec;
+        QString comment;
+        QString desktopEntryName;
+
+        QString foldedName;
+        QString foldedGenericName;
+        QString foldedExec;
+        QString foldedComment;
+        QString foldedDesktopEntryName;
+        QStringList foldedKeywords;
+        QStringList foldedCategories;
+
+        bool noDisplay = false;
+        bool isKde = false;
+        bool isKCModule = false;
+        bool isMoreCategory = false;
+        bool showInCurrentDesktop = true;
+    };
+
+    struct Action {
+        KService::Ptr service;
+        KServiceAction action;
+        QString foldedText;
+    };
+
+    static QSharedPointer<const ServiceIndex> build()
+    {
+        QSharedPointer<ServiceIndex> index(new ServiceIndex);
+
+        const KService::List applications = KServiceTypeTrader::self()->query(QStringLiteral("Application"));
+        for (const KService::Ptr &service : applications) {
+            if (!service->exec().isEmpty()) {
+                index->applications << indexService(service);
+            }
+
+            if (service->noDisplay()) {
+                continue;
+            }
+
+            const auto actions = service->actions();
+            for (const KServiceAction &action : actions) {
+                if (action.text().isEmpty() || action.exec().isEmpty()) {
+                    continue;
+                }
+                index->actions << Action{service, action, action.text().toCaseFolded()};
+            }
+        }
+
+        const KService::List kcms = KServiceTypeTrader::self()->query(QStringLiteral("KCModule"));
+        for (const KService::Ptr &service : kcms) {
+            if (!service->exec().isEmpty()) {
+                index->kcms << indexService(service);
+            }
+        }
+
+        qCDebug(RUNNER_SERVICES) << "Indexed" << index->applications.count() << "applications,"
+                                 << index->kcms.count() << "modules and" << index->actions.count() << "actions";
+
+        return index;
+    }
+
+    QVector<Service> applications;
+    QVector<Service> kcms;
+    QVector<Action> actions;
+
+private:
+    static Service indexService(const KService::Ptr &service)
+    {
+        Service entry;
+        entry.service = service;
+        entry.name = service->name();
+        entry.genericName = service->genericName();
+        entry.exec = service->exec();
+        entry.comment = service->comment();
+        entry.desktopEntryName = service->desktopEntryName();
+
+        entry.foldedName = entry.name.toCaseFolded();
+        entry.foldedGenericName = entry.genericName.toCaseFolded();
+        entry.foldedExec = entry.exec.toCaseFolded();
+        entry.foldedComment = entry.comment.toCaseFolded();
+        entry.foldedDesktopEntryName = entry.desktopEntryName.toCaseFolded();
+        entry.foldedKeywords = caseFolded(service->keywords());
+        entry.foldedCategories = caseFolded(service->categories());
+
+        const QStringList categories = service->categories();
+        entry.noDisplay = service->noDisplay();
+        entry.isKCModule = service->serviceTypes().contains(QLatin1String("KCModule"));
+        entry.isKde = categories.contains(QLatin1String("KDE")) || entry.isKCModule;
+        entry.isMoreCategory = categories.contains(QLatin1String("X-KDE-More"));
+        entry.showInCurrentDesktop = service->showInCurrentDesktop();
+
+        return entry;
+    }
+};
+
 /**
  * @brief Finds all KServices for a given runner query
  */
 class ServiceFinder
 {
 public:
-    ServiceFinder(ServiceRunner *runner)
+    ServiceFinder(ServiceRunner *runner, const QSharedPointer<const ServiceIndex> &index)
          : m_runner(runner)
+         , m_index(index)
     {}
 
 
@@ -68,22 +209,24 @@ public:
         }
 
         term = context.query();
+        foldedTerm = term.toCaseFolded();
         weightedTermLength = weightedLength(term);
 
         matchExectuables();
         matchNameKeywordAndGenericName();
         matchCategories();
         matchJumpListActions();
+        matchSubsequences();
 
         context.addMatches(matches);
     }
 
 private:
 
-    void seen(const KService::Ptr &service)
+    void seen(const ServiceIndex::Service &entry)
     {
-        m_seen.insert(service->storageId());
-        m_seen.insert(service->exec());
+        m_seen.insert(entry.service->storageId());
+        m_seen.insert(entry.exec);
     }
 
     void seen(const KServiceAction &action)
@@ -91,10 +234,10 @@ private:
         m_seen.insert(action.exec());
     }
 
-    bool hasSeen(const KService::Ptr &service)
+    bool hasSeen(const ServiceIndex::Service &entry)
     {
-        return m_seen.contains(service->storageId()) &&
-               m_seen.contains(service->exec());
+        return m_seen.contains(entry.service->storageId()) &&
+               m_seen.contains(entry.exec);
     }
 
     bool hasSeen(const KServiceAction &action)
@@ -102,89 +245,69 @@ private:
         return m_seen.contains(action.exec());
     }
 
-    bool disqualify(const KService::Ptr &service)
+    bool disqualify(const ServiceIndex::Service &entry)
     {
-        auto ret = hasSeen(service) || service->noDisplay();
-        qCDebug(RUNNER_SERVICES) << service->name() << "disqualified?" << ret;
-        seen(service);
+        auto ret = hasSeen(entry) || entry.noDisplay;
+        qCDebug(RUNNER_SERVICES) << entry.name << "disqualified?" << ret;
+        seen(entry);
         return ret;
     }
 
-    qreal increaseMatchRelavance(const KService::Ptr &service, const QVector<QStringRef> &strList, const QString &category)
+    qreal increaseMatchRelavance(const QString &field, const QVector<QStringRef> &strList)
     {
         //Increment the relevance based on all the words (other than the first) of the query list
         qreal relevanceIncrement = 0;
 
         for(int i = 1; i < strList.size(); ++i) {
-            const auto &str = strList.at(i);
-            if (category == QLatin1String("Name")) {
-                if (service->name().contains(str, Qt::CaseInsensitive)) {
-                    relevanceIncrement += 0.01;
-                }
-            } else if (category == QLatin1String("GenericName")) {
-                if (service->genericName().contains(str, Qt::CaseInsensitive)) {
-                    relevanceIncrement += 0.01;
-                }
-            } else if (category == QLatin1String("Exec")) {
-                if (service->exec().contains(str, Qt::CaseInsensitive)) {
-                    relevanceIncrement += 0.01;
-                }
-            } else if (category == QLatin1String("Comment")) {
-                if (service->comment().contains(str, Qt::CaseInsensitive)) {
-                    relevanceIncrement += 0.01;
-                }
+            if (field.contains(strList.at(i), Qt::CaseInsensitive)) {
+                relevanceIncrement += 0.01;
             }
         }
 
         return relevanceIncrement;
     }
 
-    QString generateQuery(const QVector<QStringRef> &strList)
+    bool matchesWords(const ServiceIndex::Service &entry, const QVector<QStringRef> &foldedWords)
     {
-        QString keywordTemplate = QStringLiteral("exist Keywords");
-        QString genericNameTemplate = QStringLiteral("exist GenericName");
-        QString nameTemplate = QStringLiteral("exist Name");
-        QString commentTemplate = QStringLiteral("exist Comment");
-
-        // Search for applications which are executable and the term case-insensitive matches any of
-        // * a substring of one of the keywords
-        // * a substring of the GenericName field
-        // * a substring of the Name field
-        // Note that before asking for the content of e.g. Keywords and GenericName we need to ask if
-        // they exist to prevent a tree evaluation error if they are not defined.
-        for (const QStringRef &str : strList)
-        {
-            keywordTemplate += QStringLiteral(" and '%1' ~subin Keywords").arg(str.toString());
-            genericNameTemplate += QStringLiteral(" and '%1' ~~ GenericName").arg(str.toString());
-            nameTemplate += QStringLiteral(" and '%1' ~~ Name").arg(str.toString());
-            commentTemplate += QStringLiteral(" and '%1' ~~ Comment").arg(str.toString());
+        // Search for services where the term case-insensitive matches any of
+        // * a substring of one of the keywords (all words)
+        // * a substring of the GenericName field (all words)
+        // * a substring of the Name field (all words)
+        // * a substring of the Exec field (first word)
+        // * a substring of the Comment field (all words)
+        bool inKeywords = !entry.foldedKeywords.isEmpty();
+        for (const QStringRef &word : foldedWords) {
+            if (!inKeywords) {
+                break;
+            }
+            inKeywords = anyContains(entry.foldedKeywords, word);
         }
 
-        QString finalQuery = QStringLiteral("exist Exec and ( (%1) or (%2) or (%3) or ('%4' ~~ Exec) or (%5) )")
-            .arg(keywordTemplate, genericNameTemplate, nameTemplate, strList[0].toString(), commentTemplate);
-
-        qCDebug(RUNNER_SERVICES) << "Final query : " << finalQuery;
-        return finalQuery;
+        return inKeywords
+            || (!entry.foldedGenericName.isEmpty() && containsAll(entry.foldedGenericName, foldedWords))
+            || (!entry.foldedName.isEmpty() && containsAll(entry.foldedName, foldedWords))
+            || entry.foldedExec.contains(foldedWords.at(0))
+            || (!entry.foldedComment.isEmpty() && containsAll(entry.foldedComment, foldedWords));
     }
 
-    void setupMatch(const KService::Ptr &service, Plasma::QueryMatch &match)
+    void setupMatch(const ServiceIndex::Service &entry, Plasma::QueryMatch &match)
     {
-        const QString name = service->name();
+        const QString &name = entry.name;
 
         match.setText(name);
 
-        QUrl url(service->storageId());
+        QUrl url(entry.service->storageId());
         url.setScheme(QStringLiteral("applications"));
         match.setData(url);
 
-        if (!service->genericName().isEmpty() && service->genericName() != name) {
-            match.setSubtext(service->genericName());
-        } else if (!service->comment().isEmpty()) {
-            match.setSubtext(service->comment());
+        if (!entry.genericName.isEmpty() && entry.genericName != name) {
+            match.setSubtext(entry.genericName);
+        } else if (!entry.comment.isEmpty()) {
+            match.setSubtext(entry.comment);
         }
 
-        if (!service->icon().isEmpty()) {
-            match.setIconName(service->icon());
+        if (!entry.service->icon().isEmpty()) {
+            match.setIconName(entry.service->icon());
         }
     }
 
@@ -195,23 +318,18 @@ private:
         }
 
         // Search for applications which are executable and case-insensitively match the search term
-        // See https://techbase.kde.org/Development/Tutorials/Services/Traders#The_KTrader_Query_Language
-        // if the following is unclear to you.
-        query = QStringLiteral("exist Exec and ('%1' =~ Name)").arg(term);
-        const KService::List services = KServiceTypeTrader::self()->query(QStringLiteral("Application"), query);
-
-        if (services.isEmpty()) {
-            return;
-        }
+        for (const ServiceIndex::Service &entry : m_index->applications) {
+            if (entry.foldedName != foldedTerm) {
+                continue;
+            }
 
-        for (const KService::Ptr &service : services) {
-            qCDebug(RUNNER_SERVICES) << service->name() << "is an exact match!" << service->storageId() << service->exec();
-            if (disqualify(service)) {
+            qCDebug(RUNNER_SERVICES) << entry.name << "is an exact match!" << entry.service->storageId() << entry.exec;
+            if (disqualify(entry)) {
                 continue;
             }
             Plasma::QueryMatch match(m_runner);
             match.setType(Plasma::QueryMatch::ExactMatch);
-            setupMatch(service, match);
+            setupMatch(entry, match);
             match.setRelevance(1);
             matches << match;
         }
@@ -221,80 +339,81 @@ private:
     {
         //Splitting the query term to match using subsequences
         QVector<QStringRef> queryList = term.splitRef(QLatin1Char(' '));
+        const QVector<QStringRef> foldedQueryList = foldedTerm.splitRef(QLatin1Char(' '));
 
-        // If the term length is < 3, no real point searching the Keywords and GenericName
-        if (weightedTermLength < 3) {
-            query = QStringLiteral("exist Exec and ( (exist Name and '%1' ~~ Name) or ('%1' ~~ Exec) )").arg(term);
-        } else {
-            //Match using subsequences (Bug: 262837)
-            query = generateQuery(queryList);
-        }
-
-        KService::List services = KServiceTypeTrader::self()->query(QStringLiteral("Application"), query);
-        services += KServiceTypeTrader::self()->query(QStringLiteral("KCModule"), query);
+        matchNameKeywordAndGenericName(m_index->applications, queryList, foldedQueryList);
+        matchNameKeywordAndGenericName(m_index->kcms, queryList, foldedQueryList);
+    }
 
-        qCDebug(RUNNER_SERVICES) << "got " << services.count() << " services from " << query;
-        for (const KService::Ptr &service : qAsConst(services)) {
-            if (disqualify(service)) {
+    void matchNameKeywordAndGenericName(const QVector<ServiceIndex::Service> &services,
+                                        const QVector<QStringRef> &queryList, const QVector<QStringRef> &foldedQueryList)
+    {
+        for (const ServiceIndex::Service &entry : services) {
+            // If the term length is < 3, no real point searching the Keywords and GenericName
+            if (weightedTermLength < 3) {
+                if (!entry.foldedName.contains(foldedTerm) && !entry.foldedExec.contains(foldedTerm)) {
+                    continue;
+                }
+            } else if (!matchesWords(entry, foldedQueryList)) {
                 continue;
             }
 
-            const QString id = service->storageId();
-            const QString name = service->desktopEntryName();
-            const QString exec = service->exec();
+            if (disqualify(entry)) {
+                continue;
+            }
 
             Plasma::QueryMatch match(m_runner);
             match.setType(Plasma::QueryMatch::PossibleMatch);
-            setupMatch(service, match);
+            setupMatch(entry, match);
             qreal relevance(0.6);
 
             // If the term was < 3 chars and NOT at the beginning of the App's name or Exec, then
             // chances are the user doesn't want that app.
             if (weightedTermLength < 3) {
-                if (name.startsWith(term, Qt::CaseInsensitive) || exec.startsWith(term, Qt::CaseInsensitive)) {
+                if (entry.foldedDesktopEntryName.startsWith(foldedTerm) || entry.foldedExec.startsWith(foldedTerm)) {
                     relevance = 0.9;
                 } else {
                     continue;
                 }
-            } else if (service->name().contains(queryList[0], Qt::CaseInsensitive)) {
+            } else if (entry.name.contains(queryList[0], Qt::CaseInsensitive)) {
                 relevance = 0.8;
-                relevance += increaseMatchRelavance(service, queryList, QStringLiteral("Name"));
+                relevance += increaseMatchRelavance(entry.name, queryList);
 
-                if (service->name().startsWith(queryList[0], Qt::CaseInsensitive)) {
+                if (entry.name.startsWith(queryList[0], Qt::CaseInsensitive)) {
                     relevance += 0.1;
                 }
-            } else if (service->genericName().contains(queryList[0], Qt::CaseInsensitive)) {
+            } else if (entry.genericName.contains(queryList[0], Qt::CaseInsensitive)) {
                 relevance = 0.65;
-                relevance += increaseMatchRelavance(service, queryList, QStringLiteral("GenericName"));
+                relevance += increaseMatchRelavance(entry.genericName, queryList);
 
-                if (service->genericName().startsWith(queryList[0], Qt::CaseInsensitive)) {
+                if (entry.genericName.startsWith(queryList[0], Qt::CaseInsensitive)) {
                     relevance += 0.05;
                 }
-            } else if (service->exec().contains(queryList[0], Qt::CaseInsensitive)) {
+            } else if (entry.exec.contains(queryList[0], Qt::CaseInsensitive)) {
                 relevance = 0.7;
-                relevance += increaseMatchRelavance(service, queryList, QStringLiteral("Exec"));
+                relevance += increaseMatchRelavance(entry.exec, queryList);
 
-                if (service->exec().startsWith(queryList[0], Qt::CaseInsensitive)) {
+                if (entry.exec.startsWith(queryList[0], Qt::CaseInsensitive)) {
                     relevance += 0.05;
                 }
-            } else if (service->comment().contains(queryList[0], Qt::CaseInsensitive)) {
+            } else if (entry.comment.contains(queryList[0], Qt::CaseInsensitive)) {
                 relevance = 0.5;
-                relevance += increaseMatchRelavance(service, queryList, QStringLiteral("Comment"));
+                relevance += increaseMatchRelavance(entry.comment, queryList);
 
-                if (service->comment().startsWith(queryList[0], Qt::CaseInsensitive)) {
+                if (entry.comment.startsWith(queryList[0], Qt::CaseInsensitive)) {
                     relevance += 0.05;
                 }
             }
 
-            if (service->categories().contains(QLatin1String("KDE")) || service->serviceTypes().contains(QLatin1String("KCModule"))) {
-                qCDebug(RUNNER_SERVICES) << "found a kde thing" << id << match.subtext() << relevance;
+            if (entry.isKde) {
+                qCDebug(RUNNER_SERVICES) << "found a kde thing" << entry.service->storageId() << match.subtext() << relevance;
                 relevance += .09;
             }
 
-            qCDebug(RUNNER_SERVICES) << service->name() << "is this relevant:" << relevance;
+            qCDebug(RUNNER_SERVICES) << entry.name << "is this relevant:" << relevance;
             match.setRelevance(relevance);
-            if (service->serviceTypes().contains(QLatin1String("KCModule"))) {
-                if (service->parentApp() == QStringLiteral("kinfocenter")) {
+            if (entry.isKCModule) {
+                if (entry.service->parentApp() == QStringLiteral("kinfocenter")) {
                     match.setMatchCategory(i18n("System Information"));
                 } else {
                     match.setMatchCategory(i18n("System Settings"));
@@ -307,26 +426,28 @@ private:
     void matchCategories()
     {
         //search for applications whose categories contains the query
-        query = QStringLiteral("exist Exec and (exist Categories and '%1' ~subin Categories)").arg(term);
-        const auto services = KServiceTypeTrader::self()->query(QStringLiteral("Application"), query);
+        const QStringRef foldedTermRef(&foldedTerm);
+
+        for (const ServiceIndex::Service &entry : m_index->applications) {
+            if (!anyContains(entry.foldedCategories, foldedTermRef)) {
+                continue;
+            }
 
-        for (const KService::Ptr &service : services) {
-            qCDebug(RUNNER_SERVICES) << service->name() << "is an exact match!" << service->storageId() << service->exec();
-            if (disqualify(service)) {
+            qCDebug(RUNNER_SERVICES) << entry.name << "is an exact match!" << entry.service->storageId() << entry.exec;
+            if (disqualify(entry)) {
                 continue;
             }
 
             Plasma::QueryMatch match(m_runner);
             match.setType(Plasma::QueryMatch::PossibleMatch);
-            setupMatch(service, match);
+            setupMatch(entry, match);
 
             qreal relevance = 0.6;
-            if (service->categories().contains(QLatin1String("X-KDE-More")) ||
-                    !service->showInCurrentDesktop()) {
+            if (entry.isMoreCategory || !entry.showInCurrentDesktop) {
                 relevance = 0.5;
             }
 
-            if (service->isApplication()) {
+            if (entry.service->isApplication()) {
                 relevance += .04;
             }
 
@@ -341,63 +462,128 @@ private:
             return;
         }
 
-        query = QStringLiteral("exist Actions"); // doesn't work
-        const auto services = KServiceTypeTrader::self()->query(QStringLiteral("Application"));//, query);
+        for (const ServiceIndex::Action &entry : m_index->actions) {
+            const KServiceAction &action = entry.action;
+            if (hasSeen(action)) {
+                continue;
+            }
+            seen(action);
 
-        for (const KService::Ptr &service : services) {
-            if (service->noDisplay()) {
+            const int matchIndex = entry.foldedText.indexOf(foldedTerm);
+            if (matchIndex < 0) {
                 continue;
             }
 
-            const auto actions = service->actions();
-            for (const KServiceAction &action : actions) {
-                if (action.text().isEmpty() || action.exec().isEmpty() || hasSeen(action)) {
-                    continue;
-                }
-                seen(action);
+            const KService::Ptr &service = entry.service;
 
-                const int matchIndex = action.text().indexOf(term, 0, Qt::CaseInsensitive);
-                if (matchIndex < 0) {
-                    continue;
-                }
+            Plasma::QueryMatch match(m_runner);
+            match.setType(Plasma::QueryMatch::PossibleMatch);
+            if (!action.icon().isEmpty()) {
+                match.setIconName(action.icon());
+            } else {
+                match.setIconName(service->icon());
+            }
+            match.setText(i18nc("Jump list search result, %1 is action (eg. open new tab), %2 is application (eg. browser)",
+                                "%1 - %2", action.text(), service->name()));
 
-                Plasma::QueryMatch match(m_runner);
-                match.setType(Plasma::QueryMatch::PossibleMatch);
-                if (!action.icon().isEmpty()) {
-                    match.setIconName(action.icon());
-                } else {
-                    match.setIconName(service->icon());
+            QUrl url(service->storageId());
+            url.setScheme(QStringLiteral("applications"));
+
+            QUrlQuery query;
+            query.addQueryItem(QStringLiteral("action"), action.name());
+            url.setQuery(query);
+
+            match.setData(url);
+
+            qreal relevance = 0.5;
+            if (matchIndex == 0) {
+                relevance += 0.05;
+            }
+
+            match.setRelevance(relevance);
+
+            matches << match;
+        }
+    }
+
+    // Returns the length of the shortest part of @p foldedName starting at a word
+    // which contains all characters of the term in order, or -1 if there is none
+    int subsequenceSpan(const QString &foldedName)
+    {
+        int bestSpan = -1;
+
+        for (int start = 0; start < foldedName.size(); ++start) {
+            if (foldedName.at(start) != foldedTerm.at(0)
+                || (start > 0 && foldedName.at(start - 1).isLetterOrNumber())) {
+                continue;
+            }
+
+            int termPos = 1;
+            int namePos = start + 1;
+            for (; namePos < foldedName.size() && termPos < foldedTerm.size(); ++namePos) {
+                if (foldedName.at(namePos) == foldedTerm.at(termPos)) {
+                    ++termPos;
                 }
-                match.setText(i18nc("Jump list search result, %1 is action (eg. open new tab), %2 is application (eg. browser)",
-                                    "%1 - %2", action.text(), service->name()));
+            }
 
-                QUrl url(service->storageId());
-                url.setScheme(QStringLiteral("applications"));
+            if (termPos < foldedTerm.size()) {
+                // no later start can contain the term either
+                break;
+            }
 
-                QUrlQuery query;
-                query.addQueryItem(QStringLiteral("action"), action.name());
-                url.setQuery(query);
+            const int span = namePos - start;
+            if (bestSpan < 0 || span < bestSpan) {
+                bestSpan = span;
+            }
+        }
 
-                match.setData(url);
+        return bestSpan;
+    }
 
-                qreal relevance = 0.5;
-                if (matchIndex == 0) {
-                    relevance += 0.05;
+    void matchSubsequences()
+    {
+        // Abbreviations like "ffx" for Firefox or "sysset" for System Settings,
+        // ranked by how close together the typed characters are in the name
+        if (weightedTermLength < 3 || foldedTerm.contains(QLatin1Char(' '))) {
+            return;
+        }
+
+        for (const auto *services : {&m_index->applications, &m_index->kcms}) {
+            for (const ServiceIndex::Service &entry : *services) {
+                if (hasSeen(entry) || entry.noDisplay) {
+                    continue;
                 }
 
-                match.setRelevance(relevance);
+                const int span = subsequenceSpan(entry.foldedName);
+                if (span < 0) {
+                    continue;
+                }
 
+                seen(entry);
+
+                Plasma::QueryMatch match(m_runner);
+                match.setType(Plasma::QueryMatch::PossibleMatch);
+                setupMatch(entry, match);
+                match.setRelevance(0.3 + 0.2 * foldedTerm.size() / span);
+                if (entry.isKCModule) {
+                    if (entry.service->parentApp() == QStringLiteral("kinfocenter")) {
+                        match.setMatchCategory(i18n("System Information"));
+                    } else {
+                        match.setMatchCategory(i18n("System Settings"));
+                    }
+                }
                 matches << match;
             }
         }
     }
 
     ServiceRunner *m_runner;
+    QSharedPointer<const ServiceIndex> m_index;
     QSet<QString> m_seen;
 
     QList<Plasma::QueryMatch> matches;
-    QString query;
     QString term;
+    QString foldedTerm;
     int weightedTermLength = -1;
 };
 
@@ -410,6 +596,15 @@ ServiceRunner::ServiceRunner(QObject *parent, const QVariantList &args)
     setPriority(AbstractRunner::HighestPriority);
 
     addSyntax(Plasma::RunnerSyntax(QStringLiteral(":q:"), i18n("Finds applications whose name or description match :q:")));
+
+    // Build the index before the user starts typing, it is kept until the services change
+    connect(this, &Plasma::AbstractRunner::prepare, this, [this] {
+        index();
+    });
+    connect(KSycoca::self(), QOverload<const QStringList &>::of(&KSycoca::databaseChanged), this, [this] {
+        QMutexLocker locker(&m_indexMutex);
+        m_index.reset();
+    });
 }
 
 ServiceRunner::~ServiceRunner() = default;
@@ -438,10 +633,19 @@ void ServiceRunner::match(Plasma::RunnerContext &context)
 {
     // This helper class aids in keeping state across numerous
     // different queries that together form the matches set.
-    ServiceFinder finder(this);
+    ServiceFinder finder(this, index());
     finder.match(context);
 }
 
+QSharedPointer<const ServiceIndex> ServiceRunner::index()
+{
+    QMutexLocker locker(&m_indexMutex);
+    if (!m_index) {
+        m_index = ServiceIndex::build();
+    }
+    return m_index;
+}
+
 void ServiceRunner::run(const Plasma::RunnerContext &context, const Plasma::QueryMatch &match)
 {
     Q_UNUSED(context);
@@ -20,11 +20,16 @@
 #define SERVICERUNNER_H
 
 
+#include <QMutex>
+#include <QSharedPointer>
+
 #include <KService>
 
 //#include <KRunner/AbstractRunner>
 #include <krunner/abstractrunner.h>
 
+class ServiceIndex;
+
 /**
  * This class looks for matches in the set of .desktop files installed by
  * applications. This way the user can type exactly what they see in the
@@ -50,6 +55,12 @@ class ServiceRunner : public Plasma::AbstractRunner
 
     protected:
         void setupMatch(const KService::Ptr &service, Plasma::QueryMatch &action);
+
+    private:
+        QSharedPointer<const ServiceIndex> index();
+
+        QMutex m_indexMutex;
+        QSharedPointer<const ServiceIndex> m_index;
 };
 
 
@@ -20,11 +20,11 @@
 
 #include "config-windowsrunner.h"
 
-#include <QTimer>
-
 #include <QDebug>
 #include <QIcon>
+#include <QIconEngine>
 #include <QMutexLocker>
+#include <QPainter>
 #include <KWindowSystem>
 #include <KLocalizedString>
 
@@ -35,9 +35,60 @@
 
 K_EXPORT_PLASMA_RUNNER(windows, WindowsRunner)
 
+static const NET::Properties s_windowInfoProperties = NET::WMWindowType | NET::WMDesktop |
+                                                      NET::WMState | NET::XAWMState | NET::WMName;
+static const NET::Properties2 s_windowInfoProperties2 = NET::WM2WindowClass | NET::WM2WindowRole | NET::WM2AllowedActions;
+
+// Fetches the icon of a window only when it is actually painted, which
+// happens in the main thread and only for windows shown in the results
+class WindowIconEngine : public QIconEngine
+{
+public:
+    explicit WindowIconEngine(WId window)
+        : m_window(window)
+    {
+    }
+
+    void paint(QPainter *painter, const QRect &rect, QIcon::Mode mode, QIcon::State state) override
+    {
+        icon().paint(painter, rect, Qt::AlignCenter, mode, state);
+    }
+
+    QPixmap pixmap(const QSize &size, QIcon::Mode mode, QIcon::State state) override
+    {
+        return icon().pixmap(size, mode, state);
+    }
+
+    QSize actualSize(const QSize &size, QIcon::Mode mode, QIcon::State state) override
+    {
+        return icon().actualSize(size, mode, state);
+    }
+
+    QIconEngine *clone() const override
+    {
+        auto *engine = new WindowIconEngine(m_window);
+        engine->m_icon = m_icon;
+        engine->m_loaded = m_loaded;
+        return engine;
+    }
+
+private:
+    const QIcon &icon()
+    {
+        if (!m_loaded) {
+            m_icon = QIcon(KWindowSystem::icon(m_window));
+            m_loaded = true;
+        }
+        return m_icon;
+    }
+
+    WId m_window;
+    QIcon m_icon;
+    bool m_loaded = false;
+};
+
 WindowsRunner::WindowsRunner(QObject* parent, const QVariantList& args)
-    : AbstractRunner(parent, args),
-      m_inSession(false)
+    : AbstractRunner(parent, args)
 {
     Q_UNUSED(args)
     setObjectName( QLatin1String("Windows") );
@@ -59,7 +110,6 @@ WindowsRunner::WindowsRunner(QObject* parent, const QVariantList& args)
                                    i18n("Lists all other desktops and allows to switch to them.")));
 
     connect(this, &Plasma::AbstractRunner::prepare, this, &WindowsRunner::prepareForMatchSession);
-    connect(this, &Plasma::AbstractRunner::teardown, this, &WindowsRunner::matchSessionComplete);
 }
 
 WindowsRunner::~WindowsRunner()
@@ -67,66 +117,117 @@ WindowsRunner::~WindowsRunner()
 }
 
 // Called in the main thread
-void WindowsRunner::gatherInfo()
+void WindowsRunner::startTracking()
 {
-    if (!m_inSession) {
-        return;
-    }
+    m_tracking = true;
+
+    // Changes are only collected here, the windows are refreshed when the next match session starts
+    connect(KWindowSystem::self(), &KWindowSystem::windowAdded, this, [this](WId window) {
+        m_dirtyWindows.insert(window);
+    });
+    connect(KWindowSystem::self(), &KWindowSystem::windowRemoved, this, [this](WId window) {
+        m_dirtyWindows.remove(window);
+
+        QMutexLocker locker(&m_mutex);
+        m_index.windows.remove(window);
+        m_index.icons.remove(window);
+    });
+    connect(KWindowSystem::self(), QOverload<WId, NET::Properties, NET::Properties2>::of(&KWindowSystem::windowChanged),
+            this, [this](WId window, NET::Properties properties, NET::Properties2 properties2) {
+        if (properties & NET::WMIcon) {
+            QMutexLocker locker(&m_mutex);
+            if (m_index.icons.contains(window)) {
+                m_index.icons.insert(window, QIcon(new WindowIconEngine(window)));
+            }
+        }
+
+        if ((properties & s_windowInfoProperties) || (properties2 & s_windowInfoProperties2)) {
+            m_dirtyWindows.insert(window);
+        }
+    });
+    connect(KWindowSystem::self(), &KWindowSystem::desktopNamesChanged, this, [this] {
+        m_desktopNamesDirty = true;
+    });
+    connect(KWindowSystem::self(), &KWindowSystem::numberOfDesktopsChanged, this, [this] {
+        m_desktopNamesDirty = true;
+    });
 
     const auto windows = KWindowSystem::windows();
     for (const WId &w : windows) {
-        KWindowInfo info(w, NET::WMWindowType | NET::WMDesktop |
-                                                        NET::WMState | NET::XAWMState |
-                                                        NET::WMName,
-                                                    NET::WM2WindowClass | NET::WM2WindowRole | NET::WM2AllowedActions);
-        if (info.valid()) {
-            // ignore NET::Tool and other special window types
-            NET::WindowType wType = info.windowType(NET::NormalMask | NET::DesktopMask | NET::DockMask |
-                                                    NET::ToolbarMask | NET::MenuMask | NET::DialogMask |
-                                                    NET::OverrideMask | NET::TopMenuMask |
-                                                    NET::UtilityMask | NET::SplashMask);
-
-            if (wType != NET::Normal && wType != NET::Override && wType != NET::Unknown &&
-                wType != NET::Dialog && wType != NET::Utility) {
-                continue;
-            }
-            m_windows.insert(w, info);
-            m_icons.insert(w, QIcon(KWindowSystem::icon(w)));
-        }
+        m_dirtyWindows.insert(w);
     }
+    m_desktopNamesDirty = true;
+}
 
-    for (int i=1; i<=KWindowSystem::numberOfDesktops(); i++) {
-        m_desktopNames << KWindowSystem::desktopName(i);
+// Called in the main thread
+void WindowsRunner::updateWindow(WId window)
+{
+    KWindowInfo info(window, s_windowInfoProperties, s_windowInfoProperties2);
+
+    bool relevant = info.valid();
+    if (relevant) {
+        // ignore NET::Tool and other special window types
+        NET::WindowType wType = info.windowType(NET::NormalMask | NET::DesktopMask | NET::DockMask |
+                                                NET::ToolbarMask | NET::MenuMask | NET::DialogMask |
+                                                NET::OverrideMask | NET::TopMenuMask |
+                                                NET::UtilityMask | NET::SplashMask);
+
+        relevant = wType == NET::Normal || wType == NET::Override || wType == NET::Unknown ||
+                   wType == NET::Dialog || wType == NET::Utility;
     }
 
-    // unlock lock locked in prepareForMatchSession
-    m_mutex.unlock();
+    QMutexLocker locker(&m_mutex);
+    if (relevant) {
+        m_index.windows.insert(window, info);
+        if (!m_index.icons.contains(window)) {
+            m_index.icons.insert(window, QIcon(new WindowIconEngine(window)));
+        }
+    } else {
+        m_index.windows.remove(window);
+        m_index.icons.remove(window);
+    }
 }
 
 // Called in the main thread
-void WindowsRunner::prepareForMatchSession()
+void WindowsRunner::updateDesktopNames()
 {
-    // gatherInfo will unlock the lock
-    m_mutex.lock();
-    m_inSession = true;
-    QTimer::singleShot(0, this, &WindowsRunner::gatherInfo);
+    QStringList desktopNames;
+    for (int i=1; i<=KWindowSystem::numberOfDesktops(); i++) {
+        desktopNames << KWindowSystem::desktopName(i);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_index.desktopNames = desktopNames;
 }
 
 // Called in the main thread
-void WindowsRunner::matchSessionComplete()
+void WindowsRunner::prepareForMatchSession()
 {
-    QMutexLocker locker(&m_mutex);
-    m_inSession = false;
-    m_desktopNames.clear();
-    m_icons.clear();
-    m_windows.clear();
+    if (!m_tracking) {
+        startTracking();
+    }
+
+    // Usually only a few windows changed since the last session
+    const QSet<WId> dirtyWindows = m_dirtyWindows;
+    m_dirtyWindows.clear();
+    for (WId window : dirtyWindows) {
+        updateWindow(window);
+    }
+
+    if (m_desktopNamesDirty) {
+        m_desktopNamesDirty = false;
+        updateDesktopNames();
+    }
 }
 
 // Called in the secondary thread
 void WindowsRunner::match(Plasma::RunnerContext& context)
 {
-    // will run block as long as gatherInfo has not finished
-    QMutexLocker locker(&m_mutex);
+    WindowIndex index;
+    {
+        QMutexLocker locker(&m_mutex);
+        index = m_index;
+    }
 
     QString term = context.query();
 
@@ -201,7 +302,7 @@ void WindowsRunner::match(Plasma::RunnerContext& context)
                 }
             }
         }
-        QHashIterator<WId, KWindowInfo> it(m_windows);
+        QHashIterator<WId, KWindowInfo> it(index.windows);
         while(it.hasNext()) {
             it.next();
             WId w = it.key();
@@ -236,7 +337,7 @@ void WindowsRunner::match(Plasma::RunnerContext& context)
             }
             // blacklisted everything else: we have a match
             if (actionSupported(info, action)){
-                matches << windowMatch(info, action);
+                matches << windowMatch(index, info, action);
             }
         }
 
@@ -257,7 +358,7 @@ void WindowsRunner::match(Plasma::RunnerContext& context)
                 if (i == KWindowSystem::currentDesktop()) {
                     continue;
                 }
-                matches << desktopMatch(i);
+                matches << desktopMatch(index, i);
                 desktopAdded = true;
             }
         } else {
@@ -265,14 +366,14 @@ void WindowsRunner::match(Plasma::RunnerContext& context)
             bool isInt;
             int desktop = term.midRef(parts[0].length() + 1).toInt(&isInt);
             if (isInt && desktop != KWindowSystem::currentDesktop()) {
-                matches << desktopMatch(desktop);
+                matches << desktopMatch(index, desktop);
                 desktopAdded = true;
             }
         }
     }
 
     // check for matches without keywords
-    QHashIterator<WId, KWindowInfo> it(m_windows);
+    QHashIterator<WId, KWindowInfo> it(index.windows);
     while (it.hasNext()) {
         it.next();
         WId w = it.key();
@@ -284,31 +385,31 @@ void WindowsRunner::match(Plasma::RunnerContext& context)
         QString className = QString::fromUtf8(info.windowClassName());
         if (info.name().startsWith(term, Qt::CaseInsensitive) ||
             className.startsWith(term, Qt::CaseInsensitive)) {
-            matches << windowMatch(info, action, 0.8, Plasma::QueryMatch::ExactMatch);
+            matches << windowMatch(index, info, action, 0.8, Plasma::QueryMatch::ExactMatch);
         } else if ((info.name().contains(term, Qt::CaseInsensitive) ||
              className.contains(term, Qt::CaseInsensitive)) && 
             actionSupported(info, action)) {
-            matches << windowMatch(info, action, 0.7, Plasma::QueryMatch::PossibleMatch);
+            matches << windowMatch(index, info, action, 0.7, Plasma::QueryMatch::PossibleMatch);
         }
     }
 
     // check for matching desktops by name
-    for (const QString& desktopName : qAsConst(m_desktopNames)) {
-        int desktop = m_desktopNames.indexOf(desktopName) +1;
+    for (const QString& desktopName : qAsConst(index.desktopNames)) {
+        int desktop = index.desktopNames.indexOf(desktopName) +1;
         if (desktopName.contains(term, Qt::CaseInsensitive)) {
             // desktop name matches - offer switch to
             // only add desktops if it hasn't been added by the keyword which is quite likely
             if (!desktopAdded && desktop != KWindowSystem::currentDesktop()) {
-                matches << desktopMatch(desktop, 0.8);
+                matches << desktopMatch(index, desktop, 0.8);
             }
 
             // search for windows on desktop and list them with less relevance
-            QHashIterator<WId, KWindowInfo> it(m_windows);
+            QHashIterator<WId, KWindowInfo> it(index.windows);
             while (it.hasNext()) {
                 it.next();
                 KWindowInfo info = it.value();
                 if (info.isOnDesktop(desktop) && actionSupported(info, action)) {
-                    matches << windowMatch(info, action, 0.5, Plasma::QueryMatch::PossibleMatch);
+                    matches << windowMatch(index, info, action, 0.5, Plasma::QueryMatch::PossibleMatch);
                 }
             }
         }
@@ -322,7 +423,6 @@ void WindowsRunner::match(Plasma::RunnerContext& context)
 // Called in the main thread
 void WindowsRunner::run(const Plasma::RunnerContext& context, const Plasma::QueryMatch& match)
 {
-    QMutexLocker locker(&m_mutex);
     Q_UNUSED(context)
     // check if it's a desktop
     if (match.id().startsWith(QLatin1String("windows_desktop"))) {
@@ -334,8 +434,7 @@ void WindowsRunner::run(const Plasma::RunnerContext& context, const Plasma::Quer
     WindowAction action = WindowAction(parts[0].toInt());
     WId w(parts[1].toULong());
 
-    KWindowInfo info(w, NET::WMWindowType | NET::WMDesktop | NET::WMState | NET::XAWMState | NET::WMName,
-                     NET::WM2WindowClass | NET::WM2WindowRole | NET::WM2AllowedActions);
+    KWindowInfo info(w, s_windowInfoProperties, s_windowInfoProperties2);
     if (!info.valid()) {
         return;
     }
@@ -395,7 +494,7 @@ void WindowsRunner::run(const Plasma::RunnerContext& context, const Plasma::Quer
     }
 }
 
-Plasma::QueryMatch WindowsRunner::desktopMatch(int desktop, qreal relevance)
+Plasma::QueryMatch WindowsRunner::desktopMatch(const WindowIndex &index, int desktop, qreal relevance)
 {
     Plasma::QueryMatch match(this);
     match.setType(Plasma::QueryMatch::ExactMatch);
@@ -403,8 +502,8 @@ Plasma::QueryMatch WindowsRunner::desktopMatch(int desktop, qreal relevance)
     match.setId(QStringLiteral("desktop-") + QString::number(desktop));
     match.setIconName(QStringLiteral("user-desktop"));
     QString desktopName;
-    if (desktop <= m_desktopNames.size()) {
-        desktopName = m_desktopNames[desktop - 1];
+    if (desktop <= index.desktopNames.size()) {
+        desktopName = index.desktopNames[desktop - 1];
     } else {
         desktopName = KWindowSystem::desktopName(desktop);
     }
@@ -414,20 +513,20 @@ Plasma::QueryMatch WindowsRunner::desktopMatch(int desktop, qreal relevance)
     return match;
 }
 
-Plasma::QueryMatch WindowsRunner::windowMatch(const KWindowInfo& info, WindowAction action, qreal relevance, Plasma::QueryMatch::Type type)
+Plasma::QueryMatch WindowsRunner::windowMatch(const WindowIndex &index, const KWindowInfo& info, WindowAction action, qreal relevance, Plasma::QueryMatch::Type type)
 {
     Plasma::QueryMatch match(this);
     match.setType(type);
     match.setData(QString(QString::number((int)action) + QLatin1Char('_') + QString::number(info.win())));
-    match.setIcon(m_icons[info.win()]);
+    match.setIcon(index.icons.value(info.win()));
     match.setText(info.name());
     QString desktopName;
     int desktop = info.desktop();
     if (desktop == NET::OnAllDesktops) {
         desktop = KWindowSystem::currentDesktop();
     }
-    if (desktop <= m_desktopNames.size()) {
-        desktopName = m_desktopNames[desktop - 1];
+    if (desktop <= index.desktopNames.size()) {
+        desktopName = index.desktopNames[desktop - 1];
     } else {
         desktopName = KWindowSystem::desktopName(desktop);
     }
@@ -21,9 +21,12 @@
 
 #include <KRunner/AbstractRunner>
 
-#include <QMutex>
+#include <KWindowInfo>
 
-class KWindowInfo;
+#include <QHash>
+#include <QIcon>
+#include <QMutex>
+#include <QSet>
 
 class WindowsRunner : public Plasma::AbstractRunner
 {
@@ -38,8 +41,6 @@ class WindowsRunner : public Plasma::AbstractRunner
 
     private Q_SLOTS:
         void prepareForMatchSession();
-        void matchSessionComplete();
-        void gatherInfo();
 
     private:
         enum WindowAction {
@@ -52,17 +53,32 @@ class WindowsRunner : public Plasma::AbstractRunner
             KeepAboveAction,
             KeepBelowAction
         };
-        Plasma::QueryMatch desktopMatch(int desktop, qreal relevance = 1.0);
-        Plasma::QueryMatch windowMatch(const KWindowInfo& info, WindowAction action, qreal relevance = 1.0,
+
+        // Snapshot of the windows, cheap to copy as all members are implicitly shared
+        struct WindowIndex {
+            QHash<WId, KWindowInfo> windows;
+            // Icons are only fetched once they are painted
+            QHash<WId, QIcon> icons;
+            QStringList desktopNames;
+        };
+
+        void startTracking();
+        void updateWindow(WId window);
+        void updateDesktopNames();
+
+        Plasma::QueryMatch desktopMatch(const WindowIndex &index, int desktop, qreal relevance = 1.0);
+        Plasma::QueryMatch windowMatch(const WindowIndex &index, const KWindowInfo& info, WindowAction action, qreal relevance = 1.0,
                                        Plasma::QueryMatch::Type type = Plasma::QueryMatch::ExactMatch);
         bool actionSupported(const KWindowInfo& info, WindowAction action);
 
-        QHash<WId, KWindowInfo> m_windows; // protected by m_mutex
-        QHash<WId, QIcon> m_icons; // protected by m_mutex
-        QStringList m_desktopNames; // protected by m_mutex
+        WindowIndex m_index; // protected by m_mutex
         QMutex m_mutex;
 
-        bool m_inSession : 1; // only used in the main thread
+        // Only used in the main thread
+        bool m_tracking = false;
+        // Windows added or changed since the last match session
+        QSet<WId> m_dirtyWindows;
+        bool m_desktopNamesDirty = false;
 };
 
 #endif // WINDOWSRUNNER_H
@@ -0,0 +1,290 @@
+/* Copyright 2020 by the Plasma Workspace authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDBusConnection>
+#include <QDBusContext>
+#include <QMap>
+#include <QObject>
+#include <QPointer>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTest>
+#include <QTimer>
+
+#include <Plasma/Corona>
+
+#include "../scripting/scriptengine.h"
+#include "../shellcorona.h"
+
+// Answers in place of the activity manager
+class FakeActivityManager : public QObject, protected QDBusContext
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.ActivityManager.Activities")
+
+public:
+    bool failAdding = false;
+    bool failSwitching = false;
+    int switchCount = 0;
+    // msecs until AddActivity answers
+    int latency = 0;
+    QMap<QString, QString> names;
+    QString current;
+
+public Q_SLOTS:
+    QString AddActivity(const QString &name)
+    {
+        if (failAdding) {
+            return QString();
+        }
+
+        const QString id = QStringLiteral("activity-%1").arg(names.count() + 1);
+        names.insert(id, name);
+
+        if (latency > 0) {
+            setDelayedReply(true);
+            const QDBusMessage reply = message().createReply(id);
+            QTimer::singleShot(latency, this, [reply]() {
+                QDBusConnection::sessionBus().send(reply);
+            });
+        }
+        return id;
+    }
+
+    bool SetCurrentActivity(const QString &id)
+    {
+        ++switchCount;
+        if (failSwitching) {
+            sendErrorReply(QDBusError::Failed, QStringLiteral("Switching is broken"));
+            return false;
+        }
+        if (!names.contains(id)) {
+            return false;
+        }
+        current = id;
+        return true;
+    }
+
+    QString CurrentActivity() const
+    {
+        return current;
+    }
+
+    QString ActivityName(const QString &id) const
+    {
+        return names.value(id);
+    }
+
+    void SetActivityName(const QString &id, const QString &name)
+    {
+        if (names.contains(id)) {
+            names.insert(id, name);
+        }
+    }
+};
+
+class TestCorona : public Plasma::Corona
+{
+public:
+    QRect screenGeometry(int id) const override
+    {
+        Q_UNUSED(id)
+        return QRect(0, 0, 1920, 1080);
+    }
+};
+
+class ActivityScriptingTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void testScriptSeesItsChanges();
+    void testCreateActivityFails();
+    void testInsertActivitySwitchFails();
+    void testCreateActivityAsync();
+    void testCreateActivityAsyncFails();
+    void testAsyncOutlivesScript();
+    void testAsyncWithoutEngine();
+
+private:
+    FakeActivityManager m_activityManager;
+};
+
+void ActivityScriptingTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    if (!bus.isConnected()) {
+        QSKIP("The test needs a session bus");
+    }
+    if (!bus.registerService(QStringLiteral("org.kde.ActivityManager"))) {
+        QSKIP("The activity manager is running already");
+    }
+    QVERIFY(bus.registerObject(QStringLiteral("/ActivityManager/Activities"), &m_activityManager, QDBusConnection::ExportAllSlots));
+}
+
+void ActivityScriptingTest::init()
+{
+    m_activityManager.failAdding = false;
+    m_activityManager.failSwitching = false;
+    m_activityManager.switchCount = 0;
+    m_activityManager.latency = 0;
+    m_activityManager.names.clear();
+    m_activityManager.current.clear();
+}
+
+void ActivityScriptingTest::testScriptSeesItsChanges()
+{
+    TestCorona corona;
+    WorkspaceScripting::ScriptEngine engine(&corona);
+
+    // Without running the event loop in between, like scripts do
+    const QJSValue result = engine.evaluate(QStringLiteral(
+        "var id = createActivity('Created');"
+        "setCurrentActivity(id);"
+        "setActivityName(id, 'Renamed');"
+        "[id, currentActivity(), activityName(id)]"));
+    QVERIFY2(!result.isError(), qPrintable(result.toString()));
+
+    const QString id = result.property(0).toString();
+    QVERIFY(!id.isEmpty());
+    QCOMPARE(m_activityManager.current, id);
+    QCOMPARE(result.property(1).toString(), id);
+    QCOMPARE(result.property(2).toString(), QStringLiteral("Renamed"));
+}
+
+void ActivityScriptingTest::testCreateActivityFails()
+{
+    m_activityManager.failAdding = true;
+
+    TestCorona corona;
+    WorkspaceScripting::ScriptEngine engine(&corona);
+
+    const QJSValue result = engine.evaluate(QStringLiteral("createActivity('Broken')"));
+    QVERIFY(result.isError());
+    QVERIFY(m_activityManager.names.isEmpty());
+}
+
+void ActivityScriptingTest::testInsertActivitySwitchFails()
+{
+    m_activityManager.failSwitching = true;
+    m_activityManager.names.insert(QStringLiteral("new-activity"), QStringLiteral("New"));
+
+    ShellCorona corona;
+    corona.insertActivity(QStringLiteral("new-activity"), QStringLiteral("org.kde.desktopcontainment"));
+    QVERIFY(corona.availableActivities().contains(QStringLiteral("new-activity")));
+
+    // The switch is answered with an error and no result, which must not crash
+    QTRY_COMPARE(m_activityManager.switchCount, 1);
+    QTest::qWait(100);
+    QVERIFY(m_activityManager.current.isEmpty());
+}
+
+void ActivityScriptingTest::testCreateActivityAsync()
+{
+    m_activityManager.latency = 100;
+
+    TestCorona corona;
+    WorkspaceScripting::ScriptEngine engine(&corona);
+
+    const QJSValue result = engine.evaluate(QStringLiteral(
+        "var result = {};"
+        "createActivityAsync('Created').then(function(id) {"
+        "    result.id = id;"
+        "    return setCurrentActivityAsync(id);"
+        "}).then(function(switched) {"
+        "    result.switched = switched;"
+        "});"
+        "result"));
+    QVERIFY2(!result.isError(), qPrintable(result.toString()));
+
+    // The script returned before the activity manager answered
+    QVERIFY(result.property(QStringLiteral("id")).isUndefined());
+
+    QTRY_VERIFY(result.property(QStringLiteral("switched")).isBool());
+    const QString id = result.property(QStringLiteral("id")).toString();
+    QCOMPARE(m_activityManager.names.value(id), QStringLiteral("Created"));
+    QVERIFY(result.property(QStringLiteral("switched")).toBool());
+    QCOMPARE(m_activityManager.current, id);
+}
+
+void ActivityScriptingTest::testCreateActivityAsyncFails()
+{
+    m_activityManager.failAdding = true;
+
+    TestCorona corona;
+    WorkspaceScripting::ScriptEngine engine(&corona);
+
+    const QJSValue result = engine.evaluate(QStringLiteral(
+        "var result = {};"
+        "createActivityAsync('Broken').then(function(id) {"
+        "    result.id = id;"
+        "}, function(error) {"
+        "    result.error = error;"
+        "});"
+        "result"));
+    QVERIFY2(!result.isError(), qPrintable(result.toString()));
+
+    QTRY_VERIFY(result.property(QStringLiteral("error")).isError());
+    QVERIFY(result.property(QStringLiteral("id")).isUndefined());
+}
+
+void ActivityScriptingTest::testAsyncOutlivesScript()
+{
+    m_activityManager.latency = 100;
+
+    ShellCorona corona;
+    QPointer<WorkspaceScripting::ScriptEngine> engine = new WorkspaceScripting::ScriptEngine(&corona, &corona);
+    QSignalSpy printSpy(engine.data(), &WorkspaceScripting::ScriptEngine::print);
+
+    QVERIFY(engine->evaluateScript(QStringLiteral(
+        "createActivityAsync('Created').then(function(id) {"
+        "    print(id);"
+        "});")));
+    engine->deleteWhenSettled();
+
+    // Like the layout and update scripts of the shell
+    QTRY_COMPARE(printSpy.count(), 1);
+    const QString id = printSpy.first().first().toString();
+    QCOMPARE(m_activityManager.names.value(id), QStringLiteral("Created"));
+    QVERIFY(corona.availableActivities().contains(id));
+    QTRY_VERIFY(!engine);
+}
+
+void ActivityScriptingTest::testAsyncWithoutEngine()
+{
+    m_activityManager.latency = 100;
+
+    ShellCorona corona;
+    {
+        WorkspaceScripting::ScriptEngine engine(&corona);
+        QVERIFY(engine.evaluateScript(QStringLiteral("createActivityAsync('Created');")));
+    }
+
+    // Nobody is waiting for the promise anymore, the activity is still set up
+    QTRY_VERIFY(corona.availableActivities().contains(QStringLiteral("activity-1")));
+}
+
+QTEST_MAIN(ActivityScriptingTest)
+
+#include "activityscriptingtest.moc"
@@ -0,0 +1,147 @@
+/* Copyright 2020 by the Plasma Workspace authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDir>
+#include <QObject>
+#include <QSet>
+#include <QStandardPaths>
+#include <QTest>
+
+#include <KConfig>
+#include <KConfigGroup>
+#include <Plasma/Containment>
+
+#include "../coronatesthelper.h"
+#include "../shellcorona.h"
+
+static const QString s_shell = QStringLiteral("org.kde.plasmashelltest");
+
+class DeferredContainmentsTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testDeferInactive();
+
+private:
+    void writeLayout();
+    static QSet<uint> containmentIds(const Plasma::Corona &corona);
+    static int appletCount(const Plasma::Corona &corona);
+};
+
+void DeferredContainmentsTest::initTestCase()
+{
+    // Like plasmashell --test
+    QStandardPaths::setTestModeEnabled(true);
+    QDir(QStandardPaths::writableLocation(QStandardPaths::ConfigLocation)).removeRecursively();
+    qApp->setProperty("org.kde.KActivities.core.disableAutostart", true);
+
+    writeLayout();
+}
+
+void DeferredContainmentsTest::writeLayout()
+{
+    KConfig layout(QStringLiteral("plasma-") + s_shell + QStringLiteral("-appletsrc"), KConfig::SimpleConfig);
+    KConfigGroup containments(&layout, "Containments");
+
+    // Without the activity manager the current activity is empty
+    auto addContainment = [&containments](uint id, const QString &plugin, const QString &activity, int screen, uint appletId) {
+        KConfigGroup containment(&containments, QString::number(id));
+        containment.writeEntry("plugin", plugin);
+        containment.writeEntry("activityId", activity);
+        containment.writeEntry("lastScreen", screen);
+        containment.writeEntry("formfactor", 0);
+        KConfigGroup applet(&containment, "Applets");
+        applet = KConfigGroup(&applet, QString::number(appletId));
+        applet.writeEntry("plugin", QStringLiteral("org.kde.plasma.analogclock"));
+    };
+
+    // The panel holds the highest ids, which are always loaded
+    addContainment(9, QStringLiteral("org.kde.panel"), QString(), 0, 20);
+    addContainment(4, QStringLiteral("org.kde.desktopcontainment"), QString(), 0, 12);
+    addContainment(2, QStringLiteral("org.kde.desktopcontainment"), QStringLiteral("other"), 0, 10);
+    addContainment(3, QStringLiteral("org.kde.desktopcontainment"), QStringLiteral("other"), 1, 11);
+
+    QVERIFY(layout.sync());
+}
+
+QSet<uint> DeferredContainmentsTest::containmentIds(const Plasma::Corona &corona)
+{
+    QSet<uint> ids;
+    const QList<Plasma::Containment *> containments = corona.containments();
+    for (Plasma::Containment *containment : containments) {
+        ids.insert(containment->id());
+    }
+    return ids;
+}
+
+int DeferredContainmentsTest::appletCount(const Plasma::Corona &corona)
+{
+    int count = 0;
+    const QList<Plasma::Containment *> containments = corona.containments();
+    for (Plasma::Containment *containment : containments) {
+        count += containment->applets().count();
+    }
+    return count;
+}
+
+void DeferredContainmentsTest::testDeferInactive()
+{
+    ShellCorona corona;
+    CoronaTestHelper helper(&corona);
+    corona.setShell(s_shell);
+
+    QTRY_VERIFY_WITH_TIMEOUT(corona.isStartupCompleted(), 10000);
+
+    // The desktops of the other activity weren't constructed
+    QSet<uint> ids = containmentIds(corona);
+    QVERIFY(ids.contains(9));
+    QVERIFY(ids.contains(4));
+    QVERIFY(!ids.contains(2));
+    QVERIFY(!ids.contains(3));
+    QCOMPARE(helper.containmentCount(), corona.containments().count());
+    QCOMPARE(helper.appletCount(), appletCount(corona));
+
+    // Their config is still there, new containments got other ids
+    KConfigGroup containmentsGroup(corona.config(), "Containments");
+    QCOMPARE(KConfigGroup(&containmentsGroup, "2").readEntry("activityId", QString()), QStringLiteral("other"));
+    QCOMPARE(KConfigGroup(&containmentsGroup, "3").group("Applets").groupList(), QStringList({QStringLiteral("11")}));
+    for (uint id : qAsConst(ids)) {
+        QVERIFY(id == 4 || id == 9 || id > 20);
+    }
+
+    const int constructedContainments = helper.containmentCount();
+    const int constructedApplets = helper.appletCount();
+
+    corona.loadDeferredContainments();
+
+    // With the ids they had
+    ids = containmentIds(corona);
+    QVERIFY(ids.contains(2));
+    QVERIFY(ids.contains(3));
+    QCOMPARE(helper.containmentCount(), constructedContainments + 2);
+    QCOMPARE(helper.appletCount(), constructedApplets + 2);
+    QCOMPARE(helper.containmentCount(), corona.containments().count());
+    QCOMPARE(helper.appletCount(), appletCount(corona));
+}
+
+QTEST_MAIN(DeferredContainmentsTest)
+
+#include "deferredcontainmentstest.moc"
@@ -0,0 +1,147 @@
+/* Copyright 2020 by the Plasma Workspace authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QFutureInterface>
+#include <QObject>
+#include <QTest>
+#include <QThread>
+#include <QTimer>
+
+#include "../layoutoperationqueue.h"
+
+// Answers like the activity manager does, after a delay
+class FakeActivityController : public QObject
+{
+    Q_OBJECT
+
+public:
+    QFuture<QString> addActivity(const QString &name, int latency)
+    {
+        QFutureInterface<QString> *interface = new QFutureInterface<QString>();
+        interface->reportStarted();
+
+        QTimer::singleShot(latency, this, [interface, name] {
+            interface->reportResult(QStringLiteral("id-") + name);
+            interface->reportFinished();
+            delete interface;
+        });
+
+        return interface->future();
+    }
+};
+
+class LayoutOperationQueueTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testOrder();
+    void testEnqueueDoesNotBlock();
+    void testNoNestedEventLoop();
+    void testNestedEnqueue();
+};
+
+void LayoutOperationQueueTest::testOrder()
+{
+    FakeActivityController controller;
+    LayoutOperationQueue queue;
+    QStringList log;
+
+    queue.enqueue([&] {
+        queue.await(controller.addActivity(QStringLiteral("slow"), 200), [&](const QFuture<QString> &future) {
+            log << future.result();
+        });
+    });
+    queue.enqueue([&] {
+        queue.await(controller.addActivity(QStringLiteral("fast"), 0), [&](const QFuture<QString> &future) {
+            log << future.result();
+        });
+    });
+    queue.enqueue([&] {
+        log << QStringLiteral("done");
+    });
+
+    QTRY_VERIFY(queue.isIdle());
+    QCOMPARE(log, QStringList({QStringLiteral("id-slow"), QStringLiteral("id-fast"), QStringLiteral("done")}));
+}
+
+void LayoutOperationQueueTest::testEnqueueDoesNotBlock()
+{
+    FakeActivityController controller;
+    LayoutOperationQueue queue;
+    bool finished = false;
+
+    queue.enqueue([&] {
+        queue.await(controller.addActivity(QStringLiteral("slow"), 100), [&](const QFuture<QString> &) {
+            finished = true;
+        });
+    });
+
+    QVERIFY(!finished);
+    QVERIFY(!queue.isIdle());
+
+    QTRY_VERIFY(finished);
+    QVERIFY(queue.isIdle());
+}
+
+void LayoutOperationQueueTest::testNoNestedEventLoop()
+{
+    FakeActivityController controller;
+    LayoutOperationQueue queue;
+    const int loopLevel = QThread::currentThread()->loopLevel();
+    QList<int> loopLevels;
+
+    for (int i = 0; i < 3; ++i) {
+        queue.enqueue([&, i] {
+            loopLevels << QThread::currentThread()->loopLevel();
+            queue.await(controller.addActivity(QString::number(i), 10 * (3 - i)), [&](const QFuture<QString> &) {
+                loopLevels << QThread::currentThread()->loopLevel();
+            });
+        });
+    }
+
+    QTRY_VERIFY(queue.isIdle());
+
+    // QTRY_VERIFY only processes events, any deeper level would be an
+    // event loop started by the queue
+    QCOMPARE(loopLevels.count(), 6);
+    for (int level : qAsConst(loopLevels)) {
+        QCOMPARE(level, loopLevel);
+    }
+}
+
+void LayoutOperationQueueTest::testNestedEnqueue()
+{
+    LayoutOperationQueue queue;
+    QStringList log;
+
+    queue.enqueue([&] {
+        queue.enqueue([&] {
+            log << QStringLiteral("inner");
+        });
+        log << QStringLiteral("outer");
+    });
+
+    QCOMPARE(log, QStringList({QStringLiteral("outer"), QStringLiteral("inner")}));
+    QVERIFY(queue.isIdle());
+}
+
+QTEST_GUILESS_MAIN(LayoutOperationQueueTest)
+
+#include "layoutoperationqueuetest.moc"
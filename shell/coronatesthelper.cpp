@@ -33,6 +33,9 @@ CoronaTestHelper::CoronaTestHelper(Corona* parent)
 
 void CoronaTestHelper::processContainment(Plasma::Containment* containment)
 {
+    ++m_containmentCount;
+    emit containmentCountChanged();
+
     foreach(Plasma::Applet* applet, containment->applets()) {
         processApplet(applet);
     }
@@ -41,6 +44,9 @@ void CoronaTestHelper::processContainment(Plasma::Containment* containment)
 
 void CoronaTestHelper::processApplet(Plasma::Applet* applet)
 {
+    ++m_appletCount;
+    emit appletCountChanged();
+
     PlasmaQuick::AppletQuickItem* obj = applet->property("_plasma_graphicObject").value<PlasmaQuick::AppletQuickItem*>();
     if (applet->failedToLaunch()) {
         qCWarning(PLASMASHELL) << "cannot test an applet with a launch error" << applet->launchErrorMessage();
@@ -76,6 +82,10 @@ void CoronaTestHelper::integrateTest(QObject* testObject)
         return;
     }
 
+    if (testObject->metaObject()->indexOfProperty("coronaTestHelper") >= 0) {
+        testObject->setProperty("coronaTestHelper", QVariant::fromValue<QObject *>(this));
+    }
+
     qCDebug(PLASMASHELL) << "Test registered" << testObject;
     m_tests.insert(testObject);
     m_registeredTests << testObject;
@@ -93,6 +103,7 @@ void CoronaTestHelper::testFinished()
 
     qCWarning(PLASMASHELL) << "test finished" << testObject << failed << "remaining" << m_tests;
     if (m_tests.isEmpty()) {
+        qCWarning(PLASMASHELL) << "constructed" << m_containmentCount << "containments and" << m_appletCount << "applets";
         qGuiApp->exit(m_exitcode);
     }
 }
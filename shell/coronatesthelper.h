@@ -22,15 +22,31 @@
 #include <Plasma/Corona>
 #include <QSet>
 
+/**
+ * Runs the tests of the applets in the corona and quits once they are done.
+ *
+ * It also counts the containments and applets which got constructed, tests
+ * which declare a "coronaTestHelper" property get this object assigned to
+ * check on them.
+ */
 class CoronaTestHelper : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY(int containmentCount READ containmentCount NOTIFY containmentCountChanged)
+    Q_PROPERTY(int appletCount READ appletCount NOTIFY appletCountChanged)
 public:
     explicit CoronaTestHelper(Plasma::Corona* parent);
 
     void processContainment(Plasma::Containment* containment);
     void processApplet(Plasma::Applet* applet);
 
+    int containmentCount() const { return m_containmentCount; }
+    int appletCount() const { return m_appletCount; }
+
+Q_SIGNALS:
+    void containmentCountChanged();
+    void appletCountChanged();
+
 private Q_SLOTS:
     void testFinished();
 
@@ -43,6 +59,8 @@ private:
     QSet<QObject*> m_tests;
 
     int m_exitcode;
+    int m_containmentCount = 0;
+    int m_appletCount = 0;
 };
 
 #endif
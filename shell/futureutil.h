@@ -21,14 +21,41 @@
 #ifndef FUTUREUTIL_H
 #define FUTUREUTIL_H
 
-#include <QCoreApplication>
+#include <QEventLoop>
+#include <QFuture>
+#include <QFutureWatcher>
 
+/**
+ * Calls @p function with @p future once it finished, from the event loop
+ * of @p context. Nothing is called if @p context is gone by then.
+ */
+template <typename T, typename Function>
+inline void whenFinished(QObject *context, const QFuture<T> &future, Function function)
+{
+    auto watcher = new QFutureWatcher<T>(context);
+    QObject::connect(watcher, &QFutureWatcherBase::finished, context, [watcher, function]() mutable {
+        watcher->deleteLater();
+        function(watcher->future());
+    });
+    watcher->setFuture(future);
+}
+
+/**
+ * Waits until @p future finished, running a local event loop without
+ * user input in the meantime. Only meant for the synchronous scripting
+ * API, everything else should use whenFinished().
+ */
 template <typename T>
-inline void awaitFuture(const QFuture<T> &future)
+inline QFuture<T> waitForFinished(const QFuture<T> &future)
 {
-    while (!future.isFinished()) {
-        QCoreApplication::processEvents();
+    if (!future.isFinished()) {
+        QEventLoop loop;
+        QFutureWatcher<T> watcher;
+        QObject::connect(&watcher, &QFutureWatcherBase::finished, &loop, &QEventLoop::quit);
+        watcher.setFuture(future);
+        loop.exec(QEventLoop::ExcludeUserInputEvents);
     }
+    return future;
 }
 
 #endif /* !FUTUREUTIL_H */
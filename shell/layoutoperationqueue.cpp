@@ -0,0 +1,53 @@
+/*
+ *   Copyright 2020 by the Plasma Workspace authors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "layoutoperationqueue.h"
+
+LayoutOperationQueue::LayoutOperationQueue(QObject *parent)
+    : QObject(parent)
+{
+}
+
+LayoutOperationQueue::~LayoutOperationQueue() = default;
+
+void LayoutOperationQueue::enqueue(const std::function<void()> &operation)
+{
+    m_pending.enqueue(operation);
+    runPending();
+}
+
+bool LayoutOperationQueue::isIdle() const
+{
+    return m_awaiting == 0 && m_pending.isEmpty() && !m_running;
+}
+
+void LayoutOperationQueue::runPending()
+{
+    // Operations queued by a running operation run after it returned
+    if (m_running) {
+        return;
+    }
+
+    m_running = true;
+    while (m_awaiting == 0 && !m_pending.isEmpty()) {
+        const std::function<void()> operation = m_pending.dequeue();
+        operation();
+    }
+    m_running = false;
+}
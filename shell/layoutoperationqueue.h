@@ -0,0 +1,82 @@
+/*
+ *   Copyright 2020 by the Plasma Workspace authors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef LAYOUTOPERATIONQUEUE_H
+#define LAYOUTOPERATIONQUEUE_H
+
+#include <QFuture>
+#include <QObject>
+#include <QQueue>
+
+#include <functional>
+
+#include "futureutil.h"
+
+/**
+ * Runs layout operations one after the other.
+ *
+ * An operation can wait for a future, for example one of the activity
+ * manager. The operations queued after it only run once the future
+ * finished and its continuation ran, without blocking or re-entering
+ * the event loop.
+ */
+class LayoutOperationQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LayoutOperationQueue(QObject *parent = nullptr);
+    ~LayoutOperationQueue() override;
+
+    /**
+     * Runs @p operation right away if nothing is pending, otherwise
+     * after the operations queued before it.
+     */
+    void enqueue(const std::function<void()> &operation);
+
+    /**
+     * Called from an operation or a continuation: runs @p continuation
+     * with @p future once it finished, before the following operations.
+     */
+    template<typename T, typename Continuation>
+    void await(const QFuture<T> &future, Continuation continuation)
+    {
+        ++m_awaiting;
+
+        whenFinished(this, future, [this, continuation](const QFuture<T> &finished) mutable {
+            continuation(finished);
+            --m_awaiting;
+            runPending();
+        });
+    }
+
+    /**
+     * @return whether no operation is waiting or queued
+     */
+    bool isIdle() const;
+
+private:
+    void runPending();
+
+    QQueue<std::function<void()>> m_pending;
+    int m_awaiting = 0;
+    bool m_running = false;
+};
+
+#endif // LAYOUTOPERATIONQUEUE_H
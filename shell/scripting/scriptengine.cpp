@@ -68,6 +68,12 @@ ScriptEngine::ScriptEngine(Plasma::Corona *corona, QObject *parent)
     m_globalScriptEngineObject = new ScriptEngine::V1(this);
     m_localizedContext = new KLocalizedContext(this);
     setupEngine();
+
+    // Scripts work on the whole layout, including the desktops which
+    // aren't loaded yet
+    if (ShellCorona *sc = qobject_cast<ShellCorona *>(m_corona)) {
+        sc->loadDeferredContainments();
+    }
 }
 
 ScriptEngine::~ScriptEngine()
@@ -79,6 +85,35 @@ QString ScriptEngine::errorString() const
     return m_errorString;
 }
 
+void ScriptEngine::deleteWhenSettled()
+{
+    m_deleteWhenSettled = true;
+    if (m_pendingOperations == 0) {
+        deleteLater();
+    }
+}
+
+void ScriptEngine::operationStarted()
+{
+    ++m_pendingOperations;
+}
+
+void ScriptEngine::operationFinished()
+{
+    --m_pendingOperations;
+    if (!m_deleteWhenSettled) {
+        return;
+    }
+
+    // The reactions to the promise run from the event loop and might
+    // start the next operation, look again after them
+    QMetaObject::invokeMethod(this, [this]() {
+        if (m_pendingOperations == 0) {
+            deleteLater();
+        }
+    }, Qt::QueuedConnection);
+}
+
 QJSValue ScriptEngine::wrap(Plasma::Applet *w)
 {
     Widget *wrapper = new Widget(w);
@@ -200,6 +235,8 @@ void ScriptEngine::setupEngine()
 
     m_scriptSelf.setProperty(QStringLiteral("createActivity"), globalScriptEngineObject.property("createActivity"));
     m_scriptSelf.setProperty(QStringLiteral("setCurrentActivity"), globalScriptEngineObject.property("setCurrentActivity"));
+    m_scriptSelf.setProperty(QStringLiteral("createActivityAsync"), globalScriptEngineObject.property("createActivityAsync"));
+    m_scriptSelf.setProperty(QStringLiteral("setCurrentActivityAsync"), globalScriptEngineObject.property("setCurrentActivityAsync"));
     m_scriptSelf.setProperty(QStringLiteral("currentActivity"), globalScriptEngineObject.property("currentActivity"));
     m_scriptSelf.setProperty(QStringLiteral("activities"), globalScriptEngineObject.property("activities"));
     m_scriptSelf.setProperty(QStringLiteral("activityName"), globalScriptEngineObject.property("activityName"));
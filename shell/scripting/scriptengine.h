@@ -66,6 +66,12 @@ public:
 
     Plasma::Containment *createContainment(const QString &type, const QString &plugin);
 
+    /**
+     * Deletes the engine once the promises handed out to its scripts,
+     * e.g. by createActivityAsync(), are settled
+     */
+    void deleteWhenSettled();
+
 public Q_SLOTS:
     bool evaluateScript(const QString &script, const QString &path = QString());
 
@@ -84,6 +90,8 @@ private:
     QStringList availableActivities() const;
     QList<Containment*> desktopsForActivity(const QString &id);
     Containment *createContainmentWrapper(const QString &type, const QString &plugin);
+    void operationStarted();
+    void operationFinished();
 
 private Q_SLOTS:
     void exception(const QJSValue &value);
@@ -95,6 +103,8 @@ private:
     AppInterface *m_appInterface;
     QJSValue m_scriptSelf;
     QString m_errorString;
+    int m_pendingOperations = 0;
+    bool m_deleteWhenSettled = false;
 };
 
 static const int PLASMA_DESKTOP_SCRIPTING_VERSION = 20;
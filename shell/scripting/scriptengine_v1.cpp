@@ -24,14 +24,16 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QJSValueIterator>
+#include <QPointer>
 #include <QStandardPaths>
-#include <QFutureWatcher>
 
 #include <QDebug>
 #include <klocalizedstring.h>
 #include <kmimetypetrader.h>
 #include <kservicetypetrader.h>
 #include <kshell.h>
+#include <kactivities/consumer.h>
+#include <kactivities/info.h>
 
 // KIO
 //#include <kemailsettings.h> // no camelcase include
@@ -48,17 +50,25 @@
 #include "configgroup.h"
 #include "panel.h"
 #include "widget.h"
+#include "../futureutil.h"
 #include "../shellcorona.h"
 #include "../standaloneappcorona.h"
 #include "../screenpool.h"
 
 namespace {
-    template <typename T>
-    inline void awaitFuture(const QFuture<T> &future)
+    // QJSEngine has no API to create promises, make one along with the
+    // functions to settle it
+    QJSValue createDeferred(QJSEngine *engine)
     {
-        while (!future.isFinished()) {
-            QCoreApplication::processEvents();
-        }
+        return engine->evaluate(QStringLiteral(
+            "(function() {"
+            "    var deferred = {};"
+            "    deferred.promise = new Promise(function(resolve, reject) {"
+            "        deferred.resolve = resolve;"
+            "        deferred.reject = reject;"
+            "    });"
+            "    return deferred;"
+            "})()"));
     }
 
     class ScriptArray_forEach_Helper {
@@ -208,22 +218,70 @@ QJSValue ScriptEngine::V1::createActivity(const QJSValue &nameParam, const QStri
         return m_engine->newError(i18n("createActivity required the activity name"));
     }
 
-    QString plugin = pluginParam;
     const QString name = nameParam.toString();
 
     KActivities::Controller controller;
 
     // This is not the nicest way to do this, but createActivity
-    // is a synchronous API :/
-    QFuture<QString> futureId = controller.addActivity(name);
-    awaitFuture(futureId);
+    // is a synchronous API :/ createActivityAsync doesn't block.
+    const QFuture<QString> futureId = waitForFinished(controller.addActivity(name));
+    const QString id = futureId.resultCount() > 0 ? futureId.result() : QString();
+    if (id.isEmpty()) {
+        return m_engine->newError(i18n("Failed to create the activity"));
+    }
+
+    m_activityNames.insert(id, name);
+    insertActivity(m_engine->m_corona, id, pluginParam);
+
+    return m_engine->toScriptValue<QString>(id);
+}
+
+QJSValue ScriptEngine::V1::createActivityAsync(const QJSValue &nameParam, const QString &plugin)
+{
+    if (!nameParam.isString()) {
+        return m_engine->newError(i18n("createActivity required the activity name"));
+    }
 
-    QString id = futureId.result();
+    QJSValue deferred = createDeferred(m_engine);
+
+    // The engine might be gone by the time the activity manager answers,
+    // the activity still has to end up in the corona then
+    Plasma::Corona *corona = m_engine->m_corona;
+    QPointer<ScriptEngine> engine = m_engine;
+    m_engine->operationStarted();
+
+    auto controller = new KActivities::Controller(corona);
+    whenFinished(corona, controller->addActivity(nameParam.toString()), [corona, engine, controller, deferred, plugin](const QFuture<QString> &future) mutable {
+        controller->deleteLater();
+
+        const QString id = future.resultCount() > 0 ? future.result() : QString();
+        if (!id.isEmpty()) {
+            insertActivity(corona, id, plugin);
+        }
+
+        if (!engine) {
+            return;
+        }
+
+        if (id.isEmpty()) {
+            deferred.property(QStringLiteral("reject")).call({engine->newError(i18n("Failed to create the activity"))});
+        } else {
+            deferred.property(QStringLiteral("resolve")).call({QJSValue(id)});
+        }
+        engine->operationFinished();
+    });
+
+    return deferred.property(QStringLiteral("promise"));
+}
+
+void ScriptEngine::V1::insertActivity(Plasma::Corona *corona, const QString &id, const QString &pluginParam)
+{
+    QString plugin = pluginParam;
 
     qDebug() << "Setting default Containment plugin:" << plugin;
 
-    ShellCorona *sc = qobject_cast<ShellCorona *>(m_engine->m_corona);
-    StandaloneAppCorona *ac = qobject_cast<StandaloneAppCorona *>(m_engine->m_corona);
+    ShellCorona *sc = qobject_cast<ShellCorona *>(corona);
+    StandaloneAppCorona *ac = qobject_cast<StandaloneAppCorona *>(corona);
     if (sc) {
         if (plugin.isEmpty() || plugin == QLatin1String("undefined")) {
             plugin = sc->defaultContainmentPlugin();
@@ -231,13 +289,11 @@ QJSValue ScriptEngine::V1::createActivity(const QJSValue &nameParam, const QStri
         sc->insertActivity(id, plugin);
     } else if (ac) {
         if (plugin.isEmpty() || plugin == QLatin1String("undefined")) {
-            KConfigGroup shellCfg = KConfigGroup(KSharedConfig::openConfig(m_engine->m_corona->package().filePath("defaults")), "Desktop");
+            KConfigGroup shellCfg = KConfigGroup(KSharedConfig::openConfig(corona->package().filePath("defaults")), "Desktop");
             plugin = shellCfg.readEntry("Containment", "org.kde.desktopcontainment");
         }
         ac->insertActivity(id, plugin);
     }
-
-    return m_engine->toScriptValue<QString>(id);
 }
 
 QJSValue ScriptEngine::V1::setCurrentActivity(const QJSValue &param)
@@ -250,10 +306,40 @@ QJSValue ScriptEngine::V1::setCurrentActivity(const QJSValue &param)
 
     KActivities::Controller controller;
 
-    QFuture<bool> task = controller.setCurrentActivity(id);
-    awaitFuture(task);
+    const QFuture<bool> task = waitForFinished(controller.setCurrentActivity(id));
+    if (task.resultCount() == 0 || !task.result()) {
+        return false;
+    }
 
-    return task.result();
+    m_currentActivity = id;
+    return true;
+}
+
+QJSValue ScriptEngine::V1::setCurrentActivityAsync(const QJSValue &param)
+{
+    if (!param.isString()) {
+        return m_engine->newError(i18n("setCurrentActivity required the activity id"));
+    }
+
+    QJSValue deferred = createDeferred(m_engine);
+
+    Plasma::Corona *corona = m_engine->m_corona;
+    QPointer<ScriptEngine> engine = m_engine;
+    m_engine->operationStarted();
+
+    auto controller = new KActivities::Controller(corona);
+    whenFinished(corona, controller->setCurrentActivity(param.toString()), [engine, controller, deferred](const QFuture<bool> &future) mutable {
+        controller->deleteLater();
+
+        if (!engine) {
+            return;
+        }
+
+        deferred.property(QStringLiteral("resolve")).call({QJSValue(future.resultCount() > 0 && future.result())});
+        engine->operationFinished();
+    });
+
+    return deferred.property(QStringLiteral("promise"));
 }
 
 QJSValue ScriptEngine::V1::setActivityName(const QJSValue &idParam, const QJSValue &nameParam)
@@ -268,8 +354,8 @@ QJSValue ScriptEngine::V1::setActivityName(const QJSValue &idParam, const QJSVal
 
     KActivities::Controller controller;
 
-    QFuture<void> task = controller.setActivityName(id, name);
-    awaitFuture(task);
+    waitForFinished(controller.setActivityName(id, name));
+    m_activityNames.insert(id, name);
     return QJSValue();
 }
 
@@ -281,6 +367,13 @@ QJSValue ScriptEngine::V1::activityName(const QJSValue &idParam) const
 
     const QString id = idParam.toString();
 
+    // KActivities::Info might not have heard about the changes
+    // of this script yet
+    const auto it = m_activityNames.constFind(id);
+    if (it != m_activityNames.constEnd()) {
+        return QJSValue(*it);
+    }
+
     KActivities::Info info(id);
 
     return QJSValue(info.name());
@@ -288,6 +381,11 @@ QJSValue ScriptEngine::V1::activityName(const QJSValue &idParam) const
 
 QString ScriptEngine::V1::currentActivity() const
 {
+    // Like activityName(), KActivities::Consumer might not know about setCurrentActivity() yet
+    if (!m_currentActivity.isEmpty()) {
+        return m_currentActivity;
+    }
+
     KActivities::Consumer consumer;
     return consumer.currentActivity();
 }
@@ -338,7 +436,7 @@ QJSValue ScriptEngine::V1::loadSerializedLayout(const QJSValue &data)
         return m_engine->newError(i18n("loadSerializedLayout: invalid version of the serialized object"));
     }
 
-    const auto desktops = m_engine->desktopsForActivity(KActivities::Consumer().currentActivity());
+    const auto desktops = m_engine->desktopsForActivity(currentActivity());
     Q_ASSERT_X(desktops.size() != 0, "V1::loadSerializedLayout", "We need desktops");
 
     // qDebug() << "DESKTOP DESERIALIZATION: Loading desktops...";
@@ -21,6 +21,7 @@
 #ifndef SCRIPTENGINE_V1
 #define SCRIPTENGINE_V1
 
+#include <QHash>
 #include <QObject>
 #include <QJSValue>
 
@@ -49,6 +50,10 @@ public:
     Q_INVOKABLE QJSValue desktopForScreen(const QJSValue &screen = QJSValue()) const;
     Q_INVOKABLE QJSValue createActivity(const QJSValue &nameParam = QJSValue(), const QString &plugin = QString());
     Q_INVOKABLE QJSValue setCurrentActivity(const QJSValue &id = QJSValue());
+    // Like createActivity and setCurrentActivity, but return a promise
+    // instead of waiting for the activity manager
+    Q_INVOKABLE QJSValue createActivityAsync(const QJSValue &nameParam = QJSValue(), const QString &plugin = QString());
+    Q_INVOKABLE QJSValue setCurrentActivityAsync(const QJSValue &id = QJSValue());
     Q_INVOKABLE QJSValue setActivityName(const QJSValue &idParam = QJSValue(), const QJSValue &nameParam = QJSValue());
     Q_INVOKABLE QJSValue activityName(const QJSValue &idParam = QJSValue()) const;
     Q_INVOKABLE QString currentActivity() const;
@@ -76,7 +81,12 @@ public:
 Q_SIGNALS:
     void print(const QJSValue &param);
 private:
+    static void insertActivity(Plasma::Corona *corona, const QString &id, const QString &plugin);
+
     ScriptEngine *m_engine;
+    // What the script changed, which KActivities might not know yet
+    QHash<QString, QString> m_activityNames;
+    QString m_currentActivity;
 };
 
 }
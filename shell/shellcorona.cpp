@@ -83,7 +83,7 @@
 
 #include "plasmashelladaptor.h"
 #include "debug.h"
-#include "futureutil.h"
+#include "layoutoperationqueue.h"
 
 #ifndef NDEBUG
     #define CHECK_SCREEN_INVARIANTS screenInvariants();
@@ -98,12 +98,15 @@
 #endif
 
 static const int s_configSyncDelay = 10000; // 10 seconds
+static const int s_deferredContainmentsDelay = 10000; // 10 seconds
+static const int s_deferredContainmentsInterval = 1000; // 1 second
 
 ShellCorona::ShellCorona(QObject *parent)
     : Plasma::Corona(parent),
       m_config(KSharedConfig::openConfig(QStringLiteral("plasmarc"))),
       m_screenPool(new ScreenPool(KSharedConfig::openConfig(), this)),
       m_activityController(new KActivities::Controller(this)),
+      m_layoutOperations(new LayoutOperationQueue(this)),
       m_addPanelAction(nullptr),
       m_addPanelsMenu(nullptr),
       m_interactiveConsole(nullptr),
@@ -146,6 +149,9 @@ ShellCorona::ShellCorona(QObject *parent)
     m_reconsiderOutputsTimer.setInterval(1000);
     connect(&m_reconsiderOutputsTimer, &QTimer::timeout, this, &ShellCorona::reconsiderOutputs);
 
+    m_deferredContainmentsTimer.setSingleShot(true);
+    connect(&m_deferredContainmentsTimer, &QTimer::timeout, this, &ShellCorona::preloadDeferredContainment);
+
     m_desktopDefaultsConfig = KConfigGroup(KSharedConfig::openConfig(package().filePath("defaults")), "Desktop");
     m_lnfDefaultsConfig = KConfigGroup(KSharedConfig::openConfig(m_lookAndFeelPackage.filePath("defaults")), "Desktop");
     m_lnfDefaultsConfig = KConfigGroup(&m_lnfDefaultsConfig, QStringLiteral("org.kde.plasma.desktop"));
@@ -451,8 +457,11 @@ QJsonObject dumpconfigGroupJS(const KConfigGroup &rootGroup)
     return result;
 }
 
-QByteArray ShellCorona::dumpCurrentLayoutJS() const
+QByteArray ShellCorona::dumpCurrentLayoutJS()
 {
+    // The dump covers the desktops of all activities
+    loadDeferredContainments();
+
     QJsonObject root;
     root.insert("serializationFormatVersion", "1");
 
@@ -720,7 +729,7 @@ void ShellCorona::load()
     //TODO: a kconf_update script is needed
     QString configFileName(QStringLiteral("plasma-") + m_shell + QStringLiteral("-appletsrc"));
 
-    loadLayout(configFileName);
+    loadLayoutDeferringInactive(configFileName);
 
     checkActivities();
 
@@ -774,6 +783,10 @@ void ShellCorona::load()
         m_waitingPanelsTimer.start();
     }
 
+    if (!m_deferredContainments.isEmpty()) {
+        m_deferredContainmentsTimer.start(s_deferredContainmentsDelay);
+    }
+
     if (config()->isImmutable() ||
         !KAuthorized::authorize(QStringLiteral("plasma/plasmashell/unlockedDesktop"))) {
         setImmutability(Plasma::Types::SystemImmutable);
@@ -783,6 +796,185 @@ void ShellCorona::load()
     }
 }
 
+static bool hasImmutableEntries(const KConfigGroup &group)
+{
+    if (group.isImmutable()) {
+        return true;
+    }
+
+    const QStringList keys = group.keyList();
+    for (const QString &key : keys) {
+        if (group.isEntryImmutable(key)) {
+            return true;
+        }
+    }
+
+    const QStringList groups = group.groupList();
+    for (const QString &child : groups) {
+        if (hasImmutableEntries(KConfigGroup(&group, child))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ShellCorona::loadLayoutDeferringInactive(const QString &configFileName)
+{
+    // The same config object Corona::loadLayout() reads
+    KSharedConfig::Ptr conf = KSharedConfig::openConfig(configFileName, KConfig::SimpleConfig);
+    KConfigGroup containmentsGroup(conf, "Containments");
+
+    const QString currentActivity = m_activityController->currentActivity();
+    QSet<int> connectedScreens;
+    for (QScreen *screen : qGuiApp->screens()) {
+        connectedScreens.insert(m_screenPool->id(screen->name()));
+    }
+
+    // New containments and applets get the id after the highest one loaded,
+    // so the containments holding the highest ids are never deferred
+    uint maxContainmentId = 0;
+    uint maxAppletId = 0;
+    QString maxContainmentGroup;
+    QString maxAppletGroup;
+    const QStringList groups = containmentsGroup.groupList();
+    for (const QString &group : groups) {
+        const uint id = group.toUInt();
+        if (id > maxContainmentId) {
+            maxContainmentId = id;
+            maxContainmentGroup = group;
+        }
+
+        const QStringList applets = KConfigGroup(&containmentsGroup, group).group("Applets").groupList();
+        for (const QString &applet : applets) {
+            if (applet.toUInt() > maxAppletId) {
+                maxAppletId = applet.toUInt();
+                maxAppletGroup = group;
+            }
+        }
+    }
+
+    // Desktops belong to an activity and a screen, panels and the
+    // containments of applets like the system tray don't
+    QStringList deferredGroups;
+    for (const QString &group : groups) {
+        if (group == maxContainmentGroup || group == maxAppletGroup) {
+            continue;
+        }
+
+        const KConfigGroup containmentConfig(&containmentsGroup, group);
+        const QString activity = containmentConfig.readEntry("activityId", QString());
+        const int screen = containmentConfig.readEntry("lastScreen", -1);
+        if (activity.isEmpty() || screen < 0 || (activity == currentActivity && connectedScreens.contains(screen))) {
+            continue;
+        }
+
+        // Immutable entries can't be hidden from Corona
+        bool ok;
+        const uint id = group.toUInt(&ok);
+        if (ok && !hasImmutableEntries(containmentConfig)) {
+            m_deferredContainments.insert(id, {activity, screen});
+            deferredGroups << group;
+        }
+    }
+
+    if (deferredGroups.isEmpty()) {
+        loadLayout(configFileName);
+        return;
+    }
+
+    // Corona only switches to a config file in loadLayout(), which loads
+    // every containment in it. It gets a view of the layout without the
+    // deferred containments: they are removed in memory only, marked clean
+    // so no sync writes the removal, and read back from the file right after
+    if (conf->isDirty()) {
+        conf->sync();
+    }
+    for (const QString &group : qAsConst(deferredGroups)) {
+        KConfigGroup(&containmentsGroup, group).deleteGroup();
+    }
+    conf->markAsClean();
+
+    loadLayout(configFileName);
+
+    conf->reparseConfiguration();
+
+    qCDebug(PLASMASHELL) << "Deferred loading" << m_deferredContainments.count() << "containments of inactive activities and screens";
+}
+
+void ShellCorona::loadDeferredContainments()
+{
+    m_deferredContainmentsTimer.stop();
+
+    while (!m_deferredContainments.isEmpty()) {
+        loadDeferredContainment(m_deferredContainments.firstKey());
+    }
+}
+
+void ShellCorona::loadDeferredContainments(const QString &activity, int screen)
+{
+    const QList<uint> ids = m_deferredContainments.keys();
+    for (uint id : ids) {
+        const DeferredContainment deferred = m_deferredContainments.value(id);
+        if (deferred.activity == activity && deferred.screen == screen) {
+            loadDeferredContainment(id);
+        }
+    }
+}
+
+Plasma::Containment *ShellCorona::loadDeferredContainment(uint id)
+{
+    if (!m_deferredContainments.remove(id)) {
+        return nullptr;
+    }
+
+    // importLayout() replaces the config of the containment with the one
+    // passed in, which has to be a copy
+    KConfig layout(QString(), KConfig::SimpleConfig);
+    KConfigGroup layoutContainments(&layout, "Containments");
+    KConfigGroup containmentConfig(KConfigGroup(config(), "Containments"), QString::number(id));
+    KConfigGroup copy(&layoutContainments, QString::number(id));
+    containmentConfig.copyTo(&copy);
+
+    const QList<Plasma::Containment *> containments = importLayout(KConfigGroup(&layout, QString()));
+    qCDebug(PLASMASHELL) << "Loaded deferred containment" << id;
+
+    return containments.value(0);
+}
+
+void ShellCorona::dropDeferredContainments(const QString &activity)
+{
+    KConfigGroup containmentsGroup(config(), "Containments");
+    bool dropped = false;
+
+    for (auto it = m_deferredContainments.begin(); it != m_deferredContainments.end();) {
+        if (it->activity == activity) {
+            KConfigGroup(&containmentsGroup, QString::number(it.key())).deleteGroup();
+            it = m_deferredContainments.erase(it);
+            dropped = true;
+        } else {
+            ++it;
+        }
+    }
+
+    if (dropped) {
+        requestConfigSync();
+    }
+}
+
+void ShellCorona::preloadDeferredContainment()
+{
+    // Containments of screens which aren't connected are only needed
+    // once they are
+    for (auto it = m_deferredContainments.constBegin(); it != m_deferredContainments.constEnd(); ++it) {
+        if (m_desktopViewforId.contains(it->screen)) {
+            loadDeferredContainment(it.key());
+            m_deferredContainmentsTimer.start(s_deferredContainmentsInterval);
+            return;
+        }
+    }
+}
+
 void ShellCorona::primaryOutputChanged()
 {
     if (!m_desktopViewforId.contains(0)) {
@@ -924,6 +1116,8 @@ void ShellCorona::unload()
     m_panelViews.clear();
     m_waitingPanels.clear();
     m_activityContainmentPlugins.clear();
+    m_deferredContainments.clear();
+    m_deferredContainmentsTimer.stop();
 
     while (!containments().isEmpty()) {
         // Some applets react to destroyedChanged rather just destroyed,
@@ -955,19 +1149,21 @@ void ShellCorona::loadDefaultLayout()
                 QString code = file.readAll();
                 qDebug() << "evaluating pre-startup script:" << script;
 
-                WorkspaceScripting::ScriptEngine scriptEngine(this);
+                auto scriptEngine = new WorkspaceScripting::ScriptEngine(this, this);
 
-                connect(&scriptEngine, &WorkspaceScripting::ScriptEngine::printError, this,
+                connect(scriptEngine, &WorkspaceScripting::ScriptEngine::printError, this,
                         [](const QString &msg) {
                             qWarning() << msg;
                         });
-                connect(&scriptEngine, &WorkspaceScripting::ScriptEngine::print, this,
+                connect(scriptEngine, &WorkspaceScripting::ScriptEngine::print, this,
                         [](const QString &msg) {
                             qDebug() << msg;
                         });
-                if (!scriptEngine.evaluateScript(code, script)) {
+                if (!scriptEngine->evaluateScript(code, script)) {
                     qWarning() << "failed to initialize layout properly:" << script;
                 }
+                // Promises of the script settle later
+                scriptEngine->deleteWhenSettled();
             }
     }
 
@@ -1000,19 +1196,20 @@ void ShellCorona::loadDefaultLayout()
             activityAdded(id);
         }
 
-        WorkspaceScripting::ScriptEngine scriptEngine(this);
+        auto scriptEngine = new WorkspaceScripting::ScriptEngine(this, this);
 
-        connect(&scriptEngine, &WorkspaceScripting::ScriptEngine::printError, this,
+        connect(scriptEngine, &WorkspaceScripting::ScriptEngine::printError, this,
                 [](const QString &msg) {
                     qWarning() << msg;
                 });
-        connect(&scriptEngine, &WorkspaceScripting::ScriptEngine::print, this,
+        connect(scriptEngine, &WorkspaceScripting::ScriptEngine::print, this,
                 [](const QString &msg) {
                     qDebug() << msg;
                 });
-        if (!scriptEngine.evaluateScript(code, script)) {
+        if (!scriptEngine->evaluateScript(code, script)) {
             qWarning() << "failed to initialize layout properly:" << script;
         }
+        scriptEngine->deleteWhenSettled();
     }
 
     Q_EMIT startupCompleted();
@@ -1025,13 +1222,13 @@ void ShellCorona::processUpdateScripts()
         return;
     }
 
-    WorkspaceScripting::ScriptEngine scriptEngine(this);
+    auto scriptEngine = new WorkspaceScripting::ScriptEngine(this, this);
 
-    connect(&scriptEngine, &WorkspaceScripting::ScriptEngine::printError, this,
+    connect(scriptEngine, &WorkspaceScripting::ScriptEngine::printError, this,
             [](const QString &msg) {
                 qWarning() << msg;
             });
-    connect(&scriptEngine, &WorkspaceScripting::ScriptEngine::print, this,
+    connect(scriptEngine, &WorkspaceScripting::ScriptEngine::print, this,
             [](const QString &msg) {
                 qDebug() << msg;
             });
@@ -1040,11 +1237,12 @@ void ShellCorona::processUpdateScripts()
         QFile file(script);
         if (file.open(QIODevice::ReadOnly | QIODevice::Text) ) {
             QString code = file.readAll();
-            scriptEngine.evaluateScript(code);
+            scriptEngine->evaluateScript(code);
         } else {
             qWarning() << "Unable to open the script file" << script << "for reading";
         }
     }
+    scriptEngine->deleteWhenSettled();
 }
 
 int ShellCorona::numScreens() const
@@ -1346,6 +1544,8 @@ void ShellCorona::checkAllDesktopsUiReady(bool ready)
 
 Plasma::Containment *ShellCorona::createContainmentForActivity(const QString& activity, int screenNum)
 {
+    loadDeferredContainments(activity, screenNum);
+
     for (Plasma::Containment *cont : containmentsForActivity(activity)) {
         //in the case of a corrupt config file
         //with multiple containments with same lastScreen
@@ -1634,6 +1834,16 @@ void ShellCorona::checkActivities()
             "null uuid", "There is a nulluuid activity present");
 
     // Killing the unassigned containments
+    QSet<QString> deferredActivities;
+    for (const DeferredContainment &deferred : qAsConst(m_deferredContainments)) {
+        if (!existingActivities.contains(deferred.activity)) {
+            deferredActivities.insert(deferred.activity);
+        }
+    }
+    for (const QString &activity : qAsConst(deferredActivities)) {
+        dropDeferredContainments(activity);
+    }
+
     const auto conts = containments();
     for (Plasma::Containment *cont : conts) {
         if ((cont->containmentType() == Plasma::Types::DesktopContainment ||
@@ -1673,6 +1883,7 @@ void ShellCorona::activityAdded(const QString &id)
 void ShellCorona::activityRemoved(const QString &id)
 {
     m_activityContainmentPlugins.remove(id);
+    dropDeferredContainments(id);
     for (auto cont : containmentsForActivity(id)) {
         cont->destroy();
     }
@@ -1682,24 +1893,8 @@ void ShellCorona::insertActivity(const QString &id, const QString &plugin)
 {
     activityAdded(id);
 
-    const QString currentActivityReally = m_activityController->currentActivity();
-
-    // TODO: This needs to go away!
-    // The containment creation API does not know when we have a
-    // new activity to create a containment for, we need to pretend
-    // that the current activity has been changed
-    QFuture<bool> currentActivity = m_activityController->setCurrentActivity(id);
-    awaitFuture(currentActivity);
-
-    if (!currentActivity.result()) {
-        qDebug() << "Failed to create and switch to the activity";
-        return;
-    }
-
-    while (m_activityController->currentActivity() != id) {
-        QCoreApplication::processEvents();
-    }
-
+    // The containments are created for the activity itself, they don't
+    // need it to be the current one
     m_activityContainmentPlugins.insert(id, plugin);
     for (auto it = m_desktopViewforId.constBegin(); it != m_desktopViewforId.constEnd(); ++it) {
         Plasma::Containment *c = createContainmentForActivity(id, it.key());
@@ -1707,6 +1902,17 @@ void ShellCorona::insertActivity(const QString &id, const QString &plugin)
             c->config().writeEntry("lastScreen", it.key());
         }
     }
+
+    // A newly created activity becomes the current one. Switch without
+    // waiting for the activity manager, the queue keeps the switches of
+    // several new activities in order.
+    m_layoutOperations->enqueue([this, id] {
+        m_layoutOperations->await(m_activityController->setCurrentActivity(id), [id](const QFuture<bool> &switched) {
+            if (switched.resultCount() == 0 || !switched.result()) {
+                qWarning() << "Failed to switch to the new activity" << id;
+            }
+        });
+    });
 }
 
 Plasma::Containment *ShellCorona::setContainmentTypeForScreen(int screen, const QString &plugin)
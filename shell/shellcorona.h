@@ -34,6 +34,7 @@
 #include <KPackage/Package>
 
 class DesktopView;
+class LayoutOperationQueue;
 class PanelView;
 class QMenu;
 class QScreen;
@@ -157,7 +158,13 @@ public Q_SLOTS:
     void evaluateScript(const QString &string);
     void activateLauncherMenu();
 
-    QByteArray dumpCurrentLayoutJS() const;
+    QByteArray dumpCurrentLayoutJS();
+
+    /**
+     * Loads the desktops of other activities and of screens which aren't
+     * connected, which are otherwise only loaded once they are needed
+     */
+    void loadDeferredContainments();
 
     /**
      * loads the shell layout from a look and feel package,
@@ -221,6 +228,7 @@ private Q_SLOTS:
     void panelContainmentDestroyed(QObject* cont);
     void interactiveConsoleVisibilityChanged(bool visible);
     void handleScreenRemoved(QScreen* screen);
+    void preloadDeferredContainment();
 
     void activateTaskManagerEntry(int index);
 
@@ -241,12 +249,29 @@ private:
 
     void insertContainment(const QString &activity, int screenNum, Plasma::Containment *containment);
 
+    /**
+     * Like Corona::loadLayout(), but leaves the desktops which aren't for
+     * the current activity and the connected screens in the config, to
+     * be loaded with loadDeferredContainment()
+     */
+    void loadLayoutDeferringInactive(const QString &configFileName);
+    void loadDeferredContainments(const QString &activity, int screen);
+    Plasma::Containment *loadDeferredContainment(uint id);
+    void dropDeferredContainments(const QString &activity);
+
+    struct DeferredContainment {
+        QString activity;
+        int screen;
+    };
+
     KSharedConfig::Ptr m_config;
     QString m_configPath;
 
     ScreenPool *m_screenPool;
     QString m_shell;
     KActivities::Controller *m_activityController;
+    // Serializes the layout changes which wait for the activity manager
+    LayoutOperationQueue *m_layoutOperations;
     //map from screen number to desktop view, qmap as order is important
     QMap<int, DesktopView *> m_desktopViewforId;
     QHash<const Plasma::Containment *, PanelView *> m_panelViews;
@@ -263,6 +288,9 @@ private:
     QTimer m_waitingPanelsTimer;
     QTimer m_appConfigSyncTimer;
     QTimer m_reconsiderOutputsTimer;
+    QTimer m_deferredContainmentsTimer;
+    // Desktops which are only in the config so far, by containment id
+    QMap<uint, DeferredContainment> m_deferredContainments;
 
     KWayland::Client::PlasmaShell *m_waylandPlasmaShell;
     bool m_closingDown : 1;
@@ -0,0 +1,137 @@
+/***************************************************************************
+ *   Copyright 2020 by the Plasma Workspace authors                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+// Measures the time from scanning a wallpaper tree to the model holding
+// all of its images, and checks the model still finds them by path.
+
+#include "image.h"
+#include "slidemodel.h"
+
+#include <QBuffer>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtTest>
+
+static const int s_imagesPerDir = 100;
+
+class BackgroundListModelBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void scanToReady_data();
+    void scanToReady();
+
+private:
+    QStringList createTree(const QString &root, int images);
+
+    QByteArray m_imageData;
+};
+
+void BackgroundListModelBenchmark::initTestCase()
+{
+    QImage image(16, 10, QImage::Format_RGB32);
+    image.fill(Qt::darkCyan);
+
+    QBuffer buffer(&m_imageData);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(image.save(&buffer, "PNG"));
+}
+
+QStringList BackgroundListModelBenchmark::createTree(const QString &root, int images)
+{
+    QStringList paths;
+
+    for (int i = 0; i < images; ++i) {
+        const QString dir = root + QStringLiteral("/dir%1").arg(i / s_imagesPerDir);
+        if (i % s_imagesPerDir == 0) {
+            QDir().mkpath(dir);
+        }
+
+        QFile file(dir + QStringLiteral("/image%1.png").arg(i));
+        if (!file.open(QIODevice::WriteOnly) || file.write(m_imageData) != m_imageData.size()) {
+            return QStringList();
+        }
+
+        paths << file.fileName();
+    }
+
+    return paths;
+}
+
+void BackgroundListModelBenchmark::scanToReady_data()
+{
+    QTest::addColumn<int>("images");
+
+    QTest::newRow("100") << 100;
+    QTest::newRow("1k") << 1000;
+
+    // Writing and scanning this many files takes too long to run with every ctest
+    if (qEnvironmentVariableIsSet("BACKGROUNDLISTMODELBENCHMARK_LARGE")) {
+        QTest::newRow("10k") << 10000;
+    }
+}
+
+void BackgroundListModelBenchmark::scanToReady()
+{
+    QFETCH(int, images);
+
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+
+    const QStringList paths = createTree(root.path(), images);
+    QCOMPARE(paths.count(), images);
+
+    Image wallpaper;
+    SlideModel model(&wallpaper, nullptr);
+    QSignalSpy doneSpy(&model, &SlideModel::done);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    model.reload({root.path()});
+    QVERIFY(doneSpy.wait(120000));
+
+    QTest::setBenchmarkResult(timer.elapsed(), QTest::WalltimeMilliseconds);
+    QCOMPARE(model.count(), images);
+
+    for (const QString &path : paths) {
+        const int row = model.indexOf(path);
+        QVERIFY(row >= 0);
+        QCOMPARE(model.index(row, 0).data(BackgroundListModel::PathRole).toUrl(), QUrl::fromLocalFile(path));
+    }
+    QCOMPARE(model.indexOf(root.path() + QLatin1String("/missing.png")), -1);
+    QCOMPARE(model.indexOf(QUrl::fromLocalFile(paths.last()).toString()), model.indexOf(paths.last()));
+
+    // Rows after the removed ones have to be found at their new place
+    model.removeBackground(root.path() + QLatin1String("/dir0"));
+    QCOMPARE(model.count(), images - qMin(images, s_imagesPerDir));
+    QCOMPARE(model.indexOf(paths.first()), -1);
+    if (images > s_imagesPerDir) {
+        const int row = model.indexOf(paths.last());
+        QCOMPARE(model.index(row, 0).data(BackgroundListModel::PathRole).toUrl(), QUrl::fromLocalFile(paths.last()));
+    }
+}
+
+QTEST_MAIN(BackgroundListModelBenchmark)
+#include "backgroundlistmodelbenchmark.moc"
@@ -0,0 +1,264 @@
+/***************************************************************************
+ *   Copyright 2020 by the Plasma Workspace authors                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "image.h"
+#include "previewcache.h"
+#include "slidemodel.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+
+static const int s_imageCount = 5;
+
+class PreviewCacheTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void testSharedBetweenModels();
+    void testSharedOnDisk();
+    void testRetryChangedFile();
+    void testInvalidate();
+    void testPrune();
+
+private:
+    // Asks for the previews of all rows and waits until the model has them
+    bool loadPreviews(SlideModel &model);
+
+    QTemporaryDir m_imageDir;
+    QStringList m_images;
+    // Created after entering test mode, it has a model using the cache itself
+    Image *m_wallpaper = nullptr;
+};
+
+void PreviewCacheTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QDir(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/plasma_wallpaper_image")).removeRecursively();
+
+    QVERIFY(m_imageDir.isValid());
+
+    for (int i = 0; i < s_imageCount; ++i) {
+        QImage image(640 + i, 480, QImage::Format_RGB32);
+        image.fill(Qt::darkGreen);
+
+        const QString path = m_imageDir.path() + QStringLiteral("/image%1.png").arg(i);
+        QVERIFY(image.save(path));
+        m_images << path;
+    }
+
+    m_wallpaper = new Image(this);
+}
+
+void PreviewCacheTest::cleanupTestCase()
+{
+    QDir(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/plasma_wallpaper_image")).removeRecursively();
+}
+
+bool PreviewCacheTest::loadPreviews(SlideModel &model)
+{
+    QSignalSpy doneSpy(&model, &SlideModel::done);
+    model.reload({m_imageDir.path()});
+    if (!doneSpy.wait() || model.rowCount() != s_imageCount) {
+        return false;
+    }
+
+    auto missingPreviews = [&model] {
+        int missing = 0;
+        for (int row = 0; row < model.rowCount(); ++row) {
+            if (model.index(row, 0).data(BackgroundListModel::ScreenshotRole).value<QPixmap>().isNull()) {
+                ++missing;
+            }
+        }
+        return missing;
+    };
+
+    if (missingPreviews() == 0) {
+        return true;
+    }
+
+    QSignalSpy dataChangedSpy(&model, &QAbstractItemModel::dataChanged);
+    while (missingPreviews() > 0) {
+        if (!dataChangedSpy.wait()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void PreviewCacheTest::testSharedBetweenModels()
+{
+    PreviewCache *cache = PreviewCache::self();
+    const int decodeCount = cache->decodeCount();
+
+    SlideModel first(m_wallpaper, nullptr);
+    QVERIFY(loadPreviews(first));
+    QCOMPARE(cache->decodeCount() - decodeCount, s_imageCount);
+
+    const QPixmap preview = first.index(0, 0).data(BackgroundListModel::ScreenshotRole).value<QPixmap>();
+    QVERIFY(preview.width() > 0 && preview.height() > 0);
+
+    // The second model gets the previews of the first one
+    SlideModel second(m_wallpaper, nullptr);
+    QVERIFY(loadPreviews(second));
+    QCOMPARE(cache->decodeCount() - decodeCount, s_imageCount);
+}
+
+void PreviewCacheTest::testSharedOnDisk()
+{
+    // Like another process showing the same wallpapers
+    PreviewCache cache;
+    QSignalSpy readySpy(&cache, &PreviewCache::previewReady);
+    QSignalSpy sizeSpy(&cache, &PreviewCache::imageSizeFound);
+
+    const QSize size(160, 100);
+    for (const QString &path : qAsConst(m_images)) {
+        cache.requestPreview(path, size);
+        cache.requestImageSize(path);
+    }
+
+    QTRY_COMPARE(readySpy.count(), s_imageCount);
+    QTRY_COMPARE(sizeSpy.count(), s_imageCount);
+
+    // A different preview size has to be decoded, the dimensions are known
+    QCOMPARE(cache.decodeCount(), s_imageCount);
+    QCOMPARE(cache.imageSize(m_images.last()), QSize(640 + s_imageCount - 1, 480));
+
+    PreviewCache otherProcess;
+    QSignalSpy otherReadySpy(&otherProcess, &PreviewCache::previewReady);
+    for (const QString &path : qAsConst(m_images)) {
+        otherProcess.requestPreview(path, size);
+    }
+
+    QTRY_COMPARE(otherReadySpy.count(), s_imageCount);
+
+    QCOMPARE(otherProcess.decodeCount(), 0);
+    QCOMPARE(otherProcess.preview(m_images.first(), size).size(), cache.preview(m_images.first(), size).size());
+}
+
+void PreviewCacheTest::testRetryChangedFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QString path = dir.path() + QStringLiteral("/broken.png");
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("not an image");
+    file.close();
+
+    PreviewCache cache;
+    QSignalSpy readySpy(&cache, &PreviewCache::previewReady);
+    const QSize size(80, 50);
+
+    cache.requestPreview(path, size);
+    QTRY_COMPARE(cache.decodeCount(), 1);
+    QTest::qWait(100);
+
+    // A file which can't be read isn't tried again
+    cache.requestPreview(path, size);
+    QTest::qWait(100);
+    QCOMPARE(cache.decodeCount(), 1);
+    QCOMPARE(readySpy.count(), 0);
+
+    // ...until it changed
+    QImage image(320, 200, QImage::Format_RGB32);
+    image.fill(Qt::darkBlue);
+    QVERIFY(image.save(path, "PNG"));
+    cache.invalidate(path);
+
+    cache.requestPreview(path, size);
+    QTRY_COMPARE(readySpy.count(), 1);
+    QCOMPARE(cache.decodeCount(), 2);
+    QVERIFY(!cache.preview(path, size).isNull());
+}
+
+void PreviewCacheTest::testInvalidate()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QString path = dir.path() + QStringLiteral("/changing.png");
+    QImage landscape(320, 200, QImage::Format_RGB32);
+    landscape.fill(Qt::darkBlue);
+    QVERIFY(landscape.save(path, "PNG"));
+
+    PreviewCache cache;
+    QSignalSpy readySpy(&cache, &PreviewCache::previewReady);
+    const QSize size(80, 80);
+
+    cache.requestPreview(path, size);
+    QTRY_COMPARE(readySpy.count(), 1);
+    QCOMPARE(cache.imageSize(path), QSize(320, 200));
+    QVERIFY(cache.preview(path, size).width() > cache.preview(path, size).height());
+
+    QImage portrait(200, 320, QImage::Format_RGB32);
+    portrait.fill(Qt::darkRed);
+    QVERIFY(portrait.save(path, "PNG"));
+
+    // Until it is invalidated, the preview in memory is used
+    cache.requestPreview(path, size);
+    QVERIFY(!cache.preview(path, size).isNull());
+    QCOMPARE(cache.decodeCount(), 1);
+
+    cache.invalidate(path);
+    QVERIFY(cache.preview(path, size).isNull());
+    QVERIFY(!cache.imageSize(path).isValid());
+
+    cache.requestPreview(path, size);
+    QTRY_COMPARE(readySpy.count(), 2);
+    QCOMPARE(cache.decodeCount(), 2);
+    QCOMPARE(cache.imageSize(path), QSize(200, 320));
+    QVERIFY(cache.preview(path, size).width() < cache.preview(path, size).height());
+}
+
+void PreviewCacheTest::testPrune()
+{
+    const QString previewsDir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/plasma_wallpaper_image/previews");
+    QVERIFY(QDir().mkpath(previewsDir));
+
+    auto createPreview = [&previewsDir](const QString &name, const QDateTime &lastModified) {
+        QFile file(previewsDir + QLatin1Char('/') + name);
+        if (!file.open(QIODevice::WriteOnly) || file.write("preview") < 0) {
+            return false;
+        }
+        return file.setFileTime(lastModified, QFileDevice::FileModificationTime);
+    };
+
+    const QDateTime now = QDateTime::currentDateTime();
+    QVERIFY(createPreview(QStringLiteral("old.png"), now.addDays(-31)));
+    QVERIFY(createPreview(QStringLiteral("recent.png"), now.addDays(-1)));
+
+    // Pruning happens in the background when the cache is created
+    PreviewCache cache;
+    QTRY_VERIFY(!QFile::exists(previewsDir + QLatin1String("/old.png")));
+    QVERIFY(QFile::exists(previewsDir + QLatin1String("/recent.png")));
+}
+
+QTEST_MAIN(PreviewCacheTest)
+#include "previewcachetest.moc"
@@ -22,11 +22,16 @@
 
 #include "debug.h"
 #include "backgroundlistmodel.h"
+#include "previewcache.h"
 
 #include <QFile>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
+#include <QSaveFile>
 #include <QStandardPaths>
 #include <QThreadPool>
+#include <QUrl>
 #include <QUuid>
 #include <QGuiApplication>
 #include <QFontMetrics>
@@ -36,9 +41,11 @@
 #include <QMutex>
 #include <QMutexLocker>
 #include <QElapsedTimer>
+#include <QMap>
+
+#include <algorithm>
 
 #include <QDebug>
-#include <KIO/PreviewJob>
 #include <KLocalizedString>
 #include <kaboutdata.h>
 
@@ -53,30 +60,21 @@
 QStringList BackgroundFinder::s_suffixes;
 QMutex BackgroundFinder::s_suffixMutex;
 
-ImageSizeFinder::ImageSizeFinder(const QString &path, QObject *parent)
-    : QObject(parent),
-      m_path(path)
-{
-}
-
-void ImageSizeFinder::run()
-{
-    QImageReader reader(m_path);
-    Q_EMIT sizeFound(m_path, reader.size());
-}
-
-
 BackgroundListModel::BackgroundListModel(Image *wallpaper, QObject *parent)
     : QAbstractListModel(parent),
-      m_wallpaper(wallpaper)
+      m_wallpaper(wallpaper),
+      m_previewCache(PreviewCache::self())
 {
-    m_imageCache.setMaxCost(10 * 1024 * 1024); // 10 MiB
-
     connect(&m_dirwatch, &KDirWatch::deleted, this, &BackgroundListModel::removeBackground);
+    connect(&m_dirwatch, &KDirWatch::dirty, this, &BackgroundListModel::backgroundChanged);
+
+    connect(m_previewCache, &PreviewCache::previewReady, this, &BackgroundListModel::previewReady);
+    connect(m_previewCache, &PreviewCache::imageSizeFound, this, &BackgroundListModel::imageSizeFound);
 
     //TODO: on Qt 4.4 use the ui scale factor
     QFontMetrics fm(QGuiApplication::font());
-    m_screenshotSize = fm.horizontalAdvance('M') * 15;
+    const int screenshotSize = fm.horizontalAdvance('M') * 15;
+    m_previewSize = QSize(screenshotSize * 1.6, screenshotSize);
 }
 
 BackgroundListModel::~BackgroundListModel() = default;
@@ -98,15 +96,137 @@ QHash<int, QByteArray> BackgroundListModel::BackgroundListModel::roleNames() con
 
 void BackgroundListModel::removeBackground(const QString &path)
 {
-    int index = -1;
-    while ((index = indexOf(path)) >= 0) {
-        beginRemoveRows(QModelIndex(), index, index);
-        m_packages.removeAt(index);
+    const QString key = normalizedPath(path);
+    QVector<int> rows;
+
+    const int row = m_rowForPath.value(key, -1);
+    if (row >= 0) {
+        rows << row;
+    } else {
+        // A watched directory is gone, remove everything that was in it
+        const QString prefix = key + QLatin1Char('/');
+        QSet<int> rowsInDir;
+        for (auto it = m_rowForPath.constBegin(), end = m_rowForPath.constEnd(); it != end; ++it) {
+            if (it.key().startsWith(prefix)) {
+                rowsInDir.insert(it.value());
+            }
+        }
+        rows = QVector<int>(rowsInDir.constBegin(), rowsInDir.constEnd());
+        std::sort(rows.begin(), rows.end());
+    }
+
+    removePackages(rows);
+}
+
+void BackgroundListModel::clearPackages()
+{
+    if (!m_packages.isEmpty()) {
+        beginRemoveRows(QModelIndex(), 0, m_packages.count() - 1);
+        m_packages.clear();
+        m_rowForPath.clear();
         endRemoveRows();
         emit countChanged();
     }
 }
 
+QString BackgroundListModel::normalizedPath(const QString &path)
+{
+    // Paths can come as file:// URLs and package paths end with a '/'
+    if (path.startsWith(QLatin1String("file:"))) {
+        return QDir::cleanPath(QUrl(path).toLocalFile());
+    }
+
+    return QDir::cleanPath(path);
+}
+
+QStringList BackgroundListModel::pathKeys(const KPackage::Package &package)
+{
+    QStringList keys;
+
+    const QString preferred = package.filePath("preferred");
+    if (!preferred.isEmpty()) {
+        keys << normalizedPath(preferred);
+    }
+
+    // Images are found by their file, packages also by their directory
+    const QStringList prefixes = package.contentsPrefixPaths();
+    if (!prefixes.isEmpty() && !prefixes.first().isEmpty()) {
+        keys << normalizedPath(package.path());
+    }
+
+    return keys;
+}
+
+void BackgroundListModel::appendPackages(const QList<KPackage::Package> &packages)
+{
+    if (packages.isEmpty()) {
+        return;
+    }
+
+    const int start = m_packages.count();
+    beginInsertRows(QModelIndex(), start, start + packages.count() - 1);
+
+    m_packages.append(packages);
+    for (int i = 0; i < packages.count(); ++i) {
+        for (const QString &key : pathKeys(packages.at(i))) {
+            m_rowForPath.insert(key, start + i);
+        }
+    }
+
+    endInsertRows();
+    emit countChanged();
+}
+
+void BackgroundListModel::prependPackage(const KPackage::Package &package)
+{
+    beginInsertRows(QModelIndex(), 0, 0);
+
+    m_packages.prepend(package);
+    for (int &row : m_rowForPath) {
+        ++row;
+    }
+    for (const QString &key : pathKeys(package)) {
+        m_rowForPath.insert(key, 0);
+    }
+
+    endInsertRows();
+    emit countChanged();
+}
+
+void BackgroundListModel::removePackages(const QVector<int> &rows)
+{
+    if (rows.isEmpty()) {
+        return;
+    }
+
+    // Remove contiguous ranges, starting from the end
+    for (int last = rows.count() - 1; last >= 0;) {
+        int first = last;
+        while (first > 0 && rows.at(first - 1) == rows.at(first) - 1) {
+            --first;
+        }
+
+        beginRemoveRows(QModelIndex(), rows.at(first), rows.at(last));
+        m_packages.erase(m_packages.begin() + rows.at(first), m_packages.begin() + rows.at(last) + 1);
+        endRemoveRows();
+
+        last = first - 1;
+    }
+
+    // Drop the removed rows from the index and move the others up
+    for (auto it = m_rowForPath.begin(); it != m_rowForPath.end();) {
+        const auto removed = std::lower_bound(rows.constBegin(), rows.constEnd(), it.value());
+        if (removed != rows.constEnd() && *removed == it.value()) {
+            it = m_rowForPath.erase(it);
+        } else {
+            it.value() -= removed - rows.constBegin();
+            ++it;
+        }
+    }
+
+    emit countChanged();
+}
+
 void BackgroundListModel::reload()
 {
     reload(QStringList());
@@ -114,12 +234,7 @@ void BackgroundListModel::reload()
 
 void BackgroundListModel::reload(const QStringList &selected)
 {
-    if (!m_packages.isEmpty()) {
-        beginRemoveRows(QModelIndex(), 0, m_packages.count() - 1);
-        m_packages.clear();
-        endRemoveRows();
-        emit countChanged();
-    }
+    clearPackages();
 
     if (!m_wallpaper) {
         return;
@@ -153,6 +268,11 @@ void BackgroundListModel::processPaths(const QStringList &paths)
         return;
     }
 
+    // Looked up for every symlink and package file
+    const QSet<QString> pathSet(paths.constBegin(), paths.constEnd());
+    // Normalized paths of newPackages
+    QSet<QString> newPaths;
+
     QList<KPackage::Package> newPackages;
     Q_FOREACH (QString file, paths) {
         // check if the path is a symlink and if it is,
@@ -181,16 +301,18 @@ void BackgroundListModel::processPaths(const QStringList &paths)
         // that are being checked in here); we want to check for duplicates
         // if and only if we actually changed the path (so the conditions from above
         // are reused here as that means we did change the path)
-        if ((info.isSymLink() || contentsIndex != -1) && paths.contains(file)) {
+        if ((info.isSymLink() || contentsIndex != -1) && pathSet.contains(file)) {
             continue;
         }
 
-        if (!contains(file) && QFile::exists(file)) {
+        const QString key = normalizedPath(file);
+        if (!newPaths.contains(key) && !contains(file) && QFile::exists(file)) {
             KPackage::Package package = KPackage::PackageLoader::self()->loadPackage(QStringLiteral("Wallpaper/Images"));
             package.setPath(file);
             if (package.isValid()) {
                 m_wallpaper->findPreferedImageInPackage(package);
                 newPackages << package;
+                newPaths.insert(key);
             }
         }
     }
@@ -202,13 +324,7 @@ void BackgroundListModel::processPaths(const QStringList &paths)
         }
     }
 
-    if (!newPackages.isEmpty()) {
-        const int start = rowCount();
-        beginInsertRows(QModelIndex(), start, start + newPackages.size() - 1);
-        m_packages.append(newPackages);
-        endInsertRows();
-        emit countChanged();
-    }
+    appendPackages(newPackages);
     //qCDebug(IMAGEWALLPAPER) << t.elapsed();
 }
 
@@ -218,53 +334,21 @@ void BackgroundListModel::addBackground(const QString& path)
         if (!m_dirwatch.contains(path)) {
             m_dirwatch.addFile(path);
         }
-        beginInsertRows(QModelIndex(), 0, 0);
         KPackage::Package package = KPackage::PackageLoader::self()->loadPackage(QStringLiteral("Wallpaper/Images"));
 
         m_removableWallpapers.insert(path);
         package.setPath(path);
         m_wallpaper->findPreferedImageInPackage(package);
         qCDebug(IMAGEWALLPAPER) << "Background added " << path << package.isValid();
-        m_packages.prepend(package);
-        endInsertRows();
-        emit countChanged();
+        prependPackage(package);
     }
 }
 
 int BackgroundListModel::indexOf(const QString &path) const
 {
-    for (int i = 0; i < m_packages.size(); i++) {
-        // packages will end with a '/', but the path passed in may not
-        QString package = m_packages[i].path();
-        if (package.at(package.length() - 1) == QChar::fromLatin1('/')) {
-            package.chop(1);
-        }
-        //remove eventual file:///
-        const QString filteredPath = QUrl(path).path();
-
-        if (filteredPath.startsWith(package)) {
-            // FIXME: ugly hack to make a difference between local files in the same dir
-            // package->path does not contain the actual file name
-            qCDebug(IMAGEWALLPAPER) << "prefix" << m_packages[i].contentsPrefixPaths() << m_packages[i].filePath("preferred") << package << filteredPath;
-            QStringList ps = m_packages[i].contentsPrefixPaths();
-            bool prefixempty = ps.count() == 0;
-            if (!prefixempty) {
-                prefixempty = ps[0].isEmpty();
-            }
-
-            //For local files (user wallpapers) filteredPath == m_packages[i].filePath("preferred")
-            //E.X. filteredPath = "/home/kde/next.png"
-            //m_packages[i].filePath("preferred") = "/home/kde/next.png"
-            //
-            //But for the system wallpapers this is not the case. filteredPath != m_packages[i].filePath("preferred")
-            //E.X. filteredPath = /usr/share/wallpapers/Next/"
-            //m_packages[i].filePath("preferred") = "/usr/share/wallpapers/Next/contents/images/1920x1080.png"
-            if ((filteredPath == m_packages[i].filePath("preferred")) || m_packages[i].filePath("preferred").contains(filteredPath)) {
-                return i;
-            }
-        }
-    }
-    return -1;
+    // Finds local images by their file, and packages by their directory
+    // or their preferred image
+    return m_rowForPath.value(normalizedPath(path), -1);
 }
 
 bool BackgroundListModel::contains(const QString &path) const
@@ -280,36 +364,44 @@ int BackgroundListModel::rowCount(const QModelIndex &) const
 
 QSize BackgroundListModel::bestSize(const KPackage::Package &package) const
 {
-    if (m_sizeCache.contains(package.path())) {
-        return m_sizeCache.value(package.path());
-    }
-
     const QString image = package.filePath("preferred");
     if (image.isEmpty()) {
         return QSize();
     }
 
-    ImageSizeFinder *finder = new ImageSizeFinder(image);
-    connect(finder, &ImageSizeFinder::sizeFound, this,
-            &BackgroundListModel::sizeFound);
-    QThreadPool::globalInstance()->start(finder);
+    const QSize size = m_previewCache->imageSize(image);
+    if (!size.isValid()) {
+        m_previewCache->requestImageSize(image);
+    }
 
-    QSize size(-1, -1);
-    const_cast<BackgroundListModel *>(this)->m_sizeCache.insert(package.path(), size);
     return size;
 }
 
-void BackgroundListModel::sizeFound(const QString &path, const QSize &s)
+void BackgroundListModel::imageSizeFound(const QString &path)
 {
-    if (!m_wallpaper) {
+    const int row = indexOf(path);
+    if (row >= 0) {
+        emit dataChanged(index(row, 0), index(row, 0), {ResolutionRole});
+    }
+}
+
+void BackgroundListModel::backgroundChanged(const QString &path)
+{
+    const int row = indexOf(path);
+    if (row < 0) {
         return;
     }
 
-    int idx = indexOf(path);
-    if (idx >= 0) {
-        KPackage::Package package = m_packages.at(idx);
-        m_sizeCache.insert(package.path(), s);
-        emit dataChanged(index(idx, 0), index(idx, 0));
+    // The previews on disk are keyed by the modification time, so new ones are created
+    m_previewCache->invalidate(package(row).filePath("preferred"));
+    emit dataChanged(index(row, 0), index(row, 0), {ScreenshotRole, ResolutionRole});
+}
+
+void BackgroundListModel::previewReady(const QString &path)
+{
+    const int row = indexOf(path);
+    if (row >= 0) {
+        emit dataChanged(index(row, 0), index(row, 0), {ScreenshotRole});
     }
 }
 
@@ -342,27 +434,13 @@ QVariant BackgroundListModel::data(const QModelIndex &index, int role) const
     case ScreenshotRole: {
         const QString path = b.filePath("preferred");
 
-        QPixmap *cachedPreview = m_imageCache.object(path);
-        if (cachedPreview) {
-            return *cachedPreview;
+        const QPixmap preview = m_previewCache->preview(path, m_previewSize);
+        if (!preview.isNull()) {
+            return preview;
         }
 
-        const QUrl url = QUrl::fromLocalFile(path);
-        const QPersistentModelIndex persistentIndex(index);
-        if (!m_previewJobsUrls.contains(persistentIndex) && url.isValid()) {
-            KFileItemList list;
-            list.append(KFileItem(url, QString(), 0));
-            QStringList availablePlugins = KIO::PreviewJob::availablePlugins();
-            KIO::PreviewJob* job = KIO::filePreview(list,
-                                                    QSize(m_screenshotSize*1.6,
-                                                    m_screenshotSize),  &availablePlugins);
-            job->setIgnoreMaximumSize(true);
-            connect(job, &KIO::PreviewJob::gotPreview,
-                    this, &BackgroundListModel::showPreview);
-            connect(job, &KIO::PreviewJob::failed,
-                    this, &BackgroundListModel::previewFailed);
-            const_cast<BackgroundListModel *>(this)->m_previewJobsUrls.insert(persistentIndex, url);
-        }
+        // Only asked for while the row is shown
+        m_previewCache->requestPreview(path, m_previewSize);
 
         return QVariant();
     }
@@ -430,36 +508,6 @@ bool BackgroundListModel::setData(const QModelIndex &index, const QVariant &valu
     return false;
 }
 
-void BackgroundListModel::showPreview(const KFileItem &item, const QPixmap &preview)
-{
-    if (!m_wallpaper) {
-        return;
-    }
-
-    QPersistentModelIndex index = m_previewJobsUrls.key(item.url());
-    m_previewJobsUrls.remove(index);
-
-    if (!index.isValid()) {
-        return;
-    }
-
-    KPackage::Package b = package(index.row());
-    if (!b.isValid()) {
-        return;
-    }
-
-    const int cost = preview.width() * preview.height() * preview.depth() / 8;
-    m_imageCache.insert(b.filePath("preferred"), new QPixmap(preview), cost);
-
-    //qCDebug(IMAGEWALLPAPER) << "WP preview size:" << preview.size();
-    emit dataChanged(index, index);
-}
-
-void BackgroundListModel::previewFailed(const KFileItem &item)
-{
-    m_previewJobsUrls.remove(m_previewJobsUrls.key(item.url()));
-}
-
 KPackage::Package BackgroundListModel::package(int index) const
 {
     return m_packages.at(index);
@@ -477,15 +525,16 @@ void BackgroundListModel::setPendingDeletion(int rowIndex, bool pendingDeletion)
 
 const QStringList BackgroundListModel::wallpapersAwaitingDeletion()
 {
-    QStringList candidates;
-    for (const KPackage::Package &b : m_packages) {
-        const QUrl wallpaperUrl = QUrl::fromLocalFile(b.filePath("preferred"));
-        if (m_pendingDeletion.contains(wallpaperUrl.toLocalFile()) && m_pendingDeletion[wallpaperUrl.toLocalFile()]) {
-            candidates << wallpaperUrl.toLocalFile();
+    // Only the wallpapers which are still in the model, in their order
+    QMap<int, QString> candidates;
+    for (auto it = m_pendingDeletion.constBegin(), end = m_pendingDeletion.constEnd(); it != end; ++it) {
+        const int row = it.value() ? indexOf(it.key()) : -1;
+        if (row >= 0) {
+            candidates.insert(row, it.key());
         }
     }
 
-    return candidates;
+    return candidates.values();
 }
 
 BackgroundFinder::BackgroundFinder(Image *wallpaper, const QStringList &paths)
@@ -533,59 +582,380 @@ bool BackgroundFinder::isAcceptableSuffix(const QString &suffix)
     return globPatterns.contains(QLatin1String("*.") + suffix.toLower());
 }
 
+namespace {
+
+// Roots which haven't been scanned for this long are forgotten with everything below them
+const qint64 s_maxRootAgeMSecs = 30LL * 24 * 60 * 60 * 1000;
+
+// What a directory contained when it was last listed
+struct ScannedDir {
+    qint64 mtime = 0;
+    QStringList images;
+    QStringList packages;
+    QStringList dirs;
+    // Whether a subdirectory is a package depends on its contents, which
+    // don't change the mtime of this directory
+    QHash<QString, qint64> subdirMtimes;
+};
+
+QDataStream &operator<<(QDataStream &stream, const ScannedDir &dir)
+{
+    return stream << dir.mtime << dir.images << dir.packages << dir.dirs << dir.subdirMtimes;
+}
+
+QDataStream &operator>>(QDataStream &stream, ScannedDir &dir)
+{
+    return stream >> dir.mtime >> dir.images >> dir.packages >> dir.dirs >> dir.subdirMtimes;
+}
+
+qint64 modificationTime(const QString &path)
+{
+    return QFileInfo(path).lastModified().toMSecsSinceEpoch();
+}
+
+// The listings of the scanned directories, kept across scans and sessions
+class ScanCache
+{
+public:
+    bool find(const QString &path, qint64 mtime, ScannedDir &dir)
+    {
+        QMutexLocker locker(&m_mutex);
+        load();
+
+        const auto it = m_dirs.constFind(path);
+        if (it == m_dirs.constEnd() || it->mtime != mtime) {
+            return false;
+        }
+
+        dir = it.value();
+        return true;
+    }
+
+    // Marks @p roots as in use, the listings below roots which aren't used for a while are dropped
+    void useRoots(const QStringList &roots)
+    {
+        QMutexLocker locker(&m_mutex);
+        load();
+
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        for (const QString &root : roots) {
+            m_roots.insert(QDir::cleanPath(root), now);
+        }
+        m_dirty = true;
+    }
+
+    void insert(const QString &path, const ScannedDir &dir)
+    {
+        QMutexLocker locker(&m_mutex);
+        load();
+
+        // Forget the subdirectories which are gone
+        const ScannedDir previous = m_dirs.value(path);
+        for (const QString &subdir : previous.dirs) {
+            if (!dir.dirs.contains(subdir)) {
+                removeTree(subdir);
+            }
+        }
+
+        m_dirs.insert(path, dir);
+        m_dirty = true;
+    }
+
+    void save()
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_dirty) {
+            return;
+        }
+
+        prune();
+
+        const QString fileName = cacheFileName();
+        QDir().mkpath(QFileInfo(fileName).path());
+
+        QSaveFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly)) {
+            qCWarning(IMAGEWALLPAPER) << "Failed to write the wallpaper scan cache" << fileName;
+            return;
+        }
+
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_5_14);
+        stream << s_version << m_roots << m_dirs;
+
+        if (file.commit()) {
+            m_dirty = false;
+        }
+    }
+
+private:
+    static QString cacheFileName()
+    {
+        return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+            + QLatin1String("/plasma_wallpaper_image/scancache");
+    }
+
+    void load()
+    {
+        if (m_loaded) {
+            return;
+        }
+        m_loaded = true;
+
+        QFile file(cacheFileName());
+        if (!file.open(QIODevice::ReadOnly)) {
+            return;
+        }
+
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_5_14);
+
+        quint32 version = 0;
+        stream >> version;
+        if (version != s_version) {
+            return;
+        }
+
+        stream >> m_roots >> m_dirs;
+        if (stream.status() != QDataStream::Ok) {
+            m_roots.clear();
+            m_dirs.clear();
+        }
+    }
+
+    void prune()
+    {
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        for (auto it = m_roots.begin(); it != m_roots.end();) {
+            if (now - it.value() > s_maxRootAgeMSecs) {
+                it = m_roots.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        QStringList prefixes;
+        for (auto it = m_roots.constBegin(), end = m_roots.constEnd(); it != end; ++it) {
+            prefixes << (it.key().endsWith(QLatin1Char('/')) ? it.key() : it.key() + QLatin1Char('/'));
+        }
+
+        for (auto it = m_dirs.begin(); it != m_dirs.end();) {
+            const QString path = QDir::cleanPath(it.key());
+            const bool used = m_roots.contains(path) || std::any_of(prefixes.constBegin(), prefixes.constEnd(), [&path](const QString &prefix) {
+                return path.startsWith(prefix);
+            });
+            if (used) {
+                ++it;
+            } else {
+                it = m_dirs.erase(it);
+            }
+        }
+    }
+
+    void removeTree(const QString &path)
+    {
+        const QString prefix = path + QLatin1Char('/');
+        for (auto it = m_dirs.begin(); it != m_dirs.end();) {
+            if (it.key() == path || it.key().startsWith(prefix)) {
+                it = m_dirs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    static const quint32 s_version = 2;
+
+    QMutex m_mutex;
+    bool m_loaded = false;
+    bool m_dirty = false;
+    // When each root was last scanned, in ms since the epoch
+    QHash<QString, qint64> m_roots;
+    QHash<QString, ScannedDir> m_dirs;
+};
+
+Q_GLOBAL_STATIC(ScanCache, s_scanCache)
+
+}
+
+class DirScanTask : public QRunnable
+{
+public:
+    DirScanTask(BackgroundFinder *finder, const QString &path, const BackgroundFinder::ScanOrder &order)
+        : m_finder(finder),
+          m_path(path),
+          m_order(order)
+    {
+    }
+
+    void run() override
+    {
+        m_finder->scanDir(m_path, m_order);
+    }
+
+private:
+    BackgroundFinder *m_finder;
+    QString m_path;
+    BackgroundFinder::ScanOrder m_order;
+};
+
 void BackgroundFinder::run()
 {
     QElapsedTimer t;
     t.start();
 
-    QStringList papersFound;
+    // Loading the package structure isn't thread safe, do it once up front
+    m_package = KPackage::PackageLoader::self()->loadPackage(QStringLiteral("Wallpaper/Images"));
+    suffixes();
+
+    // Directories on network mounts mostly wait for I/O, use more threads than cores
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(4, QThread::idealThreadCount()));
+    m_pool = &pool;
+
+    s_scanCache->useRoots(m_paths);
+    for (int i = 0; i < m_paths.count(); ++i) {
+        startScan(m_paths.at(i), {0, i});
+    }
+
+    // Hand over what was found so far every now and then, so the first
+    // backgrounds show up long before a large tree is scanned completely
+    while (!pool.waitForDone(100)) {
+        reportFound();
+    }
+    reportFound();
+
+    m_pool = nullptr;
+    s_scanCache->save();
+
+    qCDebug(IMAGEWALLPAPER) << "Scanned" << m_paths << "for backgrounds in" << t.elapsed() << "ms";
+    Q_EMIT scanFinished(m_token);
+    deleteLater();
+}
+
+void BackgroundFinder::startScan(const QString &path, const ScanOrder &order)
+{
+    {
+        QMutexLocker locker(&m_foundMutex);
+        m_results.insert(order, ScanResult());
+        ++m_pendingAtDepth[order.first()];
+    }
+
+    m_pool->start(new DirScanTask(this, path, order));
+}
+
+void BackgroundFinder::scanDir(const QString &path, const ScanOrder &order)
+{
+    const qint64 mtime = modificationTime(path);
+
+    ScannedDir scanned;
+    bool cached = s_scanCache->find(path, mtime, scanned);
+    for (auto it = scanned.subdirMtimes.constBegin(), end = scanned.subdirMtimes.constEnd(); cached && it != end; ++it) {
+        cached = modificationTime(it.key()) == it.value();
+    }
+
+    if (!cached) {
+        scanned = ScannedDir();
+        scanned.mtime = mtime;
 
-    QDir dir;
-    dir.setFilter(QDir::AllDirs | QDir::Files | QDir::Readable);
-    dir.setNameFilters(suffixes());
-    KPackage::Package package = KPackage::PackageLoader::self()->loadPackage(QStringLiteral("Wallpaper/Images"));
+        QDir dir(path);
+        dir.setFilter(QDir::AllDirs | QDir::Files | QDir::Readable | QDir::NoDotAndDotDot);
+        dir.setNameFilters(suffixes());
 
-    int i;
-    for (i = 0; i < m_paths.count(); ++i) {
-        const QString path = m_paths.at(i);
-        dir.setPath(path);
         const QFileInfoList files = dir.entryInfoList();
-        Q_FOREACH (const QFileInfo &wp, files) {
-            if (wp.isDir()) {
-                //qCDebug(IMAGEWALLPAPER) << "scanning directory" << wp.fileName();
-
-                const QString name = wp.fileName();
-                if (name == QString::fromLatin1(".") || name == QString::fromLatin1("..")) {
-                    // do nothing
-                    continue;
-                }
-
-                const QString filePath = wp.filePath();
-                if (QFile::exists(filePath + QString::fromLatin1("/metadata.desktop")) || QFile::exists(filePath + QString::fromLatin1("/metadata.json"))) {
-                    package.setPath(filePath);
-                    if (package.isValid()) {
-                        if (!package.filePath("images").isEmpty()) {
-                            papersFound << package.path();
-                        }
-                        //qCDebug(IMAGEWALLPAPER) << "adding package" << wp.filePath();
-                        continue;
-                    }
-                }
+        for (const QFileInfo &wp : files) {
+            const QString filePath = wp.filePath();
+
+            if (!wp.isDir()) {
+                scanned.images << filePath;
+                continue;
+            }
 
+            scanned.subdirMtimes.insert(filePath, wp.lastModified().toMSecsSinceEpoch());
+
+            QString packagePath;
+            if (!loadPackage(filePath, packagePath)) {
                 // add this to the directories we should be looking at
-                m_paths.append(filePath);
-            } else {
-                //qCDebug(IMAGEWALLPAPER) << "adding image file" << wp.filePath();
-                papersFound << wp.filePath();
+                scanned.dirs << filePath;
+            } else if (!packagePath.isEmpty()) {
+                scanned.packages << packagePath;
             }
         }
+
+        // A directory changed right now could change again within the
+        // resolution of its time stamp, list it again next time
+        qint64 newestMtime = mtime;
+        for (qint64 subdirMtime : qAsConst(scanned.subdirMtimes)) {
+            newestMtime = qMax(newestMtime, subdirMtime);
+        }
+        if (newestMtime < QDateTime::currentMSecsSinceEpoch() - 2000) {
+            s_scanCache->insert(path, scanned);
+        }
     }
 
-    //qCDebug(IMAGEWALLPAPER) << "WP background found!" << papersFound.size() << "in" << i << "dirs, taking" << t.elapsed() << "ms";
-    Q_EMIT backgroundsFound(papersFound, m_token);
-    deleteLater();
+    // Sorted by name like the listing of a QDir
+    QStringList found = scanned.images + scanned.packages;
+    std::sort(found.begin(), found.end(), [](const QString &a, const QString &b) {
+        return a.compare(b, Qt::CaseInsensitive) < 0;
+    });
+
+    // The subdirectories are pending before this one is done, so its level
+    // is never considered complete while they aren't known yet
+    for (int i = 0; i < scanned.dirs.count(); ++i) {
+        ScanOrder subdirOrder = order;
+        subdirOrder[0] = order.first() + 1;
+        subdirOrder.append(i);
+        startScan(scanned.dirs.at(i), subdirOrder);
+    }
+
+    QMutexLocker locker(&m_foundMutex);
+    ScanResult &result = m_results[order];
+    result.done = true;
+    result.found = found;
+    --m_pendingAtDepth[order.first()];
+}
+
+bool BackgroundFinder::loadPackage(const QString &path, QString &packagePath)
+{
+    if (!QFile::exists(path + QLatin1String("/metadata.desktop")) && !QFile::exists(path + QLatin1String("/metadata.json"))) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_packageMutex);
+    m_package.setPath(path);
+    if (!m_package.isValid()) {
+        return false;
+    }
+
+    if (!m_package.filePath("images").isEmpty()) {
+        packagePath = m_package.path();
+    }
+    return true;
 }
 
+void BackgroundFinder::reportFound()
+{
+    QStringList found;
+    {
+        QMutexLocker locker(&m_foundMutex);
+
+        // Hand over the directories in the order of a breadth-first scan, each
+        // one once all before it are done. A level is only completely known
+        // once the level above it is done.
+        for (auto it = m_results.begin(); it != m_results.end() && it->done;) {
+            const int depth = it.key().first();
+            if (depth > 0 && m_pendingAtDepth.value(depth - 1) > 0) {
+                break;
+            }
 
+            found << it->found;
+            it = m_results.erase(it);
+        }
+    }
+
+    if (!found.isEmpty()) {
+        Q_EMIT backgroundsFound(found, m_token);
+    }
+}
 
 #endif // BACKGROUNDLISTMODEL_CPP
@@ -23,34 +23,23 @@
 #include "image.h"
 
 #include <QAbstractListModel>
-#include <QCache>
-#include <QPixmap>
-#include <QRunnable>
+#include <QHash>
+#include <QMap>
+#include <QPointer>
 #include <QThread>
+#include <QThreadPool>
 #include <QMutex>
 #include <QSet>
+#include <QVector>
 
 #include <KDirWatch>
-#include <KFileItem>
 
+#include <KPackage/Package>
 #include <KPackage/PackageStructure>
 
 
 class Image;
-
-class ImageSizeFinder : public QObject, public QRunnable
-{
-    Q_OBJECT
-    public:
-        explicit ImageSizeFinder(const QString &path, QObject *parent = nullptr);
-        void run() override;
-
-    Q_SIGNALS:
-        void sizeFound(const QString &path, const QSize &size);
-
-    private:
-        QString m_path;
-};
+class PreviewCache;
 
 class BackgroundListModel : public QAbstractListModel
 {
@@ -98,13 +87,18 @@ Q_SIGNALS:
     void countChanged();
 
 protected Q_SLOTS:
-    void showPreview(const KFileItem &item, const QPixmap &preview);
-    void previewFailed(const KFileItem &item);
-    void sizeFound(const QString &path, const QSize &s);
+    void previewReady(const QString &path);
+    void imageSizeFound(const QString &path);
+    void backgroundChanged(const QString &path);
     void backgroundsFound(const QStringList &paths, const QString &token);
     void processPaths(const QStringList &paths);
 
 protected:
+    /**
+     * Removes all backgrounds.
+     */
+    void clearPackages();
+
     QPointer<Image> m_wallpaper;
     QString m_findToken;
     QList<KPackage::Package> m_packages;
@@ -112,16 +106,33 @@ protected:
 private:
     QSize bestSize(const KPackage::Package &package) const;
 
+    // The paths a package can be looked up by, normalized
+    static QStringList pathKeys(const KPackage::Package &package);
+    static QString normalizedPath(const QString &path);
+    void appendPackages(const QList<KPackage::Package> &packages);
+    void prependPackage(const KPackage::Package &package);
+    // Removes the packages in the ascending @p rows
+    void removePackages(const QVector<int> &rows);
+
     QSet<QString> m_removableWallpapers;
-    QHash<QString, QSize> m_sizeCache;
-    QHash<QPersistentModelIndex, QUrl> m_previewJobsUrls;
     KDirWatch m_dirwatch;
-    QCache<QString, QPixmap> m_imageCache;
+    PreviewCache *m_previewCache;
 
-    int m_screenshotSize;
+    QSize m_previewSize;
     QHash<QString, int> m_pendingDeletion;
+    // Rows of m_packages by the paths returned by pathKeys()
+    QHash<QString, int> m_rowForPath;
 };
 
+/**
+ * Finds the images and wallpaper packages below some directories.
+ *
+ * Directories are scanned in parallel, what was found is reported in
+ * chunks while the scan is running, in the same order as a sequential
+ * breadth-first scan with each directory sorted by name. The listings of the directories are
+ * cached on disk along with their modification time, so directories
+ * which didn't change since a previous scan are not listed again.
+ */
 class BackgroundFinder : public QThread
 {
     Q_OBJECT
@@ -137,14 +148,50 @@ public:
 
 Q_SIGNALS:
     void backgroundsFound(const QStringList &paths, const QString &token);
+    /**
+     * Emitted after the last backgroundsFound() of the scan.
+     */
+    void scanFinished(const QString &token);
 
 protected:
     void run() override;
 
 private:
+    friend class DirScanTask;
+
+    // Position of a directory in a breadth-first scan: its depth, followed
+    // by the index of it and of each of its parents in their listings
+    using ScanOrder = QVector<int>;
+
+    struct ScanResult {
+        bool done = false;
+        QStringList found;
+    };
+
+    void startScan(const QString &path, const ScanOrder &order);
+    // Runs on the scan thread pool
+    void scanDir(const QString &path, const ScanOrder &order);
+    /**
+     * @return whether @p path is a wallpaper package, @p packagePath is
+     * set if it has images
+     */
+    bool loadPackage(const QString &path, QString &packagePath);
+    void reportFound();
+
     QStringList m_paths;
     QString m_token;
 
+    QThreadPool *m_pool = nullptr;
+
+    QMutex m_packageMutex;
+    KPackage::Package m_package;
+
+    // Protects the results, which are handed over in scan order
+    QMutex m_foundMutex;
+    QMap<ScanOrder, ScanResult> m_results;
+    // Directories not scanned yet, by depth
+    QHash<int, int> m_pendingAtDepth;
+
     static QMutex s_suffixMutex;
     static QStringList s_suffixes;
 };
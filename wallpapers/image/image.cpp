@@ -64,6 +64,8 @@ Image::Image(QObject *parent)
       m_ready(false),
       m_delay(10),
       m_dirWatch(new KDirWatch(this)),
+      m_scanDirty(false),
+      m_slideShownWhileScanning(false),
       m_mode(SingleImage),
       m_slideshowMode(Random),
       m_currentSlide(-1),
@@ -648,15 +650,37 @@ void Image::startSlideshow()
     }
     // populate background list
     m_timer.stop();
+    m_slideShownWhileScanning = false;
     m_slideshowModel->reload(m_slidePaths);
+    connect(m_slideshowModel, &SlideModel::countChanged, this, &Image::firstBackgroundsFound, Qt::UniqueConnection);
     connect(m_slideshowModel, &SlideModel::done, this, &Image::backgroundsFound);
     //TODO: what would be cool: paint on the wallpaper itself a busy widget and perhaps some text
     //about loading wallpaper slideshow while the thread runs
 }
 
+void Image::firstBackgroundsFound()
+{
+    // Large or remote slide directories take a while to scan, show the
+    // first slides which were found instead of waiting for all of them
+    if (m_scanDirty || m_slideFilterModel->rowCount() == 0) {
+        return;
+    }
+
+    disconnect(m_slideshowModel, &SlideModel::countChanged, this, &Image::firstBackgroundsFound);
+
+    if (m_currentSlide == -1) {
+        m_currentSlide = m_slideFilterModel->indexOf(m_wallpaper) - 1;
+    } else {
+        m_currentSlide = -1;
+    }
+    nextSlide();
+    m_slideShownWhileScanning = true;
+}
+
 void Image::backgroundsFound()
 {
     disconnect(m_slideshowModel, &SlideModel::done, this, 0);
+    disconnect(m_slideshowModel, &SlideModel::countChanged, this, &Image::firstBackgroundsFound);
 
     if(m_scanDirty) {
         m_scanDirty = false;
@@ -669,6 +693,10 @@ void Image::backgroundsFound()
         // no image has been found, which is quite weird... try again later (this is useful for events which
         // are not detected by KDirWatch, like a NFS directory being mounted)
         QTimer::singleShot(1000, this, &Image::startSlideshow);
+    } else if (m_slideShownWhileScanning) {
+        // Go on from the slide which is already shown
+        m_slideFilterModel->sort(0);
+        m_currentSlide = m_slideFilterModel->indexOf(m_wallpaperPath);
     } else {
         if (m_currentSlide == -1) {
             m_currentSlide = m_slideFilterModel->indexOf(m_wallpaper) - 1;
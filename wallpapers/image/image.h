@@ -177,6 +177,7 @@ class Image : public QObject, public QQmlParserStatus
         void pathCreated(const QString &path);
         void pathDeleted(const QString &path);
         void pathDirty(const QString &path);
+        void firstBackgroundsFound();
         void backgroundsFound();
 
     protected:
@@ -193,6 +194,8 @@ class Image : public QObject, public QQmlParserStatus
         QStringList m_usersWallpapers;
         KDirWatch *m_dirWatch;
         bool m_scanDirty;
+        // Whether a slide was shown before the slideshow scan finished
+        bool m_slideShownWhileScanning;
         QSize m_targetSize;
 
         RenderingMode m_mode;
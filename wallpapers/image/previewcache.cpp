@@ -0,0 +1,375 @@
+/***************************************************************************
+ *   Copyright 2020 by the Plasma Workspace authors                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "previewcache.h"
+#include "debug.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QPointer>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+// Previews waiting for a worker, older ones are dropped
+static const int s_maxQueued = 64;
+// Cached files which weren't used for this long are removed
+static const qint64 s_maxAgeSecs = 30 * 24 * 60 * 60;
+// Beyond this, the least recently used cached files are removed
+static const qint64 s_maxCacheBytes = 100 * 1024 * 1024;
+// Using a cached file only refreshes its time stamp when it is older than this
+static const qint64 s_touchIntervalSecs = 24 * 60 * 60;
+
+// Keeps a cached file from being pruned while it is in use
+static void touch(const QString &fileName, const QFileInfo &info)
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    if (info.lastModified().secsTo(now) > s_touchIntervalSecs) {
+        QFile file(fileName);
+        if (file.open(QIODevice::ReadWrite)) {
+            file.setFileTime(now, QFileDevice::FileModificationTime);
+        }
+    }
+}
+
+// Removes old previews and dimensions, and the least recently used ones when they take too much space
+class PruneTask : public QRunnable
+{
+public:
+    explicit PruneTask(const QString &cacheDir)
+        : m_cacheDir(cacheDir)
+    {
+    }
+
+    void run() override
+    {
+        const QDateTime now = QDateTime::currentDateTime();
+
+        QFileInfoList files = QDir(m_cacheDir + QLatin1String("/previews")).entryInfoList(QDir::Files);
+        files += QDir(m_cacheDir + QLatin1String("/sizes")).entryInfoList(QDir::Files);
+
+        // newest first
+        std::sort(files.begin(), files.end(), [](const QFileInfo &a, const QFileInfo &b) {
+            return a.lastModified() > b.lastModified();
+        });
+
+        qint64 totalSize = 0;
+        int removed = 0;
+        for (const QFileInfo &info : qAsConst(files)) {
+            totalSize += info.size();
+            if (totalSize > s_maxCacheBytes || info.lastModified().secsTo(now) > s_maxAgeSecs) {
+                if (QFile::remove(info.absoluteFilePath())) {
+                    ++removed;
+                }
+            }
+        }
+
+        if (removed) {
+            qCDebug(IMAGEWALLPAPER) << "Removed" << removed << "old wallpaper previews";
+        }
+    }
+
+private:
+    QString m_cacheDir;
+};
+
+class PreviewTask : public QRunnable
+{
+public:
+    PreviewTask(PreviewCache *cache, const PreviewCache::Request &request)
+        : m_cache(cache),
+          m_request(request)
+    {
+    }
+
+    void run() override
+    {
+        const PreviewCache::Result result = m_cache->process(m_request);
+
+        // The cache waits for its workers before it goes away
+        PreviewCache *cache = m_cache;
+        const PreviewCache::Request request = m_request;
+        QMetaObject::invokeMethod(cache, [cache, request, result] {
+            cache->finished(request, result);
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    PreviewCache *m_cache;
+    PreviewCache::Request m_request;
+};
+
+PreviewCache::PreviewCache(QObject *parent)
+    : QObject(parent),
+      m_cacheDir(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/plasma_wallpaper_image"))
+{
+    // Decoding large images takes a lot of memory, don't do too many at once
+    m_pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, 4));
+
+    m_previews.setMaxCost(10 * 1024 * 1024); // 10 MiB
+
+    QDir().mkpath(m_cacheDir + QLatin1String("/previews"));
+    QDir().mkpath(m_cacheDir + QLatin1String("/sizes"));
+
+    // Behind the previews which are asked for right away
+    m_pool.start(new PruneTask(m_cacheDir), -1);
+}
+
+PreviewCache::~PreviewCache()
+{
+    m_queue.clear();
+    m_pool.waitForDone();
+}
+
+PreviewCache *PreviewCache::self()
+{
+    static QPointer<PreviewCache> s_self;
+    if (!s_self) {
+        s_self = new PreviewCache(QCoreApplication::instance());
+    }
+    return s_self;
+}
+
+QString PreviewCache::requestId(const QString &path, const QSize &size)
+{
+    return QStringLiteral("%1@%2x%3").arg(path).arg(size.width()).arg(size.height());
+}
+
+QPixmap PreviewCache::preview(const QString &path, const QSize &size) const
+{
+    const QPixmap *preview = m_previews.object(requestId(path, size));
+    return preview ? *preview : QPixmap();
+}
+
+void PreviewCache::requestPreview(const QString &path, const QSize &size)
+{
+    const QString id = requestId(path, size);
+    if (m_previews.contains(id)) {
+        return;
+    }
+
+    enqueue({id, path, size});
+}
+
+QSize PreviewCache::imageSize(const QString &path) const
+{
+    return m_imageSizes.value(path);
+}
+
+void PreviewCache::requestImageSize(const QString &path)
+{
+    if (m_imageSizes.contains(path)) {
+        return;
+    }
+
+    enqueue({requestId(path, QSize()), path, QSize()});
+}
+
+int PreviewCache::decodeCount() const
+{
+    return m_decodeCount.loadAcquire();
+}
+
+void PreviewCache::invalidate(const QString &path)
+{
+    m_imageSizes.remove(path);
+
+    const QString prefix = path + QLatin1Char('@');
+    const QList<QString> ids = m_previews.keys();
+    for (const QString &id : ids) {
+        if (id.startsWith(prefix)) {
+            m_previews.remove(id);
+        }
+    }
+
+    for (auto it = m_failed.begin(); it != m_failed.end();) {
+        if (it->startsWith(prefix)) {
+            it = m_failed.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (const QString &id : qAsConst(m_running)) {
+        if (id.startsWith(prefix)) {
+            m_stale.insert(id);
+        }
+    }
+}
+
+void PreviewCache::enqueue(const Request &request)
+{
+    if (m_running.contains(request.id) || m_failed.contains(request.id)) {
+        return;
+    }
+
+    // Asked for again, so it is probably visible again: handle it first
+    for (int i = 0; i < m_queue.count(); ++i) {
+        if (m_queue.at(i).id == request.id) {
+            m_queue.removeAt(i);
+            break;
+        }
+    }
+
+    m_queue.append(request);
+    if (m_queue.count() > s_maxQueued) {
+        m_queue.removeFirst();
+    }
+
+    schedule();
+}
+
+void PreviewCache::schedule()
+{
+    while (!m_queue.isEmpty() && m_running.count() < m_pool.maxThreadCount()) {
+        const Request request = m_queue.takeLast();
+        m_running.insert(request.id);
+        m_pool.start(new PreviewTask(this, request));
+    }
+}
+
+void PreviewCache::finished(const Request &request, const Result &result)
+{
+    m_running.remove(request.id);
+
+    // It is probably still shown, but with the file as it was before
+    if (m_stale.remove(request.id)) {
+        enqueue(request);
+        return;
+    }
+
+    if (result.imageSize.isValid() && m_imageSizes.value(request.path) != result.imageSize) {
+        m_imageSizes.insert(request.path, result.imageSize);
+        emit imageSizeFound(request.path, result.imageSize);
+    }
+
+    if (request.size.isValid()) {
+        if (result.preview.isNull()) {
+            m_failed.insert(request.id);
+        } else {
+            QPixmap *preview = new QPixmap(QPixmap::fromImage(result.preview));
+            const int cost = preview->width() * preview->height() * preview->depth() / 8;
+            m_previews.insert(request.id, preview, cost);
+            emit previewReady(request.path);
+        }
+    } else if (!result.imageSize.isValid()) {
+        m_failed.insert(request.id);
+    }
+
+    schedule();
+}
+
+QString PreviewCache::cacheKey(const QFileInfo &info, const QSize &size) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(info.absoluteFilePath().toUtf8());
+    hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    hash.addData(QByteArray::number(info.size()));
+    if (size.isValid()) {
+        hash.addData(QByteArray::number(size.width()) + 'x' + QByteArray::number(size.height()));
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QSize PreviewCache::readImageSize(const QFileInfo &info, const QString &path)
+{
+    const QString fileName = m_cacheDir + QLatin1String("/sizes/") + cacheKey(info, QSize());
+    QFile file(fileName);
+    if (file.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> dimensions = file.readAll().split('x');
+        if (dimensions.count() == 2) {
+            file.close();
+            touch(fileName, QFileInfo(fileName));
+            return QSize(dimensions.at(0).toInt(), dimensions.at(1).toInt());
+        }
+    }
+
+    // Only reads the header
+    const QSize size = QImageReader(path).size();
+    if (size.isValid()) {
+        writeImageSize(info, size);
+    }
+    return size;
+}
+
+void PreviewCache::writeImageSize(const QFileInfo &info, const QSize &size)
+{
+    QSaveFile file(m_cacheDir + QLatin1String("/sizes/") + cacheKey(info, QSize()));
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QByteArray::number(size.width()) + 'x' + QByteArray::number(size.height()));
+        file.commit();
+    }
+}
+
+PreviewCache::Result PreviewCache::process(const Request &request)
+{
+    Result result;
+
+    const QFileInfo info(request.path);
+    if (!info.isFile()) {
+        return result;
+    }
+
+    if (!request.size.isValid()) {
+        result.imageSize = readImageSize(info, request.path);
+        return result;
+    }
+
+    const QString previewFile = m_cacheDir + QLatin1String("/previews/") + cacheKey(info, request.size) + QLatin1String(".png");
+    if (result.preview.load(previewFile, "PNG")) {
+        touch(previewFile, QFileInfo(previewFile));
+        return result;
+    }
+
+    QImageReader reader(request.path);
+    reader.setAutoTransform(true);
+
+    const QSize imageSize = reader.size();
+    if (imageSize.isValid()) {
+        // Lets formats like JPEG decode at a lower resolution right away
+        reader.setScaledSize(imageSize.scaled(request.size, Qt::KeepAspectRatio));
+    }
+
+    result.preview = reader.read();
+    m_decodeCount.ref();
+
+    if (result.preview.isNull()) {
+        qCDebug(IMAGEWALLPAPER) << "Failed to create a preview of" << request.path << reader.errorString();
+        return result;
+    }
+
+    if (imageSize.isValid()) {
+        result.imageSize = imageSize;
+        writeImageSize(info, imageSize);
+    }
+
+    QSaveFile file(previewFile);
+    if (file.open(QIODevice::WriteOnly) && result.preview.save(&file, "PNG")) {
+        file.commit();
+    }
+
+    return result;
+}
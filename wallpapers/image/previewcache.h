@@ -0,0 +1,145 @@
+/***************************************************************************
+ *   Copyright 2020 by the Plasma Workspace authors                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#ifndef PREVIEWCACHE_H
+#define PREVIEWCACHE_H
+
+#include <QAtomicInt>
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QSet>
+#include <QThreadPool>
+
+class QFileInfo;
+
+/**
+ * Previews and dimensions of wallpaper images.
+ *
+ * They are created on a few worker threads and stored on disk, keyed by
+ * the path, modification time and size of the image, so every model in
+ * the process and every process showing wallpapers (desktop, slideshow,
+ * lock screen settings) only decodes an image once. What is kept in
+ * memory isn't checked against the file, changed files are invalidated.
+ *
+ * Waiting requests are handled newest first and the oldest ones are
+ * dropped when there are too many, so scrolling through a large list
+ * doesn't leave the workers busy with rows which are no longer shown.
+ * Dropped previews are created again when they are asked for again.
+ *
+ * Cached files which weren't used for a month are removed when the cache
+ * is created, and the least recently used ones beyond 100 MiB.
+ */
+class PreviewCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PreviewCache(QObject *parent = nullptr);
+    ~PreviewCache() override;
+
+    /**
+     * @return the cache shared by the models of this process
+     */
+    static PreviewCache *self();
+
+    /**
+     * @return the preview of @p path fitting into @p size, or a null
+     * pixmap if it wasn't created yet
+     */
+    QPixmap preview(const QString &path, const QSize &size) const;
+
+    /**
+     * Queues creating the preview of @p path, previewReady() is emitted
+     * once it is available.
+     */
+    void requestPreview(const QString &path, const QSize &size);
+
+    /**
+     * @return the dimensions of the image at @p path, or an invalid size
+     * if they aren't known yet
+     */
+    QSize imageSize(const QString &path) const;
+
+    /**
+     * Queues reading the dimensions of @p path, imageSizeFound() is
+     * emitted once they are known.
+     */
+    void requestImageSize(const QString &path);
+
+    /**
+     * Forgets the preview and dimensions of @p path, which changed. They
+     * are created again when they are asked for the next time.
+     */
+    void invalidate(const QString &path);
+
+    /**
+     * @return how many images were decoded, as opposed to loaded from the cache
+     */
+    int decodeCount() const;
+
+Q_SIGNALS:
+    void previewReady(const QString &path);
+    void imageSizeFound(const QString &path, const QSize &size);
+
+private:
+    friend class PreviewTask;
+
+    struct Request {
+        QString id;
+        QString path;
+        // Invalid for dimension requests
+        QSize size;
+    };
+
+    struct Result {
+        QImage preview;
+        QSize imageSize;
+    };
+
+    static QString requestId(const QString &path, const QSize &size);
+    void enqueue(const Request &request);
+    void schedule();
+    void finished(const Request &request, const Result &result);
+
+    // Run on the worker threads
+    Result process(const Request &request);
+    QString cacheKey(const QFileInfo &info, const QSize &size) const;
+    QSize readImageSize(const QFileInfo &info, const QString &path);
+    void writeImageSize(const QFileInfo &info, const QSize &size);
+
+    const QString m_cacheDir;
+    QThreadPool m_pool;
+    QAtomicInt m_decodeCount;
+
+    // newest last
+    QList<Request> m_queue;
+    QSet<QString> m_running;
+    // Running for a file which changed meanwhile, handled again when done
+    QSet<QString> m_stale;
+    // Only retried once the file is invalidated
+    QSet<QString> m_failed;
+
+    QCache<QString, QPixmap> m_previews;
+    QHash<QString, QSize> m_imageSizes;
+};
+
+#endif // PREVIEWCACHE_H
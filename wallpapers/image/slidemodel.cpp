@@ -20,12 +20,7 @@
 
 void SlideModel::reload(const QStringList &selected)
 {
-    if (!m_packages.isEmpty()) {
-        beginRemoveRows(QModelIndex(), 0, m_packages.count() - 1);
-        m_packages.clear();
-        endRemoveRows();
-        emit countChanged();
-    }
+    clearPackages();
     addDirs(selected);
 }
 
@@ -34,6 +29,7 @@ void SlideModel::addDirs(const QStringList &selected)
 {
     BackgroundFinder *finder = new BackgroundFinder(m_wallpaper.data(), selected);
     connect(finder, &BackgroundFinder::backgroundsFound, this, &SlideModel::backgroundsFound);
+    connect(finder, &BackgroundFinder::scanFinished, this, &SlideModel::scanFinished);
     m_findToken = finder->token();
     finder->start(); 
 }
@@ -44,7 +40,13 @@ void SlideModel::backgroundsFound(const QStringList& paths, const QString& token
         return;
     }
     processPaths(paths);
-    emit done();
+}
+
+void SlideModel::scanFinished(const QString &token)
+{
+    if (token == m_findToken) {
+        emit done();
+    }
 }
 
 
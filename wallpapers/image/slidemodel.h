@@ -38,6 +38,7 @@ Q_SIGNALS:
 private Q_SLOTS:
     void removeBackgrounds(const QStringList &paths, const QString &token);
     void backgroundsFound(const QStringList &paths, const QString &token);
+    void scanFinished(const QString &token);
 };
 
 #endif